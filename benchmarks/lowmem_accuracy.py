@@ -0,0 +1,94 @@
+"""
+    Memory versus accuracy of low memory training(saved_input='bf16'/'int8' of shift{1,2,3}d_lowmem_func).
+
+    For every shape, input distribution and shift mode(SSL and active) the same forward/backward is run with the
+    input saved in full precision, bfloat16 and int8 with per channel scale. Reported per mode:
+        saved_bytes       - bytes saved for backward by the shift(input + weights)
+        saved_ratio       - saved_bytes relative to 'full'
+        weight_grad_*     - error of the gradient w.r.t. shifts against 'full': relative L2, max abs(relative to max
+                            abs of the full gradient) and cosine similarity
+        input_grad_equal  - gradient w.r.t. input is bitwise equal to 'full'(it does not use the saved input)
+    Results are printed(or written by --output) as one JSON document:
+
+        python benchmarks/lowmem_accuracy.py --output lowmem.json
+"""
+import argparse
+import json
+import torch
+from torchshifts.functional import shift1d_lowmem_func, shift2d_lowmem_func, shift3d_lowmem_func
+
+FUNCS = {1: shift1d_lowmem_func, 2: shift2d_lowmem_func, 3: shift3d_lowmem_func}
+SHAPES = [(8, 64, 256), (8, 64, 56, 56), (8, 256, 14, 14), (2, 32, 16, 32, 32)]
+# 'relu' - post activation inputs(half zeros, skewed), 'gaussian' - pre activation ones
+DISTRIBUTIONS = ['gaussian', 'relu']
+SAVED_INPUTS = ['full', 'bf16', 'int8']
+
+
+def make_input(shape, distribution, generator):
+    x = torch.randn(*shape, generator=generator)
+    # channels of different magnitude: per channel int8 scale matters
+    x = x * torch.logspace(-1, 1, shape[1]).view(1, -1, *([1] * (len(shape) - 2)))
+    return x.relu() if distribution == 'relu' else x
+
+
+def run(func, x, weights, grad, padding_mode, active_flag, saved_input):
+    x = x.clone().requires_grad_(True)
+    w = weights.clone().requires_grad_(True)
+    saved = [0]
+
+    def pack(t):
+        saved[0] += t.numel() * t.element_size()
+        return t
+
+    with torch.autograd.graph.saved_tensors_hooks(pack, lambda t: t):
+        out = func(x, w, padding_mode, active_flag, saved_input)
+    out.backward(grad)
+    return saved[0], x.grad, w.grad
+
+
+def compare(reference, value):
+    diff = (value - reference).double()
+    reference = reference.double()
+    return {'weight_grad_rel_l2': (diff.norm() / reference.norm().clamp_min(1e-30)).item(),
+            'weight_grad_rel_max_abs': (diff.abs().max() / reference.abs().max().clamp_min(1e-30)).item(),
+            'weight_grad_cosine': torch.nn.functional.cosine_similarity(value.double().flatten(), reference.flatten(), dim=0).item()}
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Saved memory and weight gradient error of bf16/int8 saved inputs')
+    parser.add_argument('--padding-mode', type=int, default=0)
+    parser.add_argument('--seed', type=int, default=0)
+    parser.add_argument('--output', default=None, help='JSON file, stdout when not given')
+    args = parser.parse_args()
+
+    generator = torch.Generator().manual_seed(args.seed)
+    results = []
+    for shape in SHAPES:
+        n_dims = len(shape) - 2
+        func = FUNCS[n_dims]
+        weights = torch.empty(shape[1], n_dims).uniform_(-2, 2, generator=generator)
+        for distribution in DISTRIBUTIONS:
+            x = make_input(shape, distribution, generator)
+            grad = torch.randn(*shape, generator=generator)
+            for active_flag in (False, True):
+                reference = None
+                for saved_input in SAVED_INPUTS:
+                    saved_bytes, input_grad, weight_grad = run(func, x, weights, grad, args.padding_mode, active_flag, saved_input)
+                    if reference is None:
+                        reference = (saved_bytes, input_grad, weight_grad)
+                    record = {'shape': list(shape), 'distribution': distribution, 'active_flag': active_flag,
+                              'saved_input': saved_input, 'saved_bytes': saved_bytes,
+                              'saved_ratio': saved_bytes / reference[0],
+                              'input_grad_equal': torch.equal(input_grad, reference[1])}
+                    record.update(compare(reference[2], weight_grad))
+                    results.append(record)
+    report = json.dumps({'torch': torch.__version__, 'padding_mode': args.padding_mode, 'results': results}, indent=2)
+    if args.output is None:
+        print(report)
+    else:
+        with open(args.output, 'w') as f:
+            f.write(report + '\n')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,233 @@
+"""
+    Model level benchmark of ShiftNet blocks against the depthwise convolution block they replace.
+
+    Blocks(all followed by 1x1 convolution + BatchNorm + ReLU, shift blocks use the same --sparsity-term):
+        shift     - Shift2d(SSL: rounded shifts on forward)
+        active    - Shift2d(active_flag=True: bilinear interpolation on forward)
+        quantized - shift block converted by torch.quantization.convert(..., mapping=quant_mapping), CPU inference only
+        depthwise - 3x3 depthwise convolution baseline
+
+    Every block is measured on the stage shapes of common ImageNet(224x224) and detection(640x640) networks,
+    for each batch size and thread count: p50/p99 latency, throughput and peak allocator memory, in inference
+    and training(forward + backward) modes. Results are printed(or written by --output) as one JSON document:
+
+        python benchmarks/shift_blocks.py --batch-sizes 1 8 32 --threads 1 4 --output results.json
+"""
+import argparse
+import json
+import os
+import platform
+import time
+import torch
+from torch import nn
+import torchshifts
+from torchshifts import Shift2d, quant_mapping
+
+
+# (name, channels, height, width): stages of ResNet/MobileNet like backbones
+RESOLUTIONS = {
+    'imagenet': [('imagenet_s1', 64, 56, 56), ('imagenet_s2', 128, 28, 28),
+                 ('imagenet_s3', 256, 14, 14), ('imagenet_s4', 512, 7, 7)],
+    'detection': [('detection_s1', 64, 160, 160), ('detection_s2', 128, 80, 80),
+                  ('detection_s3', 256, 40, 40), ('detection_s4', 512, 20, 20)],
+}
+BLOCKS = ['shift', 'active', 'quantized', 'depthwise']
+MODES = ['inference', 'training']
+
+
+class ShiftBlock(nn.Module):
+    def __init__(self, channels, active_flag=False, sparsity_term=0.):
+        super(ShiftBlock, self).__init__()
+        self.quant = torch.ao.quantization.QuantStub()
+        self.shift = Shift2d(channels, active_flag=active_flag, sparsity_term=sparsity_term)
+        self.conv = nn.Conv2d(channels, channels, 1, bias=False)
+        self.bn = nn.BatchNorm2d(channels)
+        self.relu = nn.ReLU()
+        self.dequant = torch.ao.quantization.DeQuantStub()
+
+    def forward(self, x):
+        out = self.shift(self.quant(x))
+        # float Shift modules return (output, sparsity loss), quantized ones only output
+        out, loss = out if isinstance(out, tuple) else (out, None)
+        out = self.dequant(self.relu(self.bn(self.conv(out))))
+        return out, loss
+
+
+class DepthwiseBlock(nn.Module):
+    def __init__(self, channels):
+        super(DepthwiseBlock, self).__init__()
+        self.dw = nn.Conv2d(channels, channels, 3, padding=1, groups=channels, bias=False)
+        self.conv = nn.Conv2d(channels, channels, 1, bias=False)
+        self.bn = nn.BatchNorm2d(channels)
+        self.relu = nn.ReLU()
+
+    def forward(self, x):
+        return self.relu(self.bn(self.conv(self.dw(x)))), None
+
+
+def quantize_block(block, example):
+    engine = 'fbgemm' if 'fbgemm' in torch.backends.quantized.supported_engines else 'qnnpack'
+    torch.backends.quantized.engine = engine
+    block.eval()
+    block.qconfig = torch.ao.quantization.get_default_qconfig(engine)
+    torch.ao.quantization.fuse_modules(block, [['conv', 'bn', 'relu']], inplace=True)
+    torch.ao.quantization.prepare(block, inplace=True)
+    with torch.no_grad():
+        block(example)
+    return torch.ao.quantization.convert(block, mapping=quant_mapping)
+
+
+def make_block(name, channels, example, sparsity_term):
+    if name == 'depthwise':
+        return DepthwiseBlock(channels)
+    if name == 'quantized':
+        return quantize_block(ShiftBlock(channels, sparsity_term=sparsity_term), example)
+    return ShiftBlock(channels, active_flag=(name == 'active'), sparsity_term=sparsity_term)
+
+
+def percentile(values, q):
+    values = sorted(values)
+    return values[min(len(values) - 1, int(round(q * (len(values) - 1))))]
+
+
+def sync(device):
+    if device.type == 'cuda':
+        torch.cuda.synchronize(device)
+
+
+def make_step(block, x, mode):
+    if mode == 'inference':
+        def step():
+            with torch.no_grad():
+                block(x)
+        return step
+
+    params = [p for p in block.parameters() if p.requires_grad]
+
+    def step():
+        out, loss = block(x)
+        out = out.mean()
+        (out if loss is None else out + loss).backward()
+        for p in params + [x]:
+            p.grad = None
+    return step
+
+
+def peak_memory(step, device):
+    """Peak bytes allocated above the current level during one step(CUDA caching allocator or CPU profiler events)"""
+    if device.type == 'cuda':
+        sync(device)
+        base = torch.cuda.memory_allocated(device)
+        torch.cuda.reset_peak_memory_stats(device)
+        step()
+        sync(device)
+        return torch.cuda.max_memory_allocated(device) - base
+    with torch.profiler.profile(activities=[torch.profiler.ProfilerActivity.CPU], profile_memory=True) as prof:
+        step()
+    # every allocation(+bytes) and free(-bytes) is a '[memory]' event, op events only sum them up
+    events = sorted((e for e in prof.events() if e.name == '[memory]'), key=lambda e: e.time_range.start)
+    current, peak = 0, 0
+    for e in events:
+        current += e.cpu_memory_usage
+        peak = max(peak, current)
+    return peak
+
+
+def saved_bytes(block, x):
+    """Bytes of tensors saved for backward by one training forward(activation memory of the block)"""
+    total = [0]
+
+    def pack(t):
+        total[0] += t.numel() * t.element_size()
+        return t
+
+    with torch.autograd.graph.saved_tensors_hooks(pack, lambda t: t):
+        block(x)
+    return total[0]
+
+
+def run_case(block, x, mode, device, warmup, iters):
+    step = make_step(block, x, mode)
+    for _ in range(warmup):
+        step()
+    latencies = []
+    for _ in range(iters):
+        sync(device)
+        start = time.perf_counter()
+        step()
+        sync(device)
+        latencies.append(time.perf_counter() - start)
+    mean = sum(latencies) / len(latencies)
+    result = {'p50_ms': 1e3 * percentile(latencies, 0.5),
+              'p99_ms': 1e3 * percentile(latencies, 0.99),
+              'mean_ms': 1e3 * mean,
+              'throughput_samples_per_s': x.shape[0] / mean,
+              'peak_memory_bytes': peak_memory(step, device)}
+    if mode == 'training':
+        result['saved_for_backward_bytes'] = saved_bytes(block, x)
+    return result
+
+
+def environment(device):
+    env = {'torch': torch.__version__,
+           'torchshifts': getattr(torchshifts, '__version__', None),
+           'python': platform.python_version(),
+           'platform': platform.platform(),
+           'processor': platform.processor(),
+           'cpu_count': os.cpu_count(),
+           'device': str(device)}
+    if device.type == 'cuda':
+        env['device_name'] = torch.cuda.get_device_name(device)
+    return env
+
+
+def main():
+    parser = argparse.ArgumentParser(description='ShiftNet block vs depthwise convolution: latency, throughput and peak memory')
+    parser.add_argument('--device', default='cpu')
+    parser.add_argument('--blocks', nargs='+', default=BLOCKS, choices=BLOCKS)
+    parser.add_argument('--resolutions', nargs='+', default=list(RESOLUTIONS.keys()), choices=list(RESOLUTIONS.keys()))
+    parser.add_argument('--modes', nargs='+', default=MODES, choices=MODES)
+    parser.add_argument('--batch-sizes', nargs='+', type=int, default=[1, 8, 32])
+    parser.add_argument('--threads', nargs='+', type=int, default=[1, torch.get_num_threads()],
+                        help='intra-op thread counts(CPU only)')
+    parser.add_argument('--sparsity-term', type=float, default=0.,
+                        help='sparsity_term of every shift block(same for shift and active, so they differ only by the kernel)')
+    parser.add_argument('--warmup', type=int, default=5)
+    parser.add_argument('--iters', type=int, default=50)
+    parser.add_argument('--output', default=None, help='JSON file, stdout when not given')
+    args = parser.parse_args()
+
+    device = torch.device(args.device)
+    threads = sorted(set(args.threads)) if device.type == 'cpu' else [torch.get_num_threads()]
+    results = []
+    for resolution in args.resolutions:
+        for stage, channels, height, width in RESOLUTIONS[resolution]:
+            for block_name in args.blocks:
+                if (block_name == 'quantized') and (device.type != 'cpu'):
+                    continue
+                for batch in args.batch_sizes:
+                    x = torch.randn(batch, channels, height, width, device=device)
+                    block = make_block(block_name, channels, x.cpu(), args.sparsity_term).to(device)
+                    for mode in args.modes:
+                        # quantized kernels have no backward
+                        if (block_name == 'quantized') and (mode == 'training'):
+                            continue
+                        block.train(mode == 'training')
+                        x.requires_grad_(mode == 'training')
+                        for n_threads in threads:
+                            torch.set_num_threads(n_threads)
+                            record = {'block': block_name, 'resolution': resolution, 'stage': stage,
+                                      'shape': [batch, channels, height, width], 'batch_size': batch,
+                                      'threads': n_threads, 'mode': mode}
+                            record.update(run_case(block, x, mode, device, args.warmup, args.iters))
+                            results.append(record)
+    report = json.dumps({'environment': environment(device), 'sparsity_term': args.sparsity_term, 'results': results}, indent=2)
+    if args.output is None:
+        print(report)
+    else:
+        with open(args.output, 'w') as f:
+            f.write(report + '\n')
+
+
+if __name__ == '__main__':
+    main()
@@ -3,7 +3,7 @@ MODULE_VERSION = '2.3'
 #DO  NOT CHANGE ON EARLIER STANDARDS PLEASE
 #(We use c++17 for using "constexpr" in our code)
 STD_VERSION = "c++17"
-PYTORCH_VERSION = "1.7"
+PYTORCH_VERSION = "2.1"
 
 
 import sys, os, copy
@@ -48,10 +48,11 @@ def get_extensions():
 
     sources = list(extensions_dir.glob('*.cpp'))
     sources += list((extensions_dir / 'cpu').glob('*.cpp')) + list((extensions_dir / 'quantized').glob('*.cpp'))
+    sources += list((extensions_dir / 'meta').glob('*.cpp'))
 
     extension = CppExtension
 
-    define_macros = []
+    define_macros = [('WITH_PYTHON', None)]
     extra_compile_args = {'cxx':[f'-std={STD_VERSION}']}
 
     parallel_method = ['-DAT_PARALLEL_NATIVE=1']
@@ -0,0 +1,90 @@
+"""
+    Round trip of ONNX export: ONNX Runtime output of exported Shift2d must equal local shift2d for every
+    padding mode, stride and channel permutation, with both lowerings(Pad + Slice/Concat and Pad + GatherND).
+        python -m pytest test/test_onnx.py
+"""
+import io
+import pytest
+import torch
+from torch import nn
+
+onnxruntime = pytest.importorskip('onnxruntime')
+pytest.importorskip('onnx')
+
+from torchshifts import Shift2d
+from torchshifts.extension import _HAS_OPS
+from torchshifts.functional import shift2d_func
+from torchshifts.modules.shifts import paddings_dict
+from torchshifts.onnx import register_onnx_symbolics, export_constants, shift_plan
+
+pytestmark = pytest.mark.skipif(not _HAS_OPS, reason='torchshifts ops are not built')
+
+OPSET = 13
+SIZE = (2, 12, 9, 11)
+
+
+class _Output(nn.Module):
+    # Shift modules return (output, loss)
+    def __init__(self, shift):
+        super(_Output, self).__init__()
+        self.shift = shift
+
+    def forward(self, x):
+        return self.shift(x)[0]
+
+
+def _make_shift(padding, stride, channel_shuffle, n_distinct):
+    torch.manual_seed(0)
+    shift = Shift2d(SIZE[1], padding=padding, stride=stride, channel_shuffle=channel_shuffle).eval()
+    # integer shifts smaller than the spatial sizes(Reflect, Symmetric and Periodic lowering limit),
+    # n_distinct controls the node count of slices and so the chosen lowering
+    values = torch.randint(-3, 4, (n_distinct, 2)).float()
+    shift.weight.data.copy_(values[torch.arange(SIZE[1]) % n_distinct])
+    return shift
+
+
+def _run_onnx(module, x, dynamic):
+    register_onnx_symbolics(OPSET)
+    buffer = io.BytesIO()
+    dynamic_axes = {'x': {2: 'h', 3: 'w'}, 'y': {2: 'h', 3: 'w'}} if dynamic else None
+    with export_constants(module):
+        torch.onnx.export(module, (x,), buffer, opset_version=OPSET, input_names=['x'], output_names=['y'],
+                          dynamic_axes=dynamic_axes)
+    session = onnxruntime.InferenceSession(buffer.getvalue(), providers=['CPUExecutionProvider'])
+    return torch.from_numpy(session.run(None, {'x': x.numpy()})[0]), buffer.getvalue()
+
+
+def _node_types(model_bytes):
+    import onnx
+    return [node.op_type for node in onnx.load_from_string(model_bytes).graph.node]
+
+
+@pytest.mark.parametrize('padding', list(paddings_dict.keys()))
+@pytest.mark.parametrize('stride', [1, 2])
+@pytest.mark.parametrize('channel_shuffle', [None, 3])
+@pytest.mark.parametrize('n_distinct', [2, 12])
+@pytest.mark.parametrize('dynamic', [False, True])
+def test_roundtrip(padding, stride, channel_shuffle, n_distinct, dynamic):
+    shift = _make_shift(padding, stride, channel_shuffle, n_distinct)
+    module = _Output(shift)
+    x = torch.randn(*SIZE)
+    with torch.no_grad():
+        expected = shift2d_func(x, shift.weight, paddings_dict[padding], False, stride, 1, None, shift.channel_perm)
+        assert torch.equal(module(x), expected)
+    actual, model_bytes = _run_onnx(module, x, dynamic)
+    assert actual.shape == expected.shape
+    assert torch.allclose(actual, expected)
+    # many distinct shifts with static sizes go to GatherND, otherwise(and with dynamic sizes) to slices
+    uses_gather_nd = 'GatherND' in _node_types(model_bytes)
+    assert uses_gather_nd == ((n_distinct == 12) and not dynamic)
+
+
+def test_shift_plan_node_counts():
+    few = [(0, 1), (0, 1), (1, 0), (1, 0)]
+    assert shift_plan(few, gather_nd=True)[0] == 'slices'
+    interleaved = [(0, 1), (1, 0)] * 4
+    lowering, order, inverse, runs = shift_plan(interleaved)
+    assert lowering == 'slices' and order is not None and len(runs) == 2
+    many = [(c // 3 - 2, c % 3 - 1) for c in range(12)]
+    assert shift_plan(many, gather_nd=True)[0] == 'gather_nd'
+    assert shift_plan(many, gather_nd=False)[0] == 'slices'
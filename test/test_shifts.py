@@ -0,0 +1,415 @@
+"""
+    Consistency of shift variants: every specialized path must give the same output and gradients
+    as the plain shift{1,2,3}d_func it replaces, every autograd Function passes gradcheck where its backward is exact.
+        python -m pytest test/test_shifts.py
+"""
+import pytest
+import torch
+from torch.autograd import gradcheck
+
+from torchshifts.extension import _HAS_OPS
+from torchshifts.functional import (shift1d_func, shift2d_func, shift3d_func, shiftnd_func,
+                                    shift1d_accumulate_func, shift2d_accumulate_func, shift3d_accumulate_func,
+                                    shift1d_multi_func, shift2d_multi_func, shift3d_multi_func,
+                                    shift1d_blocked_func, shift2d_blocked_func, shift3d_blocked_func,
+                                    shift1d_packed_func, shift2d_packed_func, shift3d_packed_func,
+                                    shift1d_grouped_func, shift2d_grouped_func, shift3d_grouped_func,
+                                    shift1d_lowmem_func, shift2d_lowmem_func, shift3d_lowmem_func,
+                                    shift3d_sparse_func, pack_samples, unpack_samples, sparsity_l1_grad,
+                                    contiguous_groups)
+from torchshifts.modules import Shift1d, Shift2d, Shift3d
+from torchshifts.recompute import recompute_shifts
+
+pytestmark = pytest.mark.skipif(not _HAS_OPS, reason='torchshifts ops are not built')
+
+FUNCS = {1: shift1d_func, 2: shift2d_func, 3: shift3d_func}
+ACCUMULATE_FUNCS = {1: shift1d_accumulate_func, 2: shift2d_accumulate_func, 3: shift3d_accumulate_func}
+MULTI_FUNCS = {1: shift1d_multi_func, 2: shift2d_multi_func, 3: shift3d_multi_func}
+BLOCKED_FUNCS = {1: shift1d_blocked_func, 2: shift2d_blocked_func, 3: shift3d_blocked_func}
+PACKED_FUNCS = {1: shift1d_packed_func, 2: shift2d_packed_func, 3: shift3d_packed_func}
+GROUPED_FUNCS = {1: shift1d_grouped_func, 2: shift2d_grouped_func, 3: shift3d_grouped_func}
+LOWMEM_FUNCS = {1: shift1d_lowmem_func, 2: shift2d_lowmem_func, 3: shift3d_lowmem_func}
+MODULES = {1: Shift1d, 2: Shift2d, 3: Shift3d}
+SIZES = {1: (2, 5, 13), 2: (2, 5, 9, 11), 3: (2, 3, 7, 6, 5)}
+# large enough to be split between threads
+LARGE_SIZES = {1: (4, 16, 1024), 2: (4, 16, 32, 32), 3: (2, 8, 16, 16, 16)}
+# gradcheck is slow: a few points per axis
+SMALL_SIZES = {1: (2, 3, 6), 2: (2, 3, 5, 4), 3: (1, 2, 4, 3, 4)}
+PADDINGS = [0, 1, 2, 3, 4]
+# backward of the shifts is the exact adjoint only for integer shifts with zeros or periodic padding,
+# other cases use the interpolation surrogate and are compared with shift{1,2,3}d_func instead of gradcheck
+EXACT_PADDINGS = [0, 2]
+
+
+def _inputs(dim, active, per_sample=False):
+    torch.manual_seed(dim)
+    x = torch.randn(SIZES[dim], dtype=torch.float64, requires_grad=True)
+    shape = (SIZES[dim][0], SIZES[dim][1], dim) if per_sample else (SIZES[dim][1], dim)
+    w = torch.empty(shape, dtype=torch.float64).uniform_(-3, 3)
+    if not active:
+        # integer shifts away from .5: rounding does not depend on the last bits
+        w = w.round()
+    return x, w.requires_grad_()
+
+
+def _weights(shape, active):
+    w = torch.empty(shape, dtype=torch.float64).uniform_(-3, 3)
+    if active:
+        # fractional parts away from 0 and 1: finite differences do not cross the integer points
+        return w.floor() + torch.empty(shape, dtype=torch.float64).uniform_(0.2, 0.8)
+    return w.round()
+
+
+def _grads(out, inputs):
+    torch.manual_seed(1)
+    return torch.autograd.grad(out, inputs, torch.randn_like(out))
+
+
+def _assert_same(actual, expected):
+    assert actual.shape == expected.shape
+    assert torch.allclose(actual, expected, atol=1e-10), (actual - expected).abs().max()
+
+
+@pytest.mark.parametrize('dim', [1, 2, 3])
+@pytest.mark.parametrize('padding', PADDINGS)
+@pytest.mark.parametrize('active', [False, True])
+@pytest.mark.parametrize('stride', [2, 3])
+def test_stride_equals_slicing(dim, padding, active, stride):
+    # output with stride s is the stride 1 output sliced by [::s] in forward and in backward
+    x, w = _inputs(dim, active)
+    out = FUNCS[dim](x, w, padding, active, stride=stride)
+    ref = FUNCS[dim](x, w, padding, active)[(Ellipsis,) + (slice(None, None, stride),)*dim]
+    _assert_same(out, ref)
+    for actual, expected in zip(_grads(out, (x, w)), _grads(ref, (x, w))):
+        _assert_same(actual, expected)
+
+
+@pytest.mark.parametrize('dim', [1, 2, 3])
+@pytest.mark.parametrize('padding', PADDINGS)
+@pytest.mark.parametrize('active', [False, True])
+@pytest.mark.parametrize('per_sample', [False, True])
+def test_rank_generic(dim, padding, active, per_sample):
+    x, w = _inputs(dim, active, per_sample)
+    out = shiftnd_func(x, w, padding, active)
+    ref = FUNCS[dim](x, w, padding, active)
+    _assert_same(out, ref)
+    for actual, expected in zip(_grads(out, (x, w)), _grads(ref, (x, w))):
+        _assert_same(actual, expected)
+
+
+@pytest.mark.parametrize('dim', [1, 2, 3])
+@pytest.mark.parametrize('active', [False, True])
+@pytest.mark.parametrize('per_sample', [False, True])
+@pytest.mark.parametrize('channels_last', [False, True])
+def test_threads_agree(dim, active, per_sample, channels_last):
+    # fused backward sums weight gradients of parallel tiles: must not depend on the number of threads
+    if channels_last and dim == 1:
+        pytest.skip('no channels last format for 3D tensors')
+    torch.manual_seed(dim)
+    x = torch.randn(LARGE_SIZES[dim], dtype=torch.float64)
+    if channels_last:
+        x = x.contiguous(memory_format=torch.channels_last if dim == 2 else torch.channels_last_3d)
+    x.requires_grad_()
+    n, c = LARGE_SIZES[dim][:2]
+    w = _weights((n, c, dim) if per_sample else (c, dim), active).requires_grad_()
+    n_threads = torch.get_num_threads()
+    try:
+        results = []
+        for threads in [1, max(n_threads, 4)]:
+            torch.set_num_threads(threads)
+            out = FUNCS[dim](x, w, 0, active)
+            results.append((out,) + _grads(out, (x, w)))
+    finally:
+        torch.set_num_threads(n_threads)
+    for actual, expected in zip(*results):
+        assert torch.allclose(actual, expected, atol=1e-8), (actual - expected).abs().max()
+
+
+@pytest.mark.parametrize('dim', [1, 2, 3])
+@pytest.mark.parametrize('padding', PADDINGS)
+@pytest.mark.parametrize('active', [False, True])
+@pytest.mark.parametrize('sparsity', [0., 1e-2])
+def test_fused_sparsity(dim, padding, active, sparsity):
+    # sparsity of the op adds sparsity*sign(w) to weight gradient, i.e. gradient of sparsity*|w|.sum()
+    x, w = _inputs(dim, active)
+    out = FUNCS[dim](x, w, padding, active, sparsity=sparsity)
+    ref = FUNCS[dim](x, w, padding, active)
+    _assert_same(out, ref)
+    grad_x, grad_w = _grads(out, (x, w))
+    ref_x, ref_w = _grads(ref, (x, w))
+    _assert_same(grad_x, ref_x)
+    _assert_same(grad_w, ref_w + sparsity * w.sign())
+
+
+@pytest.mark.parametrize('dim', [1, 2, 3])
+@pytest.mark.parametrize('groups', [None, 2])
+@pytest.mark.parametrize('saved_input', ['full', 'bf16'])
+def test_module_fused_sparsity(dim, groups, saved_input):
+    # fused_sparsity=True gives the same weight gradient as adding the returned loss
+    x, _ = _inputs(dim, False)
+    grads = []
+    for fused in [False, True]:
+        torch.manual_seed(0)
+        layer = MODULES[dim](SIZES[dim][1], sparsity_term=1e-2, active_flag=True, groups=groups,
+                             saved_input=saved_input, fused_sparsity=fused).double()
+        out, loss = layer(x)
+        assert (loss is None) == fused
+        torch.manual_seed(1)
+        total = (out * torch.randn_like(out)).sum()
+        grads.append(torch.autograd.grad(total if fused else total + loss, layer.weight)[0])
+    _assert_same(grads[1], grads[0])
+
+
+@pytest.mark.parametrize('dim', [1, 2, 3])
+@pytest.mark.parametrize('padding', PADDINGS)
+@pytest.mark.parametrize('active', [False, True])
+@pytest.mark.parametrize('alpha,beta', [(1., 1.), (0.5, 2.), (-1., 0.)])
+def test_accumulate(dim, padding, active, alpha, beta):
+    x, w = _inputs(dim, active)
+    base = torch.randn(SIZES[dim], dtype=torch.float64, requires_grad=True)
+    out = ACCUMULATE_FUNCS[dim](base.clone(), x, w, padding, active, alpha, beta)
+    ref = beta * base + alpha * FUNCS[dim](x, w, padding, active)
+    _assert_same(out, ref)
+    for actual, expected in zip(_grads(out, (base, x, w)), _grads(ref, (base, x, w))):
+        _assert_same(actual, expected)
+
+
+@pytest.mark.parametrize('dim', [1, 2, 3])
+@pytest.mark.parametrize('padding', PADDINGS)
+@pytest.mark.parametrize('active', [False, True])
+def test_multi(dim, padding, active):
+    x, _ = _inputs(dim, active)
+    w = _weights((3, SIZES[dim][1], dim), active).requires_grad_()
+    out = MULTI_FUNCS[dim](x, w, padding, active)
+    ref = torch.cat([FUNCS[dim](x, w_k, padding, active) for w_k in w], dim=1)
+    _assert_same(out, ref)
+    for actual, expected in zip(_grads(out, (x, w)), _grads(ref, (x, w))):
+        _assert_same(actual, expected)
+
+
+@pytest.mark.parametrize('dim', [1, 2, 3])
+@pytest.mark.parametrize('padding', PADDINGS)
+@pytest.mark.parametrize('active', [False, True])
+@pytest.mark.parametrize('block', [2, 8])
+@pytest.mark.parametrize('stride', [1, 2])
+def test_blocked(dim, padding, active, block, stride):
+    # [N, C/b, *spatial, b] layout with the last block padded by zero channels
+    x, w = _inputs(dim, active)
+    n, c, spatial = SIZES[dim][0], SIZES[dim][1], SIZES[dim][2:]
+    blocks = -(-c // block)
+    padded = torch.cat([x, x.new_zeros((n, blocks * block - c) + spatial)], dim=1)
+    x_blocked = padded.view((n, blocks, block) + spatial).movedim(2, -1).contiguous()
+    out = BLOCKED_FUNCS[dim](x_blocked, w, padding, active, stride=stride)
+    out = out.movedim(-1, 2).reshape((n, blocks * block) + out.shape[2:-1])[:, :c]
+    ref = FUNCS[dim](x, w, padding, active, stride=stride)
+    _assert_same(out, ref)
+    for actual, expected in zip(_grads(out, (x, w)), _grads(ref, (x, w))):
+        _assert_same(actual, expected)
+
+
+@pytest.mark.parametrize('dim', [1, 2, 3])
+@pytest.mark.parametrize('padding', PADDINGS)
+@pytest.mark.parametrize('active', [False, True])
+@pytest.mark.parametrize('contiguous', [False, True])
+def test_grouped(dim, padding, active, contiguous):
+    x, _ = _inputs(dim, active)
+    c = SIZES[dim][1]
+    groups = contiguous_groups(c, 2) if contiguous else torch.arange(c) % 2
+    w = _weights((2, dim), active).requires_grad_()
+    out = GROUPED_FUNCS[dim](x, w, groups, padding, active)
+    ref = FUNCS[dim](x, w[groups], padding, active)
+    _assert_same(out, ref)
+    for actual, expected in zip(_grads(out, (x, w)), _grads(ref, (x, w))):
+        _assert_same(actual, expected)
+
+
+@pytest.mark.parametrize('dim', [1, 2, 3])
+@pytest.mark.parametrize('active', [False, True])
+def test_grouped_sparsity_l1_grad(dim, active):
+    # weights passed through sparsity_l1_grad get gradient of sparsity*|w|.sum() in addition
+    x, _ = _inputs(dim, active)
+    groups = contiguous_groups(SIZES[dim][1], 2)
+    w = _weights((2, dim), active).requires_grad_()
+    out = GROUPED_FUNCS[dim](x, sparsity_l1_grad(w, 1e-2), groups, 0, active)
+    ref = GROUPED_FUNCS[dim](x, w, groups, 0, active)
+    _assert_same(out, ref)
+    torch.manual_seed(1)
+    grad = torch.randn_like(out)
+    actual = torch.autograd.grad((out * grad).sum(), w)[0]
+    expected = torch.autograd.grad((ref * grad).sum() + 1e-2 * w.abs().sum(), w)[0]
+    _assert_same(actual, expected)
+
+
+def _samples(dim, c=3):
+    torch.manual_seed(dim)
+    # spatial sizes differ between samples and axes, at least 2 points per axis
+    return [torch.randn((c,) + tuple(torch.randint(2, 9, (dim,)).tolist()), dtype=torch.float64, requires_grad=True)
+            for _ in range(3)]
+
+
+@pytest.mark.parametrize('dim', [1, 2, 3])
+@pytest.mark.parametrize('padding', PADDINGS)
+@pytest.mark.parametrize('active', [False, True])
+def test_packed(dim, padding, active):
+    samples = _samples(dim)
+    w = _weights((3, dim), active).requires_grad_()
+    packed, sizes = pack_samples(samples)
+    outs = unpack_samples(PACKED_FUNCS[dim](packed, sizes, w, padding, active), sizes, 3)
+    refs = [FUNCS[dim](s[None], w, padding, active)[0] for s in samples]
+    torch.manual_seed(1)
+    grads = [torch.randn_like(ref) for ref in refs]
+    for out, ref in zip(outs, refs):
+        _assert_same(out, ref)
+    actual = torch.autograd.grad(sum((out * g).sum() for out, g in zip(outs, grads)), samples + [w])
+    expected = torch.autograd.grad(sum((ref * g).sum() for ref, g in zip(refs, grads)), samples + [w])
+    for a, e in zip(actual, expected):
+        _assert_same(a, e)
+
+
+@pytest.mark.parametrize('dim', [1, 2, 3])
+@pytest.mark.parametrize('padding', PADDINGS)
+@pytest.mark.parametrize('active', [False, True])
+@pytest.mark.parametrize('saved_input', ['full', 'bf16', 'int8'])
+def test_lowmem(dim, padding, active, saved_input):
+    # output and input gradient do not use the saved input: exact, weight gradient is exact only for 'full'
+    x, w = _inputs(dim, active)
+    out = LOWMEM_FUNCS[dim](x, w, padding, active, saved_input)
+    ref = FUNCS[dim](x, w, padding, active)
+    _assert_same(out, ref)
+    grad_x, grad_w = _grads(out, (x, w))
+    ref_x, ref_w = _grads(ref, (x, w))
+    _assert_same(grad_x, ref_x)
+    if saved_input == 'full':
+        _assert_same(grad_w, ref_w)
+    else:
+        assert (grad_w - ref_w).norm() <= 5e-2 * ref_w.norm()
+
+
+def _voxels(n_voxels=40, c=4, spatial_size=(5, 6, 4), batch=2):
+    torch.manual_seed(3)
+    index = torch.randperm(batch * spatial_size[0] * spatial_size[1] * spatial_size[2])[:n_voxels]
+    coords = []
+    for size in reversed(spatial_size):
+        coords.insert(0, index % size)
+        index = index // size
+    coords = torch.stack([index] + coords, dim=1)
+    features = torch.randn(n_voxels, c, dtype=torch.float64, requires_grad=True)
+    return features, coords
+
+
+def _densify(features, coords, spatial_size, batch=2):
+    dense = features.new_zeros((batch,) + tuple(spatial_size) + (features.shape[1],))
+    dense = dense.index_put(tuple(coords.t()), features)
+    return dense.permute(0, 4, 1, 2, 3)
+
+
+@pytest.mark.parametrize('active', [False, True])
+def test_sparse(active):
+    # dense shift with zeros padding of the scattered features, gathered back at the voxels
+    spatial_size = (5, 6, 4)
+    features, coords = _voxels()
+    w = _weights((features.shape[1], 3), active).requires_grad_()
+    out = shift3d_sparse_func(features, coords, spatial_size, w, active)
+    dense = shift3d_func(_densify(features, coords, spatial_size), w, 0, active)
+    ref = dense.permute(0, 2, 3, 4, 1)[tuple(coords.t())]
+    _assert_same(out, ref)
+    for actual, expected in zip(_grads(out, (features, w)), _grads(ref, (features, w))):
+        _assert_same(actual, expected)
+
+
+@pytest.mark.parametrize('dim', [1, 2, 3])
+def test_recompute_shifts(dim):
+    # shifted tensor saved by the next layer is recomputed in backward: same gradients
+    x, _ = _inputs(dim, False)
+    grads = []
+    for recompute in [False, True]:
+        torch.manual_seed(0)
+        layer = MODULES[dim](SIZES[dim][1], active_flag=True).double()
+        with recompute_shifts() if recompute else torch.enable_grad():
+            out, _ = layer(x)
+            out = out * out
+        grads.append(_grads(out, (x, layer.weight)))
+    for actual, expected in zip(*grads):
+        _assert_same(actual, expected)
+
+
+def _gradcheck_inputs(dim, active):
+    torch.manual_seed(dim)
+    x = torch.randn(SMALL_SIZES[dim], dtype=torch.float64)
+    w = _weights((SMALL_SIZES[dim][1], dim), active)
+    # input gradient is checked for integer shifts, weight gradient for active ones
+    return (x.requires_grad_(), w) if not active else (x, w.requires_grad_())
+
+
+def _gradcheck_variants(dim, padding, active):
+    """(name, function of (x, w)) for every autograd Function of the shifts"""
+    stride = 2 if not active else 1
+    c = SMALL_SIZES[dim][1]
+    base = torch.randn(SMALL_SIZES[dim], dtype=torch.float64)
+    variants = [
+        ('shift', lambda x, w: FUNCS[dim](x, w, padding, active)),
+        ('strided', lambda x, w: FUNCS[dim](x, w, padding, active, stride=stride)),
+        ('accumulate', lambda x, w: ACCUMULATE_FUNCS[dim](base.clone(), x, w, padding, active, 0.5, 2.)),
+        ('multi', lambda x, w: MULTI_FUNCS[dim](x, torch.stack([w, w.flip(0)]), padding, active)),
+        ('grouped', lambda x, w: GROUPED_FUNCS[dim](x, w[:2], torch.arange(c) % 2, padding, active)),
+        ('lowmem', lambda x, w: LOWMEM_FUNCS[dim](x, w, padding, active, 'full' if active else 'int8')),
+        ('rank_generic', lambda x, w: shiftnd_func(x, w, padding, active)),
+    ]
+    if not active:
+        # sparsity only changes the weight gradient
+        variants.append(('sparsity', lambda x, w: FUNCS[dim](x, w, padding, active, sparsity=1e-2)))
+    if dim == 3:
+        variants.append(('rank_generic_4', lambda x, w: shiftnd_func(x[..., None].expand(x.shape + (3,)),
+                                                                    torch.cat([w, w[:, :1]], dim=1),
+                                                                    padding, active)))
+    return variants
+
+
+@pytest.mark.parametrize('dim', [1, 2, 3])
+@pytest.mark.parametrize('padding', EXACT_PADDINGS)
+@pytest.mark.parametrize('active', [False, True])
+def test_gradcheck(dim, padding, active):
+    x, w = _gradcheck_inputs(dim, active)
+    for name, func in _gradcheck_variants(dim, padding, active):
+        if active:
+            assert gradcheck(lambda w_: func(x, w_), (w,)), name
+        else:
+            assert gradcheck(lambda x_: func(x_, w), (x,)), name
+
+
+@pytest.mark.parametrize('dim', [1, 2, 3])
+@pytest.mark.parametrize('padding', EXACT_PADDINGS)
+@pytest.mark.parametrize('active', [False, True])
+def test_gradcheck_packed(dim, padding, active):
+    samples = [s.detach() for s in _samples(dim, c=2)]
+    packed, sizes = pack_samples(samples)
+    w = _weights((2, dim), active)
+    if active:
+        assert gradcheck(lambda w_: PACKED_FUNCS[dim](packed, sizes, w_, padding, active), (w.requires_grad_(),))
+    else:
+        assert gradcheck(lambda x_: PACKED_FUNCS[dim](x_, sizes, w, padding, active), (packed.requires_grad_(),))
+
+
+@pytest.mark.parametrize('dim', [1, 2, 3])
+@pytest.mark.parametrize('active', [False, True])
+def test_gradcheck_blocked(dim, active):
+    # blocked layout of SMALL_SIZES with block 2
+    _, w = _gradcheck_inputs(dim, active)
+    n, c, spatial = SMALL_SIZES[dim][0], SMALL_SIZES[dim][1], SMALL_SIZES[dim][2:]
+    x = torch.randn((n, -(-c // 2)) + spatial + (2,), dtype=torch.float64)
+    if active:
+        assert gradcheck(lambda w_: BLOCKED_FUNCS[dim](x, w_, 0, active), (w,))
+    else:
+        assert gradcheck(lambda x_: BLOCKED_FUNCS[dim](x_, w, 0, active), (x.requires_grad_(),))
+
+
+@pytest.mark.parametrize('active', [False, True])
+def test_gradcheck_sparse(active):
+    features, coords = _voxels(n_voxels=12, c=2, spatial_size=(4, 3, 3))
+    w = _weights((2, 3), active)
+    if active:
+        features = features.detach()
+        assert gradcheck(lambda w_: shift3d_sparse_func(features, coords, (4, 3, 3), w_, active),
+                         (w.requires_grad_(),))
+    else:
+        assert gradcheck(lambda f_: shift3d_sparse_func(f_, coords, (4, 3, 3), w, active), (features,))
@@ -15,4 +15,5 @@ if (not _HAS_OPS and Path(__file__).parent.resolve() == (Path.cwd() / 'torchshif
     warnings.warn(message)
 
 from torchshifts.modules import Shift1d, Shift2d, Shift3d
-from torchshifts.quantized import quant_mapping
\ No newline at end of file
+from torchshifts.quantized import quant_mapping
+from torchshifts.recompute import recompute_shifts
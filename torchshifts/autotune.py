@@ -0,0 +1,50 @@
+import torch
+from .extension import _assert_has_ops
+
+
+def enable(flag: bool = True) -> None:
+    """
+        Enables(or disables) autotuning of CPU shift kernels.
+        On first call for a new (shape, strides, dtype, padding, active_flag, num_threads) key all
+        kernel strategies are timed and the fastest one is cached in-process.
+        Can be also enabled by TORCHSHIFTS_AUTOTUNE=1 env variable.
+    """
+    _assert_has_ops()
+    torch.ops.torchshifts._autotune_enable(flag)
+
+
+def is_enabled() -> bool:
+    _assert_has_ops()
+    return torch.ops.torchshifts._autotune_enabled()
+
+
+def clear() -> None:
+    """
+        Drops all cached tuning results.
+    """
+    _assert_has_ops()
+    torch.ops.torchshifts._autotune_clear()
+
+
+def cache_size() -> int:
+    _assert_has_ops()
+    return torch.ops.torchshifts._autotune_cache_size()
+
+
+def save_cache(path: str) -> None:
+    """
+        Writes tuning results to text file. Pass it to load_cache(or TORCHSHIFTS_AUTOTUNE_CACHE env variable)
+        in serving process to start with already tuned kernels.
+    """
+    _assert_has_ops()
+    torch.ops.torchshifts._autotune_save(str(path))
+
+
+def load_cache(path: str) -> int:
+    """
+        Merges tuning results from file into the in-process cache.
+        Returns:
+            number of loaded entries
+    """
+    _assert_has_ops()
+    return torch.ops.torchshifts._autotune_load(str(path))
@@ -0,0 +1,185 @@
+#include "shifts_autotune.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+
+namespace shifts {
+    namespace autotune {
+        namespace {
+            struct TuneState {
+                std::mutex lock;
+                std::unordered_map<std::string, Strategy> cache;
+                bool enabled = false;
+
+                TuneState(){
+                    // TORCHSHIFTS_AUTOTUNE=1 enables tuning, TORCHSHIFTS_AUTOTUNE_CACHE=<file> starts warm
+                    const char* flag = std::getenv("TORCHSHIFTS_AUTOTUNE");
+                    enabled = (flag != nullptr) && (std::string(flag) == "1");
+                    const char* path = std::getenv("TORCHSHIFTS_AUTOTUNE_CACHE");
+                    if (path != nullptr){
+                        std::ifstream file(path);
+                        std::string key;
+                        int64_t value;
+                        while (file >> key >> value){
+                            if ((value >= 0) && (value < kNumStrategies)){
+                                cache[key] = static_cast<Strategy>(value);
+                            }
+                        }
+                    }
+                }
+            };
+
+            TuneState& state(){
+                static TuneState instance;
+                return instance;
+            }
+        }
+
+        const char* strategy_name(Strategy strategy){
+            switch (strategy){
+                case Strategy::PerElement: return "per_element";
+                case Strategy::PerPixel: return "per_pixel";
+                case Strategy::Planes: return "planes";
+                case Strategy::ChannelBlocked: return "channel_blocked";
+                case Strategy::Transposed: return "transposed";
+                case Strategy::Serial: return "serial";
+                case Strategy::Tiled: return "tiled";
+            }
+            return "unknown";
+        }
+
+        namespace {
+            bool channels_inner(const torch::Tensor& tensor){
+                if (tensor.is_contiguous(c10::MemoryFormat::ChannelsLast) || tensor.is_contiguous(c10::MemoryFormat::ChannelsLast3d)){
+                    return true;
+                }
+                // 1D has no channels last memory format: NLC(and 1D blocked blocks) by strides
+                return (tensor.dim() == 3) && (tensor.size(1) > 1) && (tensor.stride(1) == 1) && (tensor.stride(2) == tensor.size(1));
+            }
+        }
+
+        Strategy default_strategy(const torch::Tensor& input){
+            return channels_inner(input) ? Strategy::PerPixel : Strategy::PerElement;
+        }
+
+        Strategy default_strategy(const torch::Tensor& input, const torch::Tensor& output){
+            // one side would be walked with a stride of C(or H*W*D) elements per step
+            if ((input.size(1) > 1) && (channels_inner(input) != channels_inner(output))){
+                return Strategy::Tiled;
+            }
+            return default_strategy(input);
+        }
+
+        std::string make_key(const torch::Tensor& input, const torch::Tensor& output,
+                             int64_t nD, int64_t padding_mode, bool active_flag,
+                             c10::IntArrayRef stride){
+            std::ostringstream key;
+            key << nD << "d|" << c10::toString(input.scalar_type()) << "|";
+            for (int64_t d = 0; d < input.dim(); ++d){ key << (d ? "x" : "") << input.size(d); }
+            key << "|";
+            for (int64_t d = 0; d < input.dim(); ++d){ key << (d ? "x" : "") << input.stride(d); }
+            key << "|o";
+            for (int64_t d = 0; d < output.dim(); ++d){ key << (d ? "x" : "") << output.stride(d); }
+            key << "|s";
+            for (size_t d = 0; d < stride.size(); ++d){ key << (d ? "x" : "") << stride[d]; }
+            key << "|p" << padding_mode << "|a" << static_cast<int>(active_flag)
+                << "|t" << at::get_num_threads();
+            return key.str();
+        }
+
+        bool enabled(){
+            TuneState& s = state();
+            std::lock_guard<std::mutex> guard(s.lock);
+            return s.enabled;
+        }
+
+        void set_enabled(bool flag){
+            TuneState& s = state();
+            std::lock_guard<std::mutex> guard(s.lock);
+            s.enabled = flag;
+        }
+
+        bool lookup(const std::string& key, Strategy& strategy){
+            TuneState& s = state();
+            std::lock_guard<std::mutex> guard(s.lock);
+            auto it = s.cache.find(key);
+            if (it == s.cache.end()){ return false; }
+            strategy = it->second;
+            return true;
+        }
+
+        void store(const std::string& key, Strategy strategy){
+            TuneState& s = state();
+            std::lock_guard<std::mutex> guard(s.lock);
+            s.cache[key] = strategy;
+        }
+
+        void clear(){
+            TuneState& s = state();
+            std::lock_guard<std::mutex> guard(s.lock);
+            s.cache.clear();
+        }
+
+        int64_t size(){
+            TuneState& s = state();
+            std::lock_guard<std::mutex> guard(s.lock);
+            return static_cast<int64_t>(s.cache.size());
+        }
+
+        void save(const std::string& path){
+            TuneState& s = state();
+            std::lock_guard<std::mutex> guard(s.lock);
+            std::ofstream file(path, std::ios::trunc);
+            TORCH_CHECK(file.good(), "autotune: cannot open ", path, " for writing");
+            for (const auto& entry : s.cache){
+                file << entry.first << " " << static_cast<int64_t>(entry.second) << "\n";
+            }
+        }
+
+        int64_t load(const std::string& path){
+            TuneState& s = state();
+            std::lock_guard<std::mutex> guard(s.lock);
+            std::ifstream file(path);
+            TORCH_CHECK(file.good(), "autotune: cannot open ", path, " for reading");
+            std::string key;
+            int64_t value;
+            int64_t count = 0;
+            while (file >> key >> value){
+                if ((value >= 0) && (value < kNumStrategies)){
+                    s.cache[key] = static_cast<Strategy>(value);
+                    ++count;
+                }
+            }
+            return count;
+        }
+    }
+}
+
+
+void autotune_enable(bool flag){
+    shifts::autotune::set_enabled(flag);
+}
+
+bool autotune_enabled(){
+    return shifts::autotune::enabled();
+}
+
+void autotune_clear(){
+    shifts::autotune::clear();
+}
+
+int64_t autotune_cache_size(){
+    return shifts::autotune::size();
+}
+
+void autotune_save(const std::string& path){
+    shifts::autotune::save(path);
+}
+
+int64_t autotune_load(const std::string& path){
+    return shifts::autotune::load(path);
+}
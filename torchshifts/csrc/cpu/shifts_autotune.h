@@ -0,0 +1,50 @@
+#pragma once
+#include <torch/torch.h>
+#include "../global_scope.h"
+
+
+namespace shifts {
+    namespace autotune {
+        // CPU traversal strategies for the shift kernels.
+        // Every strategy writes every output element, so they are interchangeable.
+        enum class Strategy : int64_t {PerElement = 0,     // NCHWD traversal, partition from the cost model
+                                       PerPixel = 1,       // NHWDC traversal, partition from the cost model
+                                       Planes = 2,         // NCHWD traversal, (n, group of planes) per task
+                                       ChannelBlocked = 3, // NHWDC traversal, (n, cache line of channels) per task
+                                       Transposed = 4,     // temporary channels-innermost copy + PerPixel
+                                       Serial = 5,         // NCHWD traversal on the calling thread
+                                       Tiled = 6};         // (cache line of channels) x (cache line of pixels) tiles
+        constexpr int64_t kNumStrategies = 7;
+
+        API_EXPORT const char* strategy_name(Strategy strategy);
+
+        // Layout driven choice used when autotuning is disabled
+        API_EXPORT Strategy default_strategy(const torch::Tensor& input);
+        // Same for a given output: Tiled when the shift also converts between NCHWD and NHWDC
+        API_EXPORT Strategy default_strategy(const torch::Tensor& input, const torch::Tensor& output);
+
+        // Key is (op rank, dtype, sizes, strides, output strides, output stride, padding, active, threads)
+        API_EXPORT std::string make_key(const torch::Tensor& input, const torch::Tensor& output,
+                                        int64_t nD, int64_t padding_mode, bool active_flag,
+                                        c10::IntArrayRef stride);
+
+        API_EXPORT bool enabled();
+        API_EXPORT void set_enabled(bool flag);
+        API_EXPORT bool lookup(const std::string& key, Strategy& strategy);
+        API_EXPORT void store(const std::string& key, Strategy strategy);
+        API_EXPORT void clear();
+        API_EXPORT int64_t size();
+        // Plain text, one "<key> <strategy>" entry per line
+        API_EXPORT void save(const std::string& path);
+        API_EXPORT int64_t load(const std::string& path);
+    }
+}
+
+
+// Thin wrappers registered as torchshifts ops
+API_EXPORT void autotune_enable(bool flag);
+API_EXPORT bool autotune_enabled();
+API_EXPORT void autotune_clear();
+API_EXPORT int64_t autotune_cache_size();
+API_EXPORT void autotune_save(const std::string& path);
+API_EXPORT int64_t autotune_load(const std::string& path);
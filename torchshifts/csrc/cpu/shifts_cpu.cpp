@@ -1,21 +1,91 @@
 #ifndef _SHIFTS_CPU
 #define _SHIFTS_CPU
 
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <type_traits>
+
+#include <torch/library.h>
 #include "shifts_cpu.h"
+#include "shifts_autotune.h"
+#include "shifts_partition.h"
+#include "shifts_sparse.h"
+#include "../shifts_params.h"
 #include "../kernels/shifts_kernels.h"
 
+#define SHIFTS_AUTOTUNE_REPEATS 3
+
+using shifts::autotune::Strategy;
+using shifts::partition::Axis;
+using shifts::partition::Geometry;
+using shifts::partition::Plan;
+using shifts::sparse::ShiftGroup;
+using shifts::sparse::VoxelHash;
 
 
+API_INLINE bool strategy_channels_inner(Strategy strategy){
+    return (strategy == Strategy::PerPixel) || (strategy == Strategy::ChannelBlocked) || (strategy == Strategy::Transposed);
+}
+
+API_INLINE Plan strategy_plan(Strategy strategy, const Geometry& geometry){
+    switch (strategy){
+        case Strategy::Planes:
+        case Strategy::ChannelBlocked:
+            return shifts::partition::make_plan(Axis::ChannelBlock, geometry);
+        case Strategy::Serial:
+            return shifts::partition::make_plan(Axis::Serial, geometry);
+        default:
+            return shifts::partition::choose_plan(geometry);
+    }
+}
+
+
+// Boundaries of runs of consecutive channels with equal shifts for [C, nD] integer weights,
+// empty when runs are too short to pay off
+API_INLINE std::vector<int64_t> shift_runs(const torch::Tensor& iweights){
+    torch::Tensor w = iweights.contiguous();
+    int64_t sizeC = w.size(0);
+    int64_t sizeS = w.size(1);
+    const int64_t *w_ptr = w.data_ptr<int64_t>();
+    std::vector<int64_t> runs = {0};
+    for (int64_t c = 1; c < sizeC; ++c){
+        if (!std::equal(w_ptr + c*sizeS, w_ptr + (c + 1)*sizeS, w_ptr + (c - 1)*sizeS)){
+            runs.push_back(c);
+        }
+    }
+    runs.push_back(sizeC);
+    if (2*(static_cast<int64_t>(runs.size()) - 1) > sizeC){
+        runs.clear();
+    }
+    return runs;
+}
+
 
 template <typename scalar_t, int32_t kSpatialDim>
 API_INLINE void _shifts_forward_cpu(const torch::Tensor& input, const torch::Tensor& iweights,
                                     const torch::Tensor& dweights, torch::Tensor& output,
-                                    BIPadding padding_mode, bool active){
+                                    const std::array<int64_t, 3>& steps, scalar_t alpha, scalar_t beta,
+                                    BIPadding padding_mode, bool active, Strategy strategy,
+                                    const std::vector<int64_t>& runs, const int64_t* perm = nullptr){
+    if (strategy == Strategy::Transposed)
+    {// Temporary copy with channels innermost, then walk it pixel by pixel
+        torch::Tensor input_t = input.movedim(1, -1).contiguous().movedim(-1, 1);
+        _shifts_forward_cpu<scalar_t, kSpatialDim>(input_t, iweights, dweights, output, steps, alpha, beta,
+                                                   padding_mode, active, Strategy::PerPixel, runs, perm);
+        return;
+    }
     int64_t sizeN = input.size(0);
     int64_t sizeC = input.size(1);
     int64_t sizeH = input.size(2);
     int64_t sizeW = kSpatialDim < 2 ? 1 : input.size(3);
     int64_t sizeD = kSpatialDim < 3 ? 1 : input.size(4);
+    int64_t outH = output.size(2);
+    int64_t outW = kSpatialDim < 2 ? 1 : output.size(3);
+    int64_t outD = kSpatialDim < 3 ? 1 : output.size(4);
+    int64_t stepH = steps[0];
+    int64_t stepW = steps[1];
+    int64_t stepD = steps[2];
     int64_t input_sN = input.stride(0);
     int64_t input_sC = input.stride(1);
     int64_t input_sH = input.stride(2);
@@ -29,42 +99,105 @@ API_INLINE void _shifts_forward_cpu(const torch::Tensor& input, const torch::Ten
     scalar_t *input_ptr = input.data_ptr<scalar_t>();
     scalar_t *output_ptr = output.data_ptr<scalar_t>();
     int64_t *weights_ptr = iweights.data_ptr<int64_t>();
-    int64_t weights_sC = iweights.stride(0);
-    int64_t weights_sS = iweights.stride(1);
+    int64_t weights_sN = iweights.stride(0);
+    int64_t weights_sC = iweights.stride(1);
+    int64_t weights_sS = iweights.stride(2);
     scalar_t *dweights_ptr = dweights.data_ptr<scalar_t>();
-    int64_t dweights_sC = dweights.stride(0);
-    int64_t dweights_sS = dweights.stride(1);
-    if (input.is_contiguous(c10::MemoryFormat::ChannelsLast) || input.is_contiguous(c10::MemoryFormat::ChannelsLast3d))
+    int64_t dweights_sN = dweights.stride(0);
+    int64_t dweights_sC = dweights.stride(1);
+    int64_t dweights_sS = dweights.stride(2);
+    Geometry geometry{sizeN, sizeC, outH, outW*outD, static_cast<int64_t>(sizeof(scalar_t)),
+                      strategy_channels_inner(strategy), active ? (1 << kSpatialDim) : 1};
+    Plan plan = strategy_plan(strategy, geometry);
+    if (geometry.channels_inner && !runs.empty())
+    {// Path for NDHWC with runs of channels sharing a shift, runs[r]..runs[r+1]-1
+        shifts::partition::for_each_tile(plan, [&](int64_t n, int64_t c_begin, int64_t c_end, int64_t i_begin, int64_t i_end){
+            for (int64_t i = i_begin; i < i_end; ++i) {
+                for (int64_t j = 0; j < outW; ++j) {
+                    for (int64_t k = 0; k < outD; ++k) {
+                        for (size_t r = 0; r + 1 < runs.size(); ++r) {
+                            int64_t run_begin = std::max(runs[r], c_begin);
+                            int64_t run_end = std::min(runs[r + 1], c_end);
+                            if (run_begin >= run_end) {continue;}
+                            shift_forward_run_nhwdc<scalar_t, int64_t>(input_ptr, output_ptr, weights_ptr + n*weights_sN,
+                                                                       n, i, j, k, run_begin, run_end, sizeH, sizeW, sizeD,
+                                                                       stepH, stepW, stepD,
+                                                                       input_sN, input_sC, input_sH, input_sW, input_sD,
+                                                                       output_sN, output_sC, output_sH, output_sW, output_sD,
+                                                                       weights_sC, weights_sS,
+                                                                       alpha, beta, padding_mode);
+                        }
+                    }
+                }
+            }
+        });
+    } else if (strategy == Strategy::Tiled)
+    {// Layout conversion(NCHWD <-> NDHWC): both sides of a block x block tile stay in cache
+        const int64_t block = std::max<int64_t>(64 / static_cast<int64_t>(sizeof(scalar_t)), 1);
+        const int64_t sizeP = outW*outD;
+        shifts::partition::for_each_tile(plan, [&](int64_t n, int64_t c_begin, int64_t c_end, int64_t i_begin, int64_t i_end){
+            for (int64_t i = i_begin; i < i_end; ++i) {
+                for (int64_t p_begin = 0; p_begin < sizeP; p_begin += block) {
+                    int64_t p_end = std::min(p_begin + block, sizeP);
+                    for (int64_t cb = c_begin; cb < c_end; cb += block) {
+                        int64_t cb_end = std::min(cb + block, c_end);
+                        for (int64_t c = cb; c < cb_end; ++c) {
+                            scalar_t *output_c = perm ? output_ptr + (perm[c] - c)*output_sC : output_ptr;
+                            for (int64_t p = p_begin; p < p_end; ++p) {
+                                shift_forward_kernel_nchwd<scalar_t, int64_t>(input_ptr, output_c,
+                                                                              weights_ptr + n*weights_sN, dweights_ptr + n*dweights_sN,
+                                                                              n, c, i, p / outD, p % outD, sizeH, sizeW, sizeD,
+                                                                              stepH, stepW, stepD,
+                                                                              input_sN, input_sC, input_sH, input_sW, input_sD,
+                                                                              output_sN, output_sC, output_sH, output_sW, output_sD,
+                                                                              weights_sC, weights_sS, dweights_sC, dweights_sS,
+                                                                              alpha, beta, padding_mode, active);
+                            }
+                        }
+                    }
+                }
+            }
+        });
+    } else if (geometry.channels_inner)
     {// Path for NDHWC
-        at::parallel_for(0, sizeN*sizeH*sizeW*sizeD, 0, [&](int64_t start, int64_t end){
-            for (int64_t index = start; index < end; ++index) {
-                int64_t k = index % sizeD;
-                int64_t j = (index / sizeD) % sizeW;
-                int64_t i = (index / (sizeD*sizeW)) % sizeH;
-                int64_t n = (index / (sizeD*sizeW*sizeH));
-                shift_forward_kernel_nhwdc<scalar_t, int64_t>(input_ptr, output_ptr, weights_ptr, dweights_ptr,
-                                                              n, i, j, k, sizeC, sizeH, sizeW, sizeD,
-                                                              input_sN, input_sC, input_sH, input_sW, input_sD,
-                                                              output_sN, output_sC, output_sH, output_sW, output_sD,
-                                                              weights_sC, weights_sS, dweights_sC, dweights_sS,
-                                                              padding_mode, active);
+        shifts::partition::for_each_tile(plan, [&](int64_t n, int64_t c_begin, int64_t c_end, int64_t i_begin, int64_t i_end){
+            for (int64_t i = i_begin; i < i_end; ++i) {
+                for (int64_t j = 0; j < outW; ++j) {
+                    for (int64_t k = 0; k < outD; ++k) {
+                        // channel range is selected by offsetting the base pointers
+                        shift_forward_kernel_nhwdc<scalar_t, int64_t>(input_ptr + c_begin*input_sC, output_ptr + c_begin*output_sC,
+                                                                      weights_ptr + n*weights_sN + c_begin*weights_sC,
+                                                                      dweights_ptr + n*dweights_sN + c_begin*dweights_sC,
+                                                                      n, i, j, k, c_end - c_begin, sizeH, sizeW, sizeD,
+                                                                      stepH, stepW, stepD,
+                                                                      input_sN, input_sC, input_sH, input_sW, input_sD,
+                                                                      output_sN, output_sC, output_sH, output_sW, output_sD,
+                                                                      weights_sC, weights_sS, dweights_sC, dweights_sS,
+                                                                      alpha, beta, padding_mode, active);
+                    }
+                }
             }
         });
     } else
     {
-        at::parallel_for(0, sizeN*sizeC*sizeH*sizeW*sizeD, 0, [&](int64_t start, int64_t end){
-            for (int64_t index = start; index < end; ++index) {
-                int64_t k = index % sizeD;
-                int64_t j = (index / sizeD) % sizeW;
-                int64_t i = (index / (sizeD*sizeW)) % sizeH;
-                int64_t c = (index / (sizeD*sizeW*sizeH)) % sizeC;
-                int64_t n = (index / (sizeD*sizeW*sizeH*sizeC));
-                shift_forward_kernel_nchwd<scalar_t, int64_t>(input_ptr, output_ptr, weights_ptr, dweights_ptr,
-                                                              n, c, i, j, k, sizeH, sizeW, sizeD,
-                                                              input_sN, input_sC, input_sH, input_sW, input_sD,
-                                                              output_sN, output_sC, output_sH, output_sW, output_sD,
-                                                              weights_sC, weights_sS, dweights_sC, dweights_sS,
-                                                              padding_mode, active);
+        shifts::partition::for_each_tile(plan, [&](int64_t n, int64_t c_begin, int64_t c_end, int64_t i_begin, int64_t i_end){
+            for (int64_t c = c_begin; c < c_end; ++c) {
+                // channel permutation: kernel addresses channel c, base is moved so it lands in perm[c]
+                scalar_t *output_c = perm ? output_ptr + (perm[c] - c)*output_sC : output_ptr;
+                for (int64_t i = i_begin; i < i_end; ++i) {
+                    for (int64_t j = 0; j < outW; ++j) {
+                        for (int64_t k = 0; k < outD; ++k) {
+                            shift_forward_kernel_nchwd<scalar_t, int64_t>(input_ptr, output_c,
+                                                                          weights_ptr + n*weights_sN, dweights_ptr + n*dweights_sN,
+                                                                          n, c, i, j, k, sizeH, sizeW, sizeD,
+                                                                          stepH, stepW, stepD,
+                                                                          input_sN, input_sC, input_sH, input_sW, input_sD,
+                                                                          output_sN, output_sC, output_sH, output_sW, output_sD,
+                                                                          weights_sC, weights_sS, dweights_sC, dweights_sS,
+                                                                          alpha, beta, padding_mode, active);
+                        }
+                    }
+                }
             }
         });
     }
@@ -72,17 +205,60 @@ API_INLINE void _shifts_forward_cpu(const torch::Tensor& input, const torch::Ten
 
 
 template <typename scalar_t, int32_t kSpatialDim>
+Strategy _tune_forward_cpu(const torch::Tensor& input, const torch::Tensor& iweights,
+                           const torch::Tensor& dweights, torch::Tensor& output,
+                           const std::array<int64_t, 3>& steps,
+                           BIPadding padding_mode, bool active,
+                           const std::vector<int64_t>& runs){
+    Strategy best = shifts::autotune::default_strategy(input, output);
+    // plain overwrite, so the repeated runs do not depend on each other
+    scalar_t one = static_cast<scalar_t>(1);
+    scalar_t zero = static_cast<scalar_t>(0);
+    double best_time = std::numeric_limits<double>::max();
+    for (int64_t s = 0; s < shifts::autotune::kNumStrategies; ++s){
+        Strategy candidate = static_cast<Strategy>(s);
+        // warm up caches and the thread pool, then keep the fastest of a few runs
+        _shifts_forward_cpu<scalar_t, kSpatialDim>(input, iweights, dweights, output, steps, one, zero,
+                                                       padding_mode, active, candidate, runs);
+        double candidate_time = std::numeric_limits<double>::max();
+        for (int64_t rep = 0; rep < SHIFTS_AUTOTUNE_REPEATS; ++rep){
+            auto t0 = std::chrono::steady_clock::now();
+            _shifts_forward_cpu<scalar_t, kSpatialDim>(input, iweights, dweights, output, steps, one, zero,
+                                                       padding_mode, active, candidate, runs);
+            auto t1 = std::chrono::steady_clock::now();
+            candidate_time = std::min(candidate_time, std::chrono::duration<double>(t1 - t0).count());
+        }
+        if (candidate_time < best_time){
+            best_time = candidate_time;
+            best = candidate;
+        }
+    }
+    return best;
+}
+
+
+// input_t != scalar_t: input saved in low memory mode, input_scale is its per channel scale(or nullptr)
+template <typename scalar_t, int32_t kSpatialDim, typename input_t = scalar_t>
 API_INLINE void _shifts_backward_cpu(const torch::Tensor& grad_input, 
                                      const torch::Tensor& iweights,
                                      const torch::Tensor& dweights,
                                      const torch::Tensor& input, torch::Tensor& grad_output,
-                                     torch::Tensor& grad_weights, BIPadding padding_mode, bool active)
+                                     torch::Tensor& grad_weights, const std::array<int64_t, 3>& steps,
+                                     scalar_t alpha, scalar_t beta,
+                                     BIPadding padding_mode, bool active,
+                                     const scalar_t* input_scale = nullptr)
 {
-    int64_t sizeN = grad_input.size(0);
-    int64_t sizeC = grad_input.size(1);
-    int64_t sizeH = grad_input.size(2);
-    int64_t sizeW = kSpatialDim < 2 ? 1 : grad_input.size(3);
-    int64_t sizeD = kSpatialDim < 3 ? 1 : grad_input.size(4);
+    int64_t sizeN = input.size(0);
+    int64_t sizeC = input.size(1);
+    int64_t sizeH = input.size(2);
+    int64_t sizeW = kSpatialDim < 2 ? 1 : input.size(3);
+    int64_t sizeD = kSpatialDim < 3 ? 1 : input.size(4);
+    int64_t outH = grad_input.size(2);
+    int64_t outW = kSpatialDim < 2 ? 1 : grad_input.size(3);
+    int64_t outD = kSpatialDim < 3 ? 1 : grad_input.size(4);
+    int64_t stepH = steps[0];
+    int64_t stepW = steps[1];
+    int64_t stepD = steps[2];
     int64_t grad_input_sN = grad_input.stride(0);
     int64_t grad_input_sC = grad_input.stride(1);
     int64_t grad_input_sH = grad_input.stride(2);
@@ -99,55 +275,936 @@ API_INLINE void _shifts_backward_cpu(const torch::Tensor& grad_input,
     int64_t grad_output_sW = kSpatialDim < 2 ? 0 : grad_output.stride(3);
     int64_t grad_output_sD = kSpatialDim < 3 ? 0 : grad_output.stride(4);
     int64_t *weights_ptr = iweights.data_ptr<int64_t>();
-    int64_t weights_sC = iweights.stride(0);
-    int64_t weights_sS = iweights.stride(1);
+    int64_t weights_sN = iweights.stride(0);
+    int64_t weights_sC = iweights.stride(1);
+    int64_t weights_sS = iweights.stride(2);
     scalar_t *dweights_ptr = dweights.data_ptr<scalar_t>();
-    int64_t dweights_sC = dweights.stride(0);
-    int64_t dweights_sS = dweights.stride(1);
-    int64_t grad_weights_sC = grad_weights.stride(0);
-    int64_t grad_weights_sS = grad_weights.stride(1);
-    scalar_t *grad_weights_ptr = grad_weights.data_ptr<scalar_t>();
+    int64_t dweights_sN = dweights.stride(0);
+    int64_t dweights_sC = dweights.stride(1);
+    int64_t dweights_sS = dweights.stride(2);
+    scalar_t *grad_input_ptr = grad_input.data_ptr<scalar_t>();
+    input_t *input_ptr = input.data_ptr<input_t>();
+    scalar_t *grad_output_ptr = grad_output.data_ptr<scalar_t>();
+    Geometry geometry{sizeN, sizeC, outH, outW*outD, static_cast<int64_t>(sizeof(scalar_t)),
+                      strategy_channels_inner(shifts::autotune::default_strategy(input)),
+                      (active ? 2 : 1) * (1 << kSpatialDim) + 1};
+    Plan plan = shifts::partition::choose_plan(geometry);
+    // Weight gradients go to a private [sizeNw, C, S] slice of every thread, slices are summed at the end:
+    // tiles of different threads may share channels(Rows axis) or samples(shared weights)
+    int64_t sizeS = grad_weights.size(-1);
+    int64_t sizeNw = (grad_weights.dim() == 3) ? sizeN : 1;
+    int64_t slots = (plan.axis == Axis::Serial) ? 1 : at::get_num_threads();
+    torch::Tensor partial = torch::zeros({slots, sizeNw, sizeC, sizeS}, grad_weights.options());
+    scalar_t *partial_ptr = partial.data_ptr<scalar_t>();
+    auto slot_ptr = [&](int64_t n){
+        int64_t slot = (plan.axis == Axis::Serial) ? 0 : at::get_thread_num();
+        return partial_ptr + (slot*sizeNw + ((sizeNw > 1) ? n : 0))*sizeC*sizeS;
+    };
+    auto load_shifts = [&](int64_t n, int64_t c, int64_t* shifts, scalar_t* dshifts){
+        int64_t *w = weights_ptr + n*weights_sN + c*weights_sC;
+        scalar_t *dw = dweights_ptr + n*dweights_sN + c*dweights_sC;
+        shifts[0] = w[0];
+        dshifts[0] = dw[0];
+        shifts[1] = (sizeW > 1) ? w[weights_sS] : 0;
+        dshifts[1] = (sizeW > 1) ? dw[dweights_sS] : static_cast<scalar_t>(0);
+        shifts[2] = (sizeD > 1) ? w[2*weights_sS] : 0;
+        dshifts[2] = (sizeD > 1) ? dw[2*dweights_sS] : static_cast<scalar_t>(0);
+    };
+    if (!is_unit_param(steps))
+    {
+        if constexpr (!std::is_same<input_t, scalar_t>::value){
+            TORCH_CHECK(false, "shift", kSpatialDim, "d: backward with stride > 1 needs full precision input");
+        } else {
+            // weight gradients: one term per output element
+            shifts::partition::for_each_tile(plan, [&](int64_t n, int64_t c_begin, int64_t c_end, int64_t i_begin, int64_t i_end){
+                scalar_t *grad_weights_ptr = slot_ptr(n);
+                for (int64_t c = c_begin; c < c_end; ++c) {
+                    for (int64_t i = i_begin; i < i_end; ++i) {
+                        for (int64_t j = 0; j < outW; ++j) {
+                            for (int64_t k = 0; k < outD; ++k) {
+                                shift_backward_weights_kernel_strided<scalar_t, int64_t>(grad_input_ptr, input_ptr,
+                                                                                         weights_ptr + n*weights_sN, dweights_ptr + n*dweights_sN,
+                                                                                         grad_weights_ptr,
+                                                                                         n, c, i, j, k, sizeH, sizeW, sizeD,
+                                                                                         stepH, stepW, stepD,
+                                                                                         grad_input_sN, grad_input_sC, grad_input_sH, grad_input_sW, grad_input_sD,
+                                                                                         input_sN, input_sC, input_sH, input_sW, input_sD,
+                                                                                         weights_sC, weights_sS, dweights_sC, dweights_sS, sizeS, 1,
+                                                                                         padding_mode);
+                            }
+                        }
+                    }
+                }
+            });
+            // input gradient: gathered per input element, like in the stride 1 paths below
+            Geometry input_geometry = geometry;
+            input_geometry.sizeH = sizeH;
+            input_geometry.sizeR = sizeW*sizeD;
+            shifts::partition::for_each_tile(shifts::partition::choose_plan(input_geometry),
+                                             [&](int64_t n, int64_t c_begin, int64_t c_end, int64_t i_begin, int64_t i_end){
+                for (int64_t c = c_begin; c < c_end; ++c) {
+                    for (int64_t i = i_begin; i < i_end; ++i) {
+                        for (int64_t j = 0; j < sizeW; ++j) {
+                            for (int64_t k = 0; k < sizeD; ++k) {
+                                shift_backward_input_kernel_strided<scalar_t, int64_t>(grad_input_ptr, grad_output_ptr,
+                                                                                       weights_ptr + n*weights_sN, dweights_ptr + n*dweights_sN,
+                                                                                       n, c, i, j, k, sizeH, sizeW, sizeD,
+                                                                                       stepH, stepW, stepD,
+                                                                                       grad_input_sN, grad_input_sC, grad_input_sH, grad_input_sW, grad_input_sD,
+                                                                                       grad_output_sN, grad_output_sC, grad_output_sH, grad_output_sW, grad_output_sD,
+                                                                                       weights_sC, weights_sS, dweights_sC, dweights_sS,
+                                                                                       alpha, beta, padding_mode, active);
+                            }
+                        }
+                    }
+                }
+            });
+        }
+    }
+    else if (geometry.channels_inner)
+    {// Path for NDHWC: shifts of the tile channels are loaded once, weight gradients are summed per tile
+        shifts::partition::for_each_tile(plan, [&](int64_t n, int64_t c_begin, int64_t c_end, int64_t i_begin, int64_t i_end){
+            int64_t sizeT = c_end - c_begin;
+            std::vector<int64_t> tile_shifts(3*sizeT);
+            std::vector<scalar_t> tile_dshifts(3*sizeT);
+            std::vector<scalar_t> acc(3*sizeT, static_cast<scalar_t>(0));
+            for (int64_t c = 0; c < sizeT; ++c) {
+                load_shifts(n, c_begin + c, tile_shifts.data() + 3*c, tile_dshifts.data() + 3*c);
+            }
+            for (int64_t i = i_begin; i < i_end; ++i) {
+                for (int64_t j = 0; j < sizeW; ++j) {
+                    for (int64_t k = 0; k < sizeD; ++k) {
+                        for (int64_t c = 0; c < sizeT; ++c) {
+                            shift_backward_fused<scalar_t, int64_t, input_t>(grad_input_ptr + n*grad_input_sN + (c_begin + c)*grad_input_sC,
+                                                                    input_ptr + n*input_sN + (c_begin + c)*input_sC,
+                                                                    grad_output_ptr + n*grad_output_sN + (c_begin + c)*grad_output_sC,
+                                                                    tile_shifts.data() + 3*c, tile_dshifts.data() + 3*c,
+                                                                    i, j, k, sizeH, sizeW, sizeD,
+                                                                    grad_input_sH, grad_input_sW, grad_input_sD,
+                                                                    input_sH, input_sW, input_sD,
+                                                                    grad_output_sH, grad_output_sW, grad_output_sD,
+                                                                    alpha, beta, padding_mode, active, acc.data() + 3*c);
+                        }
+                    }
+                }
+            }
+            scalar_t *grad_weights_ptr = slot_ptr(n);
+            for (int64_t c = 0; c < sizeT; ++c) {
+                scalar_t scale = (input_scale != nullptr) ? input_scale[c_begin + c] : static_cast<scalar_t>(1);
+                for (int64_t s = 0; s < sizeS; ++s) {
+                    grad_weights_ptr[(c_begin + c)*sizeS + s] += scale * acc[3*c + s];
+                }
+            }
+        });
+    } else
+    {// Path for NCHWD: one channel plane at a time, its weight gradient stays in registers
+        shifts::partition::for_each_tile(plan, [&](int64_t n, int64_t c_begin, int64_t c_end, int64_t i_begin, int64_t i_end){
+            scalar_t *grad_weights_ptr = slot_ptr(n);
+            for (int64_t c = c_begin; c < c_end; ++c) {
+                int64_t shifts[3];
+                scalar_t dshifts[3];
+                scalar_t acc[3] = {0, 0, 0};
+                load_shifts(n, c, shifts, dshifts);
+                scalar_t *grad_input_NC = grad_input_ptr + n*grad_input_sN + c*grad_input_sC;
+                input_t *input_NC = input_ptr + n*input_sN + c*input_sC;
+                scalar_t *grad_output_NC = grad_output_ptr + n*grad_output_sN + c*grad_output_sC;
+                for (int64_t i = i_begin; i < i_end; ++i) {
+                    for (int64_t j = 0; j < sizeW; ++j) {
+                        for (int64_t k = 0; k < sizeD; ++k) {
+                            shift_backward_fused<scalar_t, int64_t, input_t>(grad_input_NC, input_NC, grad_output_NC, shifts, dshifts,
+                                                                    i, j, k, sizeH, sizeW, sizeD,
+                                                                    grad_input_sH, grad_input_sW, grad_input_sD,
+                                                                    input_sH, input_sW, input_sD,
+                                                                    grad_output_sH, grad_output_sW, grad_output_sD,
+                                                                    alpha, beta, padding_mode, active, acc);
+                        }
+                    }
+                }
+                // weight gradients are linear in input: scale of a compressed input is applied once per plane
+                scalar_t scale = (input_scale != nullptr) ? input_scale[c] : static_cast<scalar_t>(1);
+                for (int64_t s = 0; s < sizeS; ++s) {
+                    grad_weights_ptr[c*sizeS + s] += scale * acc[s];
+                }
+            }
+        });
+    }
+    grad_weights.add_(partial.sum(0).view(grad_weights.sizes()));
+}
+
+
+// K shift sets over the same input: weights are [K, C, dim], output is [N, K*C, ...] where
+// channels k*C..(k+1)*C-1 hold the k-th shifted copy. Shift sets are the innermost loop,
+// so each input tile is brought to cache once for all K outputs.
+template <typename scalar_t, int32_t kSpatialDim>
+API_INLINE void _shifts_multi_forward_cpu(const torch::Tensor& input, const torch::Tensor& iweights,
+                                          const torch::Tensor& dweights, torch::Tensor& output,
+                                          BIPadding padding_mode, bool active){
+    int64_t sizeN = input.size(0);
+    int64_t sizeC = input.size(1);
+    int64_t sizeH = input.size(2);
+    int64_t sizeW = kSpatialDim < 2 ? 1 : input.size(3);
+    int64_t sizeD = kSpatialDim < 3 ? 1 : input.size(4);
+    int64_t sizeK = iweights.size(0);
+    int64_t input_sN = input.stride(0);
+    int64_t input_sC = input.stride(1);
+    int64_t input_sH = input.stride(2);
+    int64_t input_sW = kSpatialDim < 2 ? 0 : input.stride(3);
+    int64_t input_sD = kSpatialDim < 3 ? 0 : input.stride(4);
+    int64_t output_sN = output.stride(0);
+    int64_t output_sC = output.stride(1);
+    int64_t output_sH = output.stride(2);
+    int64_t output_sW = kSpatialDim < 2 ? 0 : output.stride(3);
+    int64_t output_sD = kSpatialDim < 3 ? 0 : output.stride(4);
+    scalar_t *input_ptr = input.data_ptr<scalar_t>();
+    scalar_t *output_ptr = output.data_ptr<scalar_t>();
+    int64_t *weights_ptr = iweights.data_ptr<int64_t>();
+    int64_t weights_sK = iweights.stride(0);
+    int64_t weights_sC = iweights.stride(1);
+    int64_t weights_sS = iweights.stride(2);
+    scalar_t *dweights_ptr = dweights.data_ptr<scalar_t>();
+    int64_t dweights_sK = dweights.stride(0);
+    int64_t dweights_sC = dweights.stride(1);
+    int64_t dweights_sS = dweights.stride(2);
+    scalar_t one = static_cast<scalar_t>(1);
+    scalar_t zero = static_cast<scalar_t>(0);
+    Geometry geometry{sizeN, sizeC, sizeH, sizeW*sizeD, static_cast<int64_t>(sizeof(scalar_t)),
+                      strategy_channels_inner(shifts::autotune::default_strategy(input)),
+                      sizeK * (active ? (1 << kSpatialDim) : 1)};
+    Plan plan = shifts::partition::choose_plan(geometry);
+    if (geometry.channels_inner)
+    {// Path for NDHWC
+        shifts::partition::for_each_tile(plan, [&](int64_t n, int64_t c_begin, int64_t c_end, int64_t i_begin, int64_t i_end){
+            for (int64_t i = i_begin; i < i_end; ++i) {
+                for (int64_t j = 0; j < sizeW; ++j) {
+                    for (int64_t k = 0; k < sizeD; ++k) {
+                        for (int64_t s = 0; s < sizeK; ++s) {
+                            shift_forward_kernel_nhwdc<scalar_t, int64_t>(input_ptr + c_begin*input_sC,
+                                                                          output_ptr + (s*sizeC + c_begin)*output_sC,
+                                                                          weights_ptr + s*weights_sK + c_begin*weights_sC,
+                                                                          dweights_ptr + s*dweights_sK + c_begin*dweights_sC,
+                                                                          n, i, j, k, c_end - c_begin, sizeH, sizeW, sizeD,
+                                                                          1, 1, 1,
+                                                                          input_sN, input_sC, input_sH, input_sW, input_sD,
+                                                                          output_sN, output_sC, output_sH, output_sW, output_sD,
+                                                                          weights_sC, weights_sS, dweights_sC, dweights_sS,
+                                                                          one, zero, padding_mode, active);
+                        }
+                    }
+                }
+            }
+        });
+    } else
+    {
+        shifts::partition::for_each_tile(plan, [&](int64_t n, int64_t c_begin, int64_t c_end, int64_t i_begin, int64_t i_end){
+            for (int64_t c = c_begin; c < c_end; ++c) {
+                for (int64_t s = 0; s < sizeK; ++s) {
+                    for (int64_t i = i_begin; i < i_end; ++i) {
+                        for (int64_t j = 0; j < sizeW; ++j) {
+                            for (int64_t k = 0; k < sizeD; ++k) {
+                                shift_forward_kernel_nchwd<scalar_t, int64_t>(input_ptr, output_ptr + s*sizeC*output_sC,
+                                                                              weights_ptr + s*weights_sK, dweights_ptr + s*dweights_sK,
+                                                                              n, c, i, j, k, sizeH, sizeW, sizeD,
+                                                                              1, 1, 1,
+                                                                              input_sN, input_sC, input_sH, input_sW, input_sD,
+                                                                              output_sN, output_sC, output_sH, output_sW, output_sD,
+                                                                              weights_sC, weights_sS, dweights_sC, dweights_sS,
+                                                                              one, zero, padding_mode, active);
+                            }
+                        }
+                    }
+                }
+            }
+        });
+    }
+}
+
+
+// Input gradient sums over the K shift sets: the first set overwrites, the others accumulate,
+// so every input gradient element is finished by the task which owns it.
+template <typename scalar_t, int32_t kSpatialDim>
+API_INLINE void _shifts_multi_backward_cpu(const torch::Tensor& grad_input, 
+                                           const torch::Tensor& iweights,
+                                           const torch::Tensor& dweights,
+                                           const torch::Tensor& input, torch::Tensor& grad_output,
+                                           torch::Tensor& grad_weights,
+                                           BIPadding padding_mode, bool active){
+    int64_t sizeN = input.size(0);
+    int64_t sizeC = input.size(1);
+    int64_t sizeH = input.size(2);
+    int64_t sizeW = kSpatialDim < 2 ? 1 : input.size(3);
+    int64_t sizeD = kSpatialDim < 3 ? 1 : input.size(4);
+    int64_t sizeK = iweights.size(0);
+    int64_t grad_input_sN = grad_input.stride(0);
+    int64_t grad_input_sC = grad_input.stride(1);
+    int64_t grad_input_sH = grad_input.stride(2);
+    int64_t grad_input_sW = kSpatialDim < 2 ? 0 : grad_input.stride(3);
+    int64_t grad_input_sD = kSpatialDim < 3 ? 0 : grad_input.stride(4);
+    int64_t input_sN = input.stride(0);
+    int64_t input_sC = input.stride(1);
+    int64_t input_sH = input.stride(2);
+    int64_t input_sW = kSpatialDim < 2 ? 0 : input.stride(3);
+    int64_t input_sD = kSpatialDim < 3 ? 0 : input.stride(4);
+    int64_t grad_output_sN = grad_output.stride(0);
+    int64_t grad_output_sC = grad_output.stride(1);
+    int64_t grad_output_sH = grad_output.stride(2);
+    int64_t grad_output_sW = kSpatialDim < 2 ? 0 : grad_output.stride(3);
+    int64_t grad_output_sD = kSpatialDim < 3 ? 0 : grad_output.stride(4);
+    int64_t *weights_ptr = iweights.data_ptr<int64_t>();
+    int64_t weights_sK = iweights.stride(0);
+    int64_t weights_sC = iweights.stride(1);
+    int64_t weights_sS = iweights.stride(2);
+    scalar_t *dweights_ptr = dweights.data_ptr<scalar_t>();
+    int64_t dweights_sK = dweights.stride(0);
+    int64_t dweights_sC = dweights.stride(1);
+    int64_t dweights_sS = dweights.stride(2);
     scalar_t *grad_input_ptr = grad_input.data_ptr<scalar_t>();
     scalar_t *input_ptr = input.data_ptr<scalar_t>();
     scalar_t *grad_output_ptr = grad_output.data_ptr<scalar_t>();
-    if (input.is_contiguous(c10::MemoryFormat::ChannelsLast) || input.is_contiguous(c10::MemoryFormat::ChannelsLast3d))
+    scalar_t one = static_cast<scalar_t>(1);
+    scalar_t zero = static_cast<scalar_t>(0);
+    Geometry geometry{sizeN, sizeC, sizeH, sizeW*sizeD, static_cast<int64_t>(sizeof(scalar_t)),
+                      strategy_channels_inner(shifts::autotune::default_strategy(input)),
+                      sizeK * ((active ? 2 : 1) * (1 << kSpatialDim) + 1)};
+    Plan plan = shifts::partition::choose_plan(geometry);
+    // Weight gradients go to a private [K, C, S] slice of every thread, slices are summed at the end:
+    // tiles of different threads share shift sets and channels(Batch and Rows axes)
+    int64_t sizeS = grad_weights.size(-1);
+    int64_t slots = (plan.axis == Axis::Serial) ? 1 : at::get_num_threads();
+    torch::Tensor partial = torch::zeros({slots, sizeK, sizeC, sizeS}, grad_weights.options());
+    scalar_t *partial_ptr = partial.data_ptr<scalar_t>();
+    int64_t grad_weights_sK = sizeC*sizeS;
+    int64_t grad_weights_sC = sizeS;
+    int64_t grad_weights_sS = 1;
+    auto slot_ptr = [&](){
+        int64_t slot = (plan.axis == Axis::Serial) ? 0 : at::get_thread_num();
+        return partial_ptr + slot*sizeK*sizeC*sizeS;
+    };
+    if (geometry.channels_inner)
     {// Path for NDHWC
-        at::parallel_for(0, sizeN*sizeH*sizeW*sizeD, 0, [&](int64_t start, int64_t end){
-            for (int64_t index = start; index < end; ++index) {
-                int64_t k = index % sizeD;
-                int64_t j = (index / sizeD) % sizeW;
-                int64_t i = (index / (sizeD*sizeW)) % sizeH;
-                int64_t n = (index / (sizeD*sizeW*sizeH));
-                shift_backward_kernel_nhwdc<scalar_t, int64_t>(grad_input_ptr, input_ptr, grad_output_ptr,
-                                                               weights_ptr, dweights_ptr, grad_weights_ptr,
-                                                               n, i, j, k, sizeC, sizeH, sizeW, sizeD,
-                                                               grad_input_sN, grad_input_sC, grad_input_sH, grad_input_sW, grad_input_sD,
-                                                               input_sN, input_sC, input_sH, input_sW, input_sD,
-                                                               grad_output_sN, grad_output_sC, grad_output_sH, grad_output_sW, grad_output_sD,
-                                                               weights_sC, weights_sS, dweights_sC, dweights_sS, grad_weights_sC, grad_weights_sS,
-                                                               padding_mode, active);
+        shifts::partition::for_each_tile(plan, [&](int64_t n, int64_t c_begin, int64_t c_end, int64_t i_begin, int64_t i_end){
+            scalar_t *grad_weights_ptr = slot_ptr();
+            for (int64_t i = i_begin; i < i_end; ++i) {
+                for (int64_t j = 0; j < sizeW; ++j) {
+                    for (int64_t k = 0; k < sizeD; ++k) {
+                        for (int64_t s = 0; s < sizeK; ++s) {
+                            shift_backward_kernel_nhwdc<scalar_t, int64_t>(grad_input_ptr + (s*sizeC + c_begin)*grad_input_sC,
+                                                                           input_ptr + c_begin*input_sC,
+                                                                           grad_output_ptr + c_begin*grad_output_sC,
+                                                                           weights_ptr + s*weights_sK + c_begin*weights_sC,
+                                                                           dweights_ptr + s*dweights_sK + c_begin*dweights_sC,
+                                                                           grad_weights_ptr + s*grad_weights_sK + c_begin*grad_weights_sC,
+                                                                           n, i, j, k, c_end - c_begin, sizeH, sizeW, sizeD,
+                                                                           grad_input_sN, grad_input_sC, grad_input_sH, grad_input_sW, grad_input_sD,
+                                                                           input_sN, input_sC, input_sH, input_sW, input_sD,
+                                                                           grad_output_sN, grad_output_sC, grad_output_sH, grad_output_sW, grad_output_sD,
+                                                                           weights_sC, weights_sS, dweights_sC, dweights_sS, grad_weights_sC, grad_weights_sS,
+                                                                           one, (s > 0) ? one : zero, padding_mode, active);
+                        }
+                    }
+                }
             }
         });
     } else
     {
-        at::parallel_for(0, sizeN*sizeC*sizeH*sizeW*sizeD, 0, [&](int64_t start, int64_t end){
-            for (int64_t index = start; index < end; ++index) {
-                int64_t k = index % sizeD;
-                int64_t j = (index / sizeD) % sizeW;
-                int64_t i = (index / (sizeD*sizeW)) % sizeH;
-                int64_t c = (index / (sizeD*sizeW*sizeH)) % sizeC;
-                int64_t n = (index / (sizeD*sizeW*sizeH*sizeC));
-                shift_backward_kernel_nchwd<scalar_t, int64_t>(grad_input_ptr, input_ptr, grad_output_ptr,
-                                                               weights_ptr, dweights_ptr, grad_weights_ptr,
-                                                               n, c, i, j, k, sizeH, sizeW, sizeD,
-                                                               grad_input_sN, grad_input_sC, grad_input_sH, grad_input_sW, grad_input_sD,
-                                                               input_sN, input_sC, input_sH, input_sW, input_sD,
-                                                               grad_output_sN, grad_output_sC, grad_output_sH, grad_output_sW, grad_output_sD,
-                                                               weights_sC, weights_sS, dweights_sC, dweights_sS, grad_weights_sC, grad_weights_sS,
-                                                               padding_mode, active);
+        shifts::partition::for_each_tile(plan, [&](int64_t n, int64_t c_begin, int64_t c_end, int64_t i_begin, int64_t i_end){
+            scalar_t *grad_weights_ptr = slot_ptr();
+            for (int64_t c = c_begin; c < c_end; ++c) {
+                for (int64_t s = 0; s < sizeK; ++s) {
+                    for (int64_t i = i_begin; i < i_end; ++i) {
+                        for (int64_t j = 0; j < sizeW; ++j) {
+                            for (int64_t k = 0; k < sizeD; ++k) {
+                                shift_backward_kernel_nchwd<scalar_t, int64_t>(grad_input_ptr + s*sizeC*grad_input_sC, input_ptr, grad_output_ptr,
+                                                                               weights_ptr + s*weights_sK, dweights_ptr + s*dweights_sK,
+                                                                               grad_weights_ptr + s*grad_weights_sK,
+                                                                               n, c, i, j, k, sizeH, sizeW, sizeD,
+                                                                               grad_input_sN, grad_input_sC, grad_input_sH, grad_input_sW, grad_input_sD,
+                                                                               input_sN, input_sC, input_sH, input_sW, input_sD,
+                                                                               grad_output_sN, grad_output_sC, grad_output_sH, grad_output_sW, grad_output_sD,
+                                                                               weights_sC, weights_sS, dweights_sC, dweights_sS, grad_weights_sC, grad_weights_sS,
+                                                                               one, (s > 0) ? one : zero, padding_mode, active);
+                            }
+                        }
+                    }
+                }
             }
         });
     }
+    grad_weights.add_(partial.sum(0).view(grad_weights.sizes()));
+}
+
+
+// Packed batch of samples with different spatial sizes(see packed_offsets), sample n is a contiguous
+// [C, H_n, W_n, D_n] tensor at offsets[n]. One parallel region over all (sample, channel) planes,
+// padding is applied at the borders of every sample.
+template <typename scalar_t, int32_t kSpatialDim>
+API_INLINE void _shifts_packed_forward_cpu(const torch::Tensor& input, const torch::Tensor& sizes,
+                                           const std::vector<int64_t>& offsets,
+                                           const torch::Tensor& iweights, const torch::Tensor& dweights,
+                                           torch::Tensor& output, BIPadding padding_mode, bool active){
+    int64_t sizeN = sizes.size(0);
+    int64_t sizeC = iweights.size(0);
+    auto sizes_acc = sizes.accessor<int64_t, 2>();
+    scalar_t *input_ptr = input.data_ptr<scalar_t>();
+    scalar_t *output_ptr = output.data_ptr<scalar_t>();
+    int64_t *weights_ptr = iweights.data_ptr<int64_t>();
+    int64_t weights_sC = iweights.stride(0);
+    int64_t weights_sS = iweights.stride(1);
+    scalar_t *dweights_ptr = dweights.data_ptr<scalar_t>();
+    int64_t dweights_sC = dweights.stride(0);
+    int64_t dweights_sS = dweights.stride(1);
+    scalar_t one = static_cast<scalar_t>(1);
+    scalar_t zero = static_cast<scalar_t>(0);
+    // planes differ in size: tasks are sized by the mean plane
+    int64_t cost = active ? (1 << kSpatialDim) : 1;
+    int64_t grain = std::max<int64_t>(1, SHIFTS_MIN_TASK_WORK*sizeN*sizeC / std::max<int64_t>(1, input.numel()*cost));
+    at::parallel_for(0, sizeN*sizeC, grain, [&](int64_t start, int64_t end){
+        for (int64_t index = start; index < end; ++index) {
+            int64_t n = index / sizeC;
+            int64_t c = index % sizeC;
+            int64_t sizeH = sizes_acc[n][0];
+            int64_t sizeW = kSpatialDim < 2 ? 1 : sizes_acc[n][1];
+            int64_t sizeD = kSpatialDim < 3 ? 1 : sizes_acc[n][2];
+            int64_t sD = 1;
+            int64_t sW = sizeD;
+            int64_t sH = sizeW*sizeD;
+            int64_t sC = sizeH*sizeW*sizeD;
+            for (int64_t i = 0; i < sizeH; ++i) {
+                for (int64_t j = 0; j < sizeW; ++j) {
+                    for (int64_t k = 0; k < sizeD; ++k) {
+                        shift_forward_kernel_nchwd<scalar_t, int64_t>(input_ptr + offsets[n], output_ptr + offsets[n],
+                                                                      weights_ptr, dweights_ptr,
+                                                                      0, c, i, j, k, sizeH, sizeW, sizeD,
+                                                                      1, 1, 1,
+                                                                      0, sC, sH, sW, sD,
+                                                                      0, sC, sH, sW, sD,
+                                                                      weights_sC, weights_sS, dweights_sC, dweights_sS,
+                                                                      one, zero, padding_mode, active);
+                    }
+                }
+            }
+        }
+    });
+}
+
+
+// Every (sample, channel) plane is owned by one task: input gradient is written once and
+// weight gradients go to the per sample rows of grad_weights [N, C, nD](reduced by the caller).
+template <typename scalar_t, int32_t kSpatialDim>
+API_INLINE void _shifts_packed_backward_cpu(const torch::Tensor& grad_input, const torch::Tensor& sizes,
+                                            const std::vector<int64_t>& offsets,
+                                            const torch::Tensor& iweights,
+                                            const torch::Tensor& dweights,
+                                            const torch::Tensor& input, torch::Tensor& grad_output,
+                                            torch::Tensor& grad_weights,
+                                            BIPadding padding_mode, bool active){
+    int64_t sizeN = sizes.size(0);
+    int64_t sizeC = iweights.size(0);
+    auto sizes_acc = sizes.accessor<int64_t, 2>();
+    int64_t *weights_ptr = iweights.data_ptr<int64_t>();
+    int64_t weights_sC = iweights.stride(0);
+    int64_t weights_sS = iweights.stride(1);
+    scalar_t *dweights_ptr = dweights.data_ptr<scalar_t>();
+    int64_t dweights_sC = dweights.stride(0);
+    int64_t dweights_sS = dweights.stride(1);
+    int64_t grad_weights_sN = grad_weights.stride(0);
+    int64_t grad_weights_sC = grad_weights.stride(1);
+    int64_t grad_weights_sS = grad_weights.stride(2);
+    scalar_t *grad_weights_ptr = grad_weights.data_ptr<scalar_t>();
+    scalar_t *grad_input_ptr = grad_input.data_ptr<scalar_t>();
+    scalar_t *input_ptr = input.data_ptr<scalar_t>();
+    scalar_t *grad_output_ptr = grad_output.data_ptr<scalar_t>();
+    scalar_t one = static_cast<scalar_t>(1);
+    scalar_t zero = static_cast<scalar_t>(0);
+    int64_t cost = (active ? 2 : 1) * (1 << kSpatialDim) + 1;
+    int64_t grain = std::max<int64_t>(1, SHIFTS_MIN_TASK_WORK*sizeN*sizeC / std::max<int64_t>(1, input.numel()*cost));
+    at::parallel_for(0, sizeN*sizeC, grain, [&](int64_t start, int64_t end){
+        for (int64_t index = start; index < end; ++index) {
+            int64_t n = index / sizeC;
+            int64_t c = index % sizeC;
+            int64_t sizeH = sizes_acc[n][0];
+            int64_t sizeW = kSpatialDim < 2 ? 1 : sizes_acc[n][1];
+            int64_t sizeD = kSpatialDim < 3 ? 1 : sizes_acc[n][2];
+            int64_t sD = 1;
+            int64_t sW = sizeD;
+            int64_t sH = sizeW*sizeD;
+            int64_t sC = sizeH*sizeW*sizeD;
+            for (int64_t i = 0; i < sizeH; ++i) {
+                for (int64_t j = 0; j < sizeW; ++j) {
+                    for (int64_t k = 0; k < sizeD; ++k) {
+                        shift_backward_kernel_nchwd<scalar_t, int64_t>(grad_input_ptr + offsets[n], input_ptr + offsets[n],
+                                                                       grad_output_ptr + offsets[n],
+                                                                       weights_ptr, dweights_ptr, grad_weights_ptr + n*grad_weights_sN,
+                                                                       0, c, i, j, k, sizeH, sizeW, sizeD,
+                                                                       0, sC, sH, sW, sD,
+                                                                       0, sC, sH, sW, sD,
+                                                                       0, sC, sH, sW, sD,
+                                                                       weights_sC, weights_sS, dweights_sC, dweights_sS, grad_weights_sC, grad_weights_sS,
+                                                                       one, zero, padding_mode, active);
+                    }
+                }
+            }
+        }
+    });
+}
+
+
+// Sparse voxel grid(see check_sparse_voxels): output is computed at the occupied voxels only and equals
+// the dense Zeros padded shift of the scattered features gathered back at the same voxels.
+// For every group of channels with the same integer shift the source voxels(2^3 corners when active)
+// are looked up once per voxel, so cost scales with occupied voxels instead of the grid volume.
+template <typename scalar_t>
+API_INLINE void _shifts_sparse_forward_cpu(const torch::Tensor& features, const torch::Tensor& coords,
+                                           const VoxelHash& hash, const std::vector<ShiftGroup>& groups,
+                                           const torch::Tensor& dweights, torch::Tensor& output, bool active){
+    int64_t sizeM = features.size(0);
+    int64_t sizeC = features.size(1);
+    int64_t ncorners = active ? 8 : 1;
+    scalar_t *features_ptr = features.data_ptr<scalar_t>();
+    scalar_t *output_ptr = output.data_ptr<scalar_t>();
+    int64_t *coords_ptr = coords.data_ptr<int64_t>();
+    scalar_t *dweights_ptr = dweights.data_ptr<scalar_t>();
+    int64_t dweights_sC = dweights.stride(0);
+    int64_t dweights_sS = dweights.stride(1);
+    scalar_t zp = static_cast<scalar_t>(0);
+    int64_t grain = std::max<int64_t>(1, SHIFTS_MIN_TASK_WORK / std::max<int64_t>(1, sizeC*ncorners));
+    at::parallel_for(0, sizeM, grain, [&](int64_t start, int64_t end){
+        for (const ShiftGroup& group : groups){
+            for (int64_t m = start; m < end; ++m){
+                int64_t *p = coords_ptr + 4*m;
+                int64_t rows[8];
+                for (int64_t corner = 0; corner < ncorners; ++corner){
+                    rows[corner] = hash.find(p[0], p[1] - group.shift[0] + (corner & 1),
+                                             p[2] - group.shift[1] + ((corner >> 1) & 1),
+                                             p[3] - group.shift[2] + ((corner >> 2) & 1));
+                }
+                for (int64_t c : group.channels){
+                    scalar_t val = zp;
+                    if (active){
+                        scalar_t _vals_array[8];
+                        for (int64_t corner = 0; corner < 8; ++corner){
+                            _vals_array[corner] = (rows[corner] >= 0) ? features_ptr[rows[corner]*sizeC + c] : zp;
+                        }
+                        val = compute_interpolated<scalar_t,int64_t>(_vals_array, dweights_ptr[c*dweights_sC],
+                                                                     dweights_ptr[c*dweights_sC + dweights_sS],
+                                                                     dweights_ptr[c*dweights_sC + 2*dweights_sS],
+                                                                     hash.sizeH, hash.sizeW, hash.sizeD);
+                    }
+                    else if (rows[0] >= 0){
+                        val = features_ptr[rows[0]*sizeC + c];
+                    }
+                    output_ptr[m*sizeC + c] = val;
+                }
+            }
+        }
+    });
+}
+
+
+// Same gradients as the dense backward restricted to the occupied voxels. Weight gradients are
+// accumulated per thread in grad_weights [threads, C, 3](reduced by the caller).
+template <typename scalar_t>
+API_INLINE void _shifts_sparse_backward_cpu(const torch::Tensor& grad_input, const torch::Tensor& coords,
+                                            const VoxelHash& hash, const std::vector<ShiftGroup>& groups,
+                                            const torch::Tensor& dweights,
+                                            const torch::Tensor& features, torch::Tensor& grad_output,
+                                            torch::Tensor& grad_weights, bool active){
+    int64_t sizeM = features.size(0);
+    int64_t sizeC = features.size(1);
+    scalar_t *grad_input_ptr = grad_input.data_ptr<scalar_t>();
+    scalar_t *features_ptr = features.data_ptr<scalar_t>();
+    scalar_t *grad_output_ptr = grad_output.data_ptr<scalar_t>();
+    scalar_t *grad_weights_ptr = grad_weights.data_ptr<scalar_t>();
+    int64_t *coords_ptr = coords.data_ptr<int64_t>();
+    scalar_t *dweights_ptr = dweights.data_ptr<scalar_t>();
+    int64_t dweights_sC = dweights.stride(0);
+    int64_t dweights_sS = dweights.stride(1);
+    scalar_t zp = static_cast<scalar_t>(0);
+    int64_t grain = std::max<int64_t>(1, SHIFTS_MIN_TASK_WORK / std::max<int64_t>(1, sizeC*17));
+    bool serial = (sizeM <= grain) || (grad_weights.size(0) == 1);
+    at::parallel_for(0, sizeM, serial ? sizeM : grain, [&](int64_t start, int64_t end){
+        scalar_t *weights_grad = grad_weights_ptr + (serial ? 0 : at::get_thread_num())*sizeC*3;
+        for (const ShiftGroup& group : groups){
+            for (int64_t m = start; m < end; ++m){
+                int64_t *p = coords_ptr + 4*m;
+                int64_t rows[8];
+                for (int64_t corner = 0; corner < 8; ++corner){
+                    rows[corner] = hash.find(p[0], p[1] - group.shift[0] + (corner & 1),
+                                             p[2] - group.shift[1] + ((corner >> 1) & 1),
+                                             p[3] - group.shift[2] + ((corner >> 2) & 1));
+                }
+                int64_t row_back = active ? -1 : hash.find(p[0], p[1] + group.shift[0], p[2] + group.shift[1], p[3] + group.shift[2]);
+                for (int64_t c : group.channels){
+                    scalar_t dshifts[3] = {dweights_ptr[c*dweights_sC], dweights_ptr[c*dweights_sC + dweights_sS],
+                                           dweights_ptr[c*dweights_sC + 2*dweights_sS]};
+                    scalar_t _vals_array[8];
+                    if (active){
+                        for (int64_t corner = 0; corner < 8; ++corner){
+                            _vals_array[corner] = (rows[corner] >= 0) ? grad_input_ptr[rows[corner]*sizeC + c] : zp;
+                        }
+                        grad_output_ptr[m*sizeC + c] = compute_interpolated<scalar_t,int64_t>(_vals_array, dshifts[0], dshifts[1], dshifts[2],
+                                                                                                hash.sizeH, hash.sizeW, hash.sizeD);
+                    }
+                    else {
+                        grad_output_ptr[m*sizeC + c] = (row_back >= 0) ? grad_input_ptr[row_back*sizeC + c] : zp;
+                    }
+                    for (int64_t corner = 0; corner < 8; ++corner){
+                        _vals_array[corner] = (rows[corner] >= 0) ? features_ptr[rows[corner]*sizeC + c] : zp;
+                    }
+                    scalar_t _new_weights_grad[3] = {zp, zp, zp};
+                    compute_weight_gradients<scalar_t,int64_t>(_vals_array, dshifts[0], dshifts[1], dshifts[2],
+                                                               hash.sizeH, hash.sizeW, hash.sizeD, _new_weights_grad);
+                    scalar_t g = grad_input_ptr[m*sizeC + c];
+                    weights_grad[3*c] += g * _new_weights_grad[0];
+                    weights_grad[3*c + 1] += g * _new_weights_grad[1];
+                    weights_grad[3*c + 2] += g * _new_weights_grad[2];
+                }
+            }
+        }
+    });
+}
+
+
+// Rank generic shift(shiftnd) over R spatial axes, R is a template parameter(see dispatch_rank).
+// For every (sample, channel) plane the source offset of each output index along each axis is tabulated
+// once per corner(b = 0, 1 of R-linear interpolation): tables[bases[r] + b*sizes[r] + x], -1 outside of tensor.
+// An element then costs R lookups per corner instead of R padding computations.
+template <int R>
+API_INLINE void fill_rank_tables(const std::array<int64_t, R>& sizes, const std::array<int64_t, R>& strides,
+                                 const std::array<int64_t, R>& bases, const int64_t* shifts, int64_t shifts_sS,
+                                 BIPadding padding_mode, std::vector<int64_t>& tables){
+    for (int r = 0; r < R; ++r){
+        int64_t shift = shifts[r*shifts_sS];
+        for (int64_t b = 0; b < 2; ++b){
+            int64_t* table = tables.data() + bases[r] + b*sizes[r];
+            for (int64_t x = 0; x < sizes[r]; ++x){
+                int64_t index = infer_index<int64_t>(x - shift + b, sizes[r], padding_mode);
+                table[x] = (index >= 0) ? index*strides[r] : -1;
+            }
+        }
+    }
+}
+
+// Offset of corner `corner`(bit r - b of axis r) at position pos and its interpolation weight, offset is -1 outside
+template <typename scalar_t, int R>
+API_INLINE int64_t rank_corner(const std::vector<int64_t>& tables, const std::array<int64_t, R>& sizes,
+                               const std::array<int64_t, R>& bases, const std::array<int64_t, R>& pos,
+                               const std::array<scalar_t, 2*R>& fracs, int64_t corner, scalar_t& weight){
+    int64_t offset = 0;
+    weight = static_cast<scalar_t>(1);
+    for (int r = 0; r < R; ++r){
+        int64_t b = (corner >> r) & 1;
+        int64_t axis_offset = tables[bases[r] + b*sizes[r] + pos[r]];
+        if (axis_offset < 0) {return -1;}
+        offset += axis_offset;
+        weight *= fracs[2*r + b];
+    }
+    return offset;
+}
+
+// Row-major odometer over the spatial axes, the last one is the fastest
+template <int R>
+API_INLINE void next_rank_position(std::array<int64_t, R>& pos, const std::array<int64_t, R>& sizes){
+    for (int r = R - 1; r >= 0; --r){
+        if (++pos[r] < sizes[r]) {return;}
+        pos[r] = 0;
+    }
+}
+
+// Calls f(std::integral_constant<int, R>()) for the runtime rank
+template <typename F>
+API_INLINE void dispatch_rank(int64_t rank, F&& f){
+    switch (rank){
+        case 1: f(std::integral_constant<int, 1>()); break;
+        case 2: f(std::integral_constant<int, 2>()); break;
+        case 3: f(std::integral_constant<int, 3>()); break;
+        case 4: f(std::integral_constant<int, 4>()); break;
+        case 5: f(std::integral_constant<int, 5>()); break;
+        case 6: f(std::integral_constant<int, 6>()); break;
+        default: TORCH_CHECK(false, "shiftnd: ", rank, " spatial axes are not supported(1 to ", SHIFTS_MAX_RANK, ")");
+    }
+}
+
+// Output is contiguous [N, C, *spatial], input may have any strides. One task per (sample, channel) plane.
+template <typename scalar_t, int R>
+API_INLINE void _shifts_rank_forward_cpu(const torch::Tensor& input, const torch::Tensor& iweights,
+                                         const torch::Tensor& dweights, torch::Tensor& output,
+                                         BIPadding padding_mode, bool active){
+    int64_t sizeN = input.size(0);
+    int64_t sizeC = input.size(1);
+    std::array<int64_t, R> sizes;
+    std::array<int64_t, R> strides;
+    std::array<int64_t, R> bases;
+    int64_t table_size = 0;
+    int64_t plane = 1;
+    for (int r = 0; r < R; ++r){
+        sizes[r] = input.size(r + 2);
+        strides[r] = input.stride(r + 2);
+        bases[r] = table_size;
+        table_size += 2*sizes[r];
+        plane *= sizes[r];
+    }
+    int64_t input_sN = input.stride(0);
+    int64_t input_sC = input.stride(1);
+    scalar_t *input_ptr = input.data_ptr<scalar_t>();
+    scalar_t *output_ptr = output.data_ptr<scalar_t>();
+    int64_t *weights_ptr = iweights.data_ptr<int64_t>();
+    int64_t weights_sN = iweights.stride(0);
+    int64_t weights_sC = iweights.stride(1);
+    int64_t weights_sS = iweights.stride(2);
+    scalar_t *dweights_ptr = dweights.data_ptr<scalar_t>();
+    int64_t dweights_sN = dweights.stride(0);
+    int64_t dweights_sC = dweights.stride(1);
+    int64_t dweights_sS = dweights.stride(2);
+    scalar_t one = static_cast<scalar_t>(1);
+    scalar_t zero = static_cast<scalar_t>(0);
+    int64_t corners = active ? (int64_t(1) << R) : 1;
+    int64_t grain = std::max<int64_t>(1, SHIFTS_MIN_TASK_WORK / std::max<int64_t>(1, plane*corners));
+    at::parallel_for(0, sizeN*sizeC, grain, [&](int64_t start, int64_t end){
+        std::vector<int64_t> tables(table_size);
+        std::array<scalar_t, 2*R> fracs;
+        std::array<int64_t, R> pos;
+        for (int64_t index = start; index < end; ++index) {
+            int64_t n = index / sizeC;
+            int64_t c = index % sizeC;
+            scalar_t *input_NC = input_ptr + n*input_sN + c*input_sC;
+            scalar_t *output_NC = output_ptr + index*plane;
+            fill_rank_tables<R>(sizes, strides, bases, weights_ptr + n*weights_sN + c*weights_sC, weights_sS,
+                                padding_mode, tables);
+            for (int r = 0; r < R; ++r){
+                scalar_t frac = active ? dweights_ptr[n*dweights_sN + c*dweights_sC + r*dweights_sS] : zero;
+                fracs[2*r] = one - frac;
+                fracs[2*r + 1] = frac;
+            }
+            pos.fill(0);
+            for (int64_t e = 0; e < plane; ++e) {
+                scalar_t val = zero;
+                for (int64_t corner = 0; corner < corners; ++corner) {
+                    scalar_t weight;
+                    int64_t offset = rank_corner<scalar_t, R>(tables, sizes, bases, pos, fracs, corner, weight);
+                    if (offset >= 0) {val += weight * input_NC[offset];}
+                }
+                output_NC[e] = val;
+                next_rank_position<R>(pos, sizes);
+            }
+        }
+    });
+}
+
+// Input gradient is gathered as in shift{1,2,3}d backward: integer shifts read the upstream gradient at
+// x + shift, active shifts interpolate it over the same corners and weights as the forward. Weight gradients
+// are the derivatives of the R-linear interpolation over the 2^R corners(both modes, as for shift{1,2,3}d)
+// written to grad_weights [N, C, R]. input, grad and grad_output are contiguous [N, C, *spatial].
+template <typename scalar_t, int R>
+API_INLINE void _shifts_rank_backward_cpu(const torch::Tensor& grad_input, const torch::Tensor& iweights,
+                                          const torch::Tensor& dweights, const torch::Tensor& input,
+                                          torch::Tensor& grad_output, torch::Tensor& grad_weights,
+                                          BIPadding padding_mode, bool active){
+    int64_t sizeN = input.size(0);
+    int64_t sizeC = input.size(1);
+    std::array<int64_t, R> sizes;
+    std::array<int64_t, R> strides;
+    std::array<int64_t, R> bases;
+    int64_t table_size = 0;
+    int64_t plane = 1;
+    for (int r = R - 1; r >= 0; --r){
+        sizes[r] = input.size(r + 2);
+        strides[r] = plane;
+        plane *= sizes[r];
+    }
+    for (int r = 0; r < R; ++r){
+        bases[r] = table_size;
+        table_size += 2*sizes[r];
+    }
+    scalar_t *grad_input_ptr = grad_input.data_ptr<scalar_t>();
+    scalar_t *input_ptr = input.data_ptr<scalar_t>();
+    scalar_t *grad_output_ptr = grad_output.data_ptr<scalar_t>();
+    scalar_t *grad_weights_ptr = grad_weights.data_ptr<scalar_t>();
+    int64_t *weights_ptr = iweights.data_ptr<int64_t>();
+    int64_t weights_sN = iweights.stride(0);
+    int64_t weights_sC = iweights.stride(1);
+    int64_t weights_sS = iweights.stride(2);
+    scalar_t *dweights_ptr = dweights.data_ptr<scalar_t>();
+    int64_t dweights_sN = dweights.stride(0);
+    int64_t dweights_sC = dweights.stride(1);
+    int64_t dweights_sS = dweights.stride(2);
+    scalar_t one = static_cast<scalar_t>(1);
+    scalar_t zero = static_cast<scalar_t>(0);
+    const int64_t corners = int64_t(1) << R;
+    int64_t grain = std::max<int64_t>(1, SHIFTS_MIN_TASK_WORK / std::max<int64_t>(1, plane*corners*(R + 1)));
+    at::parallel_for(0, sizeN*sizeC, grain, [&](int64_t start, int64_t end){
+        std::vector<int64_t> tables(table_size);
+        // integer shifts: source offsets of the gathered gradient(x + shift), corner 0 only
+        std::vector<int64_t> gather_tables(active ? 0 : table_size);
+        std::array<int64_t, R> gather_shifts;
+        std::array<scalar_t, 2*R> fracs;
+        std::array<int64_t, R> pos;
+        for (int64_t index = start; index < end; ++index) {
+            int64_t n = index / sizeC;
+            int64_t c = index % sizeC;
+            scalar_t *grad_input_NC = grad_input_ptr + index*plane;
+            scalar_t *input_NC = input_ptr + index*plane;
+            scalar_t *grad_output_NC = grad_output_ptr + index*plane;
+            fill_rank_tables<R>(sizes, strides, bases, weights_ptr + n*weights_sN + c*weights_sC, weights_sS,
+                                padding_mode, tables);
+            if (!active){
+                for (int r = 0; r < R; ++r){
+                    gather_shifts[r] = -weights_ptr[n*weights_sN + c*weights_sC + r*weights_sS];
+                }
+                fill_rank_tables<R>(sizes, strides, bases, gather_shifts.data(), 1, padding_mode, gather_tables);
+            }
+            for (int r = 0; r < R; ++r){
+                scalar_t frac = dweights_ptr[n*dweights_sN + c*dweights_sC + r*dweights_sS];
+                fracs[2*r] = one - frac;
+                fracs[2*r + 1] = frac;
+            }
+            std::array<scalar_t, R> weights_grad;
+            weights_grad.fill(zero);
+            pos.fill(0);
+            for (int64_t e = 0; e < plane; ++e) {
+                scalar_t g = grad_input_NC[e];
+                scalar_t gathered = zero;
+                for (int64_t corner = 0; corner < corners; ++corner) {
+                    scalar_t weight;
+                    int64_t offset = rank_corner<scalar_t, R>(tables, sizes, bases, pos, fracs, corner, weight);
+                    if (offset < 0) {continue;}
+                    if (active) {gathered += weight * grad_input_NC[offset];}
+                    // d(weight)/d(frac_r): the other axes' factors, sign of corner side along r
+                    scalar_t gv = g * input_NC[offset];
+                    for (int r = 0; r < R; ++r){
+                        scalar_t d = ((corner >> r) & 1) ? one : -one;
+                        for (int q = 0; q < R; ++q){
+                            if (q != r) {d *= fracs[2*q + ((corner >> q) & 1)];}
+                        }
+                        weights_grad[r] += gv * d;
+                    }
+                }
+                if (!active){
+                    scalar_t weight;
+                    int64_t offset = rank_corner<scalar_t, R>(gather_tables, sizes, bases, pos, fracs, 0, weight);
+                    gathered = (offset >= 0) ? grad_input_NC[offset] : zero;
+                }
+                grad_output_NC[e] = gathered;
+                next_rank_position<R>(pos, sizes);
+            }
+            for (int r = 0; r < R; ++r){
+                grad_weights_ptr[index*R + r] = weights_grad[r];
+            }
+        }
+    });
+}
+
+
+// Writes output = beta*output + alpha*shift(input), output must have the strided size
+template <int nD>
+void shiftnd_forward_into_cpu(const torch::Tensor& input,
+                              const torch::Tensor& weights,
+                              torch::Tensor& output,
+                              int64_t padding_mode,
+                              bool active_flag,
+                              double alpha, double beta,
+                              const std::array<int64_t, 3>& steps,
+                              const std::array<int64_t, 3>& dilations,
+                              const c10::optional<torch::Tensor>& channel_perm = c10::nullopt){
+    std::string name = "shift"+std::to_string(nD)+"d_forward_cpu";
+    check_weights<nD>(input, weights);
+    check_channel_perm<nD>(input, channel_perm);
+    torch::Tensor sweights = is_unit_param(dilations) ? weights : weights * dilation_scale<nD>(weights, dilations);
+    
+    torch::Tensor iweights = (active_flag?torch::floor(sweights):torch::round(sweights)).to(torch::kLong);
+    torch::Tensor dweights = torch::empty_like(sweights, LEGACY_CONTIGUOUS_MEMORY_FORMAT);
+    if (active_flag){
+        dweights = sweights - torch::floor(sweights);
+    }
+    // integer shifts shared by consecutive channels(grouped shifts) are moved as runs
+    std::vector<int64_t> runs = (active_flag || (weights.dim() != 2)) ? std::vector<int64_t>() : shift_runs(iweights);
+    iweights = batched_weights(iweights, input.size(0));
+    dweights = batched_weights(dweights, input.size(0));
+
+    Strategy strategy = shifts::autotune::default_strategy(input, output);
+    std::string key;
+    bool tune = false;
+    const int64_t *perm = nullptr;
+    torch::Tensor perm_c;
+    if (has_channel_perm(channel_perm)){
+        // permuted channels are written one by one: per channel strategies only, not tuned
+        perm_c = channel_perm->contiguous();
+        perm = perm_c.data_ptr<int64_t>();
+        strategy = ((strategy == Strategy::PerElement) || (strategy == Strategy::Serial)) ? strategy : Strategy::Tiled;
+    }
+    else if (shifts::autotune::enabled()){
+        key = shifts::autotune::make_key(input, output, nD, padding_mode, active_flag, c10::IntArrayRef(steps.data(), nD));
+        // accumulation reads the output, so it can only reuse strategies tuned by plain calls
+        tune = !shifts::autotune::lookup(key, strategy) && (alpha == 1.) && (beta == 0.);
+    }
+
+    AT_DISPATCH_FLOATING_TYPES(input.scalar_type(), name, [&] {
+        if (tune){
+            // every candidate writes the full output, so the tuning runs also produce the result
+            strategy = _tune_forward_cpu<scalar_t, nD>(input, iweights, dweights, output, steps,
+                                                       static_cast<BIPadding>(padding_mode), active_flag, runs);
+        }
+        else {
+            _shifts_forward_cpu<scalar_t, nD>(input, iweights, dweights, output, steps,
+                                              static_cast<scalar_t>(alpha), static_cast<scalar_t>(beta),
+                                              static_cast<BIPadding>(padding_mode), active_flag, strategy, runs, perm);
+        }
+    });
+    if (tune){
+        shifts::autotune::store(key, strategy);
+    }
+}
+
+// Writes grad_in = beta*grad_in + alpha*dL/dinput, returns alpha*dL/dweights.
+// input may be bfloat16 or int8 with per channel input_scale(low memory mode, stride 1 only).
+template <int nD>
+torch::Tensor shiftnd_backward_into_cpu(const torch::Tensor& grad,
+                                        const torch::Tensor& weights,
+                                        const torch::Tensor& input,
+                                        torch::Tensor& out_grad,
+                                        int64_t padding_mode,
+                                        bool active_flag,
+                                        double alpha, double beta,
+                                        const std::array<int64_t, 3>& steps,
+                                        const std::array<int64_t, 3>& dilations,
+                                        const c10::optional<torch::Tensor>& input_scale = c10::nullopt){
+    std::string name = "shift"+std::to_string(nD)+"d_backward_cpu";
+    check_weights<nD>(input, weights);
+    torch::Tensor sweights = is_unit_param(dilations) ? weights : weights * dilation_scale<nD>(weights, dilations);
+    
+    torch::Tensor iweights = batched_weights((active_flag?torch::floor(sweights):torch::round(sweights)).to(torch::kLong), input.size(0));
+    torch::Tensor dweights = batched_weights(sweights - torch::floor(sweights), input.size(0));
+    
+    // shared [C, dim] weights: samples are reduced into one gradient by the kernel driver
+    torch::Tensor weights_grad = torch::zeros_like(weights, LEGACY_CONTIGUOUS_MEMORY_FORMAT);
+
+    AT_DISPATCH_FLOATING_TYPES(grad.scalar_type(), name, [&] {
+        torch::Tensor scale = (input_scale.has_value() && input_scale->defined()) ?
+                              input_scale->to(grad.scalar_type()).contiguous() : torch::Tensor();
+        const scalar_t *scale_ptr = scale.defined() ? scale.data_ptr<scalar_t>() : nullptr;
+        switch (input.scalar_type()){
+            case torch::kBFloat16:
+                _shifts_backward_cpu<scalar_t, nD, at::BFloat16>(grad, iweights, dweights, input, out_grad, weights_grad, steps,
+                                                                 static_cast<scalar_t>(alpha), static_cast<scalar_t>(beta),
+                                                                 static_cast<BIPadding>(padding_mode), active_flag, scale_ptr);
+                break;
+            case torch::kChar:
+                _shifts_backward_cpu<scalar_t, nD, int8_t>(grad, iweights, dweights, input, out_grad, weights_grad, steps,
+                                                           static_cast<scalar_t>(alpha), static_cast<scalar_t>(beta),
+                                                           static_cast<BIPadding>(padding_mode), active_flag, scale_ptr);
+                break;
+            default:
+                _shifts_backward_cpu<scalar_t, nD>(grad, iweights, dweights, input, out_grad, weights_grad, steps,
+                                                   static_cast<scalar_t>(alpha), static_cast<scalar_t>(beta),
+                                                   static_cast<BIPadding>(padding_mode), active_flag);
+        }
+    });
+    if (!is_unit_param(dilations)){
+        weights_grad.mul_(dilation_scale<nD>(weights_grad, dilations));
+    }
+    if (alpha != 1.){
+        weights_grad.mul_(alpha);
+    }
+    return weights_grad;
 }
 
 
@@ -155,9 +1212,113 @@ template <int nD>
 torch::Tensor shiftnd_forward_cpu(const torch::Tensor& input,
                                   const torch::Tensor& weights,
                                   int64_t padding_mode,
-                                  bool active_flag){
-    std::string name = "shift"+std::to_string(nD)+"d_forward_cpu";
-    torch::Tensor output = torch::zeros(input.sizes(), input.options());
+                                  bool active_flag,
+                                  c10::IntArrayRef stride,
+                                  c10::IntArrayRef dilation,
+                                  c10::optional<c10::MemoryFormat> memory_format,
+                                  const c10::optional<torch::Tensor>& channel_perm){
+    std::array<int64_t, 3> steps = expand_param<nD>(stride, "stride");
+    std::array<int64_t, 3> dilations = expand_param<nD>(dilation, "dilation");
+    // every output element is written by the kernels, layout conversion is fused into the shift
+    torch::Tensor output = empty_output<nD>(input, strided_output_size<nD>(input.sizes(), steps), memory_format);
+    shiftnd_forward_into_cpu<nD>(input, weights, output, padding_mode, active_flag, 1., 0., steps, dilations, channel_perm);
+    return output;
+}
+
+
+template <int nD>
+torch::Tensor& shiftnd_accumulate_cpu(torch::Tensor& out,
+                                      const torch::Tensor& input,
+                                      const torch::Tensor& weights,
+                                      int64_t padding_mode,
+                                      bool active_flag,
+                                      double alpha, double beta,
+                                      c10::IntArrayRef stride,
+                                      c10::IntArrayRef dilation){
+    std::array<int64_t, 3> steps = expand_param<nD>(stride, "stride");
+    std::array<int64_t, 3> dilations = expand_param<nD>(dilation, "dilation");
+    check_accumulate_out<nD>(out, strided_output_size<nD>(input.sizes(), steps), {input});
+    shiftnd_forward_into_cpu<nD>(input, weights, out, padding_mode, active_flag, alpha, beta, steps, dilations);
+    return out;
+}
+
+
+template <int nD>
+std::vector<torch::Tensor> shiftnd_backward_cpu(const torch::Tensor& grad,
+                                                const torch::Tensor& weights,
+                                                const torch::Tensor& input,
+                                                int64_t padding_mode,
+                                                bool active_flag,
+                                                c10::IntArrayRef stride,
+                                                c10::IntArrayRef dilation,
+                                                double sparsity = 0.) {
+    std::array<int64_t, 3> steps = expand_param<nD>(stride, "stride");
+    std::array<int64_t, 3> dilations = expand_param<nD>(dilation, "dilation");
+    torch::Tensor out_grad = empty_input_grad(input);
+    torch::Tensor weights_grad = shiftnd_backward_into_cpu<nD>(grad, weights, input, out_grad, padding_mode, active_flag,
+                                                               1., 0., steps, dilations);
+    if (sparsity != 0.){
+        // L1 term of the shifts: added to the reduced gradient, no separate autograd node
+        weights_grad.add_(weights.sign(), sparsity);
+    }
+    return {out_grad, weights_grad};
+}
+
+
+template <int nD>
+torch::Tensor shiftnd_backward_accumulate_cpu(torch::Tensor& out_grad,
+                                              const torch::Tensor& grad,
+                                              const torch::Tensor& weights,
+                                              const torch::Tensor& input,
+                                              int64_t padding_mode,
+                                              bool active_flag,
+                                              double alpha, double beta,
+                                              c10::IntArrayRef stride,
+                                              c10::IntArrayRef dilation) {
+    std::array<int64_t, 3> steps = expand_param<nD>(stride, "stride");
+    std::array<int64_t, 3> dilations = expand_param<nD>(dilation, "dilation");
+    check_accumulate_out<nD>(out_grad, input.sizes(), {grad, input});
+    return shiftnd_backward_into_cpu<nD>(grad, weights, input, out_grad, padding_mode, active_flag,
+                                         alpha, beta, steps, dilations);
+}
+
+
+// Backward of the low memory mode: the fused kernels read the compressed input(bfloat16, int8 + scale) directly
+template <int nD>
+std::vector<torch::Tensor> shiftnd_lowmem_backward_cpu(const torch::Tensor& grad,
+                                                       const torch::Tensor& weights,
+                                                       const torch::Tensor& saved,
+                                                       const c10::optional<torch::Tensor>& scale,
+                                                       int64_t padding_mode,
+                                                       bool active_flag,
+                                                       c10::IntArrayRef stride,
+                                                       c10::IntArrayRef dilation) {
+    std::array<int64_t, 3> steps = expand_param<nD>(stride, "stride");
+    std::array<int64_t, 3> dilations = expand_param<nD>(dilation, "dilation");
+    if ((saved.scalar_type() == grad.scalar_type()) || !is_unit_param(steps)){
+        return shiftnd_backward_cpu<nD>(grad, weights, decompress_saved_input(saved, scale, grad.scalar_type()),
+                                        padding_mode, active_flag, stride, dilation);
+    }
+    torch::Tensor out_grad = torch::empty(saved.sizes(), grad.options());
+    torch::Tensor weights_grad = shiftnd_backward_into_cpu<nD>(grad, weights, saved, out_grad, padding_mode, active_flag,
+                                                               1., 0., steps, dilations, scale);
+    return {out_grad, weights_grad};
+}
+
+
+
+
+template <int nD>
+torch::Tensor shiftnd_multi_forward_cpu(const torch::Tensor& input,
+                                        const torch::Tensor& weights,
+                                        int64_t padding_mode,
+                                        bool active_flag){
+    std::string name = "shift"+std::to_string(nD)+"d_multi_forward_cpu";
+    check_multi_weights<nD>(input, weights);
+    std::vector<int64_t> output_size(input.sizes().begin(), input.sizes().end());
+    output_size[1] *= weights.size(0);
+    // every output element is written by the kernels
+    torch::Tensor output = torch::empty(output_size, input.options().memory_format(input.suggest_memory_format()));
     
     torch::Tensor iweights = (active_flag?torch::floor(weights):torch::round(weights)).to(torch::kLong);
     torch::Tensor dweights = torch::empty_like(weights, LEGACY_CONTIGUOUS_MEMORY_FORMAT);
@@ -166,57 +1327,252 @@ torch::Tensor shiftnd_forward_cpu(const torch::Tensor& input,
     }
 
     AT_DISPATCH_FLOATING_TYPES(input.scalar_type(), name, [&] {
-         _shifts_forward_cpu<scalar_t, nD>(input, iweights, dweights, output,
-                                           static_cast<BIPadding>(padding_mode), active_flag);
-    });   
+        _shifts_multi_forward_cpu<scalar_t, nD>(input, iweights, dweights, output,
+                                                static_cast<BIPadding>(padding_mode), active_flag);
+    });
     return output;
 }
 
 
 template <int nD>
-std::vector<torch::Tensor> shiftnd_backward_cpu(const torch::Tensor& grad,
-                                                const torch::Tensor& weights,
-                                                const torch::Tensor& input,
-                                                int64_t padding_mode,
-                                                bool active_flag) {
-    std::string name = "shift"+std::to_string(nD)+"d_backward_cpu";
-    
+std::vector<torch::Tensor> shiftnd_multi_backward_cpu(const torch::Tensor& grad,
+                                                      const torch::Tensor& weights,
+                                                      const torch::Tensor& input,
+                                                      int64_t padding_mode,
+                                                      bool active_flag) {
+    std::string name = "shift"+std::to_string(nD)+"d_multi_backward_cpu";
+    check_multi_backward<nD>(grad, input, weights);
     torch::Tensor iweights = (active_flag?torch::floor(weights):torch::round(weights)).to(torch::kLong);
     torch::Tensor dweights = weights - torch::floor(weights);
     
-    torch::Tensor out_grad = torch::zeros_like(grad, LEGACY_CONTIGUOUS_MEMORY_FORMAT);
+    torch::Tensor out_grad = torch::empty_like(input, LEGACY_CONTIGUOUS_MEMORY_FORMAT);
     torch::Tensor weights_grad = torch::zeros_like(weights, LEGACY_CONTIGUOUS_MEMORY_FORMAT);
 
     AT_DISPATCH_FLOATING_TYPES(grad.scalar_type(), name, [&] {
-        _shifts_backward_cpu<scalar_t, nD>(grad, iweights, dweights, input, out_grad, weights_grad,
-                                            static_cast<BIPadding>(padding_mode), active_flag);
+        _shifts_multi_backward_cpu<scalar_t, nD>(grad, iweights, dweights, input, out_grad, weights_grad,
+                                                 static_cast<BIPadding>(padding_mode), active_flag);
     });
- 
     return {out_grad, weights_grad};
 }
 
 
 
+template <int nD>
+torch::Tensor shiftnd_packed_forward_cpu(const torch::Tensor& input,
+                                         const torch::Tensor& sizes,
+                                         const torch::Tensor& weights,
+                                         int64_t padding_mode,
+                                         bool active_flag){
+    std::string name = "shift"+std::to_string(nD)+"d_packed_forward_cpu";
+    std::vector<int64_t> offsets = packed_offsets<nD>(input, sizes, weights);
+    torch::Tensor input_c = input.contiguous();
+    torch::Tensor sizes_c = sizes.contiguous();
+    // every output element is written by the kernels
+    torch::Tensor output = torch::empty_like(input_c);
+    
+    torch::Tensor iweights = (active_flag?torch::floor(weights):torch::round(weights)).to(torch::kLong);
+    torch::Tensor dweights = torch::empty_like(weights, LEGACY_CONTIGUOUS_MEMORY_FORMAT);
+    if (active_flag){
+        dweights = weights - torch::floor(weights);
+    }
+
+    AT_DISPATCH_FLOATING_TYPES(input.scalar_type(), name, [&] {
+        _shifts_packed_forward_cpu<scalar_t, nD>(input_c, sizes_c, offsets, iweights, dweights, output,
+                                                 static_cast<BIPadding>(padding_mode), active_flag);
+    });
+    return output;
+}
+
+
+template <int nD>
+std::vector<torch::Tensor> shiftnd_packed_backward_cpu(const torch::Tensor& grad,
+                                                       const torch::Tensor& sizes,
+                                                       const torch::Tensor& weights,
+                                                       const torch::Tensor& input,
+                                                       int64_t padding_mode,
+                                                       bool active_flag) {
+    std::string name = "shift"+std::to_string(nD)+"d_packed_backward_cpu";
+    std::vector<int64_t> offsets = packed_offsets<nD>(input, sizes, weights);
+    torch::Tensor grad_c = grad.contiguous();
+    torch::Tensor input_c = input.contiguous();
+    torch::Tensor sizes_c = sizes.contiguous();
+    torch::Tensor iweights = (active_flag?torch::floor(weights):torch::round(weights)).to(torch::kLong);
+    torch::Tensor dweights = weights - torch::floor(weights);
+    
+    torch::Tensor out_grad = torch::empty_like(input_c);
+    torch::Tensor weights_grad = torch::zeros({sizes.size(0), weights.size(0), nD}, weights.options());
+
+    AT_DISPATCH_FLOATING_TYPES(grad.scalar_type(), name, [&] {
+        _shifts_packed_backward_cpu<scalar_t, nD>(grad_c, sizes_c, offsets, iweights, dweights, input_c, out_grad, weights_grad,
+                                                  static_cast<BIPadding>(padding_mode), active_flag);
+    });
+    return {out_grad, weights_grad.sum(0)};
+}
+
+
+
+
+torch::Tensor shift3d_sparse_forward_hashed_cpu(const torch::Tensor& features,
+                                                const torch::Tensor& coords,
+                                                const torch::Tensor& weights,
+                                                bool active_flag,
+                                                const VoxelHash& hash){
+    std::string name = "shift3d_sparse_forward_cpu";
+    torch::Tensor features_c = features.contiguous();
+    torch::Tensor coords_c = coords.contiguous();
+    // every output element is written by the kernels
+    torch::Tensor output = torch::empty_like(features_c);
+
+    torch::Tensor iweights = (active_flag?torch::floor(weights):torch::round(weights)).to(torch::kLong);
+    torch::Tensor dweights = torch::empty_like(weights, LEGACY_CONTIGUOUS_MEMORY_FORMAT);
+    if (active_flag){
+        dweights = weights - torch::floor(weights);
+    }
+    std::vector<ShiftGroup> groups = shifts::sparse::shift_groups(iweights);
+
+    AT_DISPATCH_FLOATING_TYPES(features.scalar_type(), name, [&] {
+        _shifts_sparse_forward_cpu<scalar_t>(features_c, coords_c, hash, groups, dweights, output, active_flag);
+    });
+    return output;
+}
+
+
+std::vector<torch::Tensor> shift3d_sparse_backward_hashed_cpu(const torch::Tensor& grad,
+                                                              const torch::Tensor& coords,
+                                                              const torch::Tensor& weights,
+                                                              const torch::Tensor& features,
+                                                              bool active_flag,
+                                                              const VoxelHash& hash){
+    std::string name = "shift3d_sparse_backward_cpu";
+    TORCH_CHECK(grad.sizes() == features.sizes(),
+                "shift3d_sparse: expected grad of shape ", features.sizes(), ", but got ", grad.sizes());
+    torch::Tensor grad_c = grad.contiguous();
+    torch::Tensor features_c = features.contiguous();
+    torch::Tensor coords_c = coords.contiguous();
+    torch::Tensor iweights = (active_flag?torch::floor(weights):torch::round(weights)).to(torch::kLong);
+    torch::Tensor dweights = weights - torch::floor(weights);
+    std::vector<ShiftGroup> groups = shifts::sparse::shift_groups(iweights);
+
+    torch::Tensor out_grad = torch::empty_like(features_c);
+    int64_t slots = at::in_parallel_region() ? 1 : at::get_num_threads();
+    torch::Tensor weights_grad = torch::zeros({slots, weights.size(0), 3}, weights.options());
+
+    AT_DISPATCH_FLOATING_TYPES(grad.scalar_type(), name, [&] {
+        _shifts_sparse_backward_cpu<scalar_t>(grad_c, coords_c, hash, groups, dweights, features_c, out_grad, weights_grad,
+                                              active_flag);
+    });
+    return {out_grad, weights_grad.sum(0)};
+}
+
+
+torch::Tensor shift3d_sparse_forward_cpu(const torch::Tensor& features,
+                                         const torch::Tensor& coords,
+                                         c10::IntArrayRef spatial_size,
+                                         const torch::Tensor& weights,
+                                         bool active_flag){
+    VoxelHash hash(coords.contiguous(), check_sparse_voxels(features, coords, spatial_size, weights));
+    return shift3d_sparse_forward_hashed_cpu(features, coords, weights, active_flag, hash);
+}
+
+
+std::vector<torch::Tensor> shift3d_sparse_backward_cpu(const torch::Tensor& grad,
+                                                       const torch::Tensor& coords,
+                                                       c10::IntArrayRef spatial_size,
+                                                       const torch::Tensor& weights,
+                                                       const torch::Tensor& features,
+                                                       bool active_flag){
+    VoxelHash hash(coords.contiguous(), check_sparse_voxels(features, coords, spatial_size, weights));
+    return shift3d_sparse_backward_hashed_cpu(grad, coords, weights, features, active_flag, hash);
+}
+
+
+
+
+torch::Tensor shiftnd_generic_forward_cpu(const torch::Tensor& input,
+                                          const torch::Tensor& weights,
+                                          int64_t padding_mode,
+                                          bool active_flag){
+    std::string name = "shiftnd_forward_cpu";
+    int64_t rank = check_rank_weights(input, weights);
+    // every output element is written by the kernels
+    torch::Tensor output = torch::empty(input.sizes(), input.options());
+
+    torch::Tensor iweights = batched_weights((active_flag?torch::floor(weights):torch::round(weights)).to(torch::kLong), input.size(0));
+    torch::Tensor dweights = batched_weights(weights - torch::floor(weights), input.size(0));
+
+    AT_DISPATCH_FLOATING_TYPES(input.scalar_type(), name, [&] {
+        dispatch_rank(rank, [&](auto kRank){
+            _shifts_rank_forward_cpu<scalar_t, decltype(kRank)::value>(input, iweights, dweights, output,
+                                                                       static_cast<BIPadding>(padding_mode), active_flag);
+        });
+    });
+    return output;
+}
+
+
+std::vector<torch::Tensor> shiftnd_generic_backward_cpu(const torch::Tensor& grad,
+                                                        const torch::Tensor& weights,
+                                                        const torch::Tensor& input,
+                                                        int64_t padding_mode,
+                                                        bool active_flag){
+    std::string name = "shiftnd_backward_cpu";
+    int64_t rank = check_rank_weights(input, weights);
+    torch::Tensor grad_c = grad.contiguous();
+    torch::Tensor input_c = input.contiguous();
+    torch::Tensor iweights = batched_weights((active_flag?torch::floor(weights):torch::round(weights)).to(torch::kLong), input.size(0));
+    torch::Tensor dweights = batched_weights(weights - torch::floor(weights), input.size(0));
+
+    // every element is written by the kernel
+    torch::Tensor out_grad = torch::empty_like(input_c);
+    torch::Tensor weights_grad = torch::empty({input.size(0), input.size(1), rank}, weights.options());
+
+    AT_DISPATCH_FLOATING_TYPES(grad.scalar_type(), name, [&] {
+        dispatch_rank(rank, [&](auto kRank){
+            _shifts_rank_backward_cpu<scalar_t, decltype(kRank)::value>(grad_c, iweights, dweights, input_c, out_grad, weights_grad,
+                                                                        static_cast<BIPadding>(padding_mode), active_flag);
+        });
+    });
+    // shared [C, R] weights: per sample gradients are reduced here
+    return {out_grad, (weights.dim() == 2) ? weights_grad.sum(0) : weights_grad};
+}
+
+
+
 
 torch::Tensor shift1d_forward_cpu(const torch::Tensor& input,
                                   const torch::Tensor& weights,
                                   int64_t padding_mode,
-                                  bool active_flag){
-    return shiftnd_forward_cpu<1>(input, weights, padding_mode, active_flag);                    
+                                  bool active_flag,
+                                  c10::IntArrayRef stride,
+                                  c10::IntArrayRef dilation,
+                                  c10::optional<c10::MemoryFormat> memory_format,
+                                  const c10::optional<torch::Tensor>& channel_perm,
+                                  double sparsity){
+    return shiftnd_forward_cpu<1>(input, weights, padding_mode, active_flag, stride, dilation, memory_format, channel_perm);                    
 }
 
 torch::Tensor shift2d_forward_cpu(const torch::Tensor& input,
                                   const torch::Tensor& weights,
                                   int64_t padding_mode,
-                                  bool active_flag){
-    return shiftnd_forward_cpu<2>(input, weights, padding_mode, active_flag);                    
+                                  bool active_flag,
+                                  c10::IntArrayRef stride,
+                                  c10::IntArrayRef dilation,
+                                  c10::optional<c10::MemoryFormat> memory_format,
+                                  const c10::optional<torch::Tensor>& channel_perm,
+                                  double sparsity){
+    return shiftnd_forward_cpu<2>(input, weights, padding_mode, active_flag, stride, dilation, memory_format, channel_perm);                    
 }
 
 torch::Tensor shift3d_forward_cpu(const torch::Tensor& input,
                                   const torch::Tensor& weights,
                                   int64_t padding_mode,
-                                  bool active_flag){
-    return shiftnd_forward_cpu<3>(input, weights, padding_mode, active_flag);                    
+                                  bool active_flag,
+                                  c10::IntArrayRef stride,
+                                  c10::IntArrayRef dilation,
+                                  c10::optional<c10::MemoryFormat> memory_format,
+                                  const c10::optional<torch::Tensor>& channel_perm,
+                                  double sparsity){
+    return shiftnd_forward_cpu<3>(input, weights, padding_mode, active_flag, stride, dilation, memory_format, channel_perm);                    
 }
 
 
@@ -224,26 +1580,273 @@ std::vector<torch::Tensor> shift1d_backward_cpu(const torch::Tensor& grad,
                                                 const torch::Tensor& weights,
                                                 const torch::Tensor& input,
                                                 int64_t padding_mode,
-                                                bool active_flag){
-    return  shiftnd_backward_cpu<1>(grad, weights, input, padding_mode, active_flag);                                       
+                                                bool active_flag,
+                                                c10::IntArrayRef stride,
+                                                c10::IntArrayRef dilation,
+                                                double sparsity){
+    return  shiftnd_backward_cpu<1>(grad, weights, input, padding_mode, active_flag, stride, dilation, sparsity);                                       
 }
 
 std::vector<torch::Tensor> shift2d_backward_cpu(const torch::Tensor& grad,
                                                 const torch::Tensor& weights,
                                                 const torch::Tensor& input,
                                                 int64_t padding_mode,
-                                                bool active_flag){
-    return  shiftnd_backward_cpu<2>(grad, weights, input, padding_mode, active_flag);                                       
+                                                bool active_flag,
+                                                c10::IntArrayRef stride,
+                                                c10::IntArrayRef dilation,
+                                                double sparsity){
+    return  shiftnd_backward_cpu<2>(grad, weights, input, padding_mode, active_flag, stride, dilation, sparsity);                                       
 }
 
 std::vector<torch::Tensor> shift3d_backward_cpu(const torch::Tensor& grad,
                                                 const torch::Tensor& weights,
                                                 const torch::Tensor& input,
                                                 int64_t padding_mode,
-                                                bool active_flag){
-    return  shiftnd_backward_cpu<3>(grad, weights, input, padding_mode, active_flag);                                       
+                                                bool active_flag,
+                                                c10::IntArrayRef stride,
+                                                c10::IntArrayRef dilation,
+                                                double sparsity){
+    return  shiftnd_backward_cpu<3>(grad, weights, input, padding_mode, active_flag, stride, dilation, sparsity);                                       
+}
+
+
+torch::Tensor& shift1d_accumulate_cpu(torch::Tensor& out,
+                                      const torch::Tensor& input,
+                                      const torch::Tensor& weights,
+                                      int64_t padding_mode,
+                                      bool active_flag,
+                                      double alpha, double beta,
+                                      c10::IntArrayRef stride,
+                                      c10::IntArrayRef dilation){
+    return shiftnd_accumulate_cpu<1>(out, input, weights, padding_mode, active_flag, alpha, beta, stride, dilation);
+}
+
+torch::Tensor& shift2d_accumulate_cpu(torch::Tensor& out,
+                                      const torch::Tensor& input,
+                                      const torch::Tensor& weights,
+                                      int64_t padding_mode,
+                                      bool active_flag,
+                                      double alpha, double beta,
+                                      c10::IntArrayRef stride,
+                                      c10::IntArrayRef dilation){
+    return shiftnd_accumulate_cpu<2>(out, input, weights, padding_mode, active_flag, alpha, beta, stride, dilation);
+}
+
+torch::Tensor& shift3d_accumulate_cpu(torch::Tensor& out,
+                                      const torch::Tensor& input,
+                                      const torch::Tensor& weights,
+                                      int64_t padding_mode,
+                                      bool active_flag,
+                                      double alpha, double beta,
+                                      c10::IntArrayRef stride,
+                                      c10::IntArrayRef dilation){
+    return shiftnd_accumulate_cpu<3>(out, input, weights, padding_mode, active_flag, alpha, beta, stride, dilation);
+}
+
+torch::Tensor shift1d_backward_accumulate_cpu(torch::Tensor& out_grad,
+                                              const torch::Tensor& grad,
+                                              const torch::Tensor& weights,
+                                              const torch::Tensor& input,
+                                              int64_t padding_mode,
+                                              bool active_flag,
+                                              double alpha, double beta,
+                                              c10::IntArrayRef stride,
+                                              c10::IntArrayRef dilation){
+    return shiftnd_backward_accumulate_cpu<1>(out_grad, grad, weights, input, padding_mode, active_flag,
+                                              alpha, beta, stride, dilation);
+}
+
+torch::Tensor shift2d_backward_accumulate_cpu(torch::Tensor& out_grad,
+                                              const torch::Tensor& grad,
+                                              const torch::Tensor& weights,
+                                              const torch::Tensor& input,
+                                              int64_t padding_mode,
+                                              bool active_flag,
+                                              double alpha, double beta,
+                                              c10::IntArrayRef stride,
+                                              c10::IntArrayRef dilation){
+    return shiftnd_backward_accumulate_cpu<2>(out_grad, grad, weights, input, padding_mode, active_flag,
+                                              alpha, beta, stride, dilation);
+}
+
+torch::Tensor shift3d_backward_accumulate_cpu(torch::Tensor& out_grad,
+                                              const torch::Tensor& grad,
+                                              const torch::Tensor& weights,
+                                              const torch::Tensor& input,
+                                              int64_t padding_mode,
+                                              bool active_flag,
+                                              double alpha, double beta,
+                                              c10::IntArrayRef stride,
+                                              c10::IntArrayRef dilation){
+    return shiftnd_backward_accumulate_cpu<3>(out_grad, grad, weights, input, padding_mode, active_flag,
+                                              alpha, beta, stride, dilation);
+}
+
+
+torch::Tensor shift1d_multi_forward_cpu(const torch::Tensor& input,
+                                        const torch::Tensor& weights,
+                                        int64_t padding_mode,
+                                        bool active_flag){
+    return shiftnd_multi_forward_cpu<1>(input, weights, padding_mode, active_flag);
+}
+
+torch::Tensor shift2d_multi_forward_cpu(const torch::Tensor& input,
+                                        const torch::Tensor& weights,
+                                        int64_t padding_mode,
+                                        bool active_flag){
+    return shiftnd_multi_forward_cpu<2>(input, weights, padding_mode, active_flag);
+}
+
+torch::Tensor shift3d_multi_forward_cpu(const torch::Tensor& input,
+                                        const torch::Tensor& weights,
+                                        int64_t padding_mode,
+                                        bool active_flag){
+    return shiftnd_multi_forward_cpu<3>(input, weights, padding_mode, active_flag);
+}
+
+std::vector<torch::Tensor> shift1d_multi_backward_cpu(const torch::Tensor& grad,
+                                                      const torch::Tensor& weights,
+                                                      const torch::Tensor& input,
+                                                      int64_t padding_mode,
+                                                      bool active_flag){
+    return shiftnd_multi_backward_cpu<1>(grad, weights, input, padding_mode, active_flag);
+}
+
+std::vector<torch::Tensor> shift2d_multi_backward_cpu(const torch::Tensor& grad,
+                                                      const torch::Tensor& weights,
+                                                      const torch::Tensor& input,
+                                                      int64_t padding_mode,
+                                                      bool active_flag){
+    return shiftnd_multi_backward_cpu<2>(grad, weights, input, padding_mode, active_flag);
+}
+
+std::vector<torch::Tensor> shift3d_multi_backward_cpu(const torch::Tensor& grad,
+                                                      const torch::Tensor& weights,
+                                                      const torch::Tensor& input,
+                                                      int64_t padding_mode,
+                                                      bool active_flag){
+    return shiftnd_multi_backward_cpu<3>(grad, weights, input, padding_mode, active_flag);
+}
+
+
+torch::Tensor shift1d_packed_forward_cpu(const torch::Tensor& input,
+                                         const torch::Tensor& sizes,
+                                         const torch::Tensor& weights,
+                                         int64_t padding_mode,
+                                         bool active_flag){
+    return shiftnd_packed_forward_cpu<1>(input, sizes, weights, padding_mode, active_flag);
+}
+
+torch::Tensor shift2d_packed_forward_cpu(const torch::Tensor& input,
+                                         const torch::Tensor& sizes,
+                                         const torch::Tensor& weights,
+                                         int64_t padding_mode,
+                                         bool active_flag){
+    return shiftnd_packed_forward_cpu<2>(input, sizes, weights, padding_mode, active_flag);
+}
+
+torch::Tensor shift3d_packed_forward_cpu(const torch::Tensor& input,
+                                         const torch::Tensor& sizes,
+                                         const torch::Tensor& weights,
+                                         int64_t padding_mode,
+                                         bool active_flag){
+    return shiftnd_packed_forward_cpu<3>(input, sizes, weights, padding_mode, active_flag);
+}
+
+std::vector<torch::Tensor> shift1d_packed_backward_cpu(const torch::Tensor& grad,
+                                                       const torch::Tensor& sizes,
+                                                       const torch::Tensor& weights,
+                                                       const torch::Tensor& input,
+                                                       int64_t padding_mode,
+                                                       bool active_flag){
+    return shiftnd_packed_backward_cpu<1>(grad, sizes, weights, input, padding_mode, active_flag);
 }
 
+std::vector<torch::Tensor> shift2d_packed_backward_cpu(const torch::Tensor& grad,
+                                                       const torch::Tensor& sizes,
+                                                       const torch::Tensor& weights,
+                                                       const torch::Tensor& input,
+                                                       int64_t padding_mode,
+                                                       bool active_flag){
+    return shiftnd_packed_backward_cpu<2>(grad, sizes, weights, input, padding_mode, active_flag);
+}
+
+std::vector<torch::Tensor> shift3d_packed_backward_cpu(const torch::Tensor& grad,
+                                                       const torch::Tensor& sizes,
+                                                       const torch::Tensor& weights,
+                                                       const torch::Tensor& input,
+                                                       int64_t padding_mode,
+                                                       bool active_flag){
+    return shiftnd_packed_backward_cpu<3>(grad, sizes, weights, input, padding_mode, active_flag);
+}
+
+
+std::vector<torch::Tensor> shift1d_lowmem_backward_cpu(const torch::Tensor& grad,
+                                                       const torch::Tensor& weights,
+                                                       const torch::Tensor& saved,
+                                                       const c10::optional<torch::Tensor>& scale,
+                                                       int64_t padding_mode,
+                                                       bool active_flag,
+                                                       c10::IntArrayRef stride,
+                                                       c10::IntArrayRef dilation){
+    return shiftnd_lowmem_backward_cpu<1>(grad, weights, saved, scale, padding_mode, active_flag, stride, dilation);
+}
 
+std::vector<torch::Tensor> shift2d_lowmem_backward_cpu(const torch::Tensor& grad,
+                                                       const torch::Tensor& weights,
+                                                       const torch::Tensor& saved,
+                                                       const c10::optional<torch::Tensor>& scale,
+                                                       int64_t padding_mode,
+                                                       bool active_flag,
+                                                       c10::IntArrayRef stride,
+                                                       c10::IntArrayRef dilation){
+    return shiftnd_lowmem_backward_cpu<2>(grad, weights, saved, scale, padding_mode, active_flag, stride, dilation);
+}
+
+std::vector<torch::Tensor> shift3d_lowmem_backward_cpu(const torch::Tensor& grad,
+                                                       const torch::Tensor& weights,
+                                                       const torch::Tensor& saved,
+                                                       const c10::optional<torch::Tensor>& scale,
+                                                       int64_t padding_mode,
+                                                       bool active_flag,
+                                                       c10::IntArrayRef stride,
+                                                       c10::IntArrayRef dilation){
+    return shiftnd_lowmem_backward_cpu<3>(grad, weights, saved, scale, padding_mode, active_flag, stride, dilation);
+}
+
+
+TORCH_LIBRARY_IMPL(torchshifts, CPU, m) {
+    m.impl("shift1d", &shift1d_forward_cpu);
+    m.impl("shift2d", &shift2d_forward_cpu);
+    m.impl("shift3d", &shift3d_forward_cpu);
+    m.impl("_shift1d_backward", &shift1d_backward_cpu);
+    m.impl("_shift2d_backward", &shift2d_backward_cpu);
+    m.impl("_shift3d_backward", &shift3d_backward_cpu);
+    m.impl("shift1d_accumulate_", &shift1d_accumulate_cpu);
+    m.impl("shift2d_accumulate_", &shift2d_accumulate_cpu);
+    m.impl("shift3d_accumulate_", &shift3d_accumulate_cpu);
+    m.impl("_shift1d_backward_accumulate_", &shift1d_backward_accumulate_cpu);
+    m.impl("_shift2d_backward_accumulate_", &shift2d_backward_accumulate_cpu);
+    m.impl("_shift3d_backward_accumulate_", &shift3d_backward_accumulate_cpu);
+    m.impl("shift1d_multi", &shift1d_multi_forward_cpu);
+    m.impl("shift2d_multi", &shift2d_multi_forward_cpu);
+    m.impl("shift3d_multi", &shift3d_multi_forward_cpu);
+    m.impl("_shift1d_multi_backward", &shift1d_multi_backward_cpu);
+    m.impl("_shift2d_multi_backward", &shift2d_multi_backward_cpu);
+    m.impl("_shift3d_multi_backward", &shift3d_multi_backward_cpu);
+    m.impl("shift1d_packed", &shift1d_packed_forward_cpu);
+    m.impl("shift2d_packed", &shift2d_packed_forward_cpu);
+    m.impl("shift3d_packed", &shift3d_packed_forward_cpu);
+    m.impl("_shift1d_packed_backward", &shift1d_packed_backward_cpu);
+    m.impl("_shift2d_packed_backward", &shift2d_packed_backward_cpu);
+    m.impl("_shift3d_packed_backward", &shift3d_packed_backward_cpu);
+    m.impl("_shift1d_lowmem_backward", &shift1d_lowmem_backward_cpu);
+    m.impl("_shift2d_lowmem_backward", &shift2d_lowmem_backward_cpu);
+    m.impl("_shift3d_lowmem_backward", &shift3d_lowmem_backward_cpu);
+    m.impl("shift3d_sparse", &shift3d_sparse_forward_cpu);
+    m.impl("_shift3d_sparse_backward", &shift3d_sparse_backward_cpu);
+    m.impl("shiftnd", &shiftnd_generic_forward_cpu);
+    m.impl("_shiftnd_backward", &shiftnd_generic_backward_cpu);
+}
 
-#endif
\ No newline at end of file
+#endif
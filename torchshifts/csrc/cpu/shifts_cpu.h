@@ -1,5 +1,5 @@
 #pragma once
-#include <torch/extension.h>
+#include <torch/torch.h>
 #include "../global_scope.h"
 
 
@@ -7,35 +7,239 @@
 API_EXPORT torch::Tensor shift1d_forward_cpu(const torch::Tensor& input,
                                              const torch::Tensor& weights,
                                              int64_t padding_mode,
-                                             bool active_flag);
+                                             bool active_flag,
+                                             c10::IntArrayRef stride,
+                                             c10::IntArrayRef dilation,
+                                             c10::optional<c10::MemoryFormat> memory_format,
+                                             const c10::optional<torch::Tensor>& channel_perm,
+                                             double sparsity);
 
 
 API_EXPORT torch::Tensor shift2d_forward_cpu(const torch::Tensor& input,
                                              const torch::Tensor& weights,
                                              int64_t padding_mode,
-                                             bool active_flag);
+                                             bool active_flag,
+                                             c10::IntArrayRef stride,
+                                             c10::IntArrayRef dilation,
+                                             c10::optional<c10::MemoryFormat> memory_format,
+                                             const c10::optional<torch::Tensor>& channel_perm,
+                                             double sparsity);
 
 
 API_EXPORT torch::Tensor shift3d_forward_cpu(const torch::Tensor& input,
                                              const torch::Tensor& weights,
                                              int64_t padding_mode,
-                                             bool active_flag);
+                                             bool active_flag,
+                                             c10::IntArrayRef stride,
+                                             c10::IntArrayRef dilation,
+                                             c10::optional<c10::MemoryFormat> memory_format,
+                                             const c10::optional<torch::Tensor>& channel_perm,
+                                             double sparsity);
 
 API_EXPORT std::vector<torch::Tensor> shift1d_backward_cpu(const torch::Tensor& grad,
                                                            const torch::Tensor& weights,
                                                            const torch::Tensor& input,
                                                            int64_t padding_mode,
-                                                           bool active_flag);
+                                                           bool active_flag,
+                                                           c10::IntArrayRef stride,
+                                                           c10::IntArrayRef dilation,
+                                                           double sparsity);
 
 API_EXPORT std::vector<torch::Tensor> shift2d_backward_cpu(const torch::Tensor& grad,
                                                            const torch::Tensor& weights,
                                                            const torch::Tensor& input,
                                                            int64_t padding_mode,
-                                                           bool active_flag);
+                                                           bool active_flag,
+                                                           c10::IntArrayRef stride,
+                                                           c10::IntArrayRef dilation,
+                                                           double sparsity);
 
 
 API_EXPORT std::vector<torch::Tensor> shift3d_backward_cpu(const torch::Tensor& grad,
                                                            const torch::Tensor& weights,
                                                            const torch::Tensor& input,
                                                            int64_t padding_mode,
-                                                           bool active_flag);
+                                                           bool active_flag,
+                                                           c10::IntArrayRef stride,
+                                                           c10::IntArrayRef dilation,
+                                                           double sparsity);
+
+API_EXPORT torch::Tensor& shift1d_accumulate_cpu(torch::Tensor& out,
+                                                 const torch::Tensor& input,
+                                                 const torch::Tensor& weights,
+                                                 int64_t padding_mode,
+                                                 bool active_flag,
+                                                 double alpha, double beta,
+                                                 c10::IntArrayRef stride,
+                                                 c10::IntArrayRef dilation);
+
+API_EXPORT torch::Tensor& shift2d_accumulate_cpu(torch::Tensor& out,
+                                                 const torch::Tensor& input,
+                                                 const torch::Tensor& weights,
+                                                 int64_t padding_mode,
+                                                 bool active_flag,
+                                                 double alpha, double beta,
+                                                 c10::IntArrayRef stride,
+                                                 c10::IntArrayRef dilation);
+
+API_EXPORT torch::Tensor& shift3d_accumulate_cpu(torch::Tensor& out,
+                                                 const torch::Tensor& input,
+                                                 const torch::Tensor& weights,
+                                                 int64_t padding_mode,
+                                                 bool active_flag,
+                                                 double alpha, double beta,
+                                                 c10::IntArrayRef stride,
+                                                 c10::IntArrayRef dilation);
+
+API_EXPORT torch::Tensor shift1d_backward_accumulate_cpu(torch::Tensor& out_grad,
+                                                         const torch::Tensor& grad,
+                                                         const torch::Tensor& weights,
+                                                         const torch::Tensor& input,
+                                                         int64_t padding_mode,
+                                                         bool active_flag,
+                                                         double alpha, double beta,
+                                                         c10::IntArrayRef stride,
+                                                         c10::IntArrayRef dilation);
+
+API_EXPORT torch::Tensor shift2d_backward_accumulate_cpu(torch::Tensor& out_grad,
+                                                         const torch::Tensor& grad,
+                                                         const torch::Tensor& weights,
+                                                         const torch::Tensor& input,
+                                                         int64_t padding_mode,
+                                                         bool active_flag,
+                                                         double alpha, double beta,
+                                                         c10::IntArrayRef stride,
+                                                         c10::IntArrayRef dilation);
+
+API_EXPORT torch::Tensor shift3d_backward_accumulate_cpu(torch::Tensor& out_grad,
+                                                         const torch::Tensor& grad,
+                                                         const torch::Tensor& weights,
+                                                         const torch::Tensor& input,
+                                                         int64_t padding_mode,
+                                                         bool active_flag,
+                                                         double alpha, double beta,
+                                                         c10::IntArrayRef stride,
+                                                         c10::IntArrayRef dilation);
+
+API_EXPORT torch::Tensor shift1d_multi_forward_cpu(const torch::Tensor& input,
+                                                   const torch::Tensor& weights,
+                                                   int64_t padding_mode,
+                                                   bool active_flag);
+
+API_EXPORT torch::Tensor shift2d_multi_forward_cpu(const torch::Tensor& input,
+                                                   const torch::Tensor& weights,
+                                                   int64_t padding_mode,
+                                                   bool active_flag);
+
+API_EXPORT torch::Tensor shift3d_multi_forward_cpu(const torch::Tensor& input,
+                                                   const torch::Tensor& weights,
+                                                   int64_t padding_mode,
+                                                   bool active_flag);
+
+API_EXPORT std::vector<torch::Tensor> shift1d_multi_backward_cpu(const torch::Tensor& grad,
+                                                                 const torch::Tensor& weights,
+                                                                 const torch::Tensor& input,
+                                                                 int64_t padding_mode,
+                                                                 bool active_flag);
+
+API_EXPORT std::vector<torch::Tensor> shift2d_multi_backward_cpu(const torch::Tensor& grad,
+                                                                 const torch::Tensor& weights,
+                                                                 const torch::Tensor& input,
+                                                                 int64_t padding_mode,
+                                                                 bool active_flag);
+
+API_EXPORT std::vector<torch::Tensor> shift3d_multi_backward_cpu(const torch::Tensor& grad,
+                                                                 const torch::Tensor& weights,
+                                                                 const torch::Tensor& input,
+                                                                 int64_t padding_mode,
+                                                                 bool active_flag);
+
+API_EXPORT torch::Tensor shift1d_packed_forward_cpu(const torch::Tensor& input,
+                                                    const torch::Tensor& sizes,
+                                                    const torch::Tensor& weights,
+                                                    int64_t padding_mode,
+                                                    bool active_flag);
+
+API_EXPORT torch::Tensor shift2d_packed_forward_cpu(const torch::Tensor& input,
+                                                    const torch::Tensor& sizes,
+                                                    const torch::Tensor& weights,
+                                                    int64_t padding_mode,
+                                                    bool active_flag);
+
+API_EXPORT torch::Tensor shift3d_packed_forward_cpu(const torch::Tensor& input,
+                                                    const torch::Tensor& sizes,
+                                                    const torch::Tensor& weights,
+                                                    int64_t padding_mode,
+                                                    bool active_flag);
+
+API_EXPORT std::vector<torch::Tensor> shift1d_packed_backward_cpu(const torch::Tensor& grad,
+                                                                  const torch::Tensor& sizes,
+                                                                  const torch::Tensor& weights,
+                                                                  const torch::Tensor& input,
+                                                                  int64_t padding_mode,
+                                                                  bool active_flag);
+
+API_EXPORT std::vector<torch::Tensor> shift2d_packed_backward_cpu(const torch::Tensor& grad,
+                                                                  const torch::Tensor& sizes,
+                                                                  const torch::Tensor& weights,
+                                                                  const torch::Tensor& input,
+                                                                  int64_t padding_mode,
+                                                                  bool active_flag);
+
+API_EXPORT std::vector<torch::Tensor> shift3d_packed_backward_cpu(const torch::Tensor& grad,
+                                                                  const torch::Tensor& sizes,
+                                                                  const torch::Tensor& weights,
+                                                                  const torch::Tensor& input,
+                                                                  int64_t padding_mode,
+                                                                  bool active_flag);
+
+API_EXPORT std::vector<torch::Tensor> shift1d_lowmem_backward_cpu(const torch::Tensor& grad,
+                                                                  const torch::Tensor& weights,
+                                                                  const torch::Tensor& saved,
+                                                                  const c10::optional<torch::Tensor>& scale,
+                                                                  int64_t padding_mode,
+                                                                  bool active_flag,
+                                                                  c10::IntArrayRef stride,
+                                                                  c10::IntArrayRef dilation);
+
+API_EXPORT std::vector<torch::Tensor> shift2d_lowmem_backward_cpu(const torch::Tensor& grad,
+                                                                  const torch::Tensor& weights,
+                                                                  const torch::Tensor& saved,
+                                                                  const c10::optional<torch::Tensor>& scale,
+                                                                  int64_t padding_mode,
+                                                                  bool active_flag,
+                                                                  c10::IntArrayRef stride,
+                                                                  c10::IntArrayRef dilation);
+
+API_EXPORT std::vector<torch::Tensor> shift3d_lowmem_backward_cpu(const torch::Tensor& grad,
+                                                                  const torch::Tensor& weights,
+                                                                  const torch::Tensor& saved,
+                                                                  const c10::optional<torch::Tensor>& scale,
+                                                                  int64_t padding_mode,
+                                                                  bool active_flag,
+                                                                  c10::IntArrayRef stride,
+                                                                  c10::IntArrayRef dilation);
+
+API_EXPORT torch::Tensor shift3d_sparse_forward_cpu(const torch::Tensor& features,
+                                                    const torch::Tensor& coords,
+                                                    c10::IntArrayRef spatial_size,
+                                                    const torch::Tensor& weights,
+                                                    bool active_flag);
+
+API_EXPORT std::vector<torch::Tensor> shift3d_sparse_backward_cpu(const torch::Tensor& grad,
+                                                                  const torch::Tensor& coords,
+                                                                  c10::IntArrayRef spatial_size,
+                                                                  const torch::Tensor& weights,
+                                                                  const torch::Tensor& features,
+                                                                  bool active_flag);
+
+API_EXPORT torch::Tensor shiftnd_generic_forward_cpu(const torch::Tensor& input,
+                                                     const torch::Tensor& weights,
+                                                     int64_t padding_mode,
+                                                     bool active_flag);
+
+API_EXPORT std::vector<torch::Tensor> shiftnd_generic_backward_cpu(const torch::Tensor& grad,
+                                                                   const torch::Tensor& weights,
+                                                                   const torch::Tensor& input,
+                                                                   int64_t padding_mode,
+                                                                   bool active_flag);
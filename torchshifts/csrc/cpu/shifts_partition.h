@@ -0,0 +1,166 @@
+#pragma once
+#include <torch/torch.h>
+#include <algorithm>
+#include "../global_scope.h"
+
+#define SHIFTS_CACHE_LINE 64
+// Amount of element-work below which waking up the thread pool costs more than the loop itself
+#define SHIFTS_MIN_PARALLEL_WORK 32768
+// Minimal amount of element-work in one task
+#define SHIFTS_MIN_TASK_WORK 8192
+// Tasks per thread, gives some room for load balancing
+#define SHIFTS_TASKS_PER_THREAD 4
+
+
+namespace shifts {
+    namespace partition {
+        // Axis along which the (N, C, H, W*D) iteration space is split between threads
+        enum class Axis {Serial, Batch, ChannelBlock, Rows};
+
+        struct Geometry {
+            int64_t sizeN;
+            int64_t sizeC;
+            int64_t sizeH;
+            int64_t sizeR;          // W*D, the part of the row which is never split
+            int64_t element_size;
+            bool channels_inner;    // traversal order: true - NHWDC, false - NCHWD
+            int64_t cost;           // relative cost of one element (loads per output)
+        };
+
+        // outer items are grouped into blocks of `block` items, blocks are the unit of work of parallel_for,
+        // so chunk boundaries are always multiples of `block`
+        struct Plan {
+            Axis axis;
+            bool channels_inner;
+            int64_t sizeC;
+            int64_t sizeH;
+            int64_t cblock;
+            int64_t ncblocks;
+            int64_t outer;
+            int64_t block;
+            int64_t nblocks;
+        };
+
+        inline int64_t divup(int64_t a, int64_t b){ return (a + b - 1) / b; }
+
+        inline int64_t gcd(int64_t a, int64_t b){
+            while (b != 0){ int64_t t = a % b; a = b; b = t; }
+            return a;
+        }
+
+        inline int64_t channel_block(const Geometry& g){
+            if (g.channels_inner){
+                // channel segments of one pixel start on cache line boundaries
+                return std::max<int64_t>(1, SHIFTS_CACHE_LINE / g.element_size);
+            }
+            // group whole planes until they make a task
+            return std::max<int64_t>(1, std::min<int64_t>(g.sizeC, divup(SHIFTS_MIN_TASK_WORK, g.sizeH*g.sizeR*g.cost)));
+        }
+
+        inline Plan make_plan(Axis axis, const Geometry& g){
+            Plan p;
+            p.axis = axis;
+            p.channels_inner = g.channels_inner;
+            p.sizeC = g.sizeC;
+            p.sizeH = g.sizeH;
+            p.cblock = channel_block(g);
+            p.ncblocks = divup(g.sizeC, p.cblock);
+            int64_t item_elements = 0;
+            switch (axis){
+                case Axis::Serial:
+                case Axis::Batch:
+                    p.outer = g.sizeN;
+                    item_elements = g.sizeC*g.sizeH*g.sizeR;
+                    break;
+                case Axis::ChannelBlock:
+                    p.outer = g.sizeN*p.ncblocks;
+                    item_elements = p.cblock*g.sizeH*g.sizeR;
+                    break;
+                case Axis::Rows:
+                    p.outer = g.channels_inner ? g.sizeN*g.sizeH : g.sizeN*g.sizeC*g.sizeH;
+                    item_elements = g.channels_inner ? g.sizeR*g.sizeC : g.sizeR;
+                    break;
+            }
+            item_elements = std::max<int64_t>(item_elements, 1);
+            p.outer = std::max<int64_t>(p.outer, 1);
+            if (axis == Axis::Serial){
+                p.block = p.outer;
+                p.nblocks = 1;
+                return p;
+            }
+            int64_t block = divup(SHIFTS_MIN_TASK_WORK, item_elements*g.cost);
+            int64_t align = 1;
+            if (axis == Axis::Rows){
+                // rows are contiguous in memory: make chunk seams fall on cache line boundaries
+                int64_t item_bytes = item_elements*g.element_size;
+                align = SHIFTS_CACHE_LINE / gcd(item_bytes, SHIFTS_CACHE_LINE);
+                block = divup(block, align) * align;
+            }
+            // do not starve threads: clamp after rounding, keeping alignment while the limit allows it
+            int64_t threads = std::max<int64_t>(1, at::get_num_threads());
+            int64_t limit = std::max<int64_t>(1, divup(p.outer, threads));
+            if (block > limit){
+                block = (limit >= align) ? (limit / align) * align : limit;
+            }
+            p.block = std::max<int64_t>(1, block);
+            p.nblocks = divup(p.outer, p.block);
+            return p;
+        }
+
+        // Cost model: serial for small work, otherwise the coarsest axis which still feeds all threads.
+        inline Plan choose_plan(const Geometry& g){
+            int64_t threads = at::get_num_threads();
+            int64_t work = g.sizeN*g.sizeC*g.sizeH*g.sizeR*g.cost;
+            if ((threads <= 1) || (work < SHIFTS_MIN_PARALLEL_WORK) || at::in_parallel_region()){
+                return make_plan(Axis::Serial, g);
+            }
+            int64_t wanted = threads * SHIFTS_TASKS_PER_THREAD;
+            if (g.sizeN >= wanted){
+                return make_plan(Axis::Batch, g);
+            }
+            if (g.sizeN*divup(g.sizeC, channel_block(g)) >= wanted){
+                return make_plan(Axis::ChannelBlock, g);
+            }
+            return make_plan(Axis::Rows, g);
+        }
+
+        // Calls f(n, c_begin, c_end, i_begin, i_end) for every tile of the plan
+        template <typename F>
+        inline void for_each_tile(const Plan& p, const F& f){
+            auto run = [&](int64_t start, int64_t end){
+                for (int64_t index = start; index < end; ++index) {
+                    switch (p.axis){
+                        case Axis::Serial:
+                        case Axis::Batch:
+                            f(index, 0, p.sizeC, 0, p.sizeH);
+                            break;
+                        case Axis::ChannelBlock: {
+                            int64_t cb = index % p.ncblocks;
+                            int64_t n = index / p.ncblocks;
+                            f(n, cb*p.cblock, std::min(p.sizeC, (cb + 1)*p.cblock), 0, p.sizeH);
+                            break;
+                        }
+                        case Axis::Rows: {
+                            int64_t i = index % p.sizeH;
+                            if (p.channels_inner){
+                                f(index / p.sizeH, 0, p.sizeC, i, i + 1);
+                            }
+                            else {
+                                int64_t c = (index / p.sizeH) % p.sizeC;
+                                f(index / (p.sizeH*p.sizeC), c, c + 1, i, i + 1);
+                            }
+                            break;
+                        }
+                    }
+                }
+            };
+            if (p.axis == Axis::Serial){
+                run(0, p.outer);
+                return;
+            }
+            at::parallel_for(0, p.nblocks, 1, [&](int64_t bstart, int64_t bend){
+                run(bstart*p.block, std::min(p.outer, bend*p.block));
+            });
+        }
+    }
+}
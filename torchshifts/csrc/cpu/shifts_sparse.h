@@ -0,0 +1,137 @@
+#pragma once
+#include <torch/torch.h>
+#include <array>
+#include <map>
+#include <vector>
+#include "../global_scope.h"
+
+
+namespace shifts {
+    namespace sparse {
+        // Open addressing(linear probing) hash of occupied voxels: (n, i, j, k) -> row of features.
+        // Built once per call for the whole batch, lookups outside of the grid are misses(Zeros padding).
+        // The table is an int64 tensor [2, capacity](keys, -1 - empty slot, and rows), so autograd of shift3d_sparse
+        // keeps the one built by forward for backward(Shift3dSparseFunction, not exposed by the op schemas).
+        struct VoxelHash {
+            torch::Tensor table;
+            const int64_t* keys;
+            const int64_t* rows;
+            uint64_t mask;
+            int64_t sizeH;
+            int64_t sizeW;
+            int64_t sizeD;
+
+            // builds the table, coords are validated(inside of the grid, no duplicates)
+            VoxelHash(const torch::Tensor& coords, const std::array<int64_t, 3>& spatial_size)
+                : sizeH(spatial_size[0]), sizeW(spatial_size[1]), sizeD(spatial_size[2]){
+                int64_t sizeM = coords.size(0);
+                int64_t capacity = table_capacity(sizeM);
+                mask = static_cast<uint64_t>(capacity - 1);
+                table = torch::full({2, capacity}, -1, coords.options().dtype(torch::kLong));
+                int64_t* keys_ptr = table.data_ptr<int64_t>();
+                int64_t* rows_ptr = keys_ptr + capacity;
+                auto coords_acc = coords.accessor<int64_t, 2>();
+                for (int64_t m = 0; m < sizeM; ++m){
+                    int64_t n = coords_acc[m][0];
+                    int64_t i = coords_acc[m][1];
+                    int64_t j = coords_acc[m][2];
+                    int64_t k = coords_acc[m][3];
+                    TORCH_CHECK((n >= 0) && inside(i, j, k),
+                                "shift3d_sparse: voxel ", m, " (", n, ", ", i, ", ", j, ", ", k, ") is outside of the grid");
+                    int64_t key = make_key(n, i, j, k);
+                    uint64_t slot = mix(key) & mask;
+                    while (keys_ptr[slot] >= 0){
+                        TORCH_CHECK(keys_ptr[slot] != key, "shift3d_sparse: voxel ", m, " (", n, ", ", i, ", ", j, ", ", k, ") is duplicated");
+                        slot = (slot + 1) & mask;
+                    }
+                    keys_ptr[slot] = key;
+                    rows_ptr[slot] = m;
+                }
+                keys = keys_ptr;
+                rows = rows_ptr;
+            }
+
+            // reuses a table built by the constructor above for the same coords and spatial_size(internal only:
+            // nothing is rebuilt or revalidated)
+            VoxelHash(const torch::Tensor& hash_table, int64_t sizeM, const std::array<int64_t, 3>& spatial_size)
+                : table(hash_table), sizeH(spatial_size[0]), sizeW(spatial_size[1]), sizeD(spatial_size[2]){
+                int64_t capacity = table_capacity(sizeM);
+                TORCH_CHECK((table.dim() == 2) && (table.size(0) == 2) && (table.size(1) == capacity) &&
+                            (table.scalar_type() == torch::kLong) && table.is_contiguous(),
+                            "shift3d_sparse: expected contiguous int64 hash of shape [2, ", capacity, "], but got ", table.sizes());
+                mask = static_cast<uint64_t>(capacity - 1);
+                keys = table.data_ptr<int64_t>();
+                rows = keys + capacity;
+            }
+
+            // power of two with load factor <= 0.5
+            static int64_t table_capacity(int64_t sizeM){
+                int64_t capacity = 16;
+                while (capacity < 2*sizeM){ capacity <<= 1; }
+                return capacity;
+            }
+
+            // splitmix64 finalizer: neighbouring voxels go to distant slots
+            static uint64_t mix(int64_t key){
+                uint64_t x = static_cast<uint64_t>(key);
+                x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+                x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+                return x ^ (x >> 31);
+            }
+
+            bool inside(int64_t i, int64_t j, int64_t k) const {
+                return (i >= 0) && (i < sizeH) && (j >= 0) && (j < sizeW) && (k >= 0) && (k < sizeD);
+            }
+
+            int64_t make_key(int64_t n, int64_t i, int64_t j, int64_t k) const {
+                return ((n*sizeH + i)*sizeW + j)*sizeD + k;
+            }
+
+            // row of voxel (n, i, j, k) or -1 if it is empty
+            int64_t find(int64_t n, int64_t i, int64_t j, int64_t k) const {
+                if (!inside(i, j, k)){ return -1; }
+                int64_t key = make_key(n, i, j, k);
+                for (uint64_t slot = mix(key) & mask;; slot = (slot + 1) & mask){
+                    if (keys[slot] == key){ return rows[slot]; }
+                    if (keys[slot] < 0){ return -1; }
+                }
+            }
+        };
+
+        // Channels with equal integer shift: one hash lookup per voxel serves all of them
+        struct ShiftGroup {
+            std::array<int64_t, 3> shift;
+            std::vector<int64_t> channels;
+        };
+
+        inline std::vector<ShiftGroup> shift_groups(const torch::Tensor& iweights){
+            torch::Tensor w = iweights.contiguous();
+            auto w_acc = w.accessor<int64_t, 2>();
+            std::map<std::array<int64_t, 3>, std::vector<int64_t>> by_shift;
+            for (int64_t c = 0; c < w.size(0); ++c){
+                by_shift[{w_acc[c][0], w_acc[c][1], w_acc[c][2]}].push_back(c);
+            }
+            std::vector<ShiftGroup> groups;
+            groups.reserve(by_shift.size());
+            for (auto& item : by_shift){
+                groups.push_back({item.first, std::move(item.second)});
+            }
+            return groups;
+        }
+    }
+}
+
+
+// Sparse shift with a prebuilt hash(shifts_cpu.cpp), coords and weights must be already checked(check_sparse_voxels)
+API_EXPORT torch::Tensor shift3d_sparse_forward_hashed_cpu(const torch::Tensor& features,
+                                                           const torch::Tensor& coords,
+                                                           const torch::Tensor& weights,
+                                                           bool active_flag,
+                                                           const shifts::sparse::VoxelHash& hash);
+
+API_EXPORT std::vector<torch::Tensor> shift3d_sparse_backward_hashed_cpu(const torch::Tensor& grad,
+                                                                         const torch::Tensor& coords,
+                                                                         const torch::Tensor& weights,
+                                                                         const torch::Tensor& features,
+                                                                         bool active_flag,
+                                                                         const shifts::sparse::VoxelHash& hash);
@@ -12,7 +12,9 @@
 #include <c10/macros/Macros.h>
 
 // include own header files
+#include <torch/library.h>
 #include "shifts_cuda.h"
+#include "../shifts_params.h"
 
 
 using namespace at::cuda::detail;
@@ -28,11 +30,17 @@ __global__ void _shifts_cuda(const idx_t n_threads,
                              TensorInfo<idx_t, idx_t> iweights,
                              TensorInfo<scalar_t, idx_t> dweights,
                              TensorInfo<scalar_t, idx_t> output,
-                             const BIPadding padding_mode,  bool active){
+                             const idx_t stepH, const idx_t stepW, const idx_t stepD,
+                             const scalar_t alpha, const scalar_t beta,
+                             const BIPadding padding_mode,  bool active,
+                             const idx_t* perm){
     idx_t sizeC = input.sizes[1];
     idx_t sizeH = input.sizes[2];
     idx_t sizeW = kSpatialDim < 2 ? 1 : input.sizes[3];
     idx_t sizeD = kSpatialDim < 3 ? 1 : input.sizes[4];
+    idx_t outH = output.sizes[2];
+    idx_t outW = kSpatialDim < 2 ? 1 : output.sizes[3];
+    idx_t outD = kSpatialDim < 3 ? 1 : output.sizes[4];
     idx_t input_sN = input.strides[0];
     idx_t input_sC = input.strides[1];
     idx_t input_sH = input.strides[2];
@@ -46,24 +54,30 @@ __global__ void _shifts_cuda(const idx_t n_threads,
     scalar_t *input_ptr = input.data;
     scalar_t *output_ptr = output.data;
     idx_t *weights_ptr = iweights.data;
-    idx_t weights_sC = iweights.strides[0];
-    idx_t weights_sS = iweights.strides[1];
+    idx_t weights_sN = iweights.strides[0];
+    idx_t weights_sC = iweights.strides[1];
+    idx_t weights_sS = iweights.strides[2];
     scalar_t *dweights_ptr = dweights.data;
-    idx_t dweights_sC = dweights.strides[0];
-    idx_t dweights_sS = dweights.strides[1];
+    idx_t dweights_sN = dweights.strides[0];
+    idx_t dweights_sC = dweights.strides[1];
+    idx_t dweights_sS = dweights.strides[2];
 
     CUDA_KERNEL_LOOP_TYPE(index, n_threads, idx_t){
-        const idx_t k = index % sizeD;
-        const idx_t j = (index / sizeD) % sizeW;
-        const idx_t i = (index / (sizeD*sizeW)) % sizeH;
-        const idx_t c = (index / (sizeD*sizeW*sizeH)) % sizeC;
-        const idx_t n = (index / (sizeD*sizeW*sizeH*sizeC));
-        shift_forward_kernel_nchwd<scalar_t, idx_t>(input_ptr, output_ptr, weights_ptr, dweights_ptr,
+        const idx_t k = index % outD;
+        const idx_t j = (index / outD) % outW;
+        const idx_t i = (index / (outD*outW)) % outH;
+        const idx_t c = (index / (outD*outW*outH)) % sizeC;
+        const idx_t n = (index / (outD*outW*outH*sizeC));
+        // channel permutation: base is moved so that channel c lands in perm[c]
+        scalar_t *output_c = (perm != nullptr) ? output_ptr + (perm[c] - c)*output_sC : output_ptr;
+        shift_forward_kernel_nchwd<scalar_t, idx_t>(input_ptr, output_c,
+                                                    weights_ptr + n*weights_sN, dweights_ptr + n*dweights_sN,
                                                     n, c, i, j, k, sizeH, sizeW, sizeD,
+                                                    stepH, stepW, stepD,
                                                     input_sN, input_sC, input_sH, input_sW, input_sD,
                                                     output_sN, output_sC, output_sH, output_sW, output_sD,
                                                     weights_sC, weights_sS, dweights_sC, dweights_sS,
-                                                    padding_mode, active);
+                                                    alpha, beta, padding_mode, active);
          
     }
 }
@@ -77,6 +91,7 @@ __global__ void _shifts_backward_cuda(const idx_t n_threads,
                                       TensorInfo<scalar_t, idx_t> input, 
                                       TensorInfo<scalar_t, idx_t> grad_output,
                                       TensorInfo<scalar_t, idx_t> grad_weights,
+                                      const scalar_t alpha, const scalar_t beta,
                                       const BIPadding padding_mode, bool active)
 {
     idx_t sizeC = grad_input.sizes[1];
@@ -98,18 +113,21 @@ __global__ void _shifts_backward_cuda(const idx_t n_threads,
     idx_t grad_output_sH = grad_output.strides[2];
     idx_t grad_output_sW = kSpatialDim < 2 ? 0 : grad_output.strides[3];
     idx_t grad_output_sD = kSpatialDim < 3 ? 0 : grad_output.strides[4];
-    idx_t grad_weights_sC = grad_weights.strides[0];
-    idx_t grad_weights_sS = grad_weights.strides[1];
+    idx_t grad_weights_sN = grad_weights.strides[0];
+    idx_t grad_weights_sC = grad_weights.strides[1];
+    idx_t grad_weights_sS = grad_weights.strides[2];
     scalar_t *grad_input_ptr = grad_input.data;
     scalar_t *input_ptr = input.data;
     scalar_t *grad_output_ptr = grad_output.data;
     scalar_t *grad_weights_ptr = grad_weights.data;
     idx_t *weights_ptr = iweights.data;
-    idx_t weights_sC = iweights.strides[0];
-    idx_t weights_sS = iweights.strides[1];
+    idx_t weights_sN = iweights.strides[0];
+    idx_t weights_sC = iweights.strides[1];
+    idx_t weights_sS = iweights.strides[2];
     scalar_t *dweights_ptr = dweights.data;
-    idx_t dweights_sC = dweights.strides[0];
-    idx_t dweights_sS = dweights.strides[1];
+    idx_t dweights_sN = dweights.strides[0];
+    idx_t dweights_sC = dweights.strides[1];
+    idx_t dweights_sS = dweights.strides[2];
 
     CUDA_KERNEL_LOOP_TYPE(index, n_threads, idx_t){
         const idx_t k = index % sizeD;
@@ -118,24 +136,274 @@ __global__ void _shifts_backward_cuda(const idx_t n_threads,
         const idx_t c = (index / (sizeD*sizeW*sizeH)) % sizeC;
         const idx_t n = (index / (sizeD*sizeW*sizeH*sizeC));
         shift_backward_kernel_nchwd<scalar_t, idx_t>(grad_input_ptr, input_ptr, grad_output_ptr,
-                                                     weights_ptr, dweights_ptr,  grad_weights_ptr,
+                                                     weights_ptr + n*weights_sN, dweights_ptr + n*dweights_sN,
+                                                     grad_weights_ptr + n*grad_weights_sN,
                                                      n, c, i, j, k, sizeH, sizeW, sizeD,
                                                      grad_input_sN, grad_input_sC, grad_input_sH, grad_input_sW, grad_input_sD,
                                                      input_sN, input_sC, input_sH, input_sW, input_sD,
                                                      grad_output_sN, grad_output_sC, grad_output_sH, grad_output_sW, grad_output_sD,
                                                      weights_sC, weights_sS, dweights_sC, dweights_sS, grad_weights_sC, grad_weights_sS,
-                                                     padding_mode, active);
+                                                     alpha, beta, padding_mode, active);
+    }
+}
+
+// Weight gradients for stride > 1: one thread per output position
+template <typename scalar_t, int kSpatialDim, typename idx_t>
+C10_LAUNCH_BOUNDS_1(CUDA_THREADS)
+__global__ void _shifts_backward_weights_strided_cuda(const idx_t n_threads,
+                                                      TensorInfo<scalar_t, idx_t> grad_input,
+                                                      TensorInfo<idx_t, idx_t> iweights,
+                                                      TensorInfo<scalar_t, idx_t> dweights,
+                                                      TensorInfo<scalar_t, idx_t> input,
+                                                      TensorInfo<scalar_t, idx_t> grad_weights,
+                                                      const idx_t stepH, const idx_t stepW, const idx_t stepD,
+                                                      const BIPadding padding_mode)
+{
+    idx_t sizeC = input.sizes[1];
+    idx_t sizeH = input.sizes[2];
+    idx_t sizeW = kSpatialDim < 2 ? 1 : input.sizes[3];
+    idx_t sizeD = kSpatialDim < 3 ? 1 : input.sizes[4];
+    idx_t outH = grad_input.sizes[2];
+    idx_t outW = kSpatialDim < 2 ? 1 : grad_input.sizes[3];
+    idx_t outD = kSpatialDim < 3 ? 1 : grad_input.sizes[4];
+    idx_t grad_input_sN = grad_input.strides[0];
+    idx_t grad_input_sC = grad_input.strides[1];
+    idx_t grad_input_sH = grad_input.strides[2];
+    idx_t grad_input_sW = kSpatialDim < 2 ? 0 : grad_input.strides[3];
+    idx_t grad_input_sD = kSpatialDim < 3 ? 0 : grad_input.strides[4];
+    idx_t input_sN = input.strides[0];
+    idx_t input_sC = input.strides[1];
+    idx_t input_sH = input.strides[2];
+    idx_t input_sW = kSpatialDim < 2 ? 0 : input.strides[3];
+    idx_t input_sD = kSpatialDim < 3 ? 0 : input.strides[4];
+    idx_t grad_weights_sN = grad_weights.strides[0];
+    idx_t grad_weights_sC = grad_weights.strides[1];
+    idx_t grad_weights_sS = grad_weights.strides[2];
+    scalar_t *grad_input_ptr = grad_input.data;
+    scalar_t *input_ptr = input.data;
+    scalar_t *grad_weights_ptr = grad_weights.data;
+    idx_t *weights_ptr = iweights.data;
+    idx_t weights_sN = iweights.strides[0];
+    idx_t weights_sC = iweights.strides[1];
+    idx_t weights_sS = iweights.strides[2];
+    scalar_t *dweights_ptr = dweights.data;
+    idx_t dweights_sN = dweights.strides[0];
+    idx_t dweights_sC = dweights.strides[1];
+    idx_t dweights_sS = dweights.strides[2];
+
+    CUDA_KERNEL_LOOP_TYPE(index, n_threads, idx_t){
+        const idx_t k = index % outD;
+        const idx_t j = (index / outD) % outW;
+        const idx_t i = (index / (outD*outW)) % outH;
+        const idx_t c = (index / (outD*outW*outH)) % sizeC;
+        const idx_t n = (index / (outD*outW*outH*sizeC));
+        shift_backward_weights_kernel_strided<scalar_t, idx_t>(grad_input_ptr, input_ptr,
+                                                               weights_ptr + n*weights_sN, dweights_ptr + n*dweights_sN,
+                                                               grad_weights_ptr + n*grad_weights_sN,
+                                                               n, c, i, j, k, sizeH, sizeW, sizeD,
+                                                               stepH, stepW, stepD,
+                                                               grad_input_sN, grad_input_sC, grad_input_sH, grad_input_sW, grad_input_sD,
+                                                               input_sN, input_sC, input_sH, input_sW, input_sD,
+                                                               weights_sC, weights_sS, dweights_sC, dweights_sS, grad_weights_sC, grad_weights_sS,
+                                                               padding_mode);
+    }
+}
+
+// Input gradient for stride > 1: one thread per input position, gathers like the stride 1 kernel
+template <typename scalar_t, int kSpatialDim, typename idx_t>
+C10_LAUNCH_BOUNDS_1(CUDA_THREADS)
+__global__ void _shifts_backward_input_strided_cuda(const idx_t n_threads,
+                                                    TensorInfo<scalar_t, idx_t> grad_input,
+                                                    TensorInfo<idx_t, idx_t> iweights,
+                                                    TensorInfo<scalar_t, idx_t> dweights,
+                                                    TensorInfo<scalar_t, idx_t> grad_output,
+                                                    const idx_t stepH, const idx_t stepW, const idx_t stepD,
+                                                    const scalar_t alpha, const scalar_t beta,
+                                                    const BIPadding padding_mode, bool active)
+{
+    idx_t sizeC = grad_output.sizes[1];
+    idx_t sizeH = grad_output.sizes[2];
+    idx_t sizeW = kSpatialDim < 2 ? 1 : grad_output.sizes[3];
+    idx_t sizeD = kSpatialDim < 3 ? 1 : grad_output.sizes[4];
+    idx_t grad_input_sN = grad_input.strides[0];
+    idx_t grad_input_sC = grad_input.strides[1];
+    idx_t grad_input_sH = grad_input.strides[2];
+    idx_t grad_input_sW = kSpatialDim < 2 ? 0 : grad_input.strides[3];
+    idx_t grad_input_sD = kSpatialDim < 3 ? 0 : grad_input.strides[4];
+    idx_t grad_output_sN = grad_output.strides[0];
+    idx_t grad_output_sC = grad_output.strides[1];
+    idx_t grad_output_sH = grad_output.strides[2];
+    idx_t grad_output_sW = kSpatialDim < 2 ? 0 : grad_output.strides[3];
+    idx_t grad_output_sD = kSpatialDim < 3 ? 0 : grad_output.strides[4];
+    scalar_t *grad_input_ptr = grad_input.data;
+    scalar_t *grad_output_ptr = grad_output.data;
+    idx_t *weights_ptr = iweights.data;
+    idx_t weights_sN = iweights.strides[0];
+    idx_t weights_sC = iweights.strides[1];
+    idx_t weights_sS = iweights.strides[2];
+    scalar_t *dweights_ptr = dweights.data;
+    idx_t dweights_sN = dweights.strides[0];
+    idx_t dweights_sC = dweights.strides[1];
+    idx_t dweights_sS = dweights.strides[2];
+
+    CUDA_KERNEL_LOOP_TYPE(index, n_threads, idx_t){
+        const idx_t k = index % sizeD;
+        const idx_t j = (index / sizeD) % sizeW;
+        const idx_t i = (index / (sizeD*sizeW)) % sizeH;
+        const idx_t c = (index / (sizeD*sizeW*sizeH)) % sizeC;
+        const idx_t n = (index / (sizeD*sizeW*sizeH*sizeC));
+        shift_backward_input_kernel_strided<scalar_t, idx_t>(grad_input_ptr, grad_output_ptr,
+                                                             weights_ptr + n*weights_sN, dweights_ptr + n*dweights_sN,
+                                                             n, c, i, j, k, sizeH, sizeW, sizeD,
+                                                             stepH, stepW, stepD,
+                                                             grad_input_sN, grad_input_sC, grad_input_sH, grad_input_sW, grad_input_sD,
+                                                             grad_output_sN, grad_output_sC, grad_output_sH, grad_output_sW, grad_output_sD,
+                                                             weights_sC, weights_sS, dweights_sC, dweights_sS,
+                                                             alpha, beta, padding_mode, active);
+    }
+}
+
+
+// One thread per input position, loops over the K shift sets(see _shifts_multi_forward_cpu)
+template <typename scalar_t, int kSpatialDim, typename idx_t>
+C10_LAUNCH_BOUNDS_1(CUDA_THREADS)
+__global__ void _shifts_multi_cuda(const idx_t n_threads,
+                                   TensorInfo<scalar_t, idx_t> input,
+                                   TensorInfo<idx_t, idx_t> iweights,
+                                   TensorInfo<scalar_t, idx_t> dweights,
+                                   TensorInfo<scalar_t, idx_t> output,
+                                   const BIPadding padding_mode,  bool active){
+    idx_t sizeC = input.sizes[1];
+    idx_t sizeH = input.sizes[2];
+    idx_t sizeW = kSpatialDim < 2 ? 1 : input.sizes[3];
+    idx_t sizeD = kSpatialDim < 3 ? 1 : input.sizes[4];
+    idx_t sizeK = iweights.sizes[0];
+    idx_t input_sN = input.strides[0];
+    idx_t input_sC = input.strides[1];
+    idx_t input_sH = input.strides[2];
+    idx_t input_sW = kSpatialDim < 2 ? 0 : input.strides[3];
+    idx_t input_sD = kSpatialDim < 3 ? 0 : input.strides[4];
+    idx_t output_sN = output.strides[0];
+    idx_t output_sC = output.strides[1];
+    idx_t output_sH = output.strides[2];
+    idx_t output_sW = kSpatialDim < 2 ? 0 : output.strides[3];
+    idx_t output_sD = kSpatialDim < 3 ? 0 : output.strides[4];
+    scalar_t *input_ptr = input.data;
+    scalar_t *output_ptr = output.data;
+    idx_t *weights_ptr = iweights.data;
+    idx_t weights_sK = iweights.strides[0];
+    idx_t weights_sC = iweights.strides[1];
+    idx_t weights_sS = iweights.strides[2];
+    scalar_t *dweights_ptr = dweights.data;
+    idx_t dweights_sK = dweights.strides[0];
+    idx_t dweights_sC = dweights.strides[1];
+    idx_t dweights_sS = dweights.strides[2];
+    scalar_t one = static_cast<scalar_t>(1);
+    scalar_t zero = static_cast<scalar_t>(0);
+
+    CUDA_KERNEL_LOOP_TYPE(index, n_threads, idx_t){
+        const idx_t k = index % sizeD;
+        const idx_t j = (index / sizeD) % sizeW;
+        const idx_t i = (index / (sizeD*sizeW)) % sizeH;
+        const idx_t c = (index / (sizeD*sizeW*sizeH)) % sizeC;
+        const idx_t n = (index / (sizeD*sizeW*sizeH*sizeC));
+        for (idx_t s = 0; s < sizeK; ++s){
+            shift_forward_kernel_nchwd<scalar_t, idx_t>(input_ptr, output_ptr + s*sizeC*output_sC,
+                                                        weights_ptr + s*weights_sK, dweights_ptr + s*dweights_sK,
+                                                        n, c, i, j, k, sizeH, sizeW, sizeD,
+                                                        1, 1, 1,
+                                                        input_sN, input_sC, input_sH, input_sW, input_sD,
+                                                        output_sN, output_sC, output_sH, output_sW, output_sD,
+                                                        weights_sC, weights_sS, dweights_sC, dweights_sS,
+                                                        one, zero, padding_mode, active);
+        }
+    }
+}
+
+template <typename scalar_t, int kSpatialDim, typename idx_t>
+C10_LAUNCH_BOUNDS_1(CUDA_THREADS)
+__global__ void _shifts_multi_backward_cuda(const idx_t n_threads, 
+                                            TensorInfo<scalar_t, idx_t> grad_input,
+                                            TensorInfo<idx_t, idx_t> iweights,
+                                            TensorInfo<scalar_t, idx_t> dweights,
+                                            TensorInfo<scalar_t, idx_t> input, 
+                                            TensorInfo<scalar_t, idx_t> grad_output,
+                                            TensorInfo<scalar_t, idx_t> grad_weights,
+                                            const BIPadding padding_mode, bool active)
+{
+    idx_t sizeC = input.sizes[1];
+    idx_t sizeH = input.sizes[2];
+    idx_t sizeW = kSpatialDim < 2 ? 1 : input.sizes[3];
+    idx_t sizeD = kSpatialDim < 3 ? 1 : input.sizes[4];
+    idx_t sizeK = iweights.sizes[0];
+    idx_t grad_input_sN = grad_input.strides[0];
+    idx_t grad_input_sC = grad_input.strides[1];
+    idx_t grad_input_sH = grad_input.strides[2];
+    idx_t grad_input_sW = kSpatialDim < 2 ? 0 : grad_input.strides[3];
+    idx_t grad_input_sD = kSpatialDim < 3 ? 0 : grad_input.strides[4];
+    idx_t input_sN = input.strides[0];
+    idx_t input_sC = input.strides[1];
+    idx_t input_sH = input.strides[2];
+    idx_t input_sW = kSpatialDim < 2 ? 0 : input.strides[3];
+    idx_t input_sD = kSpatialDim < 3 ? 0 : input.strides[4];
+    idx_t grad_output_sN = grad_output.strides[0];
+    idx_t grad_output_sC = grad_output.strides[1];
+    idx_t grad_output_sH = grad_output.strides[2];
+    idx_t grad_output_sW = kSpatialDim < 2 ? 0 : grad_output.strides[3];
+    idx_t grad_output_sD = kSpatialDim < 3 ? 0 : grad_output.strides[4];
+    idx_t grad_weights_sK = grad_weights.strides[0];
+    idx_t grad_weights_sC = grad_weights.strides[1];
+    idx_t grad_weights_sS = grad_weights.strides[2];
+    scalar_t *grad_input_ptr = grad_input.data;
+    scalar_t *input_ptr = input.data;
+    scalar_t *grad_output_ptr = grad_output.data;
+    scalar_t *grad_weights_ptr = grad_weights.data;
+    idx_t *weights_ptr = iweights.data;
+    idx_t weights_sK = iweights.strides[0];
+    idx_t weights_sC = iweights.strides[1];
+    idx_t weights_sS = iweights.strides[2];
+    scalar_t *dweights_ptr = dweights.data;
+    idx_t dweights_sK = dweights.strides[0];
+    idx_t dweights_sC = dweights.strides[1];
+    idx_t dweights_sS = dweights.strides[2];
+    scalar_t one = static_cast<scalar_t>(1);
+    scalar_t zero = static_cast<scalar_t>(0);
+
+    CUDA_KERNEL_LOOP_TYPE(index, n_threads, idx_t){
+        const idx_t k = index % sizeD;
+        const idx_t j = (index / sizeD) % sizeW;
+        const idx_t i = (index / (sizeD*sizeW)) % sizeH;
+        const idx_t c = (index / (sizeD*sizeW*sizeH)) % sizeC;
+        const idx_t n = (index / (sizeD*sizeW*sizeH*sizeC));
+        // the first set overwrites the input gradient, the others accumulate
+        for (idx_t s = 0; s < sizeK; ++s){
+            shift_backward_kernel_nchwd<scalar_t, idx_t>(grad_input_ptr + s*sizeC*grad_input_sC, input_ptr, grad_output_ptr,
+                                                         weights_ptr + s*weights_sK, dweights_ptr + s*dweights_sK,
+                                                         grad_weights_ptr + s*grad_weights_sK,
+                                                         n, c, i, j, k, sizeH, sizeW, sizeD,
+                                                         grad_input_sN, grad_input_sC, grad_input_sH, grad_input_sW, grad_input_sD,
+                                                         input_sN, input_sC, input_sH, input_sW, input_sD,
+                                                         grad_output_sN, grad_output_sC, grad_output_sH, grad_output_sW, grad_output_sD,
+                                                         weights_sC, weights_sS, dweights_sC, dweights_sS, grad_weights_sC, grad_weights_sS,
+                                                         one, (s > 0) ? one : zero, padding_mode, active);
+        }
     }
 }
 
 //end of anonymous namespace        
 }
 
+// Writes output = beta*output + alpha*shift(input), output must have the strided size
 template <int nD>
-torch::Tensor shiftnd_forward_cuda(const torch::Tensor& input,
-                                   const torch::Tensor& weights,
-                                   int64_t padding_mode,
-                                   bool active_flag){
+void shiftnd_forward_into_cuda(const torch::Tensor& input,
+                               const torch::Tensor& weights,
+                               torch::Tensor& output,
+                               int64_t padding_mode,
+                               bool active_flag,
+                               double alpha, double beta,
+                               const std::array<int64_t, 3>& steps,
+                               const std::array<int64_t, 3>& dilations,
+                               const c10::optional<torch::Tensor>& channel_perm = c10::nullopt){
     std::string name = "shift"+std::to_string(nD)+"d_forward_cpu";
     TORCH_CHECK(input.is_cuda(), "input must be a CUDA tensor");
     TORCH_CHECK(weights.is_cuda(), "weights must be a CUDA tensor");                              
@@ -145,26 +413,32 @@ torch::Tensor shiftnd_forward_cuda(const torch::Tensor& input,
     torch::checkAllSameGPU(c, {input_t, weights_t});
     torch::checkAllSameType(c, {input_t, weights_t});
     at::cuda::CUDAGuard device_guard(input.device());
+    check_weights<nD>(input, weights);
+    check_channel_perm<nD>(input, channel_perm);
     
+    torch::Tensor sweights = is_unit_param(dilations) ? weights : weights * dilation_scale<nD>(weights, dilations);
     
-    torch::Tensor output = torch::zeros(input.sizes(), input.options());
-    
-    torch::Tensor iweights = (active_flag?torch::floor(weights):torch::round(weights));
-    torch::Tensor dweights = torch::empty_like(weights, LEGACY_CONTIGUOUS_MEMORY_FORMAT);
+    torch::Tensor iweights = (active_flag?torch::floor(sweights):torch::round(sweights));
+    torch::Tensor dweights = torch::empty_like(sweights, LEGACY_CONTIGUOUS_MEMORY_FORMAT);
     if (active_flag){
-        dweights = (weights - torch::floor(weights));
+        dweights = (sweights - torch::floor(sweights));
     }
     
     bool int32bit_cond = canUse32BitIndexMath(input) && canUse32BitIndexMath(iweights) &&
                          canUse32BitIndexMath(dweights) && canUse32BitIndexMath(output);
                          
-    iweights = int32bit_cond?iweights.to(torch::kInt):iweights.to(torch::kLong);
+    iweights = batched_weights(int32bit_cond?iweights.to(torch::kInt):iweights.to(torch::kLong), input.size(0));
+    dweights = batched_weights(dweights, input.size(0));
+    torch::Tensor perm;
+    if (has_channel_perm(channel_perm)){
+        perm = channel_perm->to(int32bit_cond?torch::kInt:torch::kLong).contiguous();
+    }
     
-    int64_t N = input.size(0);
-    int64_t C = input.size(1);
-    int64_t H = input.size(2);
-    int64_t W = (nD<2)?1:input.size(3);
-    int64_t D = (nD<3)?1:input.size(4);
+    int64_t N = output.size(0);
+    int64_t C = output.size(1);
+    int64_t H = output.size(2);
+    int64_t W = (nD<2)?1:output.size(3);
+    int64_t D = (nD<3)?1:output.size(4);
     
   
     int64_t count = N*C*H*W*D;
@@ -182,8 +456,11 @@ torch::Tensor shiftnd_forward_cuda(const torch::Tensor& input,
                 getTensorInfo<int, int>(iweights),
                 getTensorInfo<scalar_t, int>(dweights),
                 getTensorInfo<scalar_t, int>(output),
+                static_cast<int>(steps[0]), static_cast<int>(steps[1]), static_cast<int>(steps[2]),
+                static_cast<scalar_t>(alpha), static_cast<scalar_t>(beta),
                 static_cast<BIPadding>(padding_mode), 
-                active_flag);
+                active_flag,
+                perm.defined() ? perm.data_ptr<int>() : nullptr);
         }
         else{
             _shifts_cuda<scalar_t, nD, int64_t>
@@ -193,21 +470,27 @@ torch::Tensor shiftnd_forward_cuda(const torch::Tensor& input,
             getTensorInfo<int64_t, int64_t>(iweights),
             getTensorInfo<scalar_t, int64_t>(dweights),
             getTensorInfo<scalar_t, int64_t>(output),
+            steps[0], steps[1], steps[2],
+            static_cast<scalar_t>(alpha), static_cast<scalar_t>(beta),
             static_cast<BIPadding>(padding_mode), 
-            active_flag);
+            active_flag,
+            perm.defined() ? perm.data_ptr<int64_t>() : nullptr);
         }
     });
     AT_CUDA_CHECK(cudaGetLastError());
- 
-    return output;
 }
 
+// Writes out_grad = beta*out_grad + alpha*dL/dinput, returns alpha*dL/dweights
 template <int nD>
-std::vector<torch::Tensor> shiftnd_backward_cuda(const torch::Tensor& grad,
-                                                 const torch::Tensor& weights,
-                                                 const torch::Tensor& input,
-                                                 int64_t padding_mode,
-                                                 bool active_flag) {
+torch::Tensor shiftnd_backward_into_cuda(const torch::Tensor& grad,
+                                         const torch::Tensor& weights,
+                                         const torch::Tensor& input,
+                                         torch::Tensor& out_grad,
+                                         int64_t padding_mode,
+                                         bool active_flag,
+                                         double alpha, double beta,
+                                         const std::array<int64_t, 3>& steps,
+                                         const std::array<int64_t, 3>& dilations) {
     std::string name = "shift"+std::to_string(nD)+"d_backward_cpu";
     at::globalContext().alertNotDeterministic(name.c_str());
     
@@ -220,20 +503,26 @@ std::vector<torch::Tensor> shiftnd_backward_cuda(const torch::Tensor& grad,
     torch::checkAllSameGPU(c, {grad_t, input_t, weights_t});
     torch::checkAllSameType(c, {grad_t, input_t, weights_t});
     at::cuda::CUDAGuard device_guard(grad.device());
+    check_weights<nD>(input, weights);
     
 
-    torch::Tensor out_grad = torch::zeros_like(grad, LEGACY_CONTIGUOUS_MEMORY_FORMAT);
     torch::Tensor weights_grad = torch::zeros_like(weights, LEGACY_CONTIGUOUS_MEMORY_FORMAT);
+    // shared weights: all samples reduce into the same [C, dim] gradient through the zero batch stride
+    torch::Tensor weights_grad_n = batched_weights(weights_grad, input.size(0));
     
-    torch::Tensor iweights = (active_flag?torch::floor(weights):torch::round(weights));
-    torch::Tensor dweights = weights - torch::floor(weights);
+    torch::Tensor sweights = is_unit_param(dilations) ? weights : weights * dilation_scale<nD>(weights, dilations);
+    torch::Tensor iweights = (active_flag?torch::floor(sweights):torch::round(sweights));
+    torch::Tensor dweights = sweights - torch::floor(sweights);
+    // strided output: weight gradients are summed over output elements, input gradient is gathered per input element
+    bool strided = !is_unit_param(steps);
 
     
     bool int32bit_cond = canUse32BitIndexMath(grad) && canUse32BitIndexMath(iweights) &&
                          canUse32BitIndexMath(dweights) && canUse32BitIndexMath(input) && 
                          canUse32BitIndexMath(out_grad) && canUse32BitIndexMath(weights_grad);
     
-    iweights = int32bit_cond?iweights.to(torch::kInt):iweights.to(torch::kLong);
+    iweights = batched_weights(int32bit_cond?iweights.to(torch::kInt):iweights.to(torch::kLong), input.size(0));
+    dweights = batched_weights(dweights, input.size(0));
   
     int64_t N = grad.size(0);
     int64_t C = grad.size(1);
@@ -248,7 +537,56 @@ std::vector<torch::Tensor> shiftnd_backward_cuda(const torch::Tensor& grad,
     cudaStream_t stream = at::cuda::getCurrentCUDAStream();
 
     AT_DISPATCH_FLOATING_TYPES_AND_HALF(grad.scalar_type(), name, [&] {
-        if (int32bit_cond){
+        if (strided){
+            int64_t input_count = input.numel();
+            if (int32bit_cond){
+                _shifts_backward_weights_strided_cuda<scalar_t, nD, int>
+                <<<GET_CUDA_BLOCKS(count), LOCAL_CUDA_NUM_THREADS, 0, stream>>>(
+                static_cast<int>(count),
+                getTensorInfo<scalar_t, int>(grad),
+                getTensorInfo<int, int>(iweights),
+                getTensorInfo<scalar_t, int>(dweights),
+                getTensorInfo<scalar_t, int>(input),
+                getTensorInfo<scalar_t, int>(weights_grad_n),
+                static_cast<int>(steps[0]), static_cast<int>(steps[1]), static_cast<int>(steps[2]),
+                static_cast<BIPadding>(padding_mode));
+                _shifts_backward_input_strided_cuda<scalar_t, nD, int>
+                <<<GET_CUDA_BLOCKS(input_count), LOCAL_CUDA_NUM_THREADS, 0, stream>>>(
+                static_cast<int>(input_count),
+                getTensorInfo<scalar_t, int>(grad),
+                getTensorInfo<int, int>(iweights),
+                getTensorInfo<scalar_t, int>(dweights),
+                getTensorInfo<scalar_t, int>(out_grad),
+                static_cast<int>(steps[0]), static_cast<int>(steps[1]), static_cast<int>(steps[2]),
+                static_cast<scalar_t>(alpha), static_cast<scalar_t>(beta),
+                static_cast<BIPadding>(padding_mode), 
+                active_flag);
+            }
+            else{
+                _shifts_backward_weights_strided_cuda<scalar_t, nD, int64_t>
+                <<<GET_CUDA_BLOCKS(count), LOCAL_CUDA_NUM_THREADS, 0, stream>>>(
+                count,
+                getTensorInfo<scalar_t, int64_t>(grad),
+                getTensorInfo<int64_t, int64_t>(iweights),
+                getTensorInfo<scalar_t, int64_t>(dweights),
+                getTensorInfo<scalar_t, int64_t>(input),
+                getTensorInfo<scalar_t, int64_t>(weights_grad_n),
+                steps[0], steps[1], steps[2],
+                static_cast<BIPadding>(padding_mode));
+                _shifts_backward_input_strided_cuda<scalar_t, nD, int64_t>
+                <<<GET_CUDA_BLOCKS(input_count), LOCAL_CUDA_NUM_THREADS, 0, stream>>>(
+                input_count,
+                getTensorInfo<scalar_t, int64_t>(grad),
+                getTensorInfo<int64_t, int64_t>(iweights),
+                getTensorInfo<scalar_t, int64_t>(dweights),
+                getTensorInfo<scalar_t, int64_t>(out_grad),
+                steps[0], steps[1], steps[2],
+                static_cast<scalar_t>(alpha), static_cast<scalar_t>(beta),
+                static_cast<BIPadding>(padding_mode), 
+                active_flag);
+            }
+        }
+        else if (int32bit_cond){
             _shifts_backward_cuda<scalar_t, nD, int>
             <<<GET_CUDA_BLOCKS(count), LOCAL_CUDA_NUM_THREADS, 0, stream>>>(
             static_cast<int>(count),
@@ -257,7 +595,8 @@ std::vector<torch::Tensor> shiftnd_backward_cuda(const torch::Tensor& grad,
             getTensorInfo<scalar_t, int>(dweights),
             getTensorInfo<scalar_t, int>(input),
             getTensorInfo<scalar_t, int>(out_grad),
-            getTensorInfo<scalar_t, int>(weights_grad),
+            getTensorInfo<scalar_t, int>(weights_grad_n),
+            static_cast<scalar_t>(alpha), static_cast<scalar_t>(beta),
             static_cast<BIPadding>(padding_mode), 
             active_flag);
         }
@@ -270,13 +609,277 @@ std::vector<torch::Tensor> shiftnd_backward_cuda(const torch::Tensor& grad,
             getTensorInfo<scalar_t, int64_t>(dweights),
             getTensorInfo<scalar_t, int64_t>(input),
             getTensorInfo<scalar_t, int64_t>(out_grad),
-            getTensorInfo<scalar_t, int64_t>(weights_grad),
+            getTensorInfo<scalar_t, int64_t>(weights_grad_n),
+            static_cast<scalar_t>(alpha), static_cast<scalar_t>(beta),
+            static_cast<BIPadding>(padding_mode), 
+            active_flag);
+        }
+    });
+    AT_CUDA_CHECK(cudaGetLastError());
+    if (!is_unit_param(dilations)){
+        weights_grad.mul_(dilation_scale<nD>(weights_grad, dilations));
+    }
+    if (alpha != 1.){
+        weights_grad.mul_(alpha);
+    }
+    return weights_grad;
+}
+
+
+template <int nD>
+torch::Tensor shiftnd_forward_cuda(const torch::Tensor& input,
+                                   const torch::Tensor& weights,
+                                   int64_t padding_mode,
+                                   bool active_flag,
+                                   c10::IntArrayRef stride,
+                                   c10::IntArrayRef dilation,
+                                   c10::optional<c10::MemoryFormat> memory_format,
+                                   const c10::optional<torch::Tensor>& channel_perm){
+    std::array<int64_t, 3> steps = expand_param<nD>(stride, "stride");
+    std::array<int64_t, 3> dilations = expand_param<nD>(dilation, "dilation");
+    // every output element is written by the kernel, layout conversion is fused into the shift
+    torch::Tensor output = empty_output<nD>(input, strided_output_size<nD>(input.sizes(), steps), memory_format);
+    shiftnd_forward_into_cuda<nD>(input, weights, output, padding_mode, active_flag, 1., 0., steps, dilations, channel_perm);
+    return output;
+}
+
+template <int nD>
+torch::Tensor& shiftnd_accumulate_cuda(torch::Tensor& out,
+                                       const torch::Tensor& input,
+                                       const torch::Tensor& weights,
+                                       int64_t padding_mode,
+                                       bool active_flag,
+                                       double alpha, double beta,
+                                       c10::IntArrayRef stride,
+                                       c10::IntArrayRef dilation){
+    std::array<int64_t, 3> steps = expand_param<nD>(stride, "stride");
+    std::array<int64_t, 3> dilations = expand_param<nD>(dilation, "dilation");
+    check_accumulate_out<nD>(out, strided_output_size<nD>(input.sizes(), steps), {input});
+    shiftnd_forward_into_cuda<nD>(input, weights, out, padding_mode, active_flag, alpha, beta, steps, dilations);
+    return out;
+}
+
+template <int nD>
+std::vector<torch::Tensor> shiftnd_backward_cuda(const torch::Tensor& grad,
+                                                 const torch::Tensor& weights,
+                                                 const torch::Tensor& input,
+                                                 int64_t padding_mode,
+                                                 bool active_flag,
+                                                 c10::IntArrayRef stride,
+                                                 c10::IntArrayRef dilation,
+                                                 double sparsity = 0.) {
+    std::array<int64_t, 3> steps = expand_param<nD>(stride, "stride");
+    std::array<int64_t, 3> dilations = expand_param<nD>(dilation, "dilation");
+    torch::Tensor out_grad = empty_input_grad(input);
+    torch::Tensor weights_grad = shiftnd_backward_into_cuda<nD>(grad, weights, input, out_grad, padding_mode, active_flag,
+                                                                1., 0., steps, dilations);
+    if (sparsity != 0.){
+        // L1 term of the shifts: added to the reduced gradient, no separate autograd node
+        weights_grad.add_(weights.sign(), sparsity);
+    }
+    return {out_grad, weights_grad};
+}
+
+template <int nD>
+torch::Tensor shiftnd_backward_accumulate_cuda(torch::Tensor& out_grad,
+                                               const torch::Tensor& grad,
+                                               const torch::Tensor& weights,
+                                               const torch::Tensor& input,
+                                               int64_t padding_mode,
+                                               bool active_flag,
+                                               double alpha, double beta,
+                                               c10::IntArrayRef stride,
+                                               c10::IntArrayRef dilation) {
+    std::array<int64_t, 3> steps = expand_param<nD>(stride, "stride");
+    std::array<int64_t, 3> dilations = expand_param<nD>(dilation, "dilation");
+    check_accumulate_out<nD>(out_grad, input.sizes(), {grad, input});
+    return shiftnd_backward_into_cuda<nD>(grad, weights, input, out_grad, padding_mode, active_flag,
+                                          alpha, beta, steps, dilations);
+}
+
+
+template <int nD>
+torch::Tensor shiftnd_multi_forward_cuda(const torch::Tensor& input,
+                                         const torch::Tensor& weights,
+                                         int64_t padding_mode,
+                                         bool active_flag){
+    std::string name = "shift"+std::to_string(nD)+"d_multi_forward_cuda";
+    TORCH_CHECK(input.is_cuda(), "input must be a CUDA tensor");
+    TORCH_CHECK(weights.is_cuda(), "weights must be a CUDA tensor");                              
+    torch::TensorArg input_t{input, "input", 1}, weights_t{weights, "weights", 2};                                 
+    torch::CheckedFrom c = name.c_str();
+    
+    torch::checkAllSameGPU(c, {input_t, weights_t});
+    torch::checkAllSameType(c, {input_t, weights_t});
+    check_multi_weights<nD>(input, weights);
+    at::cuda::CUDAGuard device_guard(input.device());
+    
+    std::vector<int64_t> output_size(input.sizes().begin(), input.sizes().end());
+    output_size[1] *= weights.size(0);
+    // every output element is written by the kernel
+    torch::Tensor output = torch::empty(output_size, input.options().memory_format(input.suggest_memory_format()));
+    
+    torch::Tensor iweights = (active_flag?torch::floor(weights):torch::round(weights));
+    torch::Tensor dweights = torch::empty_like(weights, LEGACY_CONTIGUOUS_MEMORY_FORMAT);
+    if (active_flag){
+        dweights = (weights - torch::floor(weights));
+    }
+    
+    bool int32bit_cond = canUse32BitIndexMath(input) && canUse32BitIndexMath(iweights) &&
+                         canUse32BitIndexMath(dweights) && canUse32BitIndexMath(output);
+                         
+    iweights = int32bit_cond?iweights.to(torch::kInt):iweights.to(torch::kLong);
+    
+    int64_t count = input.numel();
+    
+    cudaStream_t stream = at::cuda::getCurrentCUDAStream();
+
+    AT_DISPATCH_FLOATING_TYPES_AND_HALF(input.scalar_type(), name, [&] {
+        if (int32bit_cond){
+            _shifts_multi_cuda<scalar_t, nD, int>
+            <<<GET_CUDA_BLOCKS(count), LOCAL_CUDA_NUM_THREADS, 0, stream>>>(
+                static_cast<int>(count),
+                getTensorInfo<scalar_t, int>(input),
+                getTensorInfo<int, int>(iweights),
+                getTensorInfo<scalar_t, int>(dweights),
+                getTensorInfo<scalar_t, int>(output),
+                static_cast<BIPadding>(padding_mode), 
+                active_flag);
+        }
+        else{
+            _shifts_multi_cuda<scalar_t, nD, int64_t>
+            <<<GET_CUDA_BLOCKS(count), LOCAL_CUDA_NUM_THREADS, 0, stream>>>(
+            count,
+            getTensorInfo<scalar_t, int64_t>(input),
+            getTensorInfo<int64_t, int64_t>(iweights),
+            getTensorInfo<scalar_t, int64_t>(dweights),
+            getTensorInfo<scalar_t, int64_t>(output),
             static_cast<BIPadding>(padding_mode), 
             active_flag);
         }
     });
     AT_CUDA_CHECK(cudaGetLastError());
+    return output;
+}
+
+template <int nD>
+std::vector<torch::Tensor> shiftnd_multi_backward_cuda(const torch::Tensor& grad,
+                                                       const torch::Tensor& weights,
+                                                       const torch::Tensor& input,
+                                                       int64_t padding_mode,
+                                                       bool active_flag) {
+    std::string name = "shift"+std::to_string(nD)+"d_multi_backward_cuda";
+    at::globalContext().alertNotDeterministic(name.c_str());
+    
+    TORCH_CHECK(grad.is_cuda(), "grad must be a CUDA tensor");
+    TORCH_CHECK(input.is_cuda(), "input must be a CUDA tensor");
+    TORCH_CHECK(weights.is_cuda(), "weights must be a CUDA tensor");                               
+    torch::TensorArg grad_t{grad, "grad", 1}, weights_t{weights, "weights", 2}, input_t{input, "input", 3};
+    torch::CheckedFrom c = name.c_str();
+    
+    torch::checkAllSameGPU(c, {grad_t, input_t, weights_t});
+    torch::checkAllSameType(c, {grad_t, input_t, weights_t});
+    check_multi_backward<nD>(grad, input, weights);
+    at::cuda::CUDAGuard device_guard(grad.device());
+
+    torch::Tensor out_grad = torch::empty_like(input, LEGACY_CONTIGUOUS_MEMORY_FORMAT);
+    torch::Tensor weights_grad = torch::zeros_like(weights, LEGACY_CONTIGUOUS_MEMORY_FORMAT);
+    
+    torch::Tensor iweights = (active_flag?torch::floor(weights):torch::round(weights));
+    torch::Tensor dweights = weights - torch::floor(weights);
+    
+    bool int32bit_cond = canUse32BitIndexMath(grad) && canUse32BitIndexMath(iweights) &&
+                         canUse32BitIndexMath(dweights) && canUse32BitIndexMath(input) && 
+                         canUse32BitIndexMath(out_grad) && canUse32BitIndexMath(weights_grad);
     
+    iweights = int32bit_cond?iweights.to(torch::kInt):iweights.to(torch::kLong);
+    
+    int64_t count = input.numel();
+    
+    cudaStream_t stream = at::cuda::getCurrentCUDAStream();
+
+    AT_DISPATCH_FLOATING_TYPES_AND_HALF(grad.scalar_type(), name, [&] {
+        if (int32bit_cond){
+            _shifts_multi_backward_cuda<scalar_t, nD, int>
+            <<<GET_CUDA_BLOCKS(count), LOCAL_CUDA_NUM_THREADS, 0, stream>>>(
+            static_cast<int>(count),
+            getTensorInfo<scalar_t, int>(grad),
+            getTensorInfo<int, int>(iweights),
+            getTensorInfo<scalar_t, int>(dweights),
+            getTensorInfo<scalar_t, int>(input),
+            getTensorInfo<scalar_t, int>(out_grad),
+            getTensorInfo<scalar_t, int>(weights_grad),
+            static_cast<BIPadding>(padding_mode), 
+            active_flag);
+        }
+        else{
+            _shifts_multi_backward_cuda<scalar_t, nD, int64_t>
+            <<<GET_CUDA_BLOCKS(count), LOCAL_CUDA_NUM_THREADS, 0, stream>>>(
+            count,
+            getTensorInfo<scalar_t, int64_t>(grad),
+            getTensorInfo<int64_t, int64_t>(iweights),
+            getTensorInfo<scalar_t, int64_t>(dweights),
+            getTensorInfo<scalar_t, int64_t>(input),
+            getTensorInfo<scalar_t, int64_t>(out_grad),
+            getTensorInfo<scalar_t, int64_t>(weights_grad),
+            static_cast<BIPadding>(padding_mode), 
+            active_flag);
+        }
+    });
+    AT_CUDA_CHECK(cudaGetLastError());
+    return {out_grad, weights_grad};
+}
+
+// Sample n of a packed batch(see packed_offsets) as a contiguous [1, C, *spatial_n] view of the flat buffer
+template <int nD>
+torch::Tensor packed_sample(const torch::Tensor& packed, const std::vector<int64_t>& offsets,
+                            const torch::Tensor& sizes, int64_t n, int64_t sizeC){
+    std::vector<int64_t> shape = {1, sizeC};
+    for (int d = 0; d < nD; ++d){
+        shape.push_back(sizes[n][d].item<int64_t>());
+    }
+    return packed.narrow(0, offsets[n], offsets[n + 1] - offsets[n]).view(shape);
+}
+
+template <int nD>
+torch::Tensor shiftnd_packed_forward_cuda(const torch::Tensor& input,
+                                          const torch::Tensor& sizes,
+                                          const torch::Tensor& weights,
+                                          int64_t padding_mode,
+                                          bool active_flag){
+    std::vector<int64_t> offsets = packed_offsets<nD>(input, sizes, weights);
+    torch::Tensor input_c = input.contiguous();
+    torch::Tensor output = torch::empty_like(input_c);
+    const std::array<int64_t, 3> unit = {1, 1, 1};
+    // one launch per sample: padding_mode is applied at the borders of every sample
+    for (int64_t n = 0; n < sizes.size(0); ++n){
+        torch::Tensor output_n = packed_sample<nD>(output, offsets, sizes, n, weights.size(0));
+        shiftnd_forward_into_cuda<nD>(packed_sample<nD>(input_c, offsets, sizes, n, weights.size(0)), weights, output_n,
+                                      padding_mode, active_flag, 1., 0., unit, unit);
+    }
+    return output;
+}
+
+template <int nD>
+std::vector<torch::Tensor> shiftnd_packed_backward_cuda(const torch::Tensor& grad,
+                                                        const torch::Tensor& sizes,
+                                                        const torch::Tensor& weights,
+                                                        const torch::Tensor& input,
+                                                        int64_t padding_mode,
+                                                        bool active_flag){
+    std::vector<int64_t> offsets = packed_offsets<nD>(input, sizes, weights);
+    TORCH_CHECK(grad.sizes() == input.sizes(), "shift", nD, "d_packed: expected grad of shape ", input.sizes(), ", but got ", grad.sizes());
+    torch::Tensor grad_c = grad.contiguous();
+    torch::Tensor input_c = input.contiguous();
+    torch::Tensor out_grad = torch::empty_like(input_c);
+    torch::Tensor weights_grad = torch::zeros_like(weights, LEGACY_CONTIGUOUS_MEMORY_FORMAT);
+    const std::array<int64_t, 3> unit = {1, 1, 1};
+    for (int64_t n = 0; n < sizes.size(0); ++n){
+        torch::Tensor out_grad_n = packed_sample<nD>(out_grad, offsets, sizes, n, weights.size(0));
+        weights_grad.add_(shiftnd_backward_into_cuda<nD>(packed_sample<nD>(grad_c, offsets, sizes, n, weights.size(0)), weights,
+                                                         packed_sample<nD>(input_c, offsets, sizes, n, weights.size(0)),
+                                                         out_grad_n, padding_mode, active_flag, 1., 0., unit, unit));
+    }
     return {out_grad, weights_grad};
 }
 
@@ -284,22 +887,37 @@ std::vector<torch::Tensor> shiftnd_backward_cuda(const torch::Tensor& grad,
 torch::Tensor shift1d_forward_cuda(const torch::Tensor& input,
                                    const torch::Tensor& weights,
                                    int64_t padding_mode,
-                                   bool active_flag){
-    return shiftnd_forward_cuda<1>(input, weights, padding_mode, active_flag);                    
+                                   bool active_flag,
+                                   c10::IntArrayRef stride,
+                                   c10::IntArrayRef dilation,
+                                   c10::optional<c10::MemoryFormat> memory_format,
+                                   const c10::optional<torch::Tensor>& channel_perm,
+                                   double sparsity){
+    return shiftnd_forward_cuda<1>(input, weights, padding_mode, active_flag, stride, dilation, memory_format, channel_perm);                    
 }
 
 torch::Tensor shift2d_forward_cuda(const torch::Tensor& input,
                                    const torch::Tensor& weights,
                                    int64_t padding_mode,
-                                   bool active_flag){
-    return shiftnd_forward_cuda<2>(input, weights, padding_mode, active_flag);                     
+                                   bool active_flag,
+                                   c10::IntArrayRef stride,
+                                   c10::IntArrayRef dilation,
+                                   c10::optional<c10::MemoryFormat> memory_format,
+                                   const c10::optional<torch::Tensor>& channel_perm,
+                                   double sparsity){
+    return shiftnd_forward_cuda<2>(input, weights, padding_mode, active_flag, stride, dilation, memory_format, channel_perm);                     
 }
 
 torch::Tensor shift3d_forward_cuda(const torch::Tensor& input,
                                    const torch::Tensor& weights,
                                    int64_t padding_mode,
-                                   bool active_flag){
-    return shiftnd_forward_cuda<3>(input, weights, padding_mode, active_flag);                     
+                                   bool active_flag,
+                                   c10::IntArrayRef stride,
+                                   c10::IntArrayRef dilation,
+                                   c10::optional<c10::MemoryFormat> memory_format,
+                                   const c10::optional<torch::Tensor>& channel_perm,
+                                   double sparsity){
+    return shiftnd_forward_cuda<3>(input, weights, padding_mode, active_flag, stride, dilation, memory_format, channel_perm);                     
 }
 
 
@@ -307,24 +925,230 @@ std::vector<torch::Tensor> shift1d_backward_cuda(const torch::Tensor& grad,
                                                  const torch::Tensor& weights,
                                                  const torch::Tensor& input,
                                                  int64_t padding_mode,
-                                                 bool active_flag){
-    return  shiftnd_backward_cuda<1>(grad, weights, input, padding_mode, active_flag);                                        
+                                                 bool active_flag,
+                                                 c10::IntArrayRef stride,
+                                                 c10::IntArrayRef dilation,
+                                                 double sparsity){
+    return  shiftnd_backward_cuda<1>(grad, weights, input, padding_mode, active_flag, stride, dilation, sparsity);                                        
 }
 
 std::vector<torch::Tensor> shift2d_backward_cuda(const torch::Tensor& grad,
                                                  const torch::Tensor& weights,
                                                  const torch::Tensor& input,
                                                  int64_t padding_mode,
-                                                 bool active_flag){
-    return  shiftnd_backward_cuda<2>(grad, weights, input, padding_mode, active_flag);     
+                                                 bool active_flag,
+                                                 c10::IntArrayRef stride,
+                                                 c10::IntArrayRef dilation,
+                                                 double sparsity){
+    return  shiftnd_backward_cuda<2>(grad, weights, input, padding_mode, active_flag, stride, dilation, sparsity);     
 }
 
 std::vector<torch::Tensor> shift3d_backward_cuda(const torch::Tensor& grad,
                                                  const torch::Tensor& weights,
                                                  const torch::Tensor& input,
                                                  int64_t padding_mode,
-                                                 bool active_flag){
-    return  shiftnd_backward_cuda<3>(grad, weights, input, padding_mode, active_flag);                                        
+                                                 bool active_flag,
+                                                 c10::IntArrayRef stride,
+                                                 c10::IntArrayRef dilation,
+                                                 double sparsity){
+    return  shiftnd_backward_cuda<3>(grad, weights, input, padding_mode, active_flag, stride, dilation, sparsity);                                        
+}
+
+torch::Tensor& shift1d_accumulate_cuda(torch::Tensor& out,
+                                       const torch::Tensor& input,
+                                       const torch::Tensor& weights,
+                                       int64_t padding_mode,
+                                       bool active_flag,
+                                       double alpha, double beta,
+                                       c10::IntArrayRef stride,
+                                       c10::IntArrayRef dilation){
+    return shiftnd_accumulate_cuda<1>(out, input, weights, padding_mode, active_flag, alpha, beta, stride, dilation);
+}
+
+torch::Tensor& shift2d_accumulate_cuda(torch::Tensor& out,
+                                       const torch::Tensor& input,
+                                       const torch::Tensor& weights,
+                                       int64_t padding_mode,
+                                       bool active_flag,
+                                       double alpha, double beta,
+                                       c10::IntArrayRef stride,
+                                       c10::IntArrayRef dilation){
+    return shiftnd_accumulate_cuda<2>(out, input, weights, padding_mode, active_flag, alpha, beta, stride, dilation);
+}
+
+torch::Tensor& shift3d_accumulate_cuda(torch::Tensor& out,
+                                       const torch::Tensor& input,
+                                       const torch::Tensor& weights,
+                                       int64_t padding_mode,
+                                       bool active_flag,
+                                       double alpha, double beta,
+                                       c10::IntArrayRef stride,
+                                       c10::IntArrayRef dilation){
+    return shiftnd_accumulate_cuda<3>(out, input, weights, padding_mode, active_flag, alpha, beta, stride, dilation);
+}
+
+torch::Tensor shift1d_backward_accumulate_cuda(torch::Tensor& out_grad,
+                                               const torch::Tensor& grad,
+                                               const torch::Tensor& weights,
+                                               const torch::Tensor& input,
+                                               int64_t padding_mode,
+                                               bool active_flag,
+                                               double alpha, double beta,
+                                               c10::IntArrayRef stride,
+                                               c10::IntArrayRef dilation){
+    return shiftnd_backward_accumulate_cuda<1>(out_grad, grad, weights, input, padding_mode, active_flag,
+                                               alpha, beta, stride, dilation);
+}
+
+torch::Tensor shift2d_backward_accumulate_cuda(torch::Tensor& out_grad,
+                                               const torch::Tensor& grad,
+                                               const torch::Tensor& weights,
+                                               const torch::Tensor& input,
+                                               int64_t padding_mode,
+                                               bool active_flag,
+                                               double alpha, double beta,
+                                               c10::IntArrayRef stride,
+                                               c10::IntArrayRef dilation){
+    return shiftnd_backward_accumulate_cuda<2>(out_grad, grad, weights, input, padding_mode, active_flag,
+                                               alpha, beta, stride, dilation);
+}
+
+torch::Tensor shift3d_backward_accumulate_cuda(torch::Tensor& out_grad,
+                                               const torch::Tensor& grad,
+                                               const torch::Tensor& weights,
+                                               const torch::Tensor& input,
+                                               int64_t padding_mode,
+                                               bool active_flag,
+                                               double alpha, double beta,
+                                               c10::IntArrayRef stride,
+                                               c10::IntArrayRef dilation){
+    return shiftnd_backward_accumulate_cuda<3>(out_grad, grad, weights, input, padding_mode, active_flag,
+                                               alpha, beta, stride, dilation);
+}
+
+
+torch::Tensor shift1d_multi_forward_cuda(const torch::Tensor& input,
+                                         const torch::Tensor& weights,
+                                         int64_t padding_mode,
+                                         bool active_flag){
+    return shiftnd_multi_forward_cuda<1>(input, weights, padding_mode, active_flag);
+}
+
+torch::Tensor shift2d_multi_forward_cuda(const torch::Tensor& input,
+                                         const torch::Tensor& weights,
+                                         int64_t padding_mode,
+                                         bool active_flag){
+    return shiftnd_multi_forward_cuda<2>(input, weights, padding_mode, active_flag);
+}
+
+torch::Tensor shift3d_multi_forward_cuda(const torch::Tensor& input,
+                                         const torch::Tensor& weights,
+                                         int64_t padding_mode,
+                                         bool active_flag){
+    return shiftnd_multi_forward_cuda<3>(input, weights, padding_mode, active_flag);
+}
+
+std::vector<torch::Tensor> shift1d_multi_backward_cuda(const torch::Tensor& grad,
+                                                       const torch::Tensor& weights,
+                                                       const torch::Tensor& input,
+                                                       int64_t padding_mode,
+                                                       bool active_flag){
+    return shiftnd_multi_backward_cuda<1>(grad, weights, input, padding_mode, active_flag);
+}
+
+std::vector<torch::Tensor> shift2d_multi_backward_cuda(const torch::Tensor& grad,
+                                                       const torch::Tensor& weights,
+                                                       const torch::Tensor& input,
+                                                       int64_t padding_mode,
+                                                       bool active_flag){
+    return shiftnd_multi_backward_cuda<2>(grad, weights, input, padding_mode, active_flag);
+}
+
+std::vector<torch::Tensor> shift3d_multi_backward_cuda(const torch::Tensor& grad,
+                                                       const torch::Tensor& weights,
+                                                       const torch::Tensor& input,
+                                                       int64_t padding_mode,
+                                                       bool active_flag){
+    return shiftnd_multi_backward_cuda<3>(grad, weights, input, padding_mode, active_flag);
+}
+
+torch::Tensor shift1d_packed_forward_cuda(const torch::Tensor& input,
+                                          const torch::Tensor& sizes,
+                                          const torch::Tensor& weights,
+                                          int64_t padding_mode,
+                                          bool active_flag){
+    return shiftnd_packed_forward_cuda<1>(input, sizes, weights, padding_mode, active_flag);
+}
+
+torch::Tensor shift2d_packed_forward_cuda(const torch::Tensor& input,
+                                          const torch::Tensor& sizes,
+                                          const torch::Tensor& weights,
+                                          int64_t padding_mode,
+                                          bool active_flag){
+    return shiftnd_packed_forward_cuda<2>(input, sizes, weights, padding_mode, active_flag);
+}
+
+torch::Tensor shift3d_packed_forward_cuda(const torch::Tensor& input,
+                                          const torch::Tensor& sizes,
+                                          const torch::Tensor& weights,
+                                          int64_t padding_mode,
+                                          bool active_flag){
+    return shiftnd_packed_forward_cuda<3>(input, sizes, weights, padding_mode, active_flag);
+}
+
+std::vector<torch::Tensor> shift1d_packed_backward_cuda(const torch::Tensor& grad,
+                                                        const torch::Tensor& sizes,
+                                                        const torch::Tensor& weights,
+                                                        const torch::Tensor& input,
+                                                        int64_t padding_mode,
+                                                        bool active_flag){
+    return shiftnd_packed_backward_cuda<1>(grad, sizes, weights, input, padding_mode, active_flag);
+}
+
+std::vector<torch::Tensor> shift2d_packed_backward_cuda(const torch::Tensor& grad,
+                                                        const torch::Tensor& sizes,
+                                                        const torch::Tensor& weights,
+                                                        const torch::Tensor& input,
+                                                        int64_t padding_mode,
+                                                        bool active_flag){
+    return shiftnd_packed_backward_cuda<2>(grad, sizes, weights, input, padding_mode, active_flag);
+}
+
+std::vector<torch::Tensor> shift3d_packed_backward_cuda(const torch::Tensor& grad,
+                                                        const torch::Tensor& sizes,
+                                                        const torch::Tensor& weights,
+                                                        const torch::Tensor& input,
+                                                        int64_t padding_mode,
+                                                        bool active_flag){
+    return shiftnd_packed_backward_cuda<3>(grad, sizes, weights, input, padding_mode, active_flag);
+}
+
+
+TORCH_LIBRARY_IMPL(torchshifts, CUDA, m) {
+    m.impl("shift1d", &shift1d_forward_cuda);
+    m.impl("shift2d", &shift2d_forward_cuda);
+    m.impl("shift3d", &shift3d_forward_cuda);
+    m.impl("_shift1d_backward", &shift1d_backward_cuda);
+    m.impl("_shift2d_backward", &shift2d_backward_cuda);
+    m.impl("_shift3d_backward", &shift3d_backward_cuda);
+    m.impl("shift1d_accumulate_", &shift1d_accumulate_cuda);
+    m.impl("shift2d_accumulate_", &shift2d_accumulate_cuda);
+    m.impl("shift3d_accumulate_", &shift3d_accumulate_cuda);
+    m.impl("_shift1d_backward_accumulate_", &shift1d_backward_accumulate_cuda);
+    m.impl("_shift2d_backward_accumulate_", &shift2d_backward_accumulate_cuda);
+    m.impl("_shift3d_backward_accumulate_", &shift3d_backward_accumulate_cuda);
+    m.impl("shift1d_multi", &shift1d_multi_forward_cuda);
+    m.impl("shift2d_multi", &shift2d_multi_forward_cuda);
+    m.impl("shift3d_multi", &shift3d_multi_forward_cuda);
+    m.impl("_shift1d_multi_backward", &shift1d_multi_backward_cuda);
+    m.impl("_shift2d_multi_backward", &shift2d_multi_backward_cuda);
+    m.impl("_shift3d_multi_backward", &shift3d_multi_backward_cuda);
+    m.impl("shift1d_packed", &shift1d_packed_forward_cuda);
+    m.impl("shift2d_packed", &shift2d_packed_forward_cuda);
+    m.impl("shift3d_packed", &shift3d_packed_forward_cuda);
+    m.impl("_shift1d_packed_backward", &shift1d_packed_backward_cuda);
+    m.impl("_shift2d_packed_backward", &shift2d_packed_backward_cuda);
+    m.impl("_shift3d_packed_backward", &shift3d_packed_backward_cuda);
 }
 
 #endif
\ No newline at end of file
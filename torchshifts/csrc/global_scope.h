@@ -26,7 +26,7 @@
     #define API_INLINE inline
 #endif
 #ifdef _SHIFTS_CUDA
-    #include <THC/THCAtomics.cuh>
+    #include <ATen/cuda/Atomic.cuh>
     #define ROUND(a) (::round(a))
     #define FLOOR(a) (::floor(a))
     #define ABS(a) (::abs(a))
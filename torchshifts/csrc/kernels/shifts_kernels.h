@@ -87,6 +87,14 @@ API_INLINE void get_shifted_values(idx_t i_shifted, idx_t sizeH, idx_t strideH,
 }
 
 
+// out = beta*out + alpha*value; out is not read when beta == 0, so it may be uninitialized
+template<typename scalar_t>
+API_INLINE void blend_value(scalar_t* out, scalar_t value, scalar_t alpha, scalar_t beta){
+    if (beta == static_cast<scalar_t>(0)) {*out = alpha * value;}
+    else {*out = beta * (*out) + alpha * value;}
+}
+
+
 template <typename scalar_t, typename idx_t>
 API_INLINE scalar_t compute_interpolated(scalar_t* v, scalar_t diff_shiftH, scalar_t diff_shiftW, scalar_t diff_shiftD,
                                           idx_t sizeH, idx_t sizeW, idx_t sizeD){
@@ -124,9 +132,11 @@ API_INLINE void shift_forward_kernel_nchwd(scalar_t* input, scalar_t* output,
                                            idx_t* weights, scalar_t* dweights,
                                            idx_t n, idx_t c, idx_t i, idx_t j, idx_t k,
                                            idx_t sizeH, idx_t sizeW, idx_t sizeD,
+                                           idx_t stepH, idx_t stepW, idx_t stepD,
                                            idx_t input_sN, idx_t input_sC, idx_t input_sH, idx_t input_sW, idx_t input_sD,
                                            idx_t output_sN, idx_t output_sC, idx_t output_sH, idx_t output_sW, idx_t output_sD,
                                            idx_t weights_sC, idx_t weights_sS, idx_t dweights_sC, idx_t dweights_sS,
+                                           scalar_t alpha, scalar_t beta,
                                            BIPadding padding_mode, bool active){
     scalar_t *input_NC = input + n*input_sN + c*input_sC;
     scalar_t *output_NCHWD= output + n*output_sN + c*output_sC + i*output_sH + j*output_sW + k*output_sD;
@@ -138,9 +148,9 @@ API_INLINE void shift_forward_kernel_nchwd(scalar_t* input, scalar_t* output,
     if (active)
     {    
         scalar_t _vals_array[8] = {zp, zp, zp, zp, zp, zp, zp, zp};
-        get_shifted_values<scalar_t,idx_t>(i-shifts[0], sizeH, input_sH,
-                                           j-shifts[1], sizeW, input_sW,
-                                           k-shifts[2], sizeD, input_sD,
+        get_shifted_values<scalar_t,idx_t>(i*stepH-shifts[0], sizeH, input_sH,
+                                           j*stepW-shifts[1], sizeW, input_sW,
+                                           k*stepD-shifts[2], sizeD, input_sD,
                                            0, 0, input_NC, zp, padding_mode, _vals_array);
         scalar_t dshifts[3] = {*(dweights + c*dweights_sC), zp, zp};
         if (sizeW>1){dshifts[1] = *(dweights + c*dweights_sC + dweights_sS);}
@@ -149,12 +159,12 @@ API_INLINE void shift_forward_kernel_nchwd(scalar_t* input, scalar_t* output,
                                                    sizeH, sizeW, sizeD);
     }
     else {   
-        val = get_shifted_value<scalar_t,idx_t>(i-shifts[0], sizeH, input_sH,
-                                                j-shifts[1], sizeW, input_sW,
-                                                k-shifts[2], sizeD, input_sD,
+        val = get_shifted_value<scalar_t,idx_t>(i*stepH-shifts[0], sizeH, input_sH,
+                                                j*stepW-shifts[1], sizeW, input_sW,
+                                                k*stepD-shifts[2], sizeD, input_sD,
                                                 0, 0, input_NC, zp, padding_mode);  
     }
-    *output_NCHWD = val;
+    blend_value<scalar_t>(output_NCHWD, val, alpha, beta);
 }
 
 template <typename scalar_t, typename idx_t>
@@ -166,6 +176,7 @@ API_INLINE void shift_backward_kernel_nchwd(scalar_t* input_grad, scalar_t* inpu
                                             idx_t input_sN, idx_t input_sC, idx_t input_sH, idx_t input_sW, idx_t input_sD,
                                             idx_t output_grad_sN, idx_t output_grad_sC, idx_t output_grad_sH, idx_t output_grad_sW, idx_t output_grad_sD,
                                             idx_t weights_sC, idx_t weights_sS, idx_t dweights_sC, idx_t dweights_sS, idx_t weights_grad_sC, idx_t weights_grad_sS,
+                                            scalar_t alpha, scalar_t beta,
                                             BIPadding padding_mode, bool active){
     scalar_t *input_grad_NC = input_grad + n*input_grad_sN + c*input_grad_sC;
     scalar_t input_grad_NCHWD_val = input_grad_NC[i*input_grad_sH + j*input_grad_sW + k*input_grad_sD];
@@ -187,14 +198,18 @@ API_INLINE void shift_backward_kernel_nchwd(scalar_t* input_grad, scalar_t* inpu
                                            j-shifts[1], sizeW, input_sW,
                                            k-shifts[2], sizeD, input_sD,
                                            0, 0, input_grad_NC, zp, padding_mode, _vals_array);
-        *output_grad_NCHWD = compute_interpolated<scalar_t,idx_t>(_vals_array, dshifts[0], dshifts[1], dshifts[2],
-                                                                  sizeH, sizeW, sizeD);
+        blend_value<scalar_t>(output_grad_NCHWD,
+                              compute_interpolated<scalar_t,idx_t>(_vals_array, dshifts[0], dshifts[1], dshifts[2],
+                                                                   sizeH, sizeW, sizeD),
+                              alpha, beta);
     } 
     else {                                                              
-        *output_grad_NCHWD = get_shifted_value<scalar_t,idx_t>(i+shifts[0], sizeH, input_sH,
-                                                               j+shifts[1], sizeW, input_sW,
-                                                               k+shifts[2], sizeD, input_sD,
-                                                               0, 0, input_grad_NC, zp, padding_mode);
+        blend_value<scalar_t>(output_grad_NCHWD,
+                              get_shifted_value<scalar_t,idx_t>(i+shifts[0], sizeH, input_sH,
+                                                                j+shifts[1], sizeW, input_sW,
+                                                                k+shifts[2], sizeD, input_sD,
+                                                                0, 0, input_grad_NC, zp, padding_mode),
+                              alpha, beta);
     }
     get_shifted_values<scalar_t,idx_t>(i-shifts[0], sizeH, input_sH,
                                        j-shifts[1], sizeW, input_sW,
@@ -214,9 +229,11 @@ API_INLINE void shift_forward_kernel_nhwdc(scalar_t* input, scalar_t* output,
                                            idx_t* weights, scalar_t* dweights,
                                            idx_t n, idx_t i, idx_t j, idx_t k,
                                            idx_t sizeC, idx_t sizeH, idx_t sizeW, idx_t sizeD,
+                                           idx_t stepH, idx_t stepW, idx_t stepD,
                                            idx_t input_sN, idx_t input_sC, idx_t input_sH, idx_t input_sW, idx_t input_sD,
                                            idx_t output_sN, idx_t output_sC, idx_t output_sH, idx_t output_sW, idx_t output_sD,
                                            idx_t weights_sC, idx_t weights_sS, idx_t dweights_sC, idx_t dweights_sS,
+                                           scalar_t alpha, scalar_t beta,
                                            BIPadding padding_mode, bool active){
     scalar_t *input_N = input + n*input_sN;
     scalar_t *output_NHWD = output + n*output_sN + i*output_sH + j*output_sW + k*output_sD;
@@ -232,9 +249,9 @@ API_INLINE void shift_forward_kernel_nhwdc(scalar_t* input, scalar_t* output,
         {
             // define array here to avoid unnessary warnings, Hope the compiler can optimize it itself
             scalar_t _vals_array[8] = {zp, zp, zp, zp, zp, zp, zp, zp};
-            get_shifted_values<scalar_t,idx_t>(i-shifts[0], sizeH, input_sH,
-                                               j-shifts[1], sizeW, input_sW,
-                                               k-shifts[2], sizeD, input_sD,
+            get_shifted_values<scalar_t,idx_t>(i*stepH-shifts[0], sizeH, input_sH,
+                                               j*stepW-shifts[1], sizeW, input_sW,
+                                               k*stepD-shifts[2], sizeD, input_sD,
                                                c, input_sC, input_N, zp, padding_mode, _vals_array);
 
             val = compute_interpolated<scalar_t,idx_t>(_vals_array, *(dweights+c*dweights_sC), *(dweights+dweights_sS+c*dweights_sC),
@@ -242,12 +259,44 @@ API_INLINE void shift_forward_kernel_nhwdc(scalar_t* input, scalar_t* output,
                                                        sizeH, sizeW, sizeD);
         }
         else {   
-            val = get_shifted_value<scalar_t,idx_t>(i-shifts[0], sizeH, input_sH,
-                                                    j-shifts[1], sizeW, input_sW,
-                                                    k-shifts[2], sizeD, input_sD,
+            val = get_shifted_value<scalar_t,idx_t>(i*stepH-shifts[0], sizeH, input_sH,
+                                                    j*stepW-shifts[1], sizeW, input_sW,
+                                                    k*stepD-shifts[2], sizeD, input_sD,
                                                     c, input_sC, input_N, zp, padding_mode);
         }
-        output_NHWD[c*output_sC] = val;
+        blend_value<scalar_t>(output_NHWD + c*output_sC, val, alpha, beta);
+    }
+}
+
+// Integer shift of channels [c_begin, c_end) which share one shift(e.g. a group of grouped shifts):
+// the whole run reads the same source pixel, so in NHWDC it is a single block copy
+template <typename scalar_t, typename idx_t>
+API_INLINE void shift_forward_run_nhwdc(scalar_t* input, scalar_t* output, idx_t* weights,
+                                        idx_t n, idx_t i, idx_t j, idx_t k, idx_t c_begin, idx_t c_end,
+                                        idx_t sizeH, idx_t sizeW, idx_t sizeD,
+                                        idx_t stepH, idx_t stepW, idx_t stepD,
+                                        idx_t input_sN, idx_t input_sC, idx_t input_sH, idx_t input_sW, idx_t input_sD,
+                                        idx_t output_sN, idx_t output_sC, idx_t output_sH, idx_t output_sW, idx_t output_sD,
+                                        idx_t weights_sC, idx_t weights_sS,
+                                        scalar_t alpha, scalar_t beta,
+                                        BIPadding padding_mode){
+    scalar_t *output_NHWD = output + n*output_sN + i*output_sH + j*output_sW + k*output_sD;
+    scalar_t zp = static_cast<scalar_t>(0);
+    idx_t tidx_i = infer_index<idx_t>(i*stepH - *(weights + c_begin*weights_sC), sizeH, padding_mode);
+    idx_t tidx_j = infer_index<idx_t>(j*stepW - ((sizeW>1) ? *(weights + weights_sS + c_begin*weights_sC) : 0), sizeW, padding_mode);
+    idx_t tidx_k = infer_index<idx_t>(k*stepD - ((sizeD>1) ? *(weights + 2*weights_sS + c_begin*weights_sC) : 0), sizeD, padding_mode);
+    if ((tidx_i<0)||(tidx_j<0)||(tidx_k<0)){
+        for (idx_t c = c_begin; c < c_end; c++){blend_value<scalar_t>(output_NHWD + c*output_sC, zp, alpha, beta);}
+        return;
+    }
+    scalar_t *input_NHWD = input + n*input_sN + tidx_i*input_sH + tidx_j*input_sW + tidx_k*input_sD;
+    if ((input_sC == 1) && (output_sC == 1) && (alpha == static_cast<scalar_t>(1)) && (beta == zp)){
+        // unit strides let the compiler turn it into a plain memory copy
+        for (idx_t c = c_begin; c < c_end; c++){output_NHWD[c] = input_NHWD[c];}
+        return;
+    }
+    for (idx_t c = c_begin; c < c_end; c++){
+        blend_value<scalar_t>(output_NHWD + c*output_sC, input_NHWD[c*input_sC], alpha, beta);
     }
 }
 
@@ -260,6 +309,7 @@ API_INLINE void shift_backward_kernel_nhwdc(scalar_t* input_grad, scalar_t* inpu
                                             idx_t input_sN, idx_t input_sC, idx_t input_sH, idx_t input_sW, idx_t input_sD,
                                             idx_t output_grad_sN, idx_t output_grad_sC, idx_t output_grad_sH, idx_t output_grad_sW, idx_t output_grad_sD,
                                             idx_t weights_sC, idx_t weights_sS, idx_t dweights_sC, idx_t dweights_sS, idx_t weights_grad_sC, idx_t weights_grad_sS,
+                                            scalar_t alpha, scalar_t beta,
                                             BIPadding padding_mode,  bool active){
     scalar_t *input_grad_N = input_grad + n*input_grad_sN;
     scalar_t *input_N = input + n*input_sN;
@@ -274,7 +324,7 @@ API_INLINE void shift_backward_kernel_nhwdc(scalar_t* input_grad, scalar_t* inpu
     for (idx_t c = 0; c < sizeC; c++)
     {
         shifts[0] = *(weights + c*weights_sC);
-        dshifts[3] = *(dweights + c*dweights_sC);
+        dshifts[0] = *(dweights + c*dweights_sC);
         if (sizeW>1){
             shifts[1] = *(weights+weights_sS+c*weights_sC);         
             dshifts[1] = *(dweights+dweights_sS+c*dweights_sC);}
@@ -287,14 +337,18 @@ API_INLINE void shift_backward_kernel_nhwdc(scalar_t* input_grad, scalar_t* inpu
                                                j-shifts[1], sizeW, input_sW,
                                                k-shifts[2], sizeD, input_sD,
                                                c, input_grad_sC, input_grad_N, zp, padding_mode, _vals_array);
-            *(output_grad_NHWD+c*output_grad_sC) = compute_interpolated<scalar_t,idx_t>(_vals_array, dshifts[0], dshifts[1], dshifts[2],
-                                                                                        sizeH, sizeW, sizeD);
+            blend_value<scalar_t>(output_grad_NHWD + c*output_grad_sC,
+                                  compute_interpolated<scalar_t,idx_t>(_vals_array, dshifts[0], dshifts[1], dshifts[2],
+                                                                       sizeH, sizeW, sizeD),
+                                  alpha, beta);
         }
         else {
-            *(output_grad_NHWD+c*output_grad_sC) =  get_shifted_value<scalar_t,idx_t>(i+shifts[0], sizeH, input_sH,
-                                                                                      j+shifts[1], sizeW, input_sW,
-                                                                                      k+shifts[2], sizeD, input_sD,
-                                                                                      c, input_grad_sC, input_grad_N, zp, padding_mode);
+            blend_value<scalar_t>(output_grad_NHWD + c*output_grad_sC,
+                                  get_shifted_value<scalar_t,idx_t>(i+shifts[0], sizeH, input_sH,
+                                                                    j+shifts[1], sizeW, input_sW,
+                                                                    k+shifts[2], sizeD, input_sD,
+                                                                    c, input_grad_sC, input_grad_N, zp, padding_mode),
+                                  alpha, beta);
         }
         get_shifted_values<scalar_t,idx_t>(i-shifts[0], sizeH, input_sH,
                                            j-shifts[1], sizeW, input_sW,
@@ -310,6 +364,158 @@ API_INLINE void shift_backward_kernel_nhwdc(scalar_t* input_grad, scalar_t* inpu
 }
 
 
+// Fused backward of one pixel(i, j, k) of one channel, shifts of the channel are loaded once by the caller.
+// Writes the input gradient and adds the weight gradient terms to the caller's accumulators acc[0..2]
+// instead of memory shared between threads, so weight gradients are flushed once per tile.
+// input may be stored in a narrower type(input_t, low memory mode), it is only read for weight gradients.
+template <typename scalar_t, typename idx_t, typename input_t = scalar_t>
+API_INLINE void shift_backward_fused(scalar_t* input_grad_NC, input_t* input_NC, scalar_t* output_grad_NC,
+                                     const idx_t* shifts, const scalar_t* dshifts,
+                                     idx_t i, idx_t j, idx_t k,
+                                     idx_t sizeH, idx_t sizeW, idx_t sizeD,
+                                     idx_t input_grad_sH, idx_t input_grad_sW, idx_t input_grad_sD,
+                                     idx_t input_sH, idx_t input_sW, idx_t input_sD,
+                                     idx_t output_grad_sH, idx_t output_grad_sW, idx_t output_grad_sD,
+                                     scalar_t alpha, scalar_t beta,
+                                     BIPadding padding_mode, bool active, scalar_t* acc){
+    scalar_t zp = static_cast<scalar_t>(0);
+    scalar_t _vals_array[8] = {zp, zp, zp, zp, zp, zp, zp, zp};
+    scalar_t val;
+    if (active)
+    {
+        get_shifted_values<scalar_t,idx_t>(i-shifts[0], sizeH, input_grad_sH,
+                                           j-shifts[1], sizeW, input_grad_sW,
+                                           k-shifts[2], sizeD, input_grad_sD,
+                                           0, 0, input_grad_NC, zp, padding_mode, _vals_array);
+        val = compute_interpolated<scalar_t,idx_t>(_vals_array, dshifts[0], dshifts[1], dshifts[2],
+                                                   sizeH, sizeW, sizeD);
+    }
+    else {
+        val = get_shifted_value<scalar_t,idx_t>(i+shifts[0], sizeH, input_grad_sH,
+                                                j+shifts[1], sizeW, input_grad_sW,
+                                                k+shifts[2], sizeD, input_grad_sD,
+                                                0, 0, input_grad_NC, zp, padding_mode);
+    }
+    blend_value<scalar_t>(output_grad_NC + i*output_grad_sH + j*output_grad_sW + k*output_grad_sD, val, alpha, beta);
+    input_t izp = static_cast<input_t>(0);
+    input_t _input_vals_array[8] = {izp, izp, izp, izp, izp, izp, izp, izp};
+    get_shifted_values<input_t,idx_t>(i-shifts[0], sizeH, input_sH,
+                                      j-shifts[1], sizeW, input_sW,
+                                      k-shifts[2], sizeD, input_sD,
+                                      0, 0, input_NC, izp, padding_mode, _input_vals_array);
+    for (int v = 0; v < 8; v++){_vals_array[v] = static_cast<scalar_t>(_input_vals_array[v]);}
+    scalar_t _new_weights_grad[3] = {zp, zp, zp};
+    compute_weight_gradients<scalar_t,idx_t>(_vals_array, dshifts[0], dshifts[1], dshifts[2],
+                                             sizeH, sizeW, sizeD, _new_weights_grad);
+    scalar_t input_grad_NCHWD_val = input_grad_NC[i*input_grad_sH + j*input_grad_sW + k*input_grad_sD];
+    acc[0] += input_grad_NCHWD_val * _new_weights_grad[0];
+    acc[1] += input_grad_NCHWD_val * _new_weights_grad[1];
+    acc[2] += input_grad_NCHWD_val * _new_weights_grad[2];
+}
+
+// Element of a grid of size (sizeH, sizeW, sizeD) upsampled with zeros from array by step:
+// only positions which are multiples of step are stored(array[i/step, j/step, k/step]).
+template<typename scalar_t, typename idx_t>
+API_INLINE scalar_t get_upsampled_value(idx_t i_shifted, idx_t sizeH, idx_t stepH, idx_t strideH,
+                                        idx_t j_shifted, idx_t sizeW, idx_t stepW, idx_t strideW,
+                                        idx_t k_shifted, idx_t sizeD, idx_t stepD, idx_t strideD,
+                                        scalar_t* array, BIPadding padding_mode){
+    idx_t tidx_i = infer_index<idx_t>(i_shifted, sizeH, padding_mode);
+    idx_t tidx_j = infer_index<idx_t>(j_shifted, sizeW, padding_mode);
+    idx_t tidx_k = infer_index<idx_t>(k_shifted, sizeD, padding_mode);
+    if ((tidx_i<0)||(tidx_j<0)||(tidx_k<0)||(tidx_i%stepH != 0)||(tidx_j%stepW != 0)||(tidx_k%stepD != 0)){
+        return static_cast<scalar_t>(0);
+    }
+    return array[(tidx_i/stepH)*strideH + (tidx_j/stepW)*strideW + (tidx_k/stepD)*strideD];
+}
+
+// Input gradient for output stride > 1: (i, j, k) are input coordinates, sizes are input sizes.
+// Same gather as the stride 1 backward, over the output gradient upsampled with zeros to the input grid,
+// so a strided shift is equal to the stride 1 shift followed by slicing [::step] in forward and in backward.
+template <typename scalar_t, typename idx_t>
+API_INLINE void shift_backward_input_kernel_strided(scalar_t* input_grad, scalar_t* output_grad,
+                                                    idx_t* weights, scalar_t* dweights,
+                                                    idx_t n, idx_t c, idx_t i, idx_t j, idx_t k,
+                                                    idx_t sizeH, idx_t sizeW, idx_t sizeD,
+                                                    idx_t stepH, idx_t stepW, idx_t stepD,
+                                                    idx_t input_grad_sN, idx_t input_grad_sC, idx_t input_grad_sH, idx_t input_grad_sW, idx_t input_grad_sD,
+                                                    idx_t output_grad_sN, idx_t output_grad_sC, idx_t output_grad_sH, idx_t output_grad_sW, idx_t output_grad_sD,
+                                                    idx_t weights_sC, idx_t weights_sS, idx_t dweights_sC, idx_t dweights_sS,
+                                                    scalar_t alpha, scalar_t beta,
+                                                    BIPadding padding_mode, bool active){
+    scalar_t *input_grad_NC = input_grad + n*input_grad_sN + c*input_grad_sC;
+    scalar_t *output_grad_NCHWD = output_grad + n*output_grad_sN + c*output_grad_sC + i*output_grad_sH + j*output_grad_sW + k*output_grad_sD;
+    scalar_t zp = static_cast<scalar_t>(0);
+    idx_t shifts[3] = {*(weights + c*weights_sC), 0, 0};
+    if (sizeW>1){shifts[1] = *(weights + c*weights_sC + weights_sS);}
+    if (sizeD>1){shifts[2] = *(weights + c*weights_sC + 2*weights_sS);}
+    scalar_t val;
+    if (active)
+    {
+        scalar_t dshifts[3] = {*(dweights + c*dweights_sC), zp, zp};
+        if (sizeW>1){dshifts[1] = *(dweights + c*dweights_sC + dweights_sS);}
+        if (sizeD>1){dshifts[2] = *(dweights + c*dweights_sC + 2*dweights_sS);}
+        // corners in the order of get_shifted_values
+        scalar_t _vals_array[8] = {zp, zp, zp, zp, zp, zp, zp, zp};
+        for (idx_t corner = 0; corner < 8; corner++){
+            idx_t bH = corner & 1;
+            idx_t bW = (corner >> 1) & 1;
+            idx_t bD = (corner >> 2) & 1;
+            if (((bW>0)&&(sizeW<=1))||((bD>0)&&(sizeD<=1))){continue;}
+            _vals_array[corner] = get_upsampled_value<scalar_t,idx_t>(i-shifts[0]+bH, sizeH, stepH, input_grad_sH,
+                                                                      j-shifts[1]+bW, sizeW, stepW, input_grad_sW,
+                                                                      k-shifts[2]+bD, sizeD, stepD, input_grad_sD,
+                                                                      input_grad_NC, padding_mode);
+        }
+        val = compute_interpolated<scalar_t,idx_t>(_vals_array, dshifts[0], dshifts[1], dshifts[2],
+                                                   sizeH, sizeW, sizeD);
+    }
+    else {
+        val = get_upsampled_value<scalar_t,idx_t>(i+shifts[0], sizeH, stepH, input_grad_sH,
+                                                  j+shifts[1], sizeW, stepW, input_grad_sW,
+                                                  k+shifts[2], sizeD, stepD, input_grad_sD,
+                                                  input_grad_NC, padding_mode);
+    }
+    blend_value<scalar_t>(output_grad_NCHWD, val, alpha, beta);
+}
+
+// Weight gradients for output stride > 1: (i, j, k) are output coordinates, sizes are input sizes.
+// Only output elements contribute(the upsampled gradient is zero elsewhere).
+template <typename scalar_t, typename idx_t>
+API_INLINE void shift_backward_weights_kernel_strided(scalar_t* input_grad, scalar_t* input,
+                                                      idx_t* weights, scalar_t* dweights, scalar_t* weights_grad,
+                                                      idx_t n, idx_t c, idx_t i, idx_t j, idx_t k,
+                                                      idx_t sizeH, idx_t sizeW, idx_t sizeD,
+                                                      idx_t stepH, idx_t stepW, idx_t stepD,
+                                                      idx_t input_grad_sN, idx_t input_grad_sC, idx_t input_grad_sH, idx_t input_grad_sW, idx_t input_grad_sD,
+                                                      idx_t input_sN, idx_t input_sC, idx_t input_sH, idx_t input_sW, idx_t input_sD,
+                                                      idx_t weights_sC, idx_t weights_sS, idx_t dweights_sC, idx_t dweights_sS, idx_t weights_grad_sC, idx_t weights_grad_sS,
+                                                      BIPadding padding_mode){
+    scalar_t input_grad_NCHWD_val = input_grad[n*input_grad_sN + c*input_grad_sC + i*input_grad_sH + j*input_grad_sW + k*input_grad_sD];
+    scalar_t *input_NC = input + n*input_sN + c*input_sC;
+    scalar_t zp = static_cast<scalar_t>(0);
+    scalar_t _vals_array[8] = {zp, zp, zp, zp, zp, zp, zp, zp};
+    idx_t shifts[3] = {*(weights + c*weights_sC), 0, 0};
+    scalar_t dshifts[3] = {*(dweights + c*dweights_sC), zp, zp};
+    if (sizeW>1){
+        shifts[1] = *(weights + c*weights_sC + weights_sS);
+        dshifts[1] = *(dweights + c*dweights_sC + dweights_sS);}
+    if (sizeD>1){
+        shifts[2] = *(weights + c*weights_sC + 2*weights_sS);
+        dshifts[2] = *(dweights + c*dweights_sC + 2*dweights_sS);}
+    get_shifted_values<scalar_t,idx_t>(i*stepH - shifts[0], sizeH, input_sH,
+                                       j*stepW - shifts[1], sizeW, input_sW,
+                                       k*stepD - shifts[2], sizeD, input_sD,
+                                       0, 0, input_NC, zp, padding_mode, _vals_array);
+    scalar_t _new_weights_grad[3] = {zp, zp, zp};
+    compute_weight_gradients<scalar_t,idx_t>(_vals_array, dshifts[0], dshifts[1], dshifts[2],
+                                             sizeH, sizeW, sizeD, _new_weights_grad);
+    ADD((weights_grad + c*weights_grad_sC),(input_grad_NCHWD_val * _new_weights_grad[0]));
+    if (sizeW>1){ADD((weights_grad + c*weights_grad_sC + weights_grad_sS),(input_grad_NCHWD_val * _new_weights_grad[1]));}
+    if (sizeD>1){ADD((weights_grad + c*weights_grad_sC + 2*weights_grad_sS),(input_grad_NCHWD_val * _new_weights_grad[2]));}
+}
+
+
 /////////QUANTIZED
 
 template <typename scalar_t, typename idx_t>
@@ -317,6 +523,7 @@ API_INLINE void shift_forward_kernel_nchwd_q(scalar_t* input, scalar_t* output,
                                              idx_t* weights,
                                              idx_t n, idx_t c, idx_t i, idx_t j, idx_t k,
                                              idx_t sizeH, idx_t sizeW, idx_t sizeD,
+                                             idx_t stepH, idx_t stepW, idx_t stepD,
                                              idx_t input_sN, idx_t input_sC, idx_t input_sH, idx_t input_sW, idx_t input_sD,
                                              idx_t output_sN, idx_t output_sC, idx_t output_sH, idx_t output_sW, idx_t output_sD,
                                              idx_t weights_sC, idx_t weights_sS,
@@ -326,9 +533,9 @@ API_INLINE void shift_forward_kernel_nchwd_q(scalar_t* input, scalar_t* output,
     idx_t shifts[3] = {*(weights+c*weights_sC) - weights_zero_point, 0, 0};
     if (sizeW>1){shifts[1] = *(weights+c*weights_sC+weights_sS) - weights_zero_point;}
     if (sizeD>1){shifts[2] = *(weights+c*weights_sC+2*weights_sS) - weights_zero_point;}
-    *output_NCHWD = get_shifted_value<scalar_t,idx_t>(i-shifts[0], sizeH, input_sH,
-                                                      j-shifts[1], sizeW, input_sW,
-                                                      k-shifts[2], sizeD, input_sD,
+    *output_NCHWD = get_shifted_value<scalar_t,idx_t>(i*stepH-shifts[0], sizeH, input_sH,
+                                                      j*stepW-shifts[1], sizeW, input_sW,
+                                                      k*stepD-shifts[2], sizeD, input_sD,
                                                       0, 0, input_NC, zero_point, padding_mode);  
 }
 
@@ -338,6 +545,7 @@ API_INLINE void shift_forward_kernel_nhwdc_q(scalar_t* input, scalar_t* output,
                                              idx_t* weights,
                                              idx_t n, idx_t i, idx_t j, idx_t k,
                                              idx_t sizeC, idx_t sizeH, idx_t sizeW, idx_t sizeD,
+                                             idx_t stepH, idx_t stepW, idx_t stepD,
                                              idx_t input_sN, idx_t input_sC, idx_t input_sH, idx_t input_sW, idx_t input_sD,
                                              idx_t output_sN, idx_t output_sC, idx_t output_sH, idx_t output_sW, idx_t output_sD,
                                              idx_t weights_sC, idx_t weights_sS,
@@ -350,9 +558,9 @@ API_INLINE void shift_forward_kernel_nhwdc_q(scalar_t* input, scalar_t* output,
         shifts[0] = *(weights+c*weights_sC) - weights_zero_point;
         if (sizeW>1){shifts[1] = *(weights+weights_sS+c*weights_sC) - weights_zero_point;}
         if (sizeD>1){shifts[2] = *(weights+2*weights_sS+c*weights_sC) - weights_zero_point;}
-         output_NHWD[c*output_sC] = get_shifted_value<scalar_t,idx_t>(i-shifts[0], sizeH, input_sH,
-                                                                      j-shifts[1], sizeW, input_sW,
-                                                                      k-shifts[2], sizeD, input_sD,
+         output_NHWD[c*output_sC] = get_shifted_value<scalar_t,idx_t>(i*stepH-shifts[0], sizeH, input_sH,
+                                                                      j*stepW-shifts[1], sizeW, input_sW,
+                                                                      k*stepD-shifts[2], sizeD, input_sD,
                                                                       c, input_sC, input_N, zero_point, padding_mode);
      }
 }
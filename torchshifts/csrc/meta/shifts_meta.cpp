@@ -0,0 +1,436 @@
+#include <torch/library.h>
+#include "shifts_meta.h"
+#include "../shifts_params.h"
+
+
+
+template <int nD>
+torch::Tensor shiftnd_forward_meta(const torch::Tensor& input,
+                                   const torch::Tensor& weights,
+                                   int64_t padding_mode,
+                                   bool active_flag,
+                                   c10::IntArrayRef stride,
+                                   c10::IntArrayRef dilation,
+                                   c10::optional<c10::MemoryFormat> memory_format,
+                                   const c10::optional<torch::Tensor>& channel_perm){
+    TORCH_CHECK(input.dim() == nD + 2, "shift", nD, "d: expected ", nD + 2, "D input, but got ", input.dim(), "D");
+    TORCH_CHECK((weights.dim() == 2) || (weights.dim() == 3),
+                "shift", nD, "d: expected 2D or 3D(per sample) weights, but got ", weights.dim(), "D");
+    std::array<int64_t, 3> steps = expand_param<nD>(stride, "stride");
+    expand_param<nD>(dilation, "dilation");
+    check_channel_perm<nD>(input, channel_perm);
+    // same as the device kernels: requested(default contiguous) layout, spatial axes are subsampled by stride
+    std::vector<c10::SymInt> output_size(input.sym_sizes().begin(), input.sym_sizes().end());
+    for (int d = 0; d < nD; ++d){
+        output_size[d + 2] = (output_size[d + 2] + steps[d] - 1) / steps[d];
+    }
+    if ((memory_format == c10::MemoryFormat::Preserve) && is_channels_inner(input)){
+        std::rotate(output_size.begin() + 1, output_size.begin() + 2, output_size.end());
+        return at::empty_symint(output_size, input.options()).movedim(-1, 1);
+    }
+    return at::empty_symint(output_size, input.options().memory_format(output_memory_format<nD>(input, memory_format)));
+}
+
+template <int nD>
+std::vector<torch::Tensor> shiftnd_backward_meta(const torch::Tensor& grad,
+                                                 const torch::Tensor& weights,
+                                                 const torch::Tensor& input,
+                                                 int64_t padding_mode,
+                                                 bool active_flag,
+                                                 c10::IntArrayRef stride,
+                                                 c10::IntArrayRef dilation){
+    // input grad follows the input layout, see empty_input_grad
+    if (is_channels_inner(input)){
+        std::vector<c10::SymInt> storage_size(input.sym_sizes().begin(), input.sym_sizes().end());
+        std::rotate(storage_size.begin() + 1, storage_size.begin() + 2, storage_size.end());
+        return {at::empty_symint(storage_size, grad.options()).movedim(-1, 1),
+                at::empty_symint(weights.sym_sizes(), weights.options())};
+    }
+    return {at::empty_symint(input.sym_sizes(), grad.options()),
+            at::empty_symint(weights.sym_sizes(), weights.options())};
+}
+
+
+template <int nD>
+torch::Tensor& shiftnd_accumulate_meta(torch::Tensor& out,
+                                       const torch::Tensor& input,
+                                       const torch::Tensor& weights,
+                                       int64_t padding_mode,
+                                       bool active_flag,
+                                       double alpha, double beta,
+                                       c10::IntArrayRef stride,
+                                       c10::IntArrayRef dilation){
+    TORCH_CHECK(input.dim() == nD + 2, "shift", nD, "d: expected ", nD + 2, "D input, but got ", input.dim(), "D");
+    TORCH_CHECK(out.dim() == nD + 2, "shift", nD, "d: expected ", nD + 2, "D accumulation buffer, but got ", out.dim(), "D");
+    expand_param<nD>(stride, "stride");
+    expand_param<nD>(dilation, "dilation");
+    return out;
+}
+
+template <int nD>
+torch::Tensor shiftnd_backward_accumulate_meta(torch::Tensor& out_grad,
+                                               const torch::Tensor& grad,
+                                               const torch::Tensor& weights,
+                                               const torch::Tensor& input,
+                                               int64_t padding_mode,
+                                               bool active_flag,
+                                               double alpha, double beta,
+                                               c10::IntArrayRef stride,
+                                               c10::IntArrayRef dilation){
+    return at::empty_symint(weights.sym_sizes(), weights.options());
+}
+
+
+template <int nD>
+torch::Tensor shiftnd_multi_forward_meta(const torch::Tensor& input,
+                                         const torch::Tensor& weights,
+                                         int64_t padding_mode,
+                                         bool active_flag){
+    TORCH_CHECK(input.dim() == nD + 2, "shift", nD, "d_multi: expected ", nD + 2, "D input, but got ", input.dim(), "D");
+    TORCH_CHECK(weights.dim() == 3, "shift", nD, "d_multi: expected 3D weights, but got ", weights.dim(), "D");
+    std::vector<c10::SymInt> output_size(input.sym_sizes().begin(), input.sym_sizes().end());
+    output_size[1] = output_size[1] * weights.sym_size(0);
+    return at::empty_symint(output_size, input.options().memory_format(input.suggest_memory_format()));
+}
+
+template <int nD>
+std::vector<torch::Tensor> shiftnd_multi_backward_meta(const torch::Tensor& grad,
+                                                       const torch::Tensor& weights,
+                                                       const torch::Tensor& input,
+                                                       int64_t padding_mode,
+                                                       bool active_flag){
+    return {at::empty_symint(input.sym_sizes(), grad.options()),
+            at::empty_symint(weights.sym_sizes(), weights.options())};
+}
+
+template <int nD>
+torch::Tensor shiftnd_packed_forward_meta(const torch::Tensor& input,
+                                          const torch::Tensor& sizes,
+                                          const torch::Tensor& weights,
+                                          int64_t padding_mode,
+                                          bool active_flag){
+    TORCH_CHECK(input.dim() == 1, "shift", nD, "d_packed: expected flat input buffer, but got ", input.dim(), "D");
+    return at::empty_symint(input.sym_sizes(), input.options());
+}
+
+template <int nD>
+std::vector<torch::Tensor> shiftnd_packed_backward_meta(const torch::Tensor& grad,
+                                                        const torch::Tensor& sizes,
+                                                        const torch::Tensor& weights,
+                                                        const torch::Tensor& input,
+                                                        int64_t padding_mode,
+                                                        bool active_flag){
+    return {at::empty_symint(input.sym_sizes(), grad.options()),
+            at::empty_symint(weights.sym_sizes(), weights.options())};
+}
+
+
+torch::Tensor shift1d_forward_meta(const torch::Tensor& input,
+                                   const torch::Tensor& weights,
+                                   int64_t padding_mode,
+                                   bool active_flag,
+                                   c10::IntArrayRef stride,
+                                   c10::IntArrayRef dilation,
+                                   c10::optional<c10::MemoryFormat> memory_format,
+                                   const c10::optional<torch::Tensor>& channel_perm,
+                                   double sparsity){
+    return shiftnd_forward_meta<1>(input, weights, padding_mode, active_flag, stride, dilation, memory_format, channel_perm);
+}
+
+torch::Tensor shift2d_forward_meta(const torch::Tensor& input,
+                                   const torch::Tensor& weights,
+                                   int64_t padding_mode,
+                                   bool active_flag,
+                                   c10::IntArrayRef stride,
+                                   c10::IntArrayRef dilation,
+                                   c10::optional<c10::MemoryFormat> memory_format,
+                                   const c10::optional<torch::Tensor>& channel_perm,
+                                   double sparsity){
+    return shiftnd_forward_meta<2>(input, weights, padding_mode, active_flag, stride, dilation, memory_format, channel_perm);
+}
+
+torch::Tensor shift3d_forward_meta(const torch::Tensor& input,
+                                   const torch::Tensor& weights,
+                                   int64_t padding_mode,
+                                   bool active_flag,
+                                   c10::IntArrayRef stride,
+                                   c10::IntArrayRef dilation,
+                                   c10::optional<c10::MemoryFormat> memory_format,
+                                   const c10::optional<torch::Tensor>& channel_perm,
+                                   double sparsity){
+    return shiftnd_forward_meta<3>(input, weights, padding_mode, active_flag, stride, dilation, memory_format, channel_perm);
+}
+
+std::vector<torch::Tensor> shift1d_backward_meta(const torch::Tensor& grad,
+                                                 const torch::Tensor& weights,
+                                                 const torch::Tensor& input,
+                                                 int64_t padding_mode,
+                                                 bool active_flag,
+                                                 c10::IntArrayRef stride,
+                                                 c10::IntArrayRef dilation,
+                                                 double sparsity){
+    return shiftnd_backward_meta<1>(grad, weights, input, padding_mode, active_flag, stride, dilation);
+}
+
+std::vector<torch::Tensor> shift2d_backward_meta(const torch::Tensor& grad,
+                                                 const torch::Tensor& weights,
+                                                 const torch::Tensor& input,
+                                                 int64_t padding_mode,
+                                                 bool active_flag,
+                                                 c10::IntArrayRef stride,
+                                                 c10::IntArrayRef dilation,
+                                                 double sparsity){
+    return shiftnd_backward_meta<2>(grad, weights, input, padding_mode, active_flag, stride, dilation);
+}
+
+std::vector<torch::Tensor> shift3d_backward_meta(const torch::Tensor& grad,
+                                                 const torch::Tensor& weights,
+                                                 const torch::Tensor& input,
+                                                 int64_t padding_mode,
+                                                 bool active_flag,
+                                                 c10::IntArrayRef stride,
+                                                 c10::IntArrayRef dilation,
+                                                 double sparsity){
+    return shiftnd_backward_meta<3>(grad, weights, input, padding_mode, active_flag, stride, dilation);
+}
+
+
+torch::Tensor& shift1d_accumulate_meta(torch::Tensor& out,
+                                       const torch::Tensor& input,
+                                       const torch::Tensor& weights,
+                                       int64_t padding_mode,
+                                       bool active_flag,
+                                       double alpha, double beta,
+                                       c10::IntArrayRef stride,
+                                       c10::IntArrayRef dilation){
+    return shiftnd_accumulate_meta<1>(out, input, weights, padding_mode, active_flag, alpha, beta, stride, dilation);
+}
+
+torch::Tensor& shift2d_accumulate_meta(torch::Tensor& out,
+                                       const torch::Tensor& input,
+                                       const torch::Tensor& weights,
+                                       int64_t padding_mode,
+                                       bool active_flag,
+                                       double alpha, double beta,
+                                       c10::IntArrayRef stride,
+                                       c10::IntArrayRef dilation){
+    return shiftnd_accumulate_meta<2>(out, input, weights, padding_mode, active_flag, alpha, beta, stride, dilation);
+}
+
+torch::Tensor& shift3d_accumulate_meta(torch::Tensor& out,
+                                       const torch::Tensor& input,
+                                       const torch::Tensor& weights,
+                                       int64_t padding_mode,
+                                       bool active_flag,
+                                       double alpha, double beta,
+                                       c10::IntArrayRef stride,
+                                       c10::IntArrayRef dilation){
+    return shiftnd_accumulate_meta<3>(out, input, weights, padding_mode, active_flag, alpha, beta, stride, dilation);
+}
+
+torch::Tensor shift1d_backward_accumulate_meta(torch::Tensor& out_grad,
+                                               const torch::Tensor& grad,
+                                               const torch::Tensor& weights,
+                                               const torch::Tensor& input,
+                                               int64_t padding_mode,
+                                               bool active_flag,
+                                               double alpha, double beta,
+                                               c10::IntArrayRef stride,
+                                               c10::IntArrayRef dilation){
+    return shiftnd_backward_accumulate_meta<1>(out_grad, grad, weights, input, padding_mode, active_flag,
+                                               alpha, beta, stride, dilation);
+}
+
+torch::Tensor shift2d_backward_accumulate_meta(torch::Tensor& out_grad,
+                                               const torch::Tensor& grad,
+                                               const torch::Tensor& weights,
+                                               const torch::Tensor& input,
+                                               int64_t padding_mode,
+                                               bool active_flag,
+                                               double alpha, double beta,
+                                               c10::IntArrayRef stride,
+                                               c10::IntArrayRef dilation){
+    return shiftnd_backward_accumulate_meta<2>(out_grad, grad, weights, input, padding_mode, active_flag,
+                                               alpha, beta, stride, dilation);
+}
+
+torch::Tensor shift3d_backward_accumulate_meta(torch::Tensor& out_grad,
+                                               const torch::Tensor& grad,
+                                               const torch::Tensor& weights,
+                                               const torch::Tensor& input,
+                                               int64_t padding_mode,
+                                               bool active_flag,
+                                               double alpha, double beta,
+                                               c10::IntArrayRef stride,
+                                               c10::IntArrayRef dilation){
+    return shiftnd_backward_accumulate_meta<3>(out_grad, grad, weights, input, padding_mode, active_flag,
+                                               alpha, beta, stride, dilation);
+}
+
+
+torch::Tensor shift1d_multi_forward_meta(const torch::Tensor& input,
+                                         const torch::Tensor& weights,
+                                         int64_t padding_mode,
+                                         bool active_flag){
+    return shiftnd_multi_forward_meta<1>(input, weights, padding_mode, active_flag);
+}
+
+torch::Tensor shift2d_multi_forward_meta(const torch::Tensor& input,
+                                         const torch::Tensor& weights,
+                                         int64_t padding_mode,
+                                         bool active_flag){
+    return shiftnd_multi_forward_meta<2>(input, weights, padding_mode, active_flag);
+}
+
+torch::Tensor shift3d_multi_forward_meta(const torch::Tensor& input,
+                                         const torch::Tensor& weights,
+                                         int64_t padding_mode,
+                                         bool active_flag){
+    return shiftnd_multi_forward_meta<3>(input, weights, padding_mode, active_flag);
+}
+
+std::vector<torch::Tensor> shift1d_multi_backward_meta(const torch::Tensor& grad,
+                                                       const torch::Tensor& weights,
+                                                       const torch::Tensor& input,
+                                                       int64_t padding_mode,
+                                                       bool active_flag){
+    return shiftnd_multi_backward_meta<1>(grad, weights, input, padding_mode, active_flag);
+}
+
+std::vector<torch::Tensor> shift2d_multi_backward_meta(const torch::Tensor& grad,
+                                                       const torch::Tensor& weights,
+                                                       const torch::Tensor& input,
+                                                       int64_t padding_mode,
+                                                       bool active_flag){
+    return shiftnd_multi_backward_meta<2>(grad, weights, input, padding_mode, active_flag);
+}
+
+std::vector<torch::Tensor> shift3d_multi_backward_meta(const torch::Tensor& grad,
+                                                       const torch::Tensor& weights,
+                                                       const torch::Tensor& input,
+                                                       int64_t padding_mode,
+                                                       bool active_flag){
+    return shiftnd_multi_backward_meta<3>(grad, weights, input, padding_mode, active_flag);
+}
+
+
+torch::Tensor shift1d_packed_forward_meta(const torch::Tensor& input,
+                                          const torch::Tensor& sizes,
+                                          const torch::Tensor& weights,
+                                          int64_t padding_mode,
+                                          bool active_flag){
+    return shiftnd_packed_forward_meta<1>(input, sizes, weights, padding_mode, active_flag);
+}
+
+torch::Tensor shift2d_packed_forward_meta(const torch::Tensor& input,
+                                          const torch::Tensor& sizes,
+                                          const torch::Tensor& weights,
+                                          int64_t padding_mode,
+                                          bool active_flag){
+    return shiftnd_packed_forward_meta<2>(input, sizes, weights, padding_mode, active_flag);
+}
+
+torch::Tensor shift3d_packed_forward_meta(const torch::Tensor& input,
+                                          const torch::Tensor& sizes,
+                                          const torch::Tensor& weights,
+                                          int64_t padding_mode,
+                                          bool active_flag){
+    return shiftnd_packed_forward_meta<3>(input, sizes, weights, padding_mode, active_flag);
+}
+
+std::vector<torch::Tensor> shift1d_packed_backward_meta(const torch::Tensor& grad,
+                                                        const torch::Tensor& sizes,
+                                                        const torch::Tensor& weights,
+                                                        const torch::Tensor& input,
+                                                        int64_t padding_mode,
+                                                        bool active_flag){
+    return shiftnd_packed_backward_meta<1>(grad, sizes, weights, input, padding_mode, active_flag);
+}
+
+std::vector<torch::Tensor> shift2d_packed_backward_meta(const torch::Tensor& grad,
+                                                        const torch::Tensor& sizes,
+                                                        const torch::Tensor& weights,
+                                                        const torch::Tensor& input,
+                                                        int64_t padding_mode,
+                                                        bool active_flag){
+    return shiftnd_packed_backward_meta<2>(grad, sizes, weights, input, padding_mode, active_flag);
+}
+
+std::vector<torch::Tensor> shift3d_packed_backward_meta(const torch::Tensor& grad,
+                                                        const torch::Tensor& sizes,
+                                                        const torch::Tensor& weights,
+                                                        const torch::Tensor& input,
+                                                        int64_t padding_mode,
+                                                        bool active_flag){
+    return shiftnd_packed_backward_meta<3>(grad, sizes, weights, input, padding_mode, active_flag);
+}
+
+
+torch::Tensor shift3d_sparse_forward_meta(const torch::Tensor& features,
+                                          const torch::Tensor& coords,
+                                          c10::IntArrayRef spatial_size,
+                                          const torch::Tensor& weights,
+                                          bool active_flag){
+    check_sparse_voxels(features, coords, spatial_size, weights);
+    return at::empty_symint(features.sym_sizes(), features.options());
+}
+
+std::vector<torch::Tensor> shift3d_sparse_backward_meta(const torch::Tensor& grad,
+                                                        const torch::Tensor& coords,
+                                                        c10::IntArrayRef spatial_size,
+                                                        const torch::Tensor& weights,
+                                                        const torch::Tensor& features,
+                                                        bool active_flag){
+    return {at::empty_symint(features.sym_sizes(), grad.options()),
+            at::empty_symint(weights.sym_sizes(), weights.options())};
+}
+
+
+torch::Tensor shiftnd_generic_forward_meta(const torch::Tensor& input,
+                                           const torch::Tensor& weights,
+                                           int64_t padding_mode,
+                                           bool active_flag){
+    check_rank_weights(input, weights);
+    return at::empty_symint(input.sym_sizes(), input.options());
+}
+
+std::vector<torch::Tensor> shiftnd_generic_backward_meta(const torch::Tensor& grad,
+                                                         const torch::Tensor& weights,
+                                                         const torch::Tensor& input,
+                                                         int64_t padding_mode,
+                                                         bool active_flag){
+    return {at::empty_symint(input.sym_sizes(), grad.options()),
+            at::empty_symint(weights.sym_sizes(), weights.options())};
+}
+
+
+TORCH_LIBRARY_IMPL(torchshifts, Meta, m) {
+    m.impl("shift1d", &shift1d_forward_meta);
+    m.impl("shift2d", &shift2d_forward_meta);
+    m.impl("shift3d", &shift3d_forward_meta);
+    m.impl("_shift1d_backward", &shift1d_backward_meta);
+    m.impl("_shift2d_backward", &shift2d_backward_meta);
+    m.impl("_shift3d_backward", &shift3d_backward_meta);
+    m.impl("shift1d_accumulate_", &shift1d_accumulate_meta);
+    m.impl("shift2d_accumulate_", &shift2d_accumulate_meta);
+    m.impl("shift3d_accumulate_", &shift3d_accumulate_meta);
+    m.impl("_shift1d_backward_accumulate_", &shift1d_backward_accumulate_meta);
+    m.impl("_shift2d_backward_accumulate_", &shift2d_backward_accumulate_meta);
+    m.impl("_shift3d_backward_accumulate_", &shift3d_backward_accumulate_meta);
+    m.impl("shift1d_multi", &shift1d_multi_forward_meta);
+    m.impl("shift2d_multi", &shift2d_multi_forward_meta);
+    m.impl("shift3d_multi", &shift3d_multi_forward_meta);
+    m.impl("_shift1d_multi_backward", &shift1d_multi_backward_meta);
+    m.impl("_shift2d_multi_backward", &shift2d_multi_backward_meta);
+    m.impl("_shift3d_multi_backward", &shift3d_multi_backward_meta);
+    m.impl("shift1d_packed", &shift1d_packed_forward_meta);
+    m.impl("shift2d_packed", &shift2d_packed_forward_meta);
+    m.impl("shift3d_packed", &shift3d_packed_forward_meta);
+    m.impl("_shift1d_packed_backward", &shift1d_packed_backward_meta);
+    m.impl("_shift2d_packed_backward", &shift2d_packed_backward_meta);
+    m.impl("_shift3d_packed_backward", &shift3d_packed_backward_meta);
+    m.impl("shift3d_sparse", &shift3d_sparse_forward_meta);
+    m.impl("_shift3d_sparse_backward", &shift3d_sparse_backward_meta);
+    m.impl("shiftnd", &shiftnd_generic_forward_meta);
+    m.impl("_shiftnd_backward", &shiftnd_generic_backward_meta);
+}
@@ -0,0 +1,215 @@
+#pragma once
+#include <torch/torch.h>
+#include "../global_scope.h"
+
+
+// Shape-only kernels for Meta/Fake tensors (torch.compile, export)
+API_EXPORT torch::Tensor shift1d_forward_meta(const torch::Tensor& input,
+                                              const torch::Tensor& weights,
+                                              int64_t padding_mode,
+                                              bool active_flag,
+                                              c10::IntArrayRef stride,
+                                              c10::IntArrayRef dilation,
+                                              c10::optional<c10::MemoryFormat> memory_format,
+                                              const c10::optional<torch::Tensor>& channel_perm,
+                                              double sparsity);
+
+API_EXPORT torch::Tensor shift2d_forward_meta(const torch::Tensor& input,
+                                              const torch::Tensor& weights,
+                                              int64_t padding_mode,
+                                              bool active_flag,
+                                              c10::IntArrayRef stride,
+                                              c10::IntArrayRef dilation,
+                                              c10::optional<c10::MemoryFormat> memory_format,
+                                              const c10::optional<torch::Tensor>& channel_perm,
+                                              double sparsity);
+
+API_EXPORT torch::Tensor shift3d_forward_meta(const torch::Tensor& input,
+                                              const torch::Tensor& weights,
+                                              int64_t padding_mode,
+                                              bool active_flag,
+                                              c10::IntArrayRef stride,
+                                              c10::IntArrayRef dilation,
+                                              c10::optional<c10::MemoryFormat> memory_format,
+                                              const c10::optional<torch::Tensor>& channel_perm,
+                                              double sparsity);
+
+API_EXPORT std::vector<torch::Tensor> shift1d_backward_meta(const torch::Tensor& grad,
+                                                            const torch::Tensor& weights,
+                                                            const torch::Tensor& input,
+                                                            int64_t padding_mode,
+                                                            bool active_flag,
+                                                            c10::IntArrayRef stride,
+                                                            c10::IntArrayRef dilation,
+                                                            double sparsity);
+
+API_EXPORT std::vector<torch::Tensor> shift2d_backward_meta(const torch::Tensor& grad,
+                                                            const torch::Tensor& weights,
+                                                            const torch::Tensor& input,
+                                                            int64_t padding_mode,
+                                                            bool active_flag,
+                                                            c10::IntArrayRef stride,
+                                                            c10::IntArrayRef dilation,
+                                                            double sparsity);
+
+API_EXPORT std::vector<torch::Tensor> shift3d_backward_meta(const torch::Tensor& grad,
+                                                            const torch::Tensor& weights,
+                                                            const torch::Tensor& input,
+                                                            int64_t padding_mode,
+                                                            bool active_flag,
+                                                            c10::IntArrayRef stride,
+                                                            c10::IntArrayRef dilation,
+                                                            double sparsity);
+
+API_EXPORT torch::Tensor& shift1d_accumulate_meta(torch::Tensor& out,
+                                                  const torch::Tensor& input,
+                                                  const torch::Tensor& weights,
+                                                  int64_t padding_mode,
+                                                  bool active_flag,
+                                                  double alpha, double beta,
+                                                  c10::IntArrayRef stride,
+                                                  c10::IntArrayRef dilation);
+
+API_EXPORT torch::Tensor& shift2d_accumulate_meta(torch::Tensor& out,
+                                                  const torch::Tensor& input,
+                                                  const torch::Tensor& weights,
+                                                  int64_t padding_mode,
+                                                  bool active_flag,
+                                                  double alpha, double beta,
+                                                  c10::IntArrayRef stride,
+                                                  c10::IntArrayRef dilation);
+
+API_EXPORT torch::Tensor& shift3d_accumulate_meta(torch::Tensor& out,
+                                                  const torch::Tensor& input,
+                                                  const torch::Tensor& weights,
+                                                  int64_t padding_mode,
+                                                  bool active_flag,
+                                                  double alpha, double beta,
+                                                  c10::IntArrayRef stride,
+                                                  c10::IntArrayRef dilation);
+
+API_EXPORT torch::Tensor shift1d_backward_accumulate_meta(torch::Tensor& out_grad,
+                                                          const torch::Tensor& grad,
+                                                          const torch::Tensor& weights,
+                                                          const torch::Tensor& input,
+                                                          int64_t padding_mode,
+                                                          bool active_flag,
+                                                          double alpha, double beta,
+                                                          c10::IntArrayRef stride,
+                                                          c10::IntArrayRef dilation);
+
+API_EXPORT torch::Tensor shift2d_backward_accumulate_meta(torch::Tensor& out_grad,
+                                                          const torch::Tensor& grad,
+                                                          const torch::Tensor& weights,
+                                                          const torch::Tensor& input,
+                                                          int64_t padding_mode,
+                                                          bool active_flag,
+                                                          double alpha, double beta,
+                                                          c10::IntArrayRef stride,
+                                                          c10::IntArrayRef dilation);
+
+API_EXPORT torch::Tensor shift3d_backward_accumulate_meta(torch::Tensor& out_grad,
+                                                          const torch::Tensor& grad,
+                                                          const torch::Tensor& weights,
+                                                          const torch::Tensor& input,
+                                                          int64_t padding_mode,
+                                                          bool active_flag,
+                                                          double alpha, double beta,
+                                                          c10::IntArrayRef stride,
+                                                          c10::IntArrayRef dilation);
+
+API_EXPORT torch::Tensor shift1d_multi_forward_meta(const torch::Tensor& input,
+                                                    const torch::Tensor& weights,
+                                                    int64_t padding_mode,
+                                                    bool active_flag);
+
+API_EXPORT torch::Tensor shift2d_multi_forward_meta(const torch::Tensor& input,
+                                                    const torch::Tensor& weights,
+                                                    int64_t padding_mode,
+                                                    bool active_flag);
+
+API_EXPORT torch::Tensor shift3d_multi_forward_meta(const torch::Tensor& input,
+                                                    const torch::Tensor& weights,
+                                                    int64_t padding_mode,
+                                                    bool active_flag);
+
+API_EXPORT std::vector<torch::Tensor> shift1d_multi_backward_meta(const torch::Tensor& grad,
+                                                                  const torch::Tensor& weights,
+                                                                  const torch::Tensor& input,
+                                                                  int64_t padding_mode,
+                                                                  bool active_flag);
+
+API_EXPORT std::vector<torch::Tensor> shift2d_multi_backward_meta(const torch::Tensor& grad,
+                                                                  const torch::Tensor& weights,
+                                                                  const torch::Tensor& input,
+                                                                  int64_t padding_mode,
+                                                                  bool active_flag);
+
+API_EXPORT std::vector<torch::Tensor> shift3d_multi_backward_meta(const torch::Tensor& grad,
+                                                                  const torch::Tensor& weights,
+                                                                  const torch::Tensor& input,
+                                                                  int64_t padding_mode,
+                                                                  bool active_flag);
+
+API_EXPORT torch::Tensor shift1d_packed_forward_meta(const torch::Tensor& input,
+                                                     const torch::Tensor& sizes,
+                                                     const torch::Tensor& weights,
+                                                     int64_t padding_mode,
+                                                     bool active_flag);
+
+API_EXPORT torch::Tensor shift2d_packed_forward_meta(const torch::Tensor& input,
+                                                     const torch::Tensor& sizes,
+                                                     const torch::Tensor& weights,
+                                                     int64_t padding_mode,
+                                                     bool active_flag);
+
+API_EXPORT torch::Tensor shift3d_packed_forward_meta(const torch::Tensor& input,
+                                                     const torch::Tensor& sizes,
+                                                     const torch::Tensor& weights,
+                                                     int64_t padding_mode,
+                                                     bool active_flag);
+
+API_EXPORT std::vector<torch::Tensor> shift1d_packed_backward_meta(const torch::Tensor& grad,
+                                                                   const torch::Tensor& sizes,
+                                                                   const torch::Tensor& weights,
+                                                                   const torch::Tensor& input,
+                                                                   int64_t padding_mode,
+                                                                   bool active_flag);
+
+API_EXPORT std::vector<torch::Tensor> shift2d_packed_backward_meta(const torch::Tensor& grad,
+                                                                   const torch::Tensor& sizes,
+                                                                   const torch::Tensor& weights,
+                                                                   const torch::Tensor& input,
+                                                                   int64_t padding_mode,
+                                                                   bool active_flag);
+
+API_EXPORT std::vector<torch::Tensor> shift3d_packed_backward_meta(const torch::Tensor& grad,
+                                                                   const torch::Tensor& sizes,
+                                                                   const torch::Tensor& weights,
+                                                                   const torch::Tensor& input,
+                                                                   int64_t padding_mode,
+                                                                   bool active_flag);
+
+API_EXPORT torch::Tensor shift3d_sparse_forward_meta(const torch::Tensor& features,
+                                                     const torch::Tensor& coords,
+                                                     c10::IntArrayRef spatial_size,
+                                                     const torch::Tensor& weights,
+                                                     bool active_flag);
+
+API_EXPORT std::vector<torch::Tensor> shift3d_sparse_backward_meta(const torch::Tensor& grad,
+                                                                   const torch::Tensor& coords,
+                                                                   c10::IntArrayRef spatial_size,
+                                                                   const torch::Tensor& weights,
+                                                                   const torch::Tensor& features,
+                                                                   bool active_flag);
+
+API_EXPORT torch::Tensor shiftnd_generic_forward_meta(const torch::Tensor& input,
+                                                      const torch::Tensor& weights,
+                                                      int64_t padding_mode,
+                                                      bool active_flag);
+
+API_EXPORT std::vector<torch::Tensor> shiftnd_generic_backward_meta(const torch::Tensor& grad,
+                                                                    const torch::Tensor& weights,
+                                                                    const torch::Tensor& input,
+                                                                    int64_t padding_mode,
+                                                                    bool active_flag);
@@ -1,9 +1,15 @@
 #ifndef _SHIFTS_CPU
 #define _SHIFTS_CPU
 
+#include <torch/library.h>
 #include "shifts_quantized.h"
+#include "../cpu/shifts_partition.h"
+#include "../shifts_params.h"
 #include "../kernels/shifts_kernels.h"
 
+using shifts::partition::Geometry;
+using shifts::partition::Plan;
+
 
 
 
@@ -11,12 +17,20 @@ template <typename scalar_t, int32_t kSpatialDim>
 API_INLINE void _q_shifts_cpu(const torch::Tensor& input, const torch::Tensor& weights,
                               torch::Tensor& output,
                               int64_t weights_zero_point,
-                              BIPadding padding_mode){
+                              const std::array<int64_t, 3>& steps,
+                              BIPadding padding_mode,
+                              const int64_t* perm){
     int64_t sizeN = input.size(0);
     int64_t sizeC = input.size(1);
     int64_t sizeH = input.size(2);
     int64_t sizeW = kSpatialDim < 2 ? 1 : input.size(3);
     int64_t sizeD = kSpatialDim < 3 ? 1 : input.size(4);
+    int64_t outH = output.size(2);
+    int64_t outW = kSpatialDim < 2 ? 1 : output.size(3);
+    int64_t outD = kSpatialDim < 3 ? 1 : output.size(4);
+    int64_t stepH = steps[0];
+    int64_t stepW = steps[1];
+    int64_t stepD = steps[2];
     int64_t input_sN = input.stride(0);
     int64_t input_sC = input.stride(1);
     int64_t input_sH = input.stride(2);
@@ -31,39 +45,51 @@ API_INLINE void _q_shifts_cpu(const torch::Tensor& input, const torch::Tensor& w
     scalar_t zero_point  = static_cast<scalar_t>(input.q_zero_point());
     scalar_t *output_ptr = output.data_ptr<scalar_t>();
     int64_t *weights_ptr = weights.data_ptr<int64_t>();
-    int64_t weights_sC = weights.stride(0);
-    int64_t weights_sS = weights.stride(1);
-    if (input.is_contiguous(c10::MemoryFormat::ChannelsLast) || input.is_contiguous(c10::MemoryFormat::ChannelsLast3d))
+    int64_t weights_sN = weights.stride(0);
+    int64_t weights_sC = weights.stride(1);
+    int64_t weights_sS = weights.stride(2);
+    // permuted channels are written one by one(NCHWD path at any layout)
+    Geometry geometry{sizeN, sizeC, outH, outW*outD, static_cast<int64_t>(sizeof(scalar_t)),
+                      (perm == nullptr) &&
+                      (input.is_contiguous(c10::MemoryFormat::ChannelsLast) || input.is_contiguous(c10::MemoryFormat::ChannelsLast3d)),
+                      1};
+    Plan plan = shifts::partition::choose_plan(geometry);
+    if (geometry.channels_inner)
     {// Path for NDHWC
-        at::parallel_for(0, sizeN*sizeH*sizeW*sizeD, 0, [&](int64_t start, int64_t end){
-            for (int64_t index = start; index < end; ++index) {
-                int64_t k = index % sizeD;
-                int64_t j = (index / sizeD) % sizeW;
-                int64_t i = (index / (sizeD*sizeW)) % sizeH;
-                int64_t n = (index / (sizeD*sizeW*sizeH));
-                shift_forward_kernel_nhwdc_q<scalar_t, int64_t>(input_ptr, output_ptr, weights_ptr,
-                                                                n, i, j, k, sizeC, sizeH, sizeW, sizeD,
-                                                                input_sN, input_sC, input_sH, input_sW, input_sD,
-                                                                output_sN, output_sC, output_sH, output_sW, output_sD,
-                                                                weights_sC, weights_sS,
-                                                                zero_point,  weights_zero_point, padding_mode);
+        shifts::partition::for_each_tile(plan, [&](int64_t n, int64_t c_begin, int64_t c_end, int64_t i_begin, int64_t i_end){
+            for (int64_t i = i_begin; i < i_end; ++i) {
+                for (int64_t j = 0; j < outW; ++j) {
+                    for (int64_t k = 0; k < outD; ++k) {
+                        shift_forward_kernel_nhwdc_q<scalar_t, int64_t>(input_ptr + c_begin*input_sC, output_ptr + c_begin*output_sC,
+                                                                        weights_ptr + n*weights_sN + c_begin*weights_sC,
+                                                                        n, i, j, k, c_end - c_begin, sizeH, sizeW, sizeD,
+                                                                        stepH, stepW, stepD,
+                                                                        input_sN, input_sC, input_sH, input_sW, input_sD,
+                                                                        output_sN, output_sC, output_sH, output_sW, output_sD,
+                                                                        weights_sC, weights_sS,
+                                                                        zero_point,  weights_zero_point, padding_mode);
+                    }
+                }
             }
         });
     } else
     {
-        at::parallel_for(0, sizeN*sizeC*sizeH*sizeW*sizeD, 0, [&](int64_t start, int64_t end){
-            for (int64_t index = start; index < end; ++index) {
-                int64_t k = index % sizeD;
-                int64_t j = (index / sizeD) % sizeW;
-                int64_t i = (index / (sizeD*sizeW)) % sizeH;
-                int64_t c = (index / (sizeD*sizeW*sizeH)) % sizeC;
-                int64_t n = (index / (sizeD*sizeW*sizeH*sizeC));
-                shift_forward_kernel_nchwd_q<scalar_t, int64_t>(input_ptr, output_ptr, weights_ptr,
-                                                                n, c, i, j, k, sizeH, sizeW, sizeD,
-                                                                input_sN, input_sC, input_sH, input_sW, input_sD,
-                                                                output_sN, output_sC, output_sH, output_sW, output_sD,
-                                                                weights_sC, weights_sS,
-                                                                zero_point,  weights_zero_point, padding_mode);
+        shifts::partition::for_each_tile(plan, [&](int64_t n, int64_t c_begin, int64_t c_end, int64_t i_begin, int64_t i_end){
+            for (int64_t c = c_begin; c < c_end; ++c) {
+                scalar_t *output_c = perm ? output_ptr + (perm[c] - c)*output_sC : output_ptr;
+                for (int64_t i = i_begin; i < i_end; ++i) {
+                    for (int64_t j = 0; j < outW; ++j) {
+                        for (int64_t k = 0; k < outD; ++k) {
+                            shift_forward_kernel_nchwd_q<scalar_t, int64_t>(input_ptr, output_c, weights_ptr + n*weights_sN,
+                                                                            n, c, i, j, k, sizeH, sizeW, sizeD,
+                                                                            stepH, stepW, stepD,
+                                                                            input_sN, input_sC, input_sH, input_sW, input_sD,
+                                                                            output_sN, output_sC, output_sH, output_sW, output_sD,
+                                                                            weights_sC, weights_sS,
+                                                                            zero_point,  weights_zero_point, padding_mode);
+                        }
+                    }
+                }
             }
         });
     }
@@ -73,24 +99,39 @@ API_INLINE void _q_shifts_cpu(const torch::Tensor& input, const torch::Tensor& w
 template <int nD>
 torch::Tensor q_shiftnd_cpu(const torch::Tensor& input,
                             const torch::Tensor& weights,
-                            int64_t padding_mode){
+                            int64_t padding_mode,
+                            c10::IntArrayRef stride,
+                            c10::IntArrayRef dilation,
+                            c10::optional<c10::MemoryFormat> memory_format,
+                            const c10::optional<torch::Tensor>& channel_perm){
     std::string name = "q_shift"+std::to_string(nD)+"d_cpu";
+    std::array<int64_t, 3> steps = expand_param<nD>(stride, "stride");
+    std::array<int64_t, 3> dilations = expand_param<nD>(dilation, "dilation");
+    std::vector<int64_t> output_size = strided_output_size<nD>(input.sizes(), steps);
+    check_weights<nD>(input, weights);
+    check_channel_perm<nD>(input, channel_perm);
+    torch::Tensor perm = has_channel_perm(channel_perm) ? channel_perm->contiguous() : torch::Tensor();
     torch::Tensor output;
     int64_t weights_zero_point = static_cast<int64_t>(weights.q_zero_point());
     torch::Tensor iweights = weights.int_repr().to(torch::kLong);
+    if (!is_unit_param(dilations)){
+        // integer shifts are scaled exactly, zero point is applied here instead of the kernel
+        iweights = (iweights - weights_zero_point) * torch::tensor(std::vector<int64_t>(dilations.begin(), dilations.begin() + nD),
+                                                                   iweights.options());
+        weights_zero_point = 0;
+    }
+    iweights = batched_weights(iweights, input.size(0));
     
     
-    if (input.is_contiguous(c10::MemoryFormat::ChannelsLast) || input.is_contiguous(c10::MemoryFormat::ChannelsLast3d)) {
-        output = at::_empty_affine_quantized(input.sizes(), input.options().memory_format(input.suggest_memory_format()),
-                                             input.q_scale(), input.q_zero_point(), c10::nullopt);
-    }
-    else {
-        output = at::_empty_affine_quantized(input.sizes(), input.options(), input.q_scale(), input.q_zero_point());
-    }
+    // quantized output keeps the input layout unless another one is requested
+    c10::MemoryFormat output_format = output_memory_format<nD>(input, memory_format, input.suggest_memory_format());
+    output = at::_empty_affine_quantized(output_size, input.options().memory_format(output_format),
+                                         input.q_scale(), input.q_zero_point(), c10::nullopt);
 
     AT_DISPATCH_QINT_TYPES(input.scalar_type(), name, [&] {
-            _q_shifts_cpu<scalar_t, nD>(input, iweights, output, weights_zero_point,
-                                        static_cast<BIPadding>(padding_mode));
+            _q_shifts_cpu<scalar_t, nD>(input, iweights, output, weights_zero_point, steps,
+                                        static_cast<BIPadding>(padding_mode),
+                                        perm.defined() ? perm.data_ptr<int64_t>() : nullptr);
     }); 
     return output;
 }
@@ -100,20 +141,45 @@ torch::Tensor q_shiftnd_cpu(const torch::Tensor& input,
 
 torch::Tensor q_shift1d_cpu(const torch::Tensor& input,
                             const torch::Tensor& weights,
-                            int64_t padding_mode){
-    return q_shiftnd_cpu<1>(input, weights, padding_mode);                    
+                            int64_t padding_mode,
+                            bool active_flag,
+                            c10::IntArrayRef stride,
+                            c10::IntArrayRef dilation,
+                            c10::optional<c10::MemoryFormat> memory_format,
+                            const c10::optional<torch::Tensor>& channel_perm,
+                            double sparsity){
+    return q_shiftnd_cpu<1>(input, weights, padding_mode, stride, dilation, memory_format, channel_perm);                    
 }
 
 torch::Tensor q_shift2d_cpu(const torch::Tensor& input,
                             const torch::Tensor& weights,
-                            int64_t padding_mode){
-    return q_shiftnd_cpu<2>(input, weights, padding_mode);                    
+                            int64_t padding_mode,
+                            bool active_flag,
+                            c10::IntArrayRef stride,
+                            c10::IntArrayRef dilation,
+                            c10::optional<c10::MemoryFormat> memory_format,
+                            const c10::optional<torch::Tensor>& channel_perm,
+                            double sparsity){
+    return q_shiftnd_cpu<2>(input, weights, padding_mode, stride, dilation, memory_format, channel_perm);                    
 }
 
 torch::Tensor q_shift3d_cpu(const torch::Tensor& input,
                             const torch::Tensor& weights,
-                            int64_t padding_mode){
-    return q_shiftnd_cpu<3>(input, weights, padding_mode);                    
+                            int64_t padding_mode,
+                            bool active_flag,
+                            c10::IntArrayRef stride,
+                            c10::IntArrayRef dilation,
+                            c10::optional<c10::MemoryFormat> memory_format,
+                            const c10::optional<torch::Tensor>& channel_perm,
+                            double sparsity){
+    return q_shiftnd_cpu<3>(input, weights, padding_mode, stride, dilation, memory_format, channel_perm);                    
+}
+
+// active_flag is ignored: quantized shifts are always integer, sparsity only matters for backward
+TORCH_LIBRARY_IMPL(torchshifts, QuantizedCPU, m) {
+    m.impl("shift1d", &q_shift1d_cpu);
+    m.impl("shift2d", &q_shift2d_cpu);
+    m.impl("shift3d", &q_shift3d_cpu);
 }
 
 #endif
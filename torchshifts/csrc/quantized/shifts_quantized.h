@@ -1,16 +1,34 @@
 #pragma once
-#include <torch/extension.h>
+#include <torch/torch.h>
 #include "../global_scope.h"
 
 
 API_EXPORT torch::Tensor q_shift1d_cpu(const torch::Tensor& input,
                                        const torch::Tensor& weights,
-                                       int64_t padding_mode);
+                                       int64_t padding_mode,
+                                       bool active_flag,
+                                       c10::IntArrayRef stride,
+                                       c10::IntArrayRef dilation,
+                                       c10::optional<c10::MemoryFormat> memory_format,
+                                       const c10::optional<torch::Tensor>& channel_perm,
+                                       double sparsity);
 
 API_EXPORT torch::Tensor q_shift2d_cpu(const torch::Tensor& input,
                                        const torch::Tensor& weights,
-                                       int64_t padding_mode);
+                                       int64_t padding_mode,
+                                       bool active_flag,
+                                       c10::IntArrayRef stride,
+                                       c10::IntArrayRef dilation,
+                                       c10::optional<c10::MemoryFormat> memory_format,
+                                       const c10::optional<torch::Tensor>& channel_perm,
+                                       double sparsity);
 
 API_EXPORT torch::Tensor q_shift3d_cpu(const torch::Tensor& input,
                                        const torch::Tensor& weights,
-                                       int64_t padding_mode);  
\ No newline at end of file
+                                       int64_t padding_mode,
+                                       bool active_flag,
+                                       c10::IntArrayRef stride,
+                                       c10::IntArrayRef dilation,
+                                       c10::optional<c10::MemoryFormat> memory_format,
+                                       const c10::optional<torch::Tensor>& channel_perm,
+                                       double sparsity);  
\ No newline at end of file
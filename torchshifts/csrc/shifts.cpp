@@ -1,15 +1,18 @@
-#include <Python.h>
+#ifdef WITH_PYTHON
+    #include <Python.h>
+#endif
 #include <torch/script.h>
 
 #ifdef WITH_CUDA
     #include <cuda.h>
 #endif
 
-#include "shifts.h"
+#include "torchshifts.h"
 #include "shifts_ops.h"
+#include "cpu/shifts_autotune.h"
 
 
-#ifdef _WIN32
+#if defined(_WIN32) && defined(WITH_PYTHON)
     #if PY_MAJOR_VERSION < 3
         PyMODINIT_FUNC init_C(void) {return NULL;}
     #else
@@ -25,11 +28,249 @@ namespace shifts {
             return -1;
         #endif
     }
+
+    // Public C++ API(torchshifts.h)
+    torch::Tensor shift1d(const torch::Tensor& input, const torch::Tensor& weights,
+                          int64_t padding_mode, bool active_flag,
+                          c10::IntArrayRef stride, c10::IntArrayRef dilation,
+                          c10::optional<c10::MemoryFormat> memory_format,
+                          const c10::optional<torch::Tensor>& channel_perm,
+                          double sparsity){
+        return ::shift1d(input, weights, padding_mode, active_flag, stride, dilation, memory_format, channel_perm, sparsity);
+    }
+
+    torch::Tensor shift2d(const torch::Tensor& input, const torch::Tensor& weights,
+                          int64_t padding_mode, bool active_flag,
+                          c10::IntArrayRef stride, c10::IntArrayRef dilation,
+                          c10::optional<c10::MemoryFormat> memory_format,
+                          const c10::optional<torch::Tensor>& channel_perm,
+                          double sparsity){
+        return ::shift2d(input, weights, padding_mode, active_flag, stride, dilation, memory_format, channel_perm, sparsity);
+    }
+
+    torch::Tensor shift3d(const torch::Tensor& input, const torch::Tensor& weights,
+                          int64_t padding_mode, bool active_flag,
+                          c10::IntArrayRef stride, c10::IntArrayRef dilation,
+                          c10::optional<c10::MemoryFormat> memory_format,
+                          const c10::optional<torch::Tensor>& channel_perm,
+                          double sparsity){
+        return ::shift3d(input, weights, padding_mode, active_flag, stride, dilation, memory_format, channel_perm, sparsity);
+    }
+
+    torch::Tensor& shift1d_accumulate_(torch::Tensor& out, const torch::Tensor& input, const torch::Tensor& weights,
+                                       int64_t padding_mode, bool active_flag, double alpha, double beta,
+                                       c10::IntArrayRef stride, c10::IntArrayRef dilation){
+        return ::shift1d_accumulate_(out, input, weights, padding_mode, active_flag, alpha, beta, stride, dilation);
+    }
+
+    torch::Tensor& shift2d_accumulate_(torch::Tensor& out, const torch::Tensor& input, const torch::Tensor& weights,
+                                       int64_t padding_mode, bool active_flag, double alpha, double beta,
+                                       c10::IntArrayRef stride, c10::IntArrayRef dilation){
+        return ::shift2d_accumulate_(out, input, weights, padding_mode, active_flag, alpha, beta, stride, dilation);
+    }
+
+    torch::Tensor& shift3d_accumulate_(torch::Tensor& out, const torch::Tensor& input, const torch::Tensor& weights,
+                                       int64_t padding_mode, bool active_flag, double alpha, double beta,
+                                       c10::IntArrayRef stride, c10::IntArrayRef dilation){
+        return ::shift3d_accumulate_(out, input, weights, padding_mode, active_flag, alpha, beta, stride, dilation);
+    }
+
+    torch::Tensor shift1d_multi(const torch::Tensor& input, const torch::Tensor& weights,
+                                int64_t padding_mode, bool active_flag){
+        return ::shift1d_multi(input, weights, padding_mode, active_flag);
+    }
+
+    torch::Tensor shift2d_multi(const torch::Tensor& input, const torch::Tensor& weights,
+                                int64_t padding_mode, bool active_flag){
+        return ::shift2d_multi(input, weights, padding_mode, active_flag);
+    }
+
+    torch::Tensor shift3d_multi(const torch::Tensor& input, const torch::Tensor& weights,
+                                int64_t padding_mode, bool active_flag){
+        return ::shift3d_multi(input, weights, padding_mode, active_flag);
+    }
+
+    torch::Tensor shift1d_blocked(const torch::Tensor& input, const torch::Tensor& weights,
+                                  int64_t padding_mode, bool active_flag,
+                                  c10::IntArrayRef stride, c10::IntArrayRef dilation){
+        return ::shift1d_blocked(input, weights, padding_mode, active_flag, stride, dilation);
+    }
+
+    torch::Tensor shift2d_blocked(const torch::Tensor& input, const torch::Tensor& weights,
+                                  int64_t padding_mode, bool active_flag,
+                                  c10::IntArrayRef stride, c10::IntArrayRef dilation){
+        return ::shift2d_blocked(input, weights, padding_mode, active_flag, stride, dilation);
+    }
+
+    torch::Tensor shift3d_blocked(const torch::Tensor& input, const torch::Tensor& weights,
+                                  int64_t padding_mode, bool active_flag,
+                                  c10::IntArrayRef stride, c10::IntArrayRef dilation){
+        return ::shift3d_blocked(input, weights, padding_mode, active_flag, stride, dilation);
+    }
+
+    torch::Tensor shift1d_packed(const torch::Tensor& input, const torch::Tensor& sizes, const torch::Tensor& weights,
+                                 int64_t padding_mode, bool active_flag){
+        return ::shift1d_packed(input, sizes, weights, padding_mode, active_flag);
+    }
+
+    torch::Tensor shift2d_packed(const torch::Tensor& input, const torch::Tensor& sizes, const torch::Tensor& weights,
+                                 int64_t padding_mode, bool active_flag){
+        return ::shift2d_packed(input, sizes, weights, padding_mode, active_flag);
+    }
+
+    torch::Tensor shift3d_packed(const torch::Tensor& input, const torch::Tensor& sizes, const torch::Tensor& weights,
+                                 int64_t padding_mode, bool active_flag){
+        return ::shift3d_packed(input, sizes, weights, padding_mode, active_flag);
+    }
+
+    torch::Tensor shift1d_grouped(const torch::Tensor& input, const torch::Tensor& weights, const torch::Tensor& groups,
+                                  int64_t padding_mode, bool active_flag,
+                                  c10::IntArrayRef stride, c10::IntArrayRef dilation){
+        return ::shift1d_grouped(input, weights, groups, padding_mode, active_flag, stride, dilation);
+    }
+
+    torch::Tensor shift2d_grouped(const torch::Tensor& input, const torch::Tensor& weights, const torch::Tensor& groups,
+                                  int64_t padding_mode, bool active_flag,
+                                  c10::IntArrayRef stride, c10::IntArrayRef dilation){
+        return ::shift2d_grouped(input, weights, groups, padding_mode, active_flag, stride, dilation);
+    }
+
+    torch::Tensor shift3d_grouped(const torch::Tensor& input, const torch::Tensor& weights, const torch::Tensor& groups,
+                                  int64_t padding_mode, bool active_flag,
+                                  c10::IntArrayRef stride, c10::IntArrayRef dilation){
+        return ::shift3d_grouped(input, weights, groups, padding_mode, active_flag, stride, dilation);
+    }
+
+    torch::Tensor shift1d_lowmem(const torch::Tensor& input, const torch::Tensor& weights,
+                                 int64_t padding_mode, bool active_flag, int64_t saved_input,
+                                 c10::IntArrayRef stride, c10::IntArrayRef dilation){
+        return ::shift1d_lowmem(input, weights, padding_mode, active_flag, saved_input, stride, dilation);
+    }
+
+    torch::Tensor shift2d_lowmem(const torch::Tensor& input, const torch::Tensor& weights,
+                                 int64_t padding_mode, bool active_flag, int64_t saved_input,
+                                 c10::IntArrayRef stride, c10::IntArrayRef dilation){
+        return ::shift2d_lowmem(input, weights, padding_mode, active_flag, saved_input, stride, dilation);
+    }
+
+    torch::Tensor shift3d_lowmem(const torch::Tensor& input, const torch::Tensor& weights,
+                                 int64_t padding_mode, bool active_flag, int64_t saved_input,
+                                 c10::IntArrayRef stride, c10::IntArrayRef dilation){
+        return ::shift3d_lowmem(input, weights, padding_mode, active_flag, saved_input, stride, dilation);
+    }
+
+    torch::Tensor shift3d_sparse(const torch::Tensor& features, const torch::Tensor& coords, c10::IntArrayRef spatial_size,
+                                 const torch::Tensor& weights, bool active_flag){
+        return ::shift3d_sparse(features, coords, spatial_size, weights, active_flag);
+    }
+
+    torch::Tensor shiftnd(const torch::Tensor& input, const torch::Tensor& weights,
+                          int64_t padding_mode, bool active_flag){
+        return ::shiftnd(input, weights, padding_mode, active_flag);
+    }
 } 
 
 TORCH_LIBRARY(torchshifts, m) {
-    m.def("shift1d", &shift1d);
-    m.def("shift2d", &shift2d);
-    m.def("shift3d", &shift3d);
+    m.def("shift1d(Tensor input, Tensor weights, int padding_mode, bool active_flag, int[] stride=[1], int[] dilation=[1], MemoryFormat? memory_format=None, Tensor? channel_perm=None, float sparsity=0) -> Tensor");
+    m.def("shift2d(Tensor input, Tensor weights, int padding_mode, bool active_flag, int[] stride=[1], int[] dilation=[1], MemoryFormat? memory_format=None, Tensor? channel_perm=None, float sparsity=0) -> Tensor");
+    m.def("shift3d(Tensor input, Tensor weights, int padding_mode, bool active_flag, int[] stride=[1], int[] dilation=[1], MemoryFormat? memory_format=None, Tensor? channel_perm=None, float sparsity=0) -> Tensor");
+    m.def("_shift1d_backward(Tensor grad, Tensor weights, Tensor input, int padding_mode, bool active_flag, int[] stride=[1], int[] dilation=[1], float sparsity=0) -> Tensor[]");
+    m.def("_shift2d_backward(Tensor grad, Tensor weights, Tensor input, int padding_mode, bool active_flag, int[] stride=[1], int[] dilation=[1], float sparsity=0) -> Tensor[]");
+    m.def("_shift3d_backward(Tensor grad, Tensor weights, Tensor input, int padding_mode, bool active_flag, int[] stride=[1], int[] dilation=[1], float sparsity=0) -> Tensor[]");
+    m.def("shift1d_accumulate_(Tensor(a!) out, Tensor input, Tensor weights, int padding_mode, bool active_flag, float alpha=1, float beta=1, int[] stride=[1], int[] dilation=[1]) -> Tensor(a!)");
+    m.def("shift2d_accumulate_(Tensor(a!) out, Tensor input, Tensor weights, int padding_mode, bool active_flag, float alpha=1, float beta=1, int[] stride=[1], int[] dilation=[1]) -> Tensor(a!)");
+    m.def("shift3d_accumulate_(Tensor(a!) out, Tensor input, Tensor weights, int padding_mode, bool active_flag, float alpha=1, float beta=1, int[] stride=[1], int[] dilation=[1]) -> Tensor(a!)");
+    m.def("_shift1d_backward_accumulate_(Tensor(a!) out_grad, Tensor grad, Tensor weights, Tensor input, int padding_mode, bool active_flag, float alpha=1, float beta=1, int[] stride=[1], int[] dilation=[1]) -> Tensor");
+    m.def("_shift2d_backward_accumulate_(Tensor(a!) out_grad, Tensor grad, Tensor weights, Tensor input, int padding_mode, bool active_flag, float alpha=1, float beta=1, int[] stride=[1], int[] dilation=[1]) -> Tensor");
+    m.def("_shift3d_backward_accumulate_(Tensor(a!) out_grad, Tensor grad, Tensor weights, Tensor input, int padding_mode, bool active_flag, float alpha=1, float beta=1, int[] stride=[1], int[] dilation=[1]) -> Tensor");
+    m.def("shift1d_multi(Tensor input, Tensor weights, int padding_mode, bool active_flag) -> Tensor");
+    m.def("shift2d_multi(Tensor input, Tensor weights, int padding_mode, bool active_flag) -> Tensor");
+    m.def("shift3d_multi(Tensor input, Tensor weights, int padding_mode, bool active_flag) -> Tensor");
+    m.def("_shift1d_multi_backward(Tensor grad, Tensor weights, Tensor input, int padding_mode, bool active_flag) -> Tensor[]");
+    m.def("_shift2d_multi_backward(Tensor grad, Tensor weights, Tensor input, int padding_mode, bool active_flag) -> Tensor[]");
+    m.def("_shift3d_multi_backward(Tensor grad, Tensor weights, Tensor input, int padding_mode, bool active_flag) -> Tensor[]");
+    m.def("shift1d_blocked(Tensor input, Tensor weights, int padding_mode, bool active_flag, int[] stride=[1], int[] dilation=[1]) -> Tensor");
+    m.def("shift2d_blocked(Tensor input, Tensor weights, int padding_mode, bool active_flag, int[] stride=[1], int[] dilation=[1]) -> Tensor");
+    m.def("shift3d_blocked(Tensor input, Tensor weights, int padding_mode, bool active_flag, int[] stride=[1], int[] dilation=[1]) -> Tensor");
+    m.def("shift1d_packed(Tensor input, Tensor sizes, Tensor weights, int padding_mode, bool active_flag) -> Tensor");
+    m.def("shift2d_packed(Tensor input, Tensor sizes, Tensor weights, int padding_mode, bool active_flag) -> Tensor");
+    m.def("shift3d_packed(Tensor input, Tensor sizes, Tensor weights, int padding_mode, bool active_flag) -> Tensor");
+    m.def("_shift1d_packed_backward(Tensor grad, Tensor sizes, Tensor weights, Tensor input, int padding_mode, bool active_flag) -> Tensor[]");
+    m.def("_shift2d_packed_backward(Tensor grad, Tensor sizes, Tensor weights, Tensor input, int padding_mode, bool active_flag) -> Tensor[]");
+    m.def("_shift3d_packed_backward(Tensor grad, Tensor sizes, Tensor weights, Tensor input, int padding_mode, bool active_flag) -> Tensor[]");
+    m.def("shift1d_grouped(Tensor input, Tensor weights, Tensor groups, int padding_mode, bool active_flag, int[] stride=[1], int[] dilation=[1]) -> Tensor");
+    m.def("shift2d_grouped(Tensor input, Tensor weights, Tensor groups, int padding_mode, bool active_flag, int[] stride=[1], int[] dilation=[1]) -> Tensor");
+    m.def("shift3d_grouped(Tensor input, Tensor weights, Tensor groups, int padding_mode, bool active_flag, int[] stride=[1], int[] dilation=[1]) -> Tensor");
+    m.def("shift1d_lowmem(Tensor input, Tensor weights, int padding_mode, bool active_flag, int saved_input, int[] stride=[1], int[] dilation=[1]) -> Tensor");
+    m.def("shift2d_lowmem(Tensor input, Tensor weights, int padding_mode, bool active_flag, int saved_input, int[] stride=[1], int[] dilation=[1]) -> Tensor");
+    m.def("shift3d_lowmem(Tensor input, Tensor weights, int padding_mode, bool active_flag, int saved_input, int[] stride=[1], int[] dilation=[1]) -> Tensor");
+    m.def("_shift1d_lowmem_backward(Tensor grad, Tensor weights, Tensor saved, Tensor? scale, int padding_mode, bool active_flag, int[] stride=[1], int[] dilation=[1]) -> Tensor[]");
+    m.def("_shift2d_lowmem_backward(Tensor grad, Tensor weights, Tensor saved, Tensor? scale, int padding_mode, bool active_flag, int[] stride=[1], int[] dilation=[1]) -> Tensor[]");
+    m.def("_shift3d_lowmem_backward(Tensor grad, Tensor weights, Tensor saved, Tensor? scale, int padding_mode, bool active_flag, int[] stride=[1], int[] dilation=[1]) -> Tensor[]");
+    m.def("shift3d_sparse(Tensor features, Tensor coords, int[] spatial_size, Tensor weights, bool active_flag) -> Tensor");
+    m.def("_shift3d_sparse_backward(Tensor grad, Tensor coords, int[] spatial_size, Tensor weights, Tensor features, bool active_flag) -> Tensor[]");
+    m.def("shiftnd(Tensor input, Tensor weights, int padding_mode, bool active_flag) -> Tensor");
+    m.def("_shiftnd_backward(Tensor grad, Tensor weights, Tensor input, int padding_mode, bool active_flag) -> Tensor[]");
+    m.def("_sparsity_l1(Tensor(a) weights, float sparsity) -> Tensor(a)");
     m.def("_cuda_version", &shifts::cuda_version);
+    m.def("_autotune_enable", &autotune_enable);
+    m.def("_autotune_enabled", &autotune_enabled);
+    m.def("_autotune_clear", &autotune_clear);
+    m.def("_autotune_cache_size", &autotune_cache_size);
+    m.def("_autotune_save", &autotune_save);
+    m.def("_autotune_load", &autotune_load);
+}
+
+TORCH_LIBRARY_IMPL(torchshifts, Autograd, m) {
+    m.impl("shift1d", &shiftnd_autograd<1>);
+    m.impl("shift2d", &shiftnd_autograd<2>);
+    m.impl("shift3d", &shiftnd_autograd<3>);
+    m.impl("_shift1d_backward", &shiftnd_backward_autograd<1>);
+    m.impl("_shift2d_backward", &shiftnd_backward_autograd<2>);
+    m.impl("_shift3d_backward", &shiftnd_backward_autograd<3>);
+    m.impl("shift1d_accumulate_", &shiftnd_accumulate_autograd<1>);
+    m.impl("shift2d_accumulate_", &shiftnd_accumulate_autograd<2>);
+    m.impl("shift3d_accumulate_", &shiftnd_accumulate_autograd<3>);
+    m.impl("shift1d_multi", &shiftnd_multi_autograd<1>);
+    m.impl("shift2d_multi", &shiftnd_multi_autograd<2>);
+    m.impl("shift3d_multi", &shiftnd_multi_autograd<3>);
+    m.impl("_shift1d_multi_backward", &shiftnd_multi_backward_autograd<1>);
+    m.impl("_shift2d_multi_backward", &shiftnd_multi_backward_autograd<2>);
+    m.impl("_shift3d_multi_backward", &shiftnd_multi_backward_autograd<3>);
+    m.impl("shift1d_packed", &shiftnd_packed_autograd<1>);
+    m.impl("shift2d_packed", &shiftnd_packed_autograd<2>);
+    m.impl("shift3d_packed", &shiftnd_packed_autograd<3>);
+    m.impl("_shift1d_packed_backward", &shiftnd_packed_backward_autograd<1>);
+    m.impl("_shift2d_packed_backward", &shiftnd_packed_backward_autograd<2>);
+    m.impl("_shift3d_packed_backward", &shiftnd_packed_backward_autograd<3>);
+    m.impl("shift1d_lowmem", &shiftnd_lowmem_autograd<1>);
+    m.impl("shift2d_lowmem", &shiftnd_lowmem_autograd<2>);
+    m.impl("shift3d_lowmem", &shiftnd_lowmem_autograd<3>);
+    m.impl("shift3d_sparse", &shift3d_sparse_autograd);
+    m.impl("_shift3d_sparse_backward", &shift3d_sparse_backward_autograd);
+    m.impl("shiftnd", &shiftnd_generic_autograd);
+    m.impl("_shiftnd_backward", &shiftnd_generic_backward_autograd);
+    m.impl("_sparsity_l1", &sparsity_l1_autograd);
+}
+
+// Blocked and grouped ops are built from the other ops: work on every backend, autograd included
+TORCH_LIBRARY_IMPL(torchshifts, CompositeImplicitAutograd, m) {
+    m.impl("shift1d_blocked", &shiftnd_blocked_composite<1>);
+    m.impl("shift2d_blocked", &shiftnd_blocked_composite<2>);
+    m.impl("shift3d_blocked", &shiftnd_blocked_composite<3>);
+    m.impl("shift1d_grouped", &shiftnd_grouped_composite<1>);
+    m.impl("shift2d_grouped", &shiftnd_grouped_composite<2>);
+    m.impl("shift3d_grouped", &shiftnd_grouped_composite<3>);
+}
+
+// Low memory mode: forward below autograd and backward on devices without their own kernel(CPU has one),
+// sparsity gradient below autograd is an alias of weights(no copy)
+TORCH_LIBRARY_IMPL(torchshifts, CompositeExplicitAutograd, m) {
+    m.impl("shift1d_lowmem", &shiftnd_lowmem_composite<1>);
+    m.impl("shift2d_lowmem", &shiftnd_lowmem_composite<2>);
+    m.impl("shift3d_lowmem", &shiftnd_lowmem_composite<3>);
+    m.impl("_shift1d_lowmem_backward", &shiftnd_lowmem_backward_composite<1>);
+    m.impl("_shift2d_lowmem_backward", &shiftnd_lowmem_backward_composite<2>);
+    m.impl("_shift3d_lowmem_backward", &shiftnd_lowmem_backward_composite<3>);
+    m.impl("_sparsity_l1", &sparsity_l1_composite);
 }
@@ -3,15 +3,17 @@
 
 
 #include <cstdint>
+#include "global_scope.h"
 
 
 namespace shifts {
-    int64_t cuda_version();
+    API_EXPORT int64_t cuda_version();
 
     namespace detail {
         //(Taken from torchvision)
-        int64_t _cuda_version = cuda_version();
-    } 
-} 
+        // Every translation unit including this header refers to the library, so linkers keep it(and its ops registration)
+        inline int64_t _cuda_version = cuda_version();
+    }
+}
 
-#endif 
+#endif
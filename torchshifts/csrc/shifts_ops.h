@@ -1,80 +1,410 @@
 #pragma once
-#include "cpu/shifts_cpu.h"
-#include "quantized/shifts_quantized.h"
-#ifdef WITH_CUDA
-    #include "cuda/shifts_cuda.h"
-#endif
+#include <torch/torch.h>
+#include <ATen/core/dispatch/Dispatcher.h>
+#include "global_scope.h"
+#include "shifts_params.h"
+#include "cpu/shifts_sparse.h"
 
 
-template<int nD = 1>
-torch::Tensor shiftnd_forward(const torch::Tensor& input,
-                              const torch::Tensor& weights,
-                              int64_t padding_mode,
-                              bool active_flag){
-    if (input.is_cuda()) {
-        #ifdef WITH_CUDA
-            if constexpr(nD == 3){
-                return shift3d_forward_cuda(input, weights, padding_mode, active_flag);
-
-            } else if constexpr(nD == 2){
-                return shift2d_forward_cuda(input, weights, padding_mode, active_flag);
-            } else {
-                return shift1d_forward_cuda(input, weights, padding_mode, active_flag);
-            }
-        #else
-            TORCH_CHECK(false, "Not compiled with GPU support");
-        #endif
-    }      
+// Entry points through the dispatcher. Device(CPU, QuantizedCPU, CUDA, Meta) and autograd
+// kernels are registered separately for the "torchshifts::shift{1,2,3}d" schemas.
+template <int nD>
+constexpr const char* shiftnd_op_name(){
+    if constexpr(nD == 3){
+        return "torchshifts::shift3d";
+    } else if constexpr(nD == 2){
+        return "torchshifts::shift2d";
+    } else {
+        return "torchshifts::shift1d";
+    }
+}
+
+template <int nD>
+constexpr const char* shiftnd_backward_op_name(){
+    if constexpr(nD == 3){
+        return "torchshifts::_shift3d_backward";
+    } else if constexpr(nD == 2){
+        return "torchshifts::_shift2d_backward";
+    } else {
+        return "torchshifts::_shift1d_backward";
+    }
+}
+
+
+template <int nD>
+constexpr const char* shiftnd_accumulate_op_name(){
+    if constexpr(nD == 3){
+        return "torchshifts::shift3d_accumulate_";
+    } else if constexpr(nD == 2){
+        return "torchshifts::shift2d_accumulate_";
+    } else {
+        return "torchshifts::shift1d_accumulate_";
+    }
+}
+
+template <int nD>
+constexpr const char* shiftnd_backward_accumulate_op_name(){
+    if constexpr(nD == 3){
+        return "torchshifts::_shift3d_backward_accumulate_";
+    } else if constexpr(nD == 2){
+        return "torchshifts::_shift2d_backward_accumulate_";
+    } else {
+        return "torchshifts::_shift1d_backward_accumulate_";
+    }
+}
+
+
+template <int nD>
+constexpr const char* shiftnd_multi_op_name(){
+    if constexpr(nD == 3){
+        return "torchshifts::shift3d_multi";
+    } else if constexpr(nD == 2){
+        return "torchshifts::shift2d_multi";
+    } else {
+        return "torchshifts::shift1d_multi";
+    }
+}
+
+template <int nD>
+constexpr const char* shiftnd_multi_backward_op_name(){
+    if constexpr(nD == 3){
+        return "torchshifts::_shift3d_multi_backward";
+    } else if constexpr(nD == 2){
+        return "torchshifts::_shift2d_multi_backward";
+    } else {
+        return "torchshifts::_shift1d_multi_backward";
+    }
+}
+
+template <int nD>
+constexpr const char* shiftnd_blocked_op_name(){
     if constexpr(nD == 3){
-        return shift3d_forward_cpu(input, weights, padding_mode, active_flag);
+        return "torchshifts::shift3d_blocked";
     } else if constexpr(nD == 2){
-        return shift2d_forward_cpu(input, weights, padding_mode, active_flag);
+        return "torchshifts::shift2d_blocked";
     } else {
-        return shift1d_forward_cpu(input, weights, padding_mode, active_flag);
+        return "torchshifts::shift1d_blocked";
     }
 }
 
-template<int nD = 1>
+template <int nD>
+constexpr const char* shiftnd_packed_op_name(){
+    if constexpr(nD == 3){
+        return "torchshifts::shift3d_packed";
+    } else if constexpr(nD == 2){
+        return "torchshifts::shift2d_packed";
+    } else {
+        return "torchshifts::shift1d_packed";
+    }
+}
+
+template <int nD>
+constexpr const char* shiftnd_packed_backward_op_name(){
+    if constexpr(nD == 3){
+        return "torchshifts::_shift3d_packed_backward";
+    } else if constexpr(nD == 2){
+        return "torchshifts::_shift2d_packed_backward";
+    } else {
+        return "torchshifts::_shift1d_packed_backward";
+    }
+}
+
+template <int nD>
+constexpr const char* shiftnd_grouped_op_name(){
+    if constexpr(nD == 3){
+        return "torchshifts::shift3d_grouped";
+    } else if constexpr(nD == 2){
+        return "torchshifts::shift2d_grouped";
+    } else {
+        return "torchshifts::shift1d_grouped";
+    }
+}
+
+template <int nD>
+constexpr const char* shiftnd_lowmem_op_name(){
+    if constexpr(nD == 3){
+        return "torchshifts::shift3d_lowmem";
+    } else if constexpr(nD == 2){
+        return "torchshifts::shift2d_lowmem";
+    } else {
+        return "torchshifts::shift1d_lowmem";
+    }
+}
+
+template <int nD>
+constexpr const char* shiftnd_lowmem_backward_op_name(){
+    if constexpr(nD == 3){
+        return "torchshifts::_shift3d_lowmem_backward";
+    } else if constexpr(nD == 2){
+        return "torchshifts::_shift2d_lowmem_backward";
+    } else {
+        return "torchshifts::_shift1d_lowmem_backward";
+    }
+}
+
+
+template <int nD = 1>
+torch::Tensor shiftnd_forward(const torch::Tensor& input,
+                              const torch::Tensor& weights,
+                              int64_t padding_mode,
+                              bool active_flag,
+                              c10::IntArrayRef stride = 1,
+                              c10::IntArrayRef dilation = 1,
+                              c10::optional<c10::MemoryFormat> memory_format = c10::nullopt,
+                              const c10::optional<torch::Tensor>& channel_perm = c10::nullopt,
+                              double sparsity = 0.){
+    static auto op = c10::Dispatcher::singleton()
+                        .findSchemaOrThrow(shiftnd_op_name<nD>(), "")
+                        .typed<torch::Tensor(const torch::Tensor&, const torch::Tensor&, int64_t, bool,
+                                             c10::IntArrayRef, c10::IntArrayRef, c10::optional<c10::MemoryFormat>,
+                                             const c10::optional<torch::Tensor>&, double)>();
+    return op.call(input, weights, padding_mode, active_flag, stride, dilation, memory_format, channel_perm, sparsity);
+}
+
+template <int nD = 1>
 std::vector<torch::Tensor> shiftnd_backward(const torch::Tensor& grad,
                                             const torch::Tensor& weights,
                                             const torch::Tensor& input,
                                             int64_t padding_mode,
+                                            bool active_flag,
+                                            c10::IntArrayRef stride = 1,
+                                            c10::IntArrayRef dilation = 1,
+                                            double sparsity = 0.){
+    static auto op = c10::Dispatcher::singleton()
+                        .findSchemaOrThrow(shiftnd_backward_op_name<nD>(), "")
+                        .typed<std::vector<torch::Tensor>(const torch::Tensor&, const torch::Tensor&,
+                                                          const torch::Tensor&, int64_t, bool,
+                                                          c10::IntArrayRef, c10::IntArrayRef, double)>();
+    return op.call(grad, weights, input, padding_mode, active_flag, stride, dilation, sparsity);
+}
+
+// out = beta*out + alpha*shift(input) in one pass over out
+template <int nD = 1>
+torch::Tensor& shiftnd_accumulate_(torch::Tensor& out,
+                                   const torch::Tensor& input,
+                                   const torch::Tensor& weights,
+                                   int64_t padding_mode,
+                                   bool active_flag,
+                                   double alpha = 1.,
+                                   double beta = 1.,
+                                   c10::IntArrayRef stride = 1,
+                                   c10::IntArrayRef dilation = 1){
+    static auto op = c10::Dispatcher::singleton()
+                        .findSchemaOrThrow(shiftnd_accumulate_op_name<nD>(), "")
+                        .typed<torch::Tensor&(torch::Tensor&, const torch::Tensor&, const torch::Tensor&, int64_t, bool,
+                                              double, double, c10::IntArrayRef, c10::IntArrayRef)>();
+    return op.call(out, input, weights, padding_mode, active_flag, alpha, beta, stride, dilation);
+}
+
+// out_grad = beta*out_grad + alpha*dL/dinput, returns alpha*dL/dweights
+template <int nD = 1>
+torch::Tensor shiftnd_backward_accumulate_(torch::Tensor& out_grad,
+                                           const torch::Tensor& grad,
+                                           const torch::Tensor& weights,
+                                           const torch::Tensor& input,
+                                           int64_t padding_mode,
+                                           bool active_flag,
+                                           double alpha = 1.,
+                                           double beta = 1.,
+                                           c10::IntArrayRef stride = 1,
+                                           c10::IntArrayRef dilation = 1){
+    static auto op = c10::Dispatcher::singleton()
+                        .findSchemaOrThrow(shiftnd_backward_accumulate_op_name<nD>(), "")
+                        .typed<torch::Tensor(torch::Tensor&, const torch::Tensor&, const torch::Tensor&,
+                                             const torch::Tensor&, int64_t, bool,
+                                             double, double, c10::IntArrayRef, c10::IntArrayRef)>();
+    return op.call(out_grad, grad, weights, input, padding_mode, active_flag, alpha, beta, stride, dilation);
+}
+
+// K shift sets [K, C, nD] applied to one input, output is [N, K*C, ...]
+template <int nD = 1>
+torch::Tensor shiftnd_multi_forward(const torch::Tensor& input,
+                                    const torch::Tensor& weights,
+                                    int64_t padding_mode,
+                                    bool active_flag){
+    static auto op = c10::Dispatcher::singleton()
+                        .findSchemaOrThrow(shiftnd_multi_op_name<nD>(), "")
+                        .typed<torch::Tensor(const torch::Tensor&, const torch::Tensor&, int64_t, bool)>();
+    return op.call(input, weights, padding_mode, active_flag);
+}
+
+template <int nD = 1>
+std::vector<torch::Tensor> shiftnd_multi_backward(const torch::Tensor& grad,
+                                                  const torch::Tensor& weights,
+                                                  const torch::Tensor& input,
+                                                  int64_t padding_mode,
+                                                  bool active_flag){
+    static auto op = c10::Dispatcher::singleton()
+                        .findSchemaOrThrow(shiftnd_multi_backward_op_name<nD>(), "")
+                        .typed<std::vector<torch::Tensor>(const torch::Tensor&, const torch::Tensor&,
+                                                          const torch::Tensor&, int64_t, bool)>();
+    return op.call(grad, weights, input, padding_mode, active_flag);
+}
+
+template <int nD = 1>
+torch::Tensor shiftnd_blocked_forward(const torch::Tensor& input,
+                                      const torch::Tensor& weights,
+                                      int64_t padding_mode,
+                                      bool active_flag,
+                                      c10::IntArrayRef stride = 1,
+                                      c10::IntArrayRef dilation = 1){
+    static auto op = c10::Dispatcher::singleton()
+                        .findSchemaOrThrow(shiftnd_blocked_op_name<nD>(), "")
+                        .typed<torch::Tensor(const torch::Tensor&, const torch::Tensor&, int64_t, bool,
+                                             c10::IntArrayRef, c10::IntArrayRef)>();
+    return op.call(input, weights, padding_mode, active_flag, stride, dilation);
+}
+
+template <int nD = 1>
+torch::Tensor shiftnd_packed_forward(const torch::Tensor& input,
+                                     const torch::Tensor& sizes,
+                                     const torch::Tensor& weights,
+                                     int64_t padding_mode,
+                                     bool active_flag){
+    static auto op = c10::Dispatcher::singleton()
+                        .findSchemaOrThrow(shiftnd_packed_op_name<nD>(), "")
+                        .typed<torch::Tensor(const torch::Tensor&, const torch::Tensor&, const torch::Tensor&, int64_t, bool)>();
+    return op.call(input, sizes, weights, padding_mode, active_flag);
+}
+
+template <int nD = 1>
+std::vector<torch::Tensor> shiftnd_packed_backward(const torch::Tensor& grad,
+                                                   const torch::Tensor& sizes,
+                                                   const torch::Tensor& weights,
+                                                   const torch::Tensor& input,
+                                                   int64_t padding_mode,
+                                                   bool active_flag){
+    static auto op = c10::Dispatcher::singleton()
+                        .findSchemaOrThrow(shiftnd_packed_backward_op_name<nD>(), "")
+                        .typed<std::vector<torch::Tensor>(const torch::Tensor&, const torch::Tensor&, const torch::Tensor&,
+                                                          const torch::Tensor&, int64_t, bool)>();
+    return op.call(grad, sizes, weights, input, padding_mode, active_flag);
+}
+
+template <int nD = 1>
+torch::Tensor shiftnd_grouped_forward(const torch::Tensor& input,
+                                      const torch::Tensor& weights,
+                                      const torch::Tensor& groups,
+                                      int64_t padding_mode,
+                                      bool active_flag,
+                                      c10::IntArrayRef stride = 1,
+                                      c10::IntArrayRef dilation = 1){
+    static auto op = c10::Dispatcher::singleton()
+                        .findSchemaOrThrow(shiftnd_grouped_op_name<nD>(), "")
+                        .typed<torch::Tensor(const torch::Tensor&, const torch::Tensor&, const torch::Tensor&, int64_t, bool,
+                                             c10::IntArrayRef, c10::IntArrayRef)>();
+    return op.call(input, weights, groups, padding_mode, active_flag, stride, dilation);
+}
+
+// Shift with the low memory mode of backward: input is saved as saved_input(see SavedInput)
+template <int nD = 1>
+torch::Tensor shiftnd_lowmem_forward(const torch::Tensor& input,
+                                     const torch::Tensor& weights,
+                                     int64_t padding_mode,
+                                     bool active_flag,
+                                     int64_t saved_input,
+                                     c10::IntArrayRef stride = 1,
+                                     c10::IntArrayRef dilation = 1){
+    static auto op = c10::Dispatcher::singleton()
+                        .findSchemaOrThrow(shiftnd_lowmem_op_name<nD>(), "")
+                        .typed<torch::Tensor(const torch::Tensor&, const torch::Tensor&, int64_t, bool, int64_t,
+                                             c10::IntArrayRef, c10::IntArrayRef)>();
+    return op.call(input, weights, padding_mode, active_flag, saved_input, stride, dilation);
+}
+
+template <int nD = 1>
+std::vector<torch::Tensor> shiftnd_lowmem_backward(const torch::Tensor& grad,
+                                                   const torch::Tensor& weights,
+                                                   const torch::Tensor& saved,
+                                                   const c10::optional<torch::Tensor>& scale,
+                                                   int64_t padding_mode,
+                                                   bool active_flag,
+                                                   c10::IntArrayRef stride = 1,
+                                                   c10::IntArrayRef dilation = 1){
+    static auto op = c10::Dispatcher::singleton()
+                        .findSchemaOrThrow(shiftnd_lowmem_backward_op_name<nD>(), "")
+                        .typed<std::vector<torch::Tensor>(const torch::Tensor&, const torch::Tensor&, const torch::Tensor&,
+                                                          const c10::optional<torch::Tensor>&, int64_t, bool,
+                                                          c10::IntArrayRef, c10::IntArrayRef)>();
+    return op.call(grad, weights, saved, scale, padding_mode, active_flag, stride, dilation);
+}
+
+inline torch::Tensor shift3d_sparse_forward(const torch::Tensor& features,
+                                            const torch::Tensor& coords,
+                                            c10::IntArrayRef spatial_size,
+                                            const torch::Tensor& weights,
                                             bool active_flag){
-    if (input.is_cuda()) {
-        #ifdef WITH_CUDA
-            if constexpr(nD == 3){
-                return shift3d_backward_cuda(grad, weights, input, padding_mode, active_flag);
+    static auto op = c10::Dispatcher::singleton()
+                        .findSchemaOrThrow("torchshifts::shift3d_sparse", "")
+                        .typed<torch::Tensor(const torch::Tensor&, const torch::Tensor&, c10::IntArrayRef,
+                                             const torch::Tensor&, bool)>();
+    return op.call(features, coords, spatial_size, weights, active_flag);
+}
 
-            } else if constexpr(nD == 2){
-                return shift2d_backward_cuda(grad, weights, input, padding_mode, active_flag);
-            } else {
-                return shift1d_backward_cuda(grad, weights, input, padding_mode, active_flag);
-            }
-        #else
-            TORCH_CHECK(false, "Not compiled with GPU support");
-        #endif
-    }      
-    if constexpr(nD == 3){
-        return shift3d_backward_cpu(grad, weights, input, padding_mode, active_flag);
-    } else if constexpr(nD == 2){
-        return shift2d_backward_cpu(grad, weights, input, padding_mode, active_flag);
-    } else {
-        return shift1d_backward_cpu(grad, weights, input, padding_mode, active_flag);
-    }
+inline std::vector<torch::Tensor> shift3d_sparse_backward(const torch::Tensor& grad,
+                                                          const torch::Tensor& coords,
+                                                          c10::IntArrayRef spatial_size,
+                                                          const torch::Tensor& weights,
+                                                          const torch::Tensor& features,
+                                                          bool active_flag){
+    static auto op = c10::Dispatcher::singleton()
+                        .findSchemaOrThrow("torchshifts::_shift3d_sparse_backward", "")
+                        .typed<std::vector<torch::Tensor>(const torch::Tensor&, const torch::Tensor&, c10::IntArrayRef,
+                                                          const torch::Tensor&, const torch::Tensor&, bool)>();
+    return op.call(grad, coords, spatial_size, weights, features, active_flag);
+}
+
+inline torch::Tensor shiftnd_generic_forward(const torch::Tensor& input,
+                                             const torch::Tensor& weights,
+                                             int64_t padding_mode,
+                                             bool active_flag){
+    static auto op = c10::Dispatcher::singleton()
+                        .findSchemaOrThrow("torchshifts::shiftnd", "")
+                        .typed<torch::Tensor(const torch::Tensor&, const torch::Tensor&, int64_t, bool)>();
+    return op.call(input, weights, padding_mode, active_flag);
 }
 
+inline std::vector<torch::Tensor> shiftnd_generic_backward(const torch::Tensor& grad,
+                                                           const torch::Tensor& weights,
+                                                           const torch::Tensor& input,
+                                                           int64_t padding_mode,
+                                                           bool active_flag){
+    static auto op = c10::Dispatcher::singleton()
+                        .findSchemaOrThrow("torchshifts::_shiftnd_backward", "")
+                        .typed<std::vector<torch::Tensor>(const torch::Tensor&, const torch::Tensor&, const torch::Tensor&,
+                                                          int64_t, bool)>();
+    return op.call(grad, weights, input, padding_mode, active_flag);
+}
+
+inline torch::Tensor sparsity_l1_forward(const torch::Tensor& weights, double sparsity){
+    static auto op = c10::Dispatcher::singleton()
+                        .findSchemaOrThrow("torchshifts::_sparsity_l1", "")
+                        .typed<torch::Tensor(const torch::Tensor&, double)>();
+    return op.call(weights, sparsity);
+}
 
 
-class Shift1dFunction : public torch::autograd::Function<Shift1dFunction> {
+template <int nD>
+class ShiftndFunction : public torch::autograd::Function<ShiftndFunction<nD>> {
     public:
         static torch::Tensor forward(torch::autograd::AutogradContext* ctx,
-                                     torch::Tensor input,
-                                     torch::Tensor weight,
-                                     int64_t padding_mode, bool active_flag){
+                                     const torch::Tensor& input,
+                                     const torch::Tensor& weight,
+                                     int64_t padding_mode, bool active_flag,
+                                     c10::IntArrayRef stride, c10::IntArrayRef dilation,
+                                     c10::optional<c10::MemoryFormat> memory_format,
+                                     const c10::optional<torch::Tensor>& channel_perm,
+                                     double sparsity){
+            at::AutoDispatchBelowADInplaceOrView guard;
             ctx->saved_data["padding_mode"] = padding_mode;
             ctx->saved_data["active_flag"] = active_flag;
+            ctx->saved_data["stride"] = stride.vec();
+            ctx->saved_data["dilation"] = dilation.vec();
+            ctx->saved_data["channel_perm"] = channel_perm.has_value() ? *channel_perm : torch::Tensor();
+            ctx->saved_data["sparsity"] = sparsity;
             ctx->save_for_backward({input, weight});
-            return shiftnd_forward<1>(input, weight, padding_mode, active_flag);
+            return shiftnd_forward<nD>(input, weight, padding_mode, active_flag, stride, dilation, memory_format, channel_perm,
+                                       sparsity);
         }
 
         static torch::autograd::variable_list backward(torch::autograd::AutogradContext* ctx,
@@ -82,29 +412,89 @@ class Shift1dFunction : public torch::autograd::Function<Shift1dFunction> {
             auto saved = ctx->get_saved_variables();
             auto input = saved[0];
             auto weight = saved[1];
-            auto result = shiftnd_backward<1>(grad_output[0], weight, input,
-                                              ctx->saved_data["padding_mode"].toInt(),
-                                              ctx->saved_data["active_flag"].toBool());
+            auto perm = ctx->saved_data["channel_perm"].toTensor();
+            // output[:, perm[c]] = shift(input)[:, c]: gather the grad back into the input channel order
+            auto grad = perm.defined() ? grad_output[0].index_select(1, perm) : grad_output[0];
+            auto result = shiftnd_backward<nD>(grad, weight, input,
+                                               ctx->saved_data["padding_mode"].toInt(),
+                                               ctx->saved_data["active_flag"].toBool(),
+                                               ctx->saved_data["stride"].toIntVector(),
+                                               ctx->saved_data["dilation"].toIntVector(),
+                                               ctx->saved_data["sparsity"].toDouble());
             auto grad_in = result[0];
             auto grad_weight = result[1];
-            return {grad_in, grad_weight, torch::Tensor(), torch::Tensor()};
-                
+            return {grad_in, grad_weight, torch::Tensor(), torch::Tensor(), torch::Tensor(), torch::Tensor(), torch::Tensor(),
+                    torch::Tensor(), torch::Tensor()};
         }
 };
 
+using Shift1dFunction = ShiftndFunction<1>;
+using Shift2dFunction = ShiftndFunction<2>;
+using Shift3dFunction = ShiftndFunction<3>;
 
 
+// In-place on out: history of out is rebased onto this node
+template <int nD>
+class ShiftndAccumulateFunction : public torch::autograd::Function<ShiftndAccumulateFunction<nD>> {
+    public:
+        static torch::Tensor forward(torch::autograd::AutogradContext* ctx,
+                                     torch::Tensor out,
+                                     const torch::Tensor& input,
+                                     const torch::Tensor& weight,
+                                     int64_t padding_mode, bool active_flag,
+                                     double alpha, double beta,
+                                     c10::IntArrayRef stride, c10::IntArrayRef dilation){
+            {
+                at::AutoDispatchBelowADInplaceOrView guard;
+                shiftnd_accumulate_<nD>(out, input, weight, padding_mode, active_flag, alpha, beta, stride, dilation);
+            }
+            out.unsafeGetTensorImpl()->bump_version();
+            ctx->mark_dirty({out});
+            ctx->saved_data["padding_mode"] = padding_mode;
+            ctx->saved_data["active_flag"] = active_flag;
+            ctx->saved_data["alpha"] = alpha;
+            ctx->saved_data["beta"] = beta;
+            ctx->saved_data["stride"] = stride.vec();
+            ctx->saved_data["dilation"] = dilation.vec();
+            ctx->save_for_backward({input, weight});
+            return out;
+        }
 
-class Shift2dFunction : public torch::autograd::Function<Shift2dFunction> {
+        static torch::autograd::variable_list backward(torch::autograd::AutogradContext* ctx,
+                                                       torch::autograd::variable_list grad_output) {
+            auto saved = ctx->get_saved_variables();
+            auto input = saved[0];
+            auto weight = saved[1];
+            auto grad = grad_output[0];
+            double beta = ctx->saved_data["beta"].toDouble();
+            // beta = 0 lets the kernels skip zero filling of the input gradient
+            // input gradient keeps the layout of input(e.g. blocked, see shiftnd_blocked)
+            torch::Tensor grad_in = torch::empty_like(input);
+            auto grad_weight = shiftnd_backward_accumulate_<nD>(grad_in, grad, weight, input,
+                                                                ctx->saved_data["padding_mode"].toInt(),
+                                                                ctx->saved_data["active_flag"].toBool(),
+                                                                ctx->saved_data["alpha"].toDouble(), 0.,
+                                                                ctx->saved_data["stride"].toIntVector(),
+                                                                ctx->saved_data["dilation"].toIntVector());
+            auto grad_out = (beta == 1.) ? grad : grad * beta;
+            return {grad_out, grad_in, grad_weight, torch::Tensor(), torch::Tensor(), torch::Tensor(),
+                    torch::Tensor(), torch::Tensor(), torch::Tensor()};
+        }
+};
+
+
+template <int nD>
+class ShiftndMultiFunction : public torch::autograd::Function<ShiftndMultiFunction<nD>> {
     public:
         static torch::Tensor forward(torch::autograd::AutogradContext* ctx,
-                                     torch::Tensor input,
-                                     torch::Tensor weight,
+                                     const torch::Tensor& input,
+                                     const torch::Tensor& weight,
                                      int64_t padding_mode, bool active_flag){
+            at::AutoDispatchBelowADInplaceOrView guard;
             ctx->saved_data["padding_mode"] = padding_mode;
             ctx->saved_data["active_flag"] = active_flag;
             ctx->save_for_backward({input, weight});
-            return shiftnd_forward<2>(input, weight, padding_mode, active_flag);
+            return shiftnd_multi_forward<nD>(input, weight, padding_mode, active_flag);
         }
 
         static torch::autograd::variable_list backward(torch::autograd::AutogradContext* ctx,
@@ -112,27 +502,138 @@ class Shift2dFunction : public torch::autograd::Function<Shift2dFunction> {
             auto saved = ctx->get_saved_variables();
             auto input = saved[0];
             auto weight = saved[1];
-            auto result = shiftnd_backward<2>(grad_output[0], weight, input,
-                                              ctx->saved_data["padding_mode"].toInt(),
-                                              ctx->saved_data["active_flag"].toBool());
+            auto result = shiftnd_multi_backward<nD>(grad_output[0], weight, input,
+                                                     ctx->saved_data["padding_mode"].toInt(),
+                                                     ctx->saved_data["active_flag"].toBool());
             auto grad_in = result[0];
             auto grad_weight = result[1];
             return {grad_in, grad_weight, torch::Tensor(), torch::Tensor()};
-                
         }
 };
 
 
-class Shift3dFunction : public torch::autograd::Function<Shift3dFunction> {
+template <int nD>
+class ShiftndPackedFunction : public torch::autograd::Function<ShiftndPackedFunction<nD>> {
     public:
         static torch::Tensor forward(torch::autograd::AutogradContext* ctx,
-                                     torch::Tensor input,
-                                     torch::Tensor weight,
+                                     const torch::Tensor& input,
+                                     const torch::Tensor& sizes,
+                                     const torch::Tensor& weight,
                                      int64_t padding_mode, bool active_flag){
+            at::AutoDispatchBelowADInplaceOrView guard;
+            ctx->saved_data["padding_mode"] = padding_mode;
+            ctx->saved_data["active_flag"] = active_flag;
+            ctx->save_for_backward({input, sizes, weight});
+            return shiftnd_packed_forward<nD>(input, sizes, weight, padding_mode, active_flag);
+        }
+
+        static torch::autograd::variable_list backward(torch::autograd::AutogradContext* ctx,
+                                                       torch::autograd::variable_list grad_output) {
+            auto saved = ctx->get_saved_variables();
+            auto input = saved[0];
+            auto sizes = saved[1];
+            auto weight = saved[2];
+            auto result = shiftnd_packed_backward<nD>(grad_output[0], sizes, weight, input,
+                                                      ctx->saved_data["padding_mode"].toInt(),
+                                                      ctx->saved_data["active_flag"].toBool());
+            auto grad_in = result[0];
+            auto grad_weight = result[1];
+            return {grad_in, torch::Tensor(), grad_weight, torch::Tensor(), torch::Tensor()};
+        }
+};
+
+
+// Low memory mode: input is saved compressed(bfloat16 or int8 with per channel scale) instead of
+// full precision, weight gradients are computed from it(CPU kernels read it without decompression).
+template <int nD>
+class ShiftndLowmemFunction : public torch::autograd::Function<ShiftndLowmemFunction<nD>> {
+    public:
+        static torch::Tensor forward(torch::autograd::AutogradContext* ctx,
+                                     const torch::Tensor& input,
+                                     const torch::Tensor& weight,
+                                     int64_t padding_mode, bool active_flag, int64_t saved_input,
+                                     c10::IntArrayRef stride, c10::IntArrayRef dilation){
+            at::AutoDispatchBelowADInplaceOrView guard;
+            ctx->saved_data["padding_mode"] = padding_mode;
+            ctx->saved_data["active_flag"] = active_flag;
+            ctx->saved_data["stride"] = stride.vec();
+            ctx->saved_data["dilation"] = dilation.vec();
+            auto [saved, scale] = compress_saved_input<nD>(input, saved_input);
+            ctx->save_for_backward({saved, scale, weight});
+            return shiftnd_forward<nD>(input, weight, padding_mode, active_flag, stride, dilation);
+        }
+
+        static torch::autograd::variable_list backward(torch::autograd::AutogradContext* ctx,
+                                                       torch::autograd::variable_list grad_output) {
+            auto saved = ctx->get_saved_variables();
+            auto result = shiftnd_lowmem_backward<nD>(grad_output[0], saved[2], saved[0], saved[1],
+                                                      ctx->saved_data["padding_mode"].toInt(),
+                                                      ctx->saved_data["active_flag"].toBool(),
+                                                      ctx->saved_data["stride"].toIntVector(),
+                                                      ctx->saved_data["dilation"].toIntVector());
+            return {result[0], result[1], torch::Tensor(), torch::Tensor(), torch::Tensor(), torch::Tensor(), torch::Tensor()};
+        }
+};
+
+
+class Shift3dSparseFunction : public torch::autograd::Function<Shift3dSparseFunction> {
+    public:
+        static torch::Tensor forward(torch::autograd::AutogradContext* ctx,
+                                     const torch::Tensor& features,
+                                     const torch::Tensor& coords,
+                                     c10::IntArrayRef spatial_size,
+                                     const torch::Tensor& weight,
+                                     bool active_flag){
+            at::AutoDispatchBelowADInplaceOrView guard;
+            ctx->saved_data["spatial_size"] = spatial_size.vec();
+            ctx->saved_data["active_flag"] = active_flag;
+            auto plain_cpu = [](const torch::Tensor& t){ return t.is_cpu() && !t.key_set().has(c10::DispatchKey::Python); };
+            if (!(plain_cpu(features) && plain_cpu(coords) && plain_cpu(weight))){
+                // Meta/Fake tensors(shapes only), tensor subclasses and unsupported devices go through the dispatcher
+                ctx->save_for_backward({features, coords, weight, torch::Tensor()});
+                return shift3d_sparse_forward(features, coords, spatial_size, weight, active_flag);
+            }
+            // hash of the voxels is built(and coords are validated) once, its table is kept here for backward only
+            shifts::sparse::VoxelHash hash(coords.contiguous(), check_sparse_voxels(features, coords, spatial_size, weight));
+            ctx->save_for_backward({features, coords, weight, hash.table});
+            return shift3d_sparse_forward_hashed_cpu(features, coords, weight, active_flag, hash);
+        }
+
+        static torch::autograd::variable_list backward(torch::autograd::AutogradContext* ctx,
+                                                       torch::autograd::variable_list grad_output) {
+            auto saved = ctx->get_saved_variables();
+            auto features = saved[0];
+            auto coords = saved[1];
+            auto weight = saved[2];
+            auto table = saved[3];
+            auto spatial_size = ctx->saved_data["spatial_size"].toIntVector();
+            bool active_flag = ctx->saved_data["active_flag"].toBool();
+            std::vector<torch::Tensor> result;
+            if (table.defined()){
+                shifts::sparse::VoxelHash hash(table, coords.size(0), {spatial_size[0], spatial_size[1], spatial_size[2]});
+                result = shift3d_sparse_backward_hashed_cpu(grad_output[0], coords, weight, features, active_flag, hash);
+            } else {
+                result = shift3d_sparse_backward(grad_output[0], coords, spatial_size, weight, features, active_flag);
+            }
+            auto grad_in = result[0];
+            auto grad_weight = result[1];
+            return {grad_in, torch::Tensor(), torch::Tensor(), grad_weight, torch::Tensor()};
+        }
+};
+
+
+// Rank generic shift: number of spatial axes is taken from the input
+class ShiftndGenericFunction : public torch::autograd::Function<ShiftndGenericFunction> {
+    public:
+        static torch::Tensor forward(torch::autograd::AutogradContext* ctx,
+                                     const torch::Tensor& input,
+                                     const torch::Tensor& weight,
+                                     int64_t padding_mode, bool active_flag){
+            at::AutoDispatchBelowADInplaceOrView guard;
             ctx->saved_data["padding_mode"] = padding_mode;
             ctx->saved_data["active_flag"] = active_flag;
             ctx->save_for_backward({input, weight});
-            return shiftnd_forward<3>(input, weight, padding_mode, active_flag);
+            return shiftnd_generic_forward(input, weight, padding_mode, active_flag);
         }
 
         static torch::autograd::variable_list backward(torch::autograd::AutogradContext* ctx,
@@ -140,55 +641,518 @@ class Shift3dFunction : public torch::autograd::Function<Shift3dFunction> {
             auto saved = ctx->get_saved_variables();
             auto input = saved[0];
             auto weight = saved[1];
-            auto result = shiftnd_backward<3>(grad_output[0], weight, input,
-                                              ctx->saved_data["padding_mode"].toInt(),
-                                              ctx->saved_data["active_flag"].toBool());
+            auto result = shiftnd_generic_backward(grad_output[0], weight, input,
+                                                   ctx->saved_data["padding_mode"].toInt(),
+                                                   ctx->saved_data["active_flag"].toBool());
             auto grad_in = result[0];
             auto grad_weight = result[1];
             return {grad_in, grad_weight, torch::Tensor(), torch::Tensor()};
-                
         }
 };
 
 
+class ShiftndGenericBackwardFunction : public torch::autograd::Function<ShiftndGenericBackwardFunction> {
+    public:
+        static torch::autograd::variable_list forward(torch::autograd::AutogradContext* ctx,
+                                                      const torch::Tensor& grad,
+                                                      const torch::Tensor& weight,
+                                                      const torch::Tensor& input,
+                                                      int64_t padding_mode, bool active_flag){
+            at::AutoDispatchBelowADInplaceOrView guard;
+            return shiftnd_generic_backward(grad, weight, input, padding_mode, active_flag);
+        }
+
+        static torch::autograd::variable_list backward(torch::autograd::AutogradContext* ctx,
+                                                       torch::autograd::variable_list grad_output) {
+            TORCH_CHECK(false, "double backwards on shiftnd is not supported");
+        }
+};
+
+
+// L1 sparsity of shifts applied directly to the gradient: alias of the weights on forward(no copy, no loss value),
+// backward adds sparsity*sign(w) to the weight gradient in one op, so no loss subgraph is needed.
+// shift{1,2,3}d take the sparsity themselves(added by their backward kernels), this one is for the other modes.
+class SparsityL1Function : public torch::autograd::Function<SparsityL1Function> {
+    public:
+        static torch::Tensor forward(torch::autograd::AutogradContext* ctx,
+                                     const torch::Tensor& weight,
+                                     double sparsity){
+            at::AutoDispatchBelowADInplaceOrView guard;
+            ctx->saved_data["sparsity"] = sparsity;
+            ctx->save_for_backward({weight});
+            return sparsity_l1_forward(weight, sparsity);
+        }
+
+        static torch::autograd::variable_list backward(torch::autograd::AutogradContext* ctx,
+                                                       torch::autograd::variable_list grad_output) {
+            auto weight = ctx->get_saved_variables()[0];
+            auto grad_weight = grad_output[0].add(weight.sign(), ctx->saved_data["sparsity"].toDouble());
+            return {grad_weight, torch::Tensor()};
+        }
+};
+
+
+// Registered for the backward ops: double backward is not implemented
+template <int nD>
+class ShiftndBackwardFunction : public torch::autograd::Function<ShiftndBackwardFunction<nD>> {
+    public:
+        static torch::autograd::variable_list forward(torch::autograd::AutogradContext* ctx,
+                                                      const torch::Tensor& grad,
+                                                      const torch::Tensor& weight,
+                                                      const torch::Tensor& input,
+                                                      int64_t padding_mode, bool active_flag,
+                                                      c10::IntArrayRef stride, c10::IntArrayRef dilation,
+                                                      double sparsity){
+            at::AutoDispatchBelowADInplaceOrView guard;
+            return shiftnd_backward<nD>(grad, weight, input, padding_mode, active_flag, stride, dilation, sparsity);
+        }
+
+        static torch::autograd::variable_list backward(torch::autograd::AutogradContext* ctx,
+                                                       torch::autograd::variable_list grad_output) {
+            TORCH_CHECK(false, "double backwards on shift", nD, "d is not supported");
+        }
+};
+
+
+template <int nD>
+class ShiftndMultiBackwardFunction : public torch::autograd::Function<ShiftndMultiBackwardFunction<nD>> {
+    public:
+        static torch::autograd::variable_list forward(torch::autograd::AutogradContext* ctx,
+                                                      const torch::Tensor& grad,
+                                                      const torch::Tensor& weight,
+                                                      const torch::Tensor& input,
+                                                      int64_t padding_mode, bool active_flag){
+            at::AutoDispatchBelowADInplaceOrView guard;
+            return shiftnd_multi_backward<nD>(grad, weight, input, padding_mode, active_flag);
+        }
+
+        static torch::autograd::variable_list backward(torch::autograd::AutogradContext* ctx,
+                                                       torch::autograd::variable_list grad_output) {
+            TORCH_CHECK(false, "double backwards on shift", nD, "d_multi is not supported");
+        }
+};
+
+
+template <int nD>
+class ShiftndPackedBackwardFunction : public torch::autograd::Function<ShiftndPackedBackwardFunction<nD>> {
+    public:
+        static torch::autograd::variable_list forward(torch::autograd::AutogradContext* ctx,
+                                                      const torch::Tensor& grad,
+                                                      const torch::Tensor& sizes,
+                                                      const torch::Tensor& weight,
+                                                      const torch::Tensor& input,
+                                                      int64_t padding_mode, bool active_flag){
+            at::AutoDispatchBelowADInplaceOrView guard;
+            return shiftnd_packed_backward<nD>(grad, sizes, weight, input, padding_mode, active_flag);
+        }
+
+        static torch::autograd::variable_list backward(torch::autograd::AutogradContext* ctx,
+                                                       torch::autograd::variable_list grad_output) {
+            TORCH_CHECK(false, "double backwards on shift", nD, "d_packed is not supported");
+        }
+};
+
+
+class Shift3dSparseBackwardFunction : public torch::autograd::Function<Shift3dSparseBackwardFunction> {
+    public:
+        static torch::autograd::variable_list forward(torch::autograd::AutogradContext* ctx,
+                                                      const torch::Tensor& grad,
+                                                      const torch::Tensor& coords,
+                                                      c10::IntArrayRef spatial_size,
+                                                      const torch::Tensor& weight,
+                                                      const torch::Tensor& features,
+                                                      bool active_flag){
+            at::AutoDispatchBelowADInplaceOrView guard;
+            return shift3d_sparse_backward(grad, coords, spatial_size, weight, features, active_flag);
+        }
+
+        static torch::autograd::variable_list backward(torch::autograd::AutogradContext* ctx,
+                                                       torch::autograd::variable_list grad_output) {
+            TORCH_CHECK(false, "double backwards on shift3d_sparse is not supported");
+        }
+};
+
+
+template <int nD = 1>
+torch::Tensor shiftnd_autograd(const torch::Tensor& input,
+                               const torch::Tensor& weights,
+                               int64_t padding_mode, bool active_flag,
+                               c10::IntArrayRef stride, c10::IntArrayRef dilation,
+                               c10::optional<c10::MemoryFormat> memory_format,
+                               const c10::optional<torch::Tensor>& channel_perm,
+                               double sparsity){
+    return ShiftndFunction<nD>::apply(input, weights, padding_mode, active_flag, stride, dilation, memory_format, channel_perm,
+                                      sparsity);
+}
+
+template <int nD = 1>
+std::vector<torch::Tensor> shiftnd_backward_autograd(const torch::Tensor& grad,
+                                                     const torch::Tensor& weights,
+                                                     const torch::Tensor& input,
+                                                     int64_t padding_mode, bool active_flag,
+                                                     c10::IntArrayRef stride, c10::IntArrayRef dilation,
+                                                     double sparsity){
+    return ShiftndBackwardFunction<nD>::apply(grad, weights, input, padding_mode, active_flag, stride, dilation, sparsity);
+}
+
+template <int nD = 1>
+torch::Tensor& shiftnd_accumulate_autograd(torch::Tensor& out,
+                                           const torch::Tensor& input,
+                                           const torch::Tensor& weights,
+                                           int64_t padding_mode, bool active_flag,
+                                           double alpha, double beta,
+                                           c10::IntArrayRef stride, c10::IntArrayRef dilation){
+    ShiftndAccumulateFunction<nD>::apply(out, input, weights, padding_mode, active_flag, alpha, beta, stride, dilation);
+    return out;
+}
+
 template <int nD = 1>
-torch::Tensor shiftnd(const torch::Tensor& input,
-                      const torch::Tensor& weights,
-                      int64_t padding_mode, bool active_flag){
-    if (input.is_quantized()) {
-        if constexpr(nD == 3){
-            return q_shift3d_cpu(input, weights, padding_mode);
-        } else if constexpr(nD == 2){
-            return q_shift2d_cpu(input, weights, padding_mode);
-        } else {
-            return q_shift1d_cpu(input, weights, padding_mode);
+torch::Tensor shiftnd_multi_autograd(const torch::Tensor& input,
+                                     const torch::Tensor& weights,
+                                     int64_t padding_mode, bool active_flag){
+    return ShiftndMultiFunction<nD>::apply(input, weights, padding_mode, active_flag);
+}
+
+template <int nD = 1>
+std::vector<torch::Tensor> shiftnd_multi_backward_autograd(const torch::Tensor& grad,
+                                                           const torch::Tensor& weights,
+                                                           const torch::Tensor& input,
+                                                           int64_t padding_mode, bool active_flag){
+    return ShiftndMultiBackwardFunction<nD>::apply(grad, weights, input, padding_mode, active_flag);
+}
+
+template <int nD = 1>
+torch::Tensor shiftnd_packed_autograd(const torch::Tensor& input,
+                                      const torch::Tensor& sizes,
+                                      const torch::Tensor& weights,
+                                      int64_t padding_mode, bool active_flag){
+    return ShiftndPackedFunction<nD>::apply(input, sizes, weights, padding_mode, active_flag);
+}
+
+template <int nD = 1>
+std::vector<torch::Tensor> shiftnd_packed_backward_autograd(const torch::Tensor& grad,
+                                                            const torch::Tensor& sizes,
+                                                            const torch::Tensor& weights,
+                                                            const torch::Tensor& input,
+                                                            int64_t padding_mode, bool active_flag){
+    return ShiftndPackedBackwardFunction<nD>::apply(grad, sizes, weights, input, padding_mode, active_flag);
+}
+
+template <int nD = 1>
+torch::Tensor shiftnd_lowmem_autograd(const torch::Tensor& input,
+                                      const torch::Tensor& weights,
+                                      int64_t padding_mode, bool active_flag, int64_t saved_input,
+                                      c10::IntArrayRef stride, c10::IntArrayRef dilation){
+    return ShiftndLowmemFunction<nD>::apply(input, weights, padding_mode, active_flag, saved_input, stride, dilation);
+}
+
+
+inline torch::Tensor shift3d_sparse_autograd(const torch::Tensor& features,
+                                             const torch::Tensor& coords,
+                                             c10::IntArrayRef spatial_size,
+                                             const torch::Tensor& weights,
+                                             bool active_flag){
+    return Shift3dSparseFunction::apply(features, coords, spatial_size, weights, active_flag);
+}
+
+inline std::vector<torch::Tensor> shift3d_sparse_backward_autograd(const torch::Tensor& grad,
+                                                                   const torch::Tensor& coords,
+                                                                   c10::IntArrayRef spatial_size,
+                                                                   const torch::Tensor& weights,
+                                                                   const torch::Tensor& features,
+                                                                   bool active_flag){
+    return Shift3dSparseBackwardFunction::apply(grad, coords, spatial_size, weights, features, active_flag);
+}
+
+inline torch::Tensor shiftnd_generic_autograd(const torch::Tensor& input,
+                                              const torch::Tensor& weights,
+                                              int64_t padding_mode, bool active_flag){
+    return ShiftndGenericFunction::apply(input, weights, padding_mode, active_flag);
+}
+
+inline std::vector<torch::Tensor> shiftnd_generic_backward_autograd(const torch::Tensor& grad,
+                                                                    const torch::Tensor& weights,
+                                                                    const torch::Tensor& input,
+                                                                    int64_t padding_mode, bool active_flag){
+    return ShiftndGenericBackwardFunction::apply(grad, weights, input, padding_mode, active_flag);
+}
+
+inline torch::Tensor sparsity_l1_autograd(const torch::Tensor& weights, double sparsity){
+    return SparsityL1Function::apply(weights, sparsity);
+}
+
+// Channel blocked layout [N, C/b, *spatial, b](oneDNN nChw8c/nChw16c as a strided tensor).
+// Block cb of sample n is a channels last [b, *spatial] tensor, shifted in place of a blocked output with
+// weights[cb*b:(cb+1)*b]: no reorder, and the b channels of one pixel are a single contiguous run.
+// Weights are only viewed per call, never expanded over the batch: sample n is C/b samples with per
+// sample weights [C/b, b, nD], block cb is N samples with shared weights [b, nD]; the shorter loop is taken.
+// Channels above C(padding of the last block) get zero shift. Composite: autograd comes from the ops it calls.
+template <int nD = 1>
+torch::Tensor shiftnd_blocked_composite(const torch::Tensor& input,
+                                        const torch::Tensor& weights,
+                                        int64_t padding_mode, bool active_flag,
+                                        c10::IntArrayRef stride, c10::IntArrayRef dilation){
+    TORCH_CHECK(input.dim() == nD + 3, "shift", nD, "d_blocked: expected ", nD + 3, "D input [N, C/b, *spatial, b], but got ",
+                input.dim(), "D");
+    TORCH_CHECK(!input.is_mkldnn(), "shift", nD, "d_blocked: opaque MKLDNN tensors are not supported, pass a strided blocked tensor");
+    int64_t sizeN = input.size(0);
+    int64_t blocks = input.size(1);
+    int64_t block = input.size(-1);
+    TORCH_CHECK((weights.dim() == 2) && (weights.size(1) == nD) &&
+                (weights.size(0) > (blocks - 1)*block) && (weights.size(0) <= blocks*block),
+                "shift", nD, "d_blocked: expected weights of shape [C, ", nD, "] with ", (blocks - 1)*block, " < C <= ", blocks*block,
+                ", but got ", weights.sizes());
+    torch::Tensor block_weights = weights;
+    if (weights.size(0) < blocks*block){
+        block_weights = torch::constant_pad_nd(weights, {0, 0, 0, blocks*block - weights.size(0)});
+    }
+    block_weights = block_weights.view({blocks, block, nD});
+
+    std::array<int64_t, 3> steps = expand_param<nD>(stride, "stride");
+    // spatial axes are 2..nD+1 in both layouts
+    torch::Tensor output = torch::empty(strided_output_size<nD>(input.sizes(), steps), input.options());
+    // beta = 0: output is only written
+    if (sizeN <= blocks){
+        for (int64_t n = 0; n < sizeN; ++n){
+            torch::Tensor output_planes = output.select(0, n).movedim(-1, 1);
+            shiftnd_accumulate_<nD>(output_planes, input.select(0, n).movedim(-1, 1), block_weights,
+                                    padding_mode, active_flag, 1., 0., stride, dilation);
         }
     }
     else {
-        if constexpr(nD == 3){
-            return Shift3dFunction::apply(input, weights, padding_mode, active_flag);
-        } else if constexpr(nD == 2){
-            return Shift2dFunction::apply(input, weights, padding_mode, active_flag);
-        } else {
-            return Shift1dFunction::apply(input, weights, padding_mode, active_flag);
+        for (int64_t cb = 0; cb < blocks; ++cb){
+            torch::Tensor output_planes = output.select(1, cb).movedim(-1, 1);
+            shiftnd_accumulate_<nD>(output_planes, input.select(1, cb).movedim(-1, 1), block_weights.select(0, cb),
+                                    padding_mode, active_flag, 1., 0., stride, dilation);
         }
     }
+    return output;
+}
+
+
+// Grouped shifts: weights [G, nD] shared by channel groups, groups [C] maps channel to its group
+// (contiguous blocks or any permutation). Per channel shifts are gathered, the gather's backward
+// reduces weight gradients per group. Channels of a group which are neighbours in memory are moved
+// as runs by the CPU kernels(see shift_runs).
+template <int nD = 1>
+torch::Tensor shiftnd_grouped_composite(const torch::Tensor& input,
+                                        const torch::Tensor& weights,
+                                        const torch::Tensor& groups,
+                                        int64_t padding_mode, bool active_flag,
+                                        c10::IntArrayRef stride, c10::IntArrayRef dilation){
+    TORCH_CHECK((groups.dim() == 1) && (groups.size(0) == input.size(1)) && (groups.scalar_type() == torch::kLong),
+                "shift", nD, "d_grouped: expected int64 groups of shape [", input.size(1), "], but got ", groups.sizes());
+    TORCH_CHECK((weights.dim() == 2) && (weights.size(1) == nD),
+                "shift", nD, "d_grouped: expected weights of shape [G, ", nD, "], but got ", weights.sizes());
+    return shiftnd_forward<nD>(input, weights.index_select(0, groups.to(weights.device())),
+                               padding_mode, active_flag, stride, dilation);
+}
+
+
+// Low memory mode below autograd is the plain shift. Backward decompresses the saved input on devices
+// without a kernel for compressed input(CPU has one).
+template <int nD = 1>
+torch::Tensor shiftnd_lowmem_composite(const torch::Tensor& input,
+                                       const torch::Tensor& weights,
+                                       int64_t padding_mode, bool active_flag, int64_t saved_input,
+                                       c10::IntArrayRef stride, c10::IntArrayRef dilation){
+    TORCH_CHECK((saved_input >= 0) && (saved_input <= 2),
+                "shift", nD, "d_lowmem: saved_input can be 0 - full, 1 - bfloat16, 2 - int8, but got ", saved_input);
+    return shiftnd_forward<nD>(input, weights, padding_mode, active_flag, stride, dilation);
+}
+
+template <int nD = 1>
+std::vector<torch::Tensor> shiftnd_lowmem_backward_composite(const torch::Tensor& grad,
+                                                             const torch::Tensor& weights,
+                                                             const torch::Tensor& saved,
+                                                             const c10::optional<torch::Tensor>& scale,
+                                                             int64_t padding_mode, bool active_flag,
+                                                             c10::IntArrayRef stride, c10::IntArrayRef dilation){
+    return shiftnd_backward<nD>(grad, weights, decompress_saved_input(saved, scale, grad.scalar_type()),
+                                padding_mode, active_flag, stride, dilation);
+}
+
+
+inline torch::Tensor sparsity_l1_composite(const torch::Tensor& weights, double sparsity){
+    return weights.alias();
+}
+
+inline torch::Tensor shift1d(const torch::Tensor& input,
+                             const torch::Tensor& weights,
+                             int64_t padding_mode, bool active_flag,
+                             c10::IntArrayRef stride = 1, c10::IntArrayRef dilation = 1,
+                             c10::optional<c10::MemoryFormat> memory_format = c10::nullopt,
+                             const c10::optional<torch::Tensor>& channel_perm = c10::nullopt,
+                             double sparsity = 0.){
+    return shiftnd_forward<1>(input, weights, padding_mode, active_flag, stride, dilation, memory_format, channel_perm, sparsity);
+}
+
+inline torch::Tensor shift2d(const torch::Tensor& input,
+                             const torch::Tensor& weights,
+                             int64_t padding_mode, bool active_flag,
+                             c10::IntArrayRef stride = 1, c10::IntArrayRef dilation = 1,
+                             c10::optional<c10::MemoryFormat> memory_format = c10::nullopt,
+                             const c10::optional<torch::Tensor>& channel_perm = c10::nullopt,
+                             double sparsity = 0.){
+    return shiftnd_forward<2>(input, weights, padding_mode, active_flag, stride, dilation, memory_format, channel_perm, sparsity);
+}
+
+inline torch::Tensor shift3d(const torch::Tensor& input,
+                             const torch::Tensor& weights,
+                             int64_t padding_mode, bool active_flag,
+                             c10::IntArrayRef stride = 1, c10::IntArrayRef dilation = 1,
+                             c10::optional<c10::MemoryFormat> memory_format = c10::nullopt,
+                             const c10::optional<torch::Tensor>& channel_perm = c10::nullopt,
+                             double sparsity = 0.){
+    return shiftnd_forward<3>(input, weights, padding_mode, active_flag, stride, dilation, memory_format, channel_perm, sparsity);
+}
+
+inline torch::Tensor& shift1d_accumulate_(torch::Tensor& out,
+                                          const torch::Tensor& input,
+                                          const torch::Tensor& weights,
+                                          int64_t padding_mode, bool active_flag,
+                                          double alpha = 1., double beta = 1.,
+                                          c10::IntArrayRef stride = 1, c10::IntArrayRef dilation = 1){
+    return shiftnd_accumulate_<1>(out, input, weights, padding_mode, active_flag, alpha, beta, stride, dilation);
+}
+
+inline torch::Tensor& shift2d_accumulate_(torch::Tensor& out,
+                                          const torch::Tensor& input,
+                                          const torch::Tensor& weights,
+                                          int64_t padding_mode, bool active_flag,
+                                          double alpha = 1., double beta = 1.,
+                                          c10::IntArrayRef stride = 1, c10::IntArrayRef dilation = 1){
+    return shiftnd_accumulate_<2>(out, input, weights, padding_mode, active_flag, alpha, beta, stride, dilation);
+}
+
+inline torch::Tensor& shift3d_accumulate_(torch::Tensor& out,
+                                          const torch::Tensor& input,
+                                          const torch::Tensor& weights,
+                                          int64_t padding_mode, bool active_flag,
+                                          double alpha = 1., double beta = 1.,
+                                          c10::IntArrayRef stride = 1, c10::IntArrayRef dilation = 1){
+    return shiftnd_accumulate_<3>(out, input, weights, padding_mode, active_flag, alpha, beta, stride, dilation);
+}
+
+inline torch::Tensor shift1d_multi(const torch::Tensor& input,
+                                   const torch::Tensor& weights,
+                                   int64_t padding_mode, bool active_flag){
+    return shiftnd_multi_forward<1>(input, weights, padding_mode, active_flag);
+}
+
+inline torch::Tensor shift2d_multi(const torch::Tensor& input,
+                                   const torch::Tensor& weights,
+                                   int64_t padding_mode, bool active_flag){
+    return shiftnd_multi_forward<2>(input, weights, padding_mode, active_flag);
+}
+
+inline torch::Tensor shift3d_multi(const torch::Tensor& input,
+                                   const torch::Tensor& weights,
+                                   int64_t padding_mode, bool active_flag){
+    return shiftnd_multi_forward<3>(input, weights, padding_mode, active_flag);
+}
+
+inline torch::Tensor shift1d_blocked(const torch::Tensor& input,
+                                     const torch::Tensor& weights,
+                                     int64_t padding_mode, bool active_flag,
+                                     c10::IntArrayRef stride = 1, c10::IntArrayRef dilation = 1){
+    return shiftnd_blocked_forward<1>(input, weights, padding_mode, active_flag, stride, dilation);
 }
 
-torch::Tensor shift1d(const torch::Tensor& input,
-                      const torch::Tensor& weights,
-                      int64_t padding_mode, bool active_flag){
-    return shiftnd<1>(input, weights, padding_mode, active_flag);
+inline torch::Tensor shift2d_blocked(const torch::Tensor& input,
+                                     const torch::Tensor& weights,
+                                     int64_t padding_mode, bool active_flag,
+                                     c10::IntArrayRef stride = 1, c10::IntArrayRef dilation = 1){
+    return shiftnd_blocked_forward<2>(input, weights, padding_mode, active_flag, stride, dilation);
 }
 
-torch::Tensor shift2d(const torch::Tensor& input,
-                      const torch::Tensor& weights,
-                      int64_t padding_mode, bool active_flag){
-    return shiftnd<2>(input, weights, padding_mode, active_flag);
+inline torch::Tensor shift3d_blocked(const torch::Tensor& input,
+                                     const torch::Tensor& weights,
+                                     int64_t padding_mode, bool active_flag,
+                                     c10::IntArrayRef stride = 1, c10::IntArrayRef dilation = 1){
+    return shiftnd_blocked_forward<3>(input, weights, padding_mode, active_flag, stride, dilation);
 }
 
-torch::Tensor shift3d(const torch::Tensor& input,
-                      const torch::Tensor& weights,
-                      int64_t padding_mode, bool active_flag){
-    return shiftnd<3>(input, weights, padding_mode, active_flag);
-}
\ No newline at end of file
+inline torch::Tensor shift1d_packed(const torch::Tensor& input,
+                                    const torch::Tensor& sizes,
+                                    const torch::Tensor& weights,
+                                    int64_t padding_mode, bool active_flag){
+    return shiftnd_packed_forward<1>(input, sizes, weights, padding_mode, active_flag);
+}
+
+inline torch::Tensor shift2d_packed(const torch::Tensor& input,
+                                    const torch::Tensor& sizes,
+                                    const torch::Tensor& weights,
+                                    int64_t padding_mode, bool active_flag){
+    return shiftnd_packed_forward<2>(input, sizes, weights, padding_mode, active_flag);
+}
+
+inline torch::Tensor shift3d_packed(const torch::Tensor& input,
+                                    const torch::Tensor& sizes,
+                                    const torch::Tensor& weights,
+                                    int64_t padding_mode, bool active_flag){
+    return shiftnd_packed_forward<3>(input, sizes, weights, padding_mode, active_flag);
+}
+
+inline torch::Tensor shift1d_grouped(const torch::Tensor& input,
+                                     const torch::Tensor& weights,
+                                     const torch::Tensor& groups,
+                                     int64_t padding_mode, bool active_flag,
+                                     c10::IntArrayRef stride = 1, c10::IntArrayRef dilation = 1){
+    return shiftnd_grouped_forward<1>(input, weights, groups, padding_mode, active_flag, stride, dilation);
+}
+
+inline torch::Tensor shift2d_grouped(const torch::Tensor& input,
+                                     const torch::Tensor& weights,
+                                     const torch::Tensor& groups,
+                                     int64_t padding_mode, bool active_flag,
+                                     c10::IntArrayRef stride = 1, c10::IntArrayRef dilation = 1){
+    return shiftnd_grouped_forward<2>(input, weights, groups, padding_mode, active_flag, stride, dilation);
+}
+
+inline torch::Tensor shift3d_grouped(const torch::Tensor& input,
+                                     const torch::Tensor& weights,
+                                     const torch::Tensor& groups,
+                                     int64_t padding_mode, bool active_flag,
+                                     c10::IntArrayRef stride = 1, c10::IntArrayRef dilation = 1){
+    return shiftnd_grouped_forward<3>(input, weights, groups, padding_mode, active_flag, stride, dilation);
+}
+
+inline torch::Tensor shift1d_lowmem(const torch::Tensor& input,
+                                    const torch::Tensor& weights,
+                                    int64_t padding_mode, bool active_flag, int64_t saved_input,
+                                    c10::IntArrayRef stride = 1, c10::IntArrayRef dilation = 1){
+    return shiftnd_lowmem_forward<1>(input, weights, padding_mode, active_flag, saved_input, stride, dilation);
+}
+
+inline torch::Tensor shift2d_lowmem(const torch::Tensor& input,
+                                    const torch::Tensor& weights,
+                                    int64_t padding_mode, bool active_flag, int64_t saved_input,
+                                    c10::IntArrayRef stride = 1, c10::IntArrayRef dilation = 1){
+    return shiftnd_lowmem_forward<2>(input, weights, padding_mode, active_flag, saved_input, stride, dilation);
+}
+
+inline torch::Tensor shift3d_lowmem(const torch::Tensor& input,
+                                    const torch::Tensor& weights,
+                                    int64_t padding_mode, bool active_flag, int64_t saved_input,
+                                    c10::IntArrayRef stride = 1, c10::IntArrayRef dilation = 1){
+    return shiftnd_lowmem_forward<3>(input, weights, padding_mode, active_flag, saved_input, stride, dilation);
+}
+
+// Sparse voxel grid: features [M, C] of occupied voxels, int64 coords [M, 4](n, i, j, k) in grid spatial_size [H, W, D].
+// Output [M, C] at the same voxels, Zeros padding(empty voxels are zeros).
+inline torch::Tensor shift3d_sparse(const torch::Tensor& features,
+                                    const torch::Tensor& coords,
+                                    c10::IntArrayRef spatial_size,
+                                    const torch::Tensor& weights,
+                                    bool active_flag){
+    return shift3d_sparse_forward(features, coords, spatial_size, weights, active_flag);
+}
+
+// Any number R of spatial axes(1 to SHIFTS_MAX_RANK, e.g. video [N, C, T, H, W]): input [N, C, *spatial],
+// weights [C, R] or [N, C, R], R-linear interpolation in active mode. CPU only.
+inline torch::Tensor shiftnd(const torch::Tensor& input,
+                             const torch::Tensor& weights,
+                             int64_t padding_mode, bool active_flag){
+    return shiftnd_generic_forward(input, weights, padding_mode, active_flag);
+}
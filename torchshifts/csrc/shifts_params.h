@@ -0,0 +1,280 @@
+#pragma once
+#include <torch/torch.h>
+#include <ATen/MemoryOverlap.h>
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <tuple>
+#include <vector>
+
+
+// Expands int[] argument of an op to per axis values: a single value is broadcast to all nD axes,
+// axes above nD are filled by 1 (kernels always work with H, W, D)
+template <int nD>
+inline std::array<int64_t, 3> expand_param(c10::IntArrayRef param, const char* name){
+    TORCH_CHECK((param.size() == 1) || (param.size() == nD),
+                "shift", nD, "d: ", name, " must have 1 or ", nD, " values, but got ", param.size());
+    std::array<int64_t, 3> out = {1, 1, 1};
+    for (int d = 0; d < nD; ++d){
+        out[d] = (param.size() == 1) ? param[0] : param[d];
+        TORCH_CHECK(out[d] >= 1, "shift", nD, "d: ", name, " must be positive, but got ", out[d]);
+    }
+    return out;
+}
+
+inline bool is_unit_param(const std::array<int64_t, 3>& param){
+    return (param[0] == 1) && (param[1] == 1) && (param[2] == 1);
+}
+
+// Output keeps positions 0, step, 2*step, ... of every spatial axis
+template <int nD>
+inline std::vector<int64_t> strided_output_size(c10::IntArrayRef input_size, const std::array<int64_t, 3>& steps){
+    std::vector<int64_t> output_size(input_size.begin(), input_size.end());
+    for (int d = 0; d < nD; ++d){
+        output_size[d + 2] = (input_size[d + 2] + steps[d] - 1) / steps[d];
+    }
+    return output_size;
+}
+
+// Layout of the shift output: requested memory_format(Preserve - the input one), `fallback` when it is not given.
+// The kernels write through output strides, so the layout change is done in the same pass.
+template <int nD>
+inline c10::MemoryFormat output_memory_format(const torch::Tensor& input, c10::optional<c10::MemoryFormat> memory_format,
+                                              c10::MemoryFormat fallback = c10::MemoryFormat::Contiguous){
+    if (!memory_format.has_value()){
+        return fallback;
+    }
+    c10::MemoryFormat format = (*memory_format == c10::MemoryFormat::Preserve) ? input.suggest_memory_format() : *memory_format;
+    TORCH_CHECK((format == c10::MemoryFormat::Contiguous) ||
+                ((format == c10::MemoryFormat::ChannelsLast) && (nD == 2)) ||
+                ((format == c10::MemoryFormat::ChannelsLast3d) && (nD == 3)),
+                "shift", nD, "d: memory_format ", format, " is not supported for ", nD + 2, "D output");
+    return format;
+}
+
+// Channels stored innermost([N, *spatial, C] storage seen as [N, C, *spatial]) at any rank,
+// 1D NLC and token layouts moved by movedim included(they have no MemoryFormat)
+inline bool is_channels_inner(const torch::Tensor& tensor){
+    return (tensor.dim() >= 3) && (tensor.sym_size(1) > 1) && (tensor.sym_stride(1) == 1) && tensor.movedim(1, -1).is_contiguous();
+}
+
+inline torch::Tensor empty_channels_inner(c10::IntArrayRef size, const torch::TensorOptions& options){
+    std::vector<int64_t> storage_size(size.begin(), size.end());
+    std::rotate(storage_size.begin() + 1, storage_size.begin() + 2, storage_size.end());
+    return torch::empty(storage_size, options).movedim(-1, 1);
+}
+
+// Shift output: Preserve keeps channels innermost for inputs of any rank, other formats as output_memory_format
+template <int nD>
+inline torch::Tensor empty_output(const torch::Tensor& input, c10::IntArrayRef output_size,
+                                  c10::optional<c10::MemoryFormat> memory_format){
+    if ((memory_format == c10::MemoryFormat::Preserve) && is_channels_inner(input)){
+        return empty_channels_inner(output_size, input.options());
+    }
+    return torch::empty(output_size, input.options().memory_format(output_memory_format<nD>(input, memory_format)));
+}
+
+// Input gradient in the layout of the input(contiguous unless channels are innermost)
+inline torch::Tensor empty_input_grad(const torch::Tensor& input){
+    return is_channels_inner(input) ? empty_channels_inner(input.sizes(), input.options())
+                                    : torch::empty_like(input, LEGACY_CONTIGUOUS_MEMORY_FORMAT);
+}
+
+// Output channel permutation fused into the shift: input channel c is written to output channel perm[c]
+// (e.g. ShuffleNet channel shuffle). Must be a permutation of 0..C-1 on the input device.
+template <int nD>
+inline void check_channel_perm(const torch::Tensor& input, const c10::optional<torch::Tensor>& channel_perm){
+    if (!channel_perm.has_value() || !channel_perm->defined()){
+        return;
+    }
+    const torch::Tensor& perm = *channel_perm;
+    TORCH_CHECK((perm.dim() == 1) && (perm.size(0) == input.size(1)) && (perm.scalar_type() == torch::kLong),
+                "shift", nD, "d: expected int64 channel_perm of shape [", input.size(1), "], but got ", perm.sizes());
+    TORCH_CHECK(perm.device() == input.device(),
+                "shift", nD, "d: channel_perm must be on ", input.device(), ", but it is on ", perm.device());
+    // kernels write output channel perm[c]: out of range or repeated values must not reach them(direct op calls included).
+    // O(C) on CPU, on CUDA one reduction checked by a device side assert(no host synchronization)
+    int64_t sizeC = perm.size(0);
+    if (perm.is_meta() || (sizeC == 0)){
+        return;
+    }
+    if (perm.is_cpu()){
+        torch::Tensor perm_c = perm.contiguous();
+        const int64_t* perm_ptr = perm_c.data_ptr<int64_t>();
+        std::vector<bool> seen(sizeC, false);
+        for (int64_t c = 0; c < sizeC; ++c){
+            int64_t p = perm_ptr[c];
+            TORCH_CHECK((p >= 0) && (p < sizeC) && !seen[p],
+                        "shift", nD, "d: channel_perm must be a permutation of 0..", sizeC - 1, ", but channel_perm[", c, "] = ", p);
+            seen[p] = true;
+        }
+        return;
+    }
+    torch::Tensor counts = torch::zeros({sizeC}, perm.options()).scatter_add_(0, perm.clamp(0, sizeC - 1), torch::ones_like(perm));
+    at::_assert_async(perm.ge(0).logical_and(perm.lt(sizeC)).all().logical_and(counts.eq(1).all()));
+}
+
+inline bool has_channel_perm(const c10::optional<torch::Tensor>& channel_perm){
+    return channel_perm.has_value() && channel_perm->defined();
+}
+
+// Dilation scales shifts before rounding(or interpolation)
+template <int nD>
+inline torch::Tensor dilation_scale(const torch::Tensor& weights, const std::array<int64_t, 3>& dilation){
+    std::vector<double> scale(dilation.begin(), dilation.begin() + nD);
+    return torch::tensor(scale, weights.options());
+}
+
+// Buffers updated in place by the accumulate ops: exact result size, no aliasing with what the kernels read
+template <int nD>
+inline void check_accumulate_out(const torch::Tensor& out, c10::IntArrayRef expected_size,
+                                 c10::ArrayRef<torch::Tensor> sources){
+    TORCH_CHECK(out.sizes() == expected_size,
+                "shift", nD, "d: expected accumulation buffer of size ", expected_size, ", but got ", out.sizes());
+    at::assert_no_internal_overlap(out);
+    for (const torch::Tensor& source : sources){
+        TORCH_CHECK(out.scalar_type() == source.scalar_type(),
+                    "shift", nD, "d: accumulation buffer must have type ", source.scalar_type(), ", but got ", out.scalar_type());
+        TORCH_CHECK(out.device() == source.device(),
+                    "shift", nD, "d: accumulation buffer must be on ", source.device(), ", but it is on ", out.device());
+        at::assert_no_overlap(out, source);
+    }
+}
+
+// Weights of multi shift: K shift sets of [C, nD]
+template <int nD>
+inline void check_multi_weights(const torch::Tensor& input, const torch::Tensor& weights){
+    TORCH_CHECK(input.dim() == nD + 2, "shift", nD, "d_multi: expected ", nD + 2, "D input, but got ", input.dim(), "D");
+    TORCH_CHECK((weights.dim() == 3) && (weights.size(1) == input.size(1)) && (weights.size(2) == nD),
+                "shift", nD, "d_multi: expected weights of shape [K, ", input.size(1), ", ", nD, "], but got ", weights.sizes());
+}
+
+// Backward reads grad as [N, K*C, ...] of the forward output
+template <int nD>
+inline void check_multi_backward(const torch::Tensor& grad, const torch::Tensor& input, const torch::Tensor& weights){
+    check_multi_weights<nD>(input, weights);
+    std::vector<int64_t> output_size(input.sizes().begin(), input.sizes().end());
+    output_size[1] *= weights.size(0);
+    TORCH_CHECK(grad.sizes() == torch::IntArrayRef(output_size),
+                "shift", nD, "d_multi: expected grad of shape ", torch::IntArrayRef(output_size), ", but got ", grad.sizes());
+}
+
+// Weights are shared [C, nD] or per sample [N, C, nD]
+template <int nD>
+inline void check_weights(const torch::Tensor& input, const torch::Tensor& weights){
+    TORCH_CHECK((weights.dim() == 2) || ((weights.dim() == 3) && (weights.size(0) == input.size(0))),
+                "shift", nD, "d: expected weights of shape [C, ", nD, "] or [N, C, ", nD, "] with N = ", input.size(0),
+                ", but got ", weights.sizes());
+}
+
+// Kernels always index weights as [N, C, nD]: shared weights get zero batch stride(no copy)
+inline torch::Tensor batched_weights(const torch::Tensor& weights, int64_t sizeN){
+    if (weights.dim() == 3){
+        return weights;
+    }
+    return weights.unsqueeze(0).expand({sizeN, weights.size(0), weights.size(1)});
+}
+
+// Packed variable size batch: flat buffer of N samples [C, *sizes[n]] stored one after another,
+// sizes is a [N, nD] int64 CPU table. Returns offsets of the samples in the buffer(N + 1 values).
+template <int nD>
+inline std::vector<int64_t> packed_offsets(const torch::Tensor& input, const torch::Tensor& sizes, const torch::Tensor& weights){
+    TORCH_CHECK(input.dim() == 1, "shift", nD, "d_packed: expected flat input buffer, but got ", input.dim(), "D");
+    TORCH_CHECK((sizes.dim() == 2) && (sizes.size(1) == nD) && (sizes.scalar_type() == torch::kLong) && sizes.device().is_cpu(),
+                "shift", nD, "d_packed: expected int64 CPU sizes of shape [N, ", nD, "], but got ", sizes.sizes());
+    TORCH_CHECK((weights.dim() == 2) && (weights.size(1) == nD),
+                "shift", nD, "d_packed: expected weights of shape [C, ", nD, "], but got ", weights.sizes());
+    torch::Tensor sizes_c = sizes.contiguous();
+    auto sizes_acc = sizes_c.accessor<int64_t, 2>();
+    std::vector<int64_t> offsets(sizes.size(0) + 1, 0);
+    for (int64_t n = 0; n < sizes.size(0); ++n){
+        int64_t numel = weights.size(0);
+        for (int d = 0; d < nD; ++d){
+            TORCH_CHECK(sizes_acc[n][d] > 0, "shift", nD, "d_packed: sample ", n, " has non positive size ", sizes_acc[n][d]);
+            numel *= sizes_acc[n][d];
+        }
+        offsets[n + 1] = offsets[n] + numel;
+    }
+    TORCH_CHECK(offsets.back() == input.numel(),
+                "shift", nD, "d_packed: sizes describe ", offsets.back(), " elements, but input has ", input.numel());
+    return offsets;
+}
+
+// Sparse voxel grid: features [M, C] of occupied voxels with int64 coordinates [M, 4](n, i, j, k)
+// in a grid of spatial_size [H, W, D]. Returns the spatial size.
+inline std::array<int64_t, 3> check_sparse_coords(const torch::Tensor& coords, c10::IntArrayRef spatial_size){
+    TORCH_CHECK((coords.dim() == 2) && (coords.size(1) == 4) && (coords.scalar_type() == torch::kLong),
+                "shift3d_sparse: expected int64 coords of shape [M, 4], but got ", coords.sizes());
+    TORCH_CHECK(spatial_size.size() == 3, "shift3d_sparse: expected spatial_size of 3 values, but got ", spatial_size.size());
+    std::array<int64_t, 3> size;
+    for (int d = 0; d < 3; ++d){
+        TORCH_CHECK(spatial_size[d] > 0, "shift3d_sparse: spatial_size must be positive, but got ", spatial_size);
+        size[d] = spatial_size[d];
+    }
+    return size;
+}
+
+inline std::array<int64_t, 3> check_sparse_voxels(const torch::Tensor& features, const torch::Tensor& coords,
+                                                  c10::IntArrayRef spatial_size, const torch::Tensor& weights){
+    TORCH_CHECK(features.dim() == 2, "shift3d_sparse: expected features of shape [M, C], but got ", features.sizes());
+    TORCH_CHECK((coords.dim() == 2) && (coords.size(0) == features.size(0)),
+                "shift3d_sparse: expected coords of shape [", features.size(0), ", 4], but got ", coords.sizes());
+    TORCH_CHECK((weights.dim() == 2) && (weights.size(0) == features.size(1)) && (weights.size(1) == 3),
+                "shift3d_sparse: expected weights of shape [", features.size(1), ", 3], but got ", weights.sizes());
+    return check_sparse_coords(coords, spatial_size);
+}
+
+// Rank generic shift(shiftnd): input [N, C, *spatial] with R spatial axes, weights [C, R] or per sample [N, C, R].
+// Returns R.
+#define SHIFTS_MAX_RANK 6
+inline int64_t check_rank_weights(const torch::Tensor& input, const torch::Tensor& weights){
+    int64_t rank = input.dim() - 2;
+    TORCH_CHECK((rank >= 1) && (rank <= SHIFTS_MAX_RANK),
+                "shiftnd: expected input [N, C, *spatial] with 1 to ", SHIFTS_MAX_RANK, " spatial axes, but got ", input.dim(), "D");
+    TORCH_CHECK((weights.dim() == 2) || ((weights.dim() == 3) && (weights.size(0) == input.size(0))),
+                "shiftnd: expected weights of shape [C, ", rank, "] or [N, C, ", rank, "] with N = ", input.size(0),
+                ", but got ", weights.sizes());
+    TORCH_CHECK((weights.size(-2) == input.size(1)) && (weights.size(-1) == rank),
+                "shiftnd: expected ", rank, " shifts for each of ", input.size(1), " channels, but got weights ", weights.sizes());
+    return rank;
+}
+
+// Low memory mode: how the input is saved for backward
+enum class SavedInput {Full, BFloat16, Int8};
+
+// Shape [1, C, 1, ...] for broadcasting per channel values over input
+inline std::vector<int64_t> channel_shape(const torch::Tensor& input){
+    std::vector<int64_t> shape(input.dim(), 1);
+    shape[1] = input.size(1);
+    return shape;
+}
+
+// Returns saved input and its per channel scale [C](Int8 only, symmetric: x = q*scale, |q| <= 127)
+template <int nD>
+inline std::tuple<torch::Tensor, torch::Tensor> compress_saved_input(const torch::Tensor& input, int64_t saved_input){
+    TORCH_CHECK((saved_input >= 0) && (saved_input <= 2),
+                "shift", nD, "d_lowmem: saved_input can be 0 - full, 1 - bfloat16, 2 - int8, but got ", saved_input);
+    switch (static_cast<SavedInput>(saved_input)){
+        case SavedInput::BFloat16:
+            return {input.to(torch::kBFloat16), torch::Tensor()};
+        case SavedInput::Int8: {
+            std::vector<int64_t> dims;
+            for (int64_t d = 0; d < input.dim(); ++d){
+                if (d != 1) {dims.push_back(d);}
+            }
+            torch::Tensor scale = (input.abs().amax(dims) / 127.).clamp_min(std::numeric_limits<float>::min());
+            torch::Tensor saved = torch::round(input / scale.view(channel_shape(input))).clamp(-127, 127).to(torch::kChar);
+            return {saved, scale};
+        }
+        default:
+            return {input, torch::Tensor()};
+    }
+}
+
+inline torch::Tensor decompress_saved_input(const torch::Tensor& saved, const c10::optional<torch::Tensor>& scale,
+                                            c10::ScalarType dtype){
+    if (scale.has_value() && scale->defined()){
+        return saved.to(dtype) * scale->to(dtype).view(channel_shape(saved));
+    }
+    return saved.to(dtype);
+}
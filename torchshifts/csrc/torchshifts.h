@@ -0,0 +1,107 @@
+#pragma once
+// Public C++ API of torchshifts(no Python needed): link the library built by CMake and include this header.
+// Linking also registers the torchshifts:: ops, so TorchScript models using them load by torch::jit::load.
+// Calls go through the dispatcher: CPU, QuantizedCPU, CUDA and Meta kernels and autograd are all available.
+// padding_mode: 0 - zeros, 1 - border, 2 - periodic, 3 - reflect, 4 - symmetric
+#include <torch/torch.h>
+#include "shifts.h"
+
+
+namespace shifts {
+
+// input [N, C, *spatial], weights [C, nD] or per sample [N, C, nD]
+// memory_format: layout of the output(Contiguous, ChannelsLast/ChannelsLast3d or Preserve), nullopt - contiguous
+// channel_perm: int64 permutation of channels [C] written by the shift: output[:, channel_perm[c]] = shift(input)[:, c]
+//               values are checked by the op(O(C) on CPU, device side assert on CUDA)
+// sparsity: L1 term of the shifts, sparsity*sign(weights) is added to the weights gradient by backward
+API_EXPORT torch::Tensor shift1d(const torch::Tensor& input, const torch::Tensor& weights,
+                                 int64_t padding_mode = 0, bool active_flag = false,
+                                 c10::IntArrayRef stride = 1, c10::IntArrayRef dilation = 1,
+                                 c10::optional<c10::MemoryFormat> memory_format = c10::nullopt,
+                                 const c10::optional<torch::Tensor>& channel_perm = c10::nullopt,
+                                 double sparsity = 0.);
+API_EXPORT torch::Tensor shift2d(const torch::Tensor& input, const torch::Tensor& weights,
+                                 int64_t padding_mode = 0, bool active_flag = false,
+                                 c10::IntArrayRef stride = 1, c10::IntArrayRef dilation = 1,
+                                 c10::optional<c10::MemoryFormat> memory_format = c10::nullopt,
+                                 const c10::optional<torch::Tensor>& channel_perm = c10::nullopt,
+                                 double sparsity = 0.);
+API_EXPORT torch::Tensor shift3d(const torch::Tensor& input, const torch::Tensor& weights,
+                                 int64_t padding_mode = 0, bool active_flag = false,
+                                 c10::IntArrayRef stride = 1, c10::IntArrayRef dilation = 1,
+                                 c10::optional<c10::MemoryFormat> memory_format = c10::nullopt,
+                                 const c10::optional<torch::Tensor>& channel_perm = c10::nullopt,
+                                 double sparsity = 0.);
+
+// out = beta*out + alpha*shift(input), in-place
+API_EXPORT torch::Tensor& shift1d_accumulate_(torch::Tensor& out, const torch::Tensor& input, const torch::Tensor& weights,
+                                              int64_t padding_mode = 0, bool active_flag = false,
+                                              double alpha = 1., double beta = 1.,
+                                              c10::IntArrayRef stride = 1, c10::IntArrayRef dilation = 1);
+API_EXPORT torch::Tensor& shift2d_accumulate_(torch::Tensor& out, const torch::Tensor& input, const torch::Tensor& weights,
+                                              int64_t padding_mode = 0, bool active_flag = false,
+                                              double alpha = 1., double beta = 1.,
+                                              c10::IntArrayRef stride = 1, c10::IntArrayRef dilation = 1);
+API_EXPORT torch::Tensor& shift3d_accumulate_(torch::Tensor& out, const torch::Tensor& input, const torch::Tensor& weights,
+                                              int64_t padding_mode = 0, bool active_flag = false,
+                                              double alpha = 1., double beta = 1.,
+                                              c10::IntArrayRef stride = 1, c10::IntArrayRef dilation = 1);
+
+// weights [K, C, nD], output [N, K*C, *spatial]
+API_EXPORT torch::Tensor shift1d_multi(const torch::Tensor& input, const torch::Tensor& weights,
+                                       int64_t padding_mode = 0, bool active_flag = false);
+API_EXPORT torch::Tensor shift2d_multi(const torch::Tensor& input, const torch::Tensor& weights,
+                                       int64_t padding_mode = 0, bool active_flag = false);
+API_EXPORT torch::Tensor shift3d_multi(const torch::Tensor& input, const torch::Tensor& weights,
+                                       int64_t padding_mode = 0, bool active_flag = false);
+
+// input in blocked layout [N, ceil(C/b), *spatial, b]
+API_EXPORT torch::Tensor shift1d_blocked(const torch::Tensor& input, const torch::Tensor& weights,
+                                         int64_t padding_mode = 0, bool active_flag = false,
+                                         c10::IntArrayRef stride = 1, c10::IntArrayRef dilation = 1);
+API_EXPORT torch::Tensor shift2d_blocked(const torch::Tensor& input, const torch::Tensor& weights,
+                                         int64_t padding_mode = 0, bool active_flag = false,
+                                         c10::IntArrayRef stride = 1, c10::IntArrayRef dilation = 1);
+API_EXPORT torch::Tensor shift3d_blocked(const torch::Tensor& input, const torch::Tensor& weights,
+                                         int64_t padding_mode = 0, bool active_flag = false,
+                                         c10::IntArrayRef stride = 1, c10::IntArrayRef dilation = 1);
+
+// flat buffer of samples with different spatial sizes, sizes is int64 CPU [N, nD]
+API_EXPORT torch::Tensor shift1d_packed(const torch::Tensor& input, const torch::Tensor& sizes, const torch::Tensor& weights,
+                                        int64_t padding_mode = 0, bool active_flag = false);
+API_EXPORT torch::Tensor shift2d_packed(const torch::Tensor& input, const torch::Tensor& sizes, const torch::Tensor& weights,
+                                        int64_t padding_mode = 0, bool active_flag = false);
+API_EXPORT torch::Tensor shift3d_packed(const torch::Tensor& input, const torch::Tensor& sizes, const torch::Tensor& weights,
+                                        int64_t padding_mode = 0, bool active_flag = false);
+
+// weights [G, nD] shared by channels with the same group index, groups int64 [C]
+API_EXPORT torch::Tensor shift1d_grouped(const torch::Tensor& input, const torch::Tensor& weights, const torch::Tensor& groups,
+                                         int64_t padding_mode = 0, bool active_flag = false,
+                                         c10::IntArrayRef stride = 1, c10::IntArrayRef dilation = 1);
+API_EXPORT torch::Tensor shift2d_grouped(const torch::Tensor& input, const torch::Tensor& weights, const torch::Tensor& groups,
+                                         int64_t padding_mode = 0, bool active_flag = false,
+                                         c10::IntArrayRef stride = 1, c10::IntArrayRef dilation = 1);
+API_EXPORT torch::Tensor shift3d_grouped(const torch::Tensor& input, const torch::Tensor& weights, const torch::Tensor& groups,
+                                         int64_t padding_mode = 0, bool active_flag = false,
+                                         c10::IntArrayRef stride = 1, c10::IntArrayRef dilation = 1);
+
+// low memory backward: input saved as 0 - full, 1 - bfloat16, 2 - int8 with per channel scale
+API_EXPORT torch::Tensor shift1d_lowmem(const torch::Tensor& input, const torch::Tensor& weights,
+                                        int64_t padding_mode = 0, bool active_flag = false, int64_t saved_input = 1,
+                                        c10::IntArrayRef stride = 1, c10::IntArrayRef dilation = 1);
+API_EXPORT torch::Tensor shift2d_lowmem(const torch::Tensor& input, const torch::Tensor& weights,
+                                        int64_t padding_mode = 0, bool active_flag = false, int64_t saved_input = 1,
+                                        c10::IntArrayRef stride = 1, c10::IntArrayRef dilation = 1);
+API_EXPORT torch::Tensor shift3d_lowmem(const torch::Tensor& input, const torch::Tensor& weights,
+                                        int64_t padding_mode = 0, bool active_flag = false, int64_t saved_input = 1,
+                                        c10::IntArrayRef stride = 1, c10::IntArrayRef dilation = 1);
+
+// sparse voxel grid(CPU): features [M, C], int64 coords [M, 4](n, i, j, k), output at the same voxels, Zeros padding
+API_EXPORT torch::Tensor shift3d_sparse(const torch::Tensor& features, const torch::Tensor& coords, c10::IntArrayRef spatial_size,
+                                        const torch::Tensor& weights, bool active_flag = false);
+
+// any number R of spatial axes(CPU, 1 to 6, e.g. video [N, C, T, H, W]): weights [C, R] or [N, C, R]
+API_EXPORT torch::Tensor shiftnd(const torch::Tensor& input, const torch::Tensor& weights,
+                                 int64_t padding_mode = 0, bool active_flag = false);
+
+}
@@ -1,15 +1,74 @@
+import weakref
 import torch
+from typing import List, Optional, Sequence, Tuple, Union
 from .extension import _assert_has_ops
 
 Tensor = torch.Tensor
 
+def _param_list(value, n_dims: int, name: str) -> List[int]:
+    values = [int(value)] if isinstance(value, int) else [int(v) for v in value]
+    assert len(values) in [1, n_dims], f'shift{n_dims}d_func(): expected {name} to be int or sequence of {n_dims} ints, but got {value}'
+    assert all(v >= 1 for v in values), f'shift{n_dims}d_func(): expected {name} to be positive, but got {value}'
+    return values
+
+def channel_shuffle_perm(n_channels: int, groups: int) -> Tensor:
+    """
+        Channel permutation of ShuffleNet channel shuffle for `channel_perm` argument of shift functions:
+        channel k of group g is written to position k*groups + g(same as view(N, groups, C//groups, ...).transpose(1, 2)).
+        Arguments:
+            n_channels (int): number of channels, must be divisible by groups
+            groups (int): number of channel groups
+        Returns:
+            perm (Tensor[n_channels], int64)
+    """
+    assert n_channels % groups == 0, f'channel_shuffle_perm(): expected n_channels to be divisible by groups, but got {n_channels} and {groups}'
+    return _mark_checked(torch.arange(n_channels).view(n_channels // groups, groups).t().reshape(-1))
+
+# id(perm) -> (weakref, version) of channel permutations known to be valid: Python error with the shift name is raised
+# once per tensor, not on every call(sort + compare allocate and synchronize CUDA). This is only a fast path,
+# the ops check the values themselves(check_channel_perm) for direct torch.ops calls and traced graphs.
+_checked_perms = {}
+
+def _mark_checked(perm: Tensor) -> Tensor:
+    key = id(perm)
+    _checked_perms[key] = (weakref.ref(perm, lambda _: _checked_perms.pop(key, None)), perm._version)
+    return perm
+
+def _channel_perm(channel_perm: Optional[Tensor], input: Tensor, n_dims: int) -> Optional[Tensor]:
+    if channel_perm is None:
+        return None
+    assert channel_perm.shape == (input.shape[1],), f'shift{n_dims}d_func(): expected channel_perm of shape [{input.shape[1]}], but got {tuple(channel_perm.shape)}'
+    entry = _checked_perms.get(id(channel_perm))
+    if not torch.jit.is_tracing() and not ((entry is not None) and (entry[0]() is channel_perm) and (entry[1] == channel_perm._version)):
+        assert torch.equal(channel_perm.sort()[0].cpu(), torch.arange(input.shape[1], dtype=channel_perm.dtype)), \
+            f'shift{n_dims}d_func(): expected channel_perm to be a permutation of 0..{input.shape[1] - 1}'
+        _mark_checked(channel_perm)
+    return channel_perm.to(device=input.device, dtype=torch.long)
+
+def _move_channels(input: Tensor, channel_dim: int, memory_format: Optional[torch.memory_format],
+                   n_dims: int) -> Tuple[Tensor, int, Optional[torch.memory_format]]:
+    # channels at another axis(tokens [N, L, C], [N, H, W, C], ...): op gets a [N, C, *spatial] view with channels innermost
+    # and keeps that layout for the output, so neither side is copied by a transpose
+    assert -input.dim() < channel_dim < input.dim() and channel_dim not in (0, -input.dim()), \
+        f'shift{n_dims}d_func(): expected channel_dim to be a non batch axis of {input.dim()}D input, but got {channel_dim}'
+    channel_dim = channel_dim % input.dim()
+    if channel_dim == 1:
+        return input, channel_dim, memory_format
+    return input.movedim(channel_dim, 1), channel_dim, torch.preserve_format if memory_format is None else memory_format
+
 def shift1d_func(input: Tensor, weights: Tensor,
-                 padding_mode: int, active_flag: bool) -> Tensor:
+                 padding_mode: int, active_flag: bool,
+                 stride: Union[int, Sequence[int]] = 1,
+                 dilation: Union[int, Sequence[int]] = 1,
+                 memory_format: Optional[torch.memory_format] = None,
+                 channel_perm: Optional[Tensor] = None,
+                 channel_dim: int = 1,
+                 sparsity: float = 0.) -> Tensor:
     """
         Performs shift operation on 1D tensor
         Arguments:
             input (Tensor[N, C, H]): input 3D tensor
-            weights (Tensor[C, 1]): tensor contained shift(amount(abs) and direction(sign)) value for each channel of 1D tensor
+            weights (Tensor[C, 1] or Tensor[N, C, 1]): tensor contained shift(amount(abs) and direction(sign)) value for each channel of 1D tensor, optionally per sample
             padding_mode (int): padding applyed during shift. Allowed following modes: 0 - zeros, 
                                                                                        1 - border,
                                                                                        2 - periodic, 
@@ -17,25 +76,51 @@ def shift1d_func(input: Tensor, weights: Tensor,
                                                                                        4 - symmetric
             active_flag (bool): if true - the active shift(via billinear interpolation) will used on forward pass.
                                 This option has no effect if input is Quantized tensor.
+            stride (int or tuple of 1 int): step of the output grid, output keeps every stride-th position of each spatial axis
+                                         (X_out = ceil(X / stride)). Default: 1
+            dilation (int or tuple of 1 int): multiplier applied to the shift values of each spatial axis. Default: 1
+            memory_format (torch.memory_format, optional): layout of the output, the layout conversion is done by the shift kernel
+                                                          itself(e.g. NCHW input -> torch.channels_last output).
+                                                          torch.preserve_format keeps the input layout. Default: None(contiguous)
+            channel_perm (Tensor[C], optional): permutation of output channels done by the shift itself:
+                                                output[:, channel_perm[c]] = shift(input)[:, c], e.g. channel_shuffle_perm(C, groups)
+                                                fuses ShuffleNet channel shuffle into the shift. Default: None
+            channel_dim (int): axis of channels, e.g. -1 for tokens [N, L, C] or [N, H, W, C]. Input is passed to the kernel
+                               as a view with channels innermost and output has the layout of input. Default: 1
+            sparsity (float): L1 term of the shifts, sparsity*sign(weights) is added to the weights gradient by the
+                              backward kernel(same gradient as the loss sparsity*sum(|weights|)). Default: 0
         Returns:
-            output (Tensor[N, C, H])
+            output (Tensor[N, C, H_out])
     """
     _assert_has_ops()
+    input, channel_dim, memory_format = _move_channels(input, channel_dim, memory_format, 1)
     assert padding_mode in [0,1,2,3,4], f'shift1d_func() expected padding_mode can be 0 - zeros, 1 - border, 2 - periodic, 3 - reflect, 4 - symmetric'
     assert len(input.shape) == 3, f'shift1d_func(): expected 3D tensor as input, but it is shape is {input.shape}'
     assert weights.shape[-1] == 1, f'shift1d_func(): expected [n_channels,1] tensor as weight, but it is shape is {weights.shape}'
-    assert input.shape[1] == weights.shape[0],  f'shift1d_func(): expected that input and weight have equal number of channels, but input have {input.shape[1]} and weight have {weights.shape[0]} channels.'
+    assert len(weights.shape) == 2 or (len(weights.shape) == 3 and weights.shape[0] == input.shape[0]), f'shift1d_func(): expected [n_channels,1] or [batch,n_channels,1] tensor as weight, but it is shape is {weights.shape}'
+    assert input.shape[1] == weights.shape[-2],  f'shift1d_func(): expected that input and weight have equal number of channels, but input have {input.shape[1]} and weight have {weights.shape[-2]} channels.'
     assert input.device == weights.device, f'shift1d_func(): expected input and weights to be on same device, but input is  on {input.device} and weights is on {weights.device}'
-    return torch.ops.torchshifts.shift1d(input, weights, padding_mode, active_flag)
+    stride = _param_list(stride, 1, 'stride')
+    dilation = _param_list(dilation, 1, 'dilation')
+    channel_perm = _channel_perm(channel_perm, input, 1)
+    output = torch.ops.torchshifts.shift1d(input, weights, padding_mode, active_flag, stride, dilation, memory_format, channel_perm,
+                                           float(sparsity))
+    return output if channel_dim == 1 else output.movedim(1, channel_dim)
 
 
 def shift2d_func(input: Tensor, weights: Tensor,
-                 padding_mode: int, active_flag: bool) -> Tensor:
+                 padding_mode: int, active_flag: bool,
+                 stride: Union[int, Sequence[int]] = 1,
+                 dilation: Union[int, Sequence[int]] = 1,
+                 memory_format: Optional[torch.memory_format] = None,
+                 channel_perm: Optional[Tensor] = None,
+                 channel_dim: int = 1,
+                 sparsity: float = 0.) -> Tensor:
     """
         Performs shift operation on 2D tensor
         Arguments:
             input (Tensor[N, C, H, W]): input 4D tensor
-            weights (Tensor[C, 2]): tensor contained 2 shift(amount(abs) and direction(sign)) values(for H and W axes) for each channel of 2D tensor.
+            weights (Tensor[C, 2] or Tensor[N, C, 2]): tensor contained 2 shift(amount(abs) and direction(sign)) values(for H and W axes) for each channel of 2D tensor, optionally per sample.
             padding_mode (int): padding applyed during shift. Allowed following modes: 0 - zeros, 
                                                                                        1 - border,
                                                                                        2 - periodic, 
@@ -43,24 +128,50 @@ def shift2d_func(input: Tensor, weights: Tensor,
                                                                                        4 - symmetric
             active_flag (bool): if true - the active shift(via billinear interpolation) will used on forward pass.
                                 This option has no effect if input is Quantized tensor.
+            stride (int or tuple of 2 ints): step of the output grid, output keeps every stride-th position of each spatial axis
+                                         (X_out = ceil(X / stride)). Default: 1
+            dilation (int or tuple of 2 ints): multiplier applied to the shift values of each spatial axis. Default: 1
+            memory_format (torch.memory_format, optional): layout of the output, the layout conversion is done by the shift kernel
+                                                          itself(e.g. NCHW input -> torch.channels_last output).
+                                                          torch.preserve_format keeps the input layout. Default: None(contiguous)
+            channel_perm (Tensor[C], optional): permutation of output channels done by the shift itself:
+                                                output[:, channel_perm[c]] = shift(input)[:, c], e.g. channel_shuffle_perm(C, groups)
+                                                fuses ShuffleNet channel shuffle into the shift. Default: None
+            channel_dim (int): axis of channels, e.g. -1 for tokens [N, L, C] or [N, H, W, C]. Input is passed to the kernel
+                               as a view with channels innermost and output has the layout of input. Default: 1
+            sparsity (float): L1 term of the shifts, sparsity*sign(weights) is added to the weights gradient by the
+                              backward kernel(same gradient as the loss sparsity*sum(|weights|)). Default: 0
         Returns:
-            output (Tensor[N, C, H. W])
+            output (Tensor[N, C, H_out, W_out])
     """
     _assert_has_ops()
+    input, channel_dim, memory_format = _move_channels(input, channel_dim, memory_format, 2)
     assert padding_mode in [0,1,2,3,4], f'shift2d_func() expected padding_mode can be 0 - zeros, 1 - border, 2 - periodic, 3 - reflect, 4 - symmetric'
     assert len(input.shape) == 4, f'shift2d_func(): expected 4D tensor as input, but it is shape is {input.shape}'
     assert weights.shape[-1] == 2, f'shift2d_func(): expected [n_channels,2] tensor as weight, but it is shape is {weights.shape}'
-    assert input.shape[1] == weights.shape[0],  f'shift2d_func(): expected that input and weight have equal number of channels, but input have {input.shape[1]} and weight have {weights.shape[0]} channels.'
+    assert len(weights.shape) == 2 or (len(weights.shape) == 3 and weights.shape[0] == input.shape[0]), f'shift2d_func(): expected [n_channels,2] or [batch,n_channels,2] tensor as weight, but it is shape is {weights.shape}'
+    assert input.shape[1] == weights.shape[-2],  f'shift2d_func(): expected that input and weight have equal number of channels, but input have {input.shape[1]} and weight have {weights.shape[-2]} channels.'
     assert input.device == weights.device, f'shift2d_func(): expected input and weights to be on same device, but input is  on {input.device} and weights is on {weights.device}'
-    return torch.ops.torchshifts.shift2d(input, weights, padding_mode, active_flag)
+    stride = _param_list(stride, 2, 'stride')
+    dilation = _param_list(dilation, 2, 'dilation')
+    channel_perm = _channel_perm(channel_perm, input, 2)
+    output = torch.ops.torchshifts.shift2d(input, weights, padding_mode, active_flag, stride, dilation, memory_format, channel_perm,
+                                           float(sparsity))
+    return output if channel_dim == 1 else output.movedim(1, channel_dim)
 
 def shift3d_func(input: Tensor, weights: Tensor,
-                 padding_mode: int, active_flag: bool) -> Tensor:
+                 padding_mode: int, active_flag: bool,
+                 stride: Union[int, Sequence[int]] = 1,
+                 dilation: Union[int, Sequence[int]] = 1,
+                 memory_format: Optional[torch.memory_format] = None,
+                 channel_perm: Optional[Tensor] = None,
+                 channel_dim: int = 1,
+                 sparsity: float = 0.) -> Tensor:
     """
         Performs shift operation on 3D tensor
         Arguments:
             input (Tensor[N, C, H, W, D]): input  5D tensor
-            weights (Tensor[C, 3]): tensor contained 3 shift(amount(abs) and direction(sign)) values(for H,W and D axes) for each channel of 3D tensor.
+            weights (Tensor[C, 3] or Tensor[N, C, 3]): tensor contained 3 shift(amount(abs) and direction(sign)) values(for H,W and D axes) for each channel of 3D tensor, optionally per sample.
             padding_mode (int): padding applyed during shift. Allowed following modes: 0 - zeros, 
                                                                                        1 - border,
                                                                                        2 - periodic, 
@@ -68,14 +179,583 @@ def shift3d_func(input: Tensor, weights: Tensor,
                                                                                        4 - symmetric
             active_flag (bool): if true - the active shift(via billinear interpolation) will used on forward pass.
                                 This option has no effect if input is Quantized tensor.
+            stride (int or tuple of 3 ints): step of the output grid, output keeps every stride-th position of each spatial axis
+                                         (X_out = ceil(X / stride)). Default: 1
+            dilation (int or tuple of 3 ints): multiplier applied to the shift values of each spatial axis. Default: 1
+            memory_format (torch.memory_format, optional): layout of the output, the layout conversion is done by the shift kernel
+                                                          itself(e.g. NCHW input -> torch.channels_last output).
+                                                          torch.preserve_format keeps the input layout. Default: None(contiguous)
+            channel_perm (Tensor[C], optional): permutation of output channels done by the shift itself:
+                                                output[:, channel_perm[c]] = shift(input)[:, c], e.g. channel_shuffle_perm(C, groups)
+                                                fuses ShuffleNet channel shuffle into the shift. Default: None
+            channel_dim (int): axis of channels, e.g. -1 for tokens [N, L, C] or [N, H, W, C]. Input is passed to the kernel
+                               as a view with channels innermost and output has the layout of input. Default: 1
+            sparsity (float): L1 term of the shifts, sparsity*sign(weights) is added to the weights gradient by the
+                              backward kernel(same gradient as the loss sparsity*sum(|weights|)). Default: 0
         Returns:
-            output (Tensor[N, C, H, W, D])
+            output (Tensor[N, C, H_out, W_out, D_out])
     """
     _assert_has_ops()
+    input, channel_dim, memory_format = _move_channels(input, channel_dim, memory_format, 3)
     assert padding_mode in [0,1,2,3,4], f'shift3d_func() expected padding_mode can be 0 - zeros, 1 - border, 2 - periodic, 3 - reflect, 4 - symmetric'
     assert len(input.shape) == 5, f'shift3d_func(): expected 5D tensor as input, but it is shape is {input.shape}'
     assert weights.shape[-1] == 3, f'shift3d_func(): expected [n_channels,3] tensor as weight, but it is shape is {weights.shape}'
-    assert input.shape[1] == weights.shape[0],  f'shift3d_func(): expected that input and weight have equal number of channels, but input have {input.shape[1]} and weight have {weights.shape[0]} channels.'
+    assert len(weights.shape) == 2 or (len(weights.shape) == 3 and weights.shape[0] == input.shape[0]), f'shift3d_func(): expected [n_channels,3] or [batch,n_channels,3] tensor as weight, but it is shape is {weights.shape}'
+    assert input.shape[1] == weights.shape[-2],  f'shift3d_func(): expected that input and weight have equal number of channels, but input have {input.shape[1]} and weight have {weights.shape[-2]} channels.'
     assert input.device == weights.device, f'shift3d_func(): expected input and weights to be on same device, but input is  on {input.device} and weights is on {weights.device}'
-    return torch.ops.torchshifts.shift3d(input, weights, padding_mode, active_flag)
+    stride = _param_list(stride, 3, 'stride')
+    dilation = _param_list(dilation, 3, 'dilation')
+    channel_perm = _channel_perm(channel_perm, input, 3)
+    output = torch.ops.torchshifts.shift3d(input, weights, padding_mode, active_flag, stride, dilation, memory_format, channel_perm,
+                                           float(sparsity))
+    return output if channel_dim == 1 else output.movedim(1, channel_dim)
+
+
+def shift1d_accumulate_func(out: Tensor, input: Tensor, weights: Tensor,
+                            padding_mode: int, active_flag: bool,
+                            alpha: float = 1., beta: float = 1.,
+                            stride: Union[int, Sequence[int]] = 1,
+                            dilation: Union[int, Sequence[int]] = 1) -> Tensor:
+    """
+        Computes out = beta*out + alpha*shift1d_func(input, ...) in one pass, out is modified in-place.
+        Intended for adding shifted features to a residual stream without the intermediate tensor.
+        Arguments:
+            out (Tensor[N, C, H_out]): accumulation buffer, must not overlap with input
+            alpha (float): scale of shifted input. Default: 1
+            beta (float): scale of out, with beta=0 out is overwritten(and never read). Default: 1
+            Other arguments are the same as for shift1d_func
+        Returns:
+            out
+    """
+    _assert_has_ops()
+    assert padding_mode in [0,1,2,3,4], f'shift1d_accumulate_func() expected padding_mode can be 0 - zeros, 1 - border, 2 - periodic, 3 - reflect, 4 - symmetric'
+    assert len(input.shape) == 3, f'shift1d_accumulate_func(): expected 3D tensor as input, but it is shape is {input.shape}'
+    assert weights.shape[-1] == 1, f'shift1d_accumulate_func(): expected [n_channels,1] tensor as weight, but it is shape is {weights.shape}'
+    assert len(weights.shape) == 2 or (len(weights.shape) == 3 and weights.shape[0] == input.shape[0]), f'shift1d_accumulate_func(): expected [n_channels,1] or [batch,n_channels,1] tensor as weight, but it is shape is {weights.shape}'
+    assert input.shape[1] == weights.shape[-2],  f'shift1d_accumulate_func(): expected that input and weight have equal number of channels, but input have {input.shape[1]} and weight have {weights.shape[-2]} channels.'
+    assert input.device == weights.device == out.device, f'shift1d_accumulate_func(): expected out, input and weights to be on same device'
+    stride = _param_list(stride, 1, 'stride')
+    dilation = _param_list(dilation, 1, 'dilation')
+    return torch.ops.torchshifts.shift1d_accumulate_(out, input, weights, padding_mode, active_flag,
+                                                      float(alpha), float(beta), stride, dilation)
+
+
+def shift2d_accumulate_func(out: Tensor, input: Tensor, weights: Tensor,
+                            padding_mode: int, active_flag: bool,
+                            alpha: float = 1., beta: float = 1.,
+                            stride: Union[int, Sequence[int]] = 1,
+                            dilation: Union[int, Sequence[int]] = 1) -> Tensor:
+    """
+        Computes out = beta*out + alpha*shift2d_func(input, ...) in one pass, out is modified in-place.
+        Intended for adding shifted features to a residual stream without the intermediate tensor.
+        Arguments:
+            out (Tensor[N, C, H, W_out]): accumulation buffer, must not overlap with input
+            alpha (float): scale of shifted input. Default: 1
+            beta (float): scale of out, with beta=0 out is overwritten(and never read). Default: 1
+            Other arguments are the same as for shift2d_func
+        Returns:
+            out
+    """
+    _assert_has_ops()
+    assert padding_mode in [0,1,2,3,4], f'shift2d_accumulate_func() expected padding_mode can be 0 - zeros, 1 - border, 2 - periodic, 3 - reflect, 4 - symmetric'
+    assert len(input.shape) == 4, f'shift2d_accumulate_func(): expected 4D tensor as input, but it is shape is {input.shape}'
+    assert weights.shape[-1] == 2, f'shift2d_accumulate_func(): expected [n_channels,2] tensor as weight, but it is shape is {weights.shape}'
+    assert len(weights.shape) == 2 or (len(weights.shape) == 3 and weights.shape[0] == input.shape[0]), f'shift2d_accumulate_func(): expected [n_channels,2] or [batch,n_channels,2] tensor as weight, but it is shape is {weights.shape}'
+    assert input.shape[1] == weights.shape[-2],  f'shift2d_accumulate_func(): expected that input and weight have equal number of channels, but input have {input.shape[1]} and weight have {weights.shape[-2]} channels.'
+    assert input.device == weights.device == out.device, f'shift2d_accumulate_func(): expected out, input and weights to be on same device'
+    stride = _param_list(stride, 2, 'stride')
+    dilation = _param_list(dilation, 2, 'dilation')
+    return torch.ops.torchshifts.shift2d_accumulate_(out, input, weights, padding_mode, active_flag,
+                                                      float(alpha), float(beta), stride, dilation)
+
+
+def shift3d_accumulate_func(out: Tensor, input: Tensor, weights: Tensor,
+                            padding_mode: int, active_flag: bool,
+                            alpha: float = 1., beta: float = 1.,
+                            stride: Union[int, Sequence[int]] = 1,
+                            dilation: Union[int, Sequence[int]] = 1) -> Tensor:
+    """
+        Computes out = beta*out + alpha*shift3d_func(input, ...) in one pass, out is modified in-place.
+        Intended for adding shifted features to a residual stream without the intermediate tensor.
+        Arguments:
+            out (Tensor[N, C, H, W, D_out]): accumulation buffer, must not overlap with input
+            alpha (float): scale of shifted input. Default: 1
+            beta (float): scale of out, with beta=0 out is overwritten(and never read). Default: 1
+            Other arguments are the same as for shift3d_func
+        Returns:
+            out
+    """
+    _assert_has_ops()
+    assert padding_mode in [0,1,2,3,4], f'shift3d_accumulate_func() expected padding_mode can be 0 - zeros, 1 - border, 2 - periodic, 3 - reflect, 4 - symmetric'
+    assert len(input.shape) == 5, f'shift3d_accumulate_func(): expected 5D tensor as input, but it is shape is {input.shape}'
+    assert weights.shape[-1] == 3, f'shift3d_accumulate_func(): expected [n_channels,3] tensor as weight, but it is shape is {weights.shape}'
+    assert len(weights.shape) == 2 or (len(weights.shape) == 3 and weights.shape[0] == input.shape[0]), f'shift3d_accumulate_func(): expected [n_channels,3] or [batch,n_channels,3] tensor as weight, but it is shape is {weights.shape}'
+    assert input.shape[1] == weights.shape[-2],  f'shift3d_accumulate_func(): expected that input and weight have equal number of channels, but input have {input.shape[1]} and weight have {weights.shape[-2]} channels.'
+    assert input.device == weights.device == out.device, f'shift3d_accumulate_func(): expected out, input and weights to be on same device'
+    stride = _param_list(stride, 3, 'stride')
+    dilation = _param_list(dilation, 3, 'dilation')
+    return torch.ops.torchshifts.shift3d_accumulate_(out, input, weights, padding_mode, active_flag,
+                                                      float(alpha), float(beta), stride, dilation)
+
+
+def shift1d_multi_func(input: Tensor, weights: Tensor,
+                       padding_mode: int, active_flag: bool) -> Tensor:
+    """
+        Applies K shift sets to the same input and concatenates the results by channels,
+        equal to torch.cat([shift1d_func(input, w, padding_mode, active_flag) for w in weights], dim=1),
+        but the input is read once and each shifted copy is written directly to its slice of the output.
+        Arguments:
+            input (Tensor[N, C, H]): input 3D tensor
+            weights (Tensor[K, C, 1]): K sets of shifts
+            padding_mode (int), active_flag (bool): same as for shift1d_func
+        Returns:
+            output (Tensor[N, K*C, H])
+    """
+    _assert_has_ops()
+    assert padding_mode in [0,1,2,3,4], f'shift1d_multi_func() expected padding_mode can be 0 - zeros, 1 - border, 2 - periodic, 3 - reflect, 4 - symmetric'
+    assert len(input.shape) == 3, f'shift1d_multi_func(): expected 3D tensor as input, but it is shape is {input.shape}'
+    assert len(weights.shape) == 3 and weights.shape[-1] == 1, f'shift1d_multi_func(): expected [n_sets,n_channels,1] tensor as weight, but it is shape is {weights.shape}'
+    assert input.shape[1] == weights.shape[1],  f'shift1d_multi_func(): expected that input and weight have equal number of channels, but input have {input.shape[1]} and weight have {weights.shape[1]} channels.'
+    assert input.device == weights.device, f'shift1d_multi_func(): expected input and weights to be on same device, but input is  on {input.device} and weights is on {weights.device}'
+    return torch.ops.torchshifts.shift1d_multi(input, weights, padding_mode, active_flag)
+
+
+def shift2d_multi_func(input: Tensor, weights: Tensor,
+                       padding_mode: int, active_flag: bool) -> Tensor:
+    """
+        Applies K shift sets to the same input and concatenates the results by channels,
+        equal to torch.cat([shift2d_func(input, w, padding_mode, active_flag) for w in weights], dim=1),
+        but the input is read once and each shifted copy is written directly to its slice of the output.
+        Arguments:
+            input (Tensor[N, C, H, W]): input 4D tensor
+            weights (Tensor[K, C, 2]): K sets of shifts
+            padding_mode (int), active_flag (bool): same as for shift2d_func
+        Returns:
+            output (Tensor[N, K*C, H, W])
+    """
+    _assert_has_ops()
+    assert padding_mode in [0,1,2,3,4], f'shift2d_multi_func() expected padding_mode can be 0 - zeros, 1 - border, 2 - periodic, 3 - reflect, 4 - symmetric'
+    assert len(input.shape) == 4, f'shift2d_multi_func(): expected 4D tensor as input, but it is shape is {input.shape}'
+    assert len(weights.shape) == 3 and weights.shape[-1] == 2, f'shift2d_multi_func(): expected [n_sets,n_channels,2] tensor as weight, but it is shape is {weights.shape}'
+    assert input.shape[1] == weights.shape[1],  f'shift2d_multi_func(): expected that input and weight have equal number of channels, but input have {input.shape[1]} and weight have {weights.shape[1]} channels.'
+    assert input.device == weights.device, f'shift2d_multi_func(): expected input and weights to be on same device, but input is  on {input.device} and weights is on {weights.device}'
+    return torch.ops.torchshifts.shift2d_multi(input, weights, padding_mode, active_flag)
+
+
+def shift3d_multi_func(input: Tensor, weights: Tensor,
+                       padding_mode: int, active_flag: bool) -> Tensor:
+    """
+        Applies K shift sets to the same input and concatenates the results by channels,
+        equal to torch.cat([shift3d_func(input, w, padding_mode, active_flag) for w in weights], dim=1),
+        but the input is read once and each shifted copy is written directly to its slice of the output.
+        Arguments:
+            input (Tensor[N, C, H, W, D]): input 5D tensor
+            weights (Tensor[K, C, 3]): K sets of shifts
+            padding_mode (int), active_flag (bool): same as for shift3d_func
+        Returns:
+            output (Tensor[N, K*C, H, W, D])
+    """
+    _assert_has_ops()
+    assert padding_mode in [0,1,2,3,4], f'shift3d_multi_func() expected padding_mode can be 0 - zeros, 1 - border, 2 - periodic, 3 - reflect, 4 - symmetric'
+    assert len(input.shape) == 5, f'shift3d_multi_func(): expected 5D tensor as input, but it is shape is {input.shape}'
+    assert len(weights.shape) == 3 and weights.shape[-1] == 3, f'shift3d_multi_func(): expected [n_sets,n_channels,3] tensor as weight, but it is shape is {weights.shape}'
+    assert input.shape[1] == weights.shape[1],  f'shift3d_multi_func(): expected that input and weight have equal number of channels, but input have {input.shape[1]} and weight have {weights.shape[1]} channels.'
+    assert input.device == weights.device, f'shift3d_multi_func(): expected input and weights to be on same device, but input is  on {input.device} and weights is on {weights.device}'
+    return torch.ops.torchshifts.shift3d_multi(input, weights, padding_mode, active_flag)
+
+
+def shift1d_blocked_func(input: Tensor, weights: Tensor,
+                         padding_mode: int, active_flag: bool,
+                         stride: Union[int, Sequence[int]] = 1,
+                         dilation: Union[int, Sequence[int]] = 1) -> Tensor:
+    """
+        shift1d_func for channel blocked layout(oneDNN nCw8c/nCw16c style, blocks of b channels, e.g. b = 8 or 16),
+        output has the same layout, so no reorders are needed around blocked convolutions.
+        Arguments:
+            input (Tensor[N, ceil(C/b), H, b]): input tensor, channel c is input[:, c // b, ..., c % b]
+            weights (Tensor[C, 1]): shifts, channels of the last block above C are not shifted
+            Other arguments are the same as for shift1d_func
+        Returns:
+            output (Tensor[N, ceil(C/b), H_out, b])
+    """
+    _assert_has_ops()
+    assert padding_mode in [0,1,2,3,4], f'shift1d_blocked_func() expected padding_mode can be 0 - zeros, 1 - border, 2 - periodic, 3 - reflect, 4 - symmetric'
+    assert len(input.shape) == 4, f'shift1d_blocked_func(): expected 4D tensor as input, but it is shape is {input.shape}'
+    assert len(weights.shape) == 2 and weights.shape[-1] == 1, f'shift1d_blocked_func(): expected [n_channels,1] tensor as weight, but it is shape is {weights.shape}'
+    assert (input.shape[1] - 1)*input.shape[-1] < weights.shape[0] <= input.shape[1]*input.shape[-1], f'shift1d_blocked_func(): {weights.shape[0]} channels do not fit {input.shape[1]} blocks of {input.shape[-1]}'
+    assert input.device == weights.device, f'shift1d_blocked_func(): expected input and weights to be on same device, but input is  on {input.device} and weights is on {weights.device}'
+    stride = _param_list(stride, 1, 'stride')
+    dilation = _param_list(dilation, 1, 'dilation')
+    return torch.ops.torchshifts.shift1d_blocked(input, weights, padding_mode, active_flag, stride, dilation)
+
+
+def shift2d_blocked_func(input: Tensor, weights: Tensor,
+                         padding_mode: int, active_flag: bool,
+                         stride: Union[int, Sequence[int]] = 1,
+                         dilation: Union[int, Sequence[int]] = 1) -> Tensor:
+    """
+        shift2d_func for channel blocked layout(oneDNN nChw8c/nChw16c style, blocks of b channels, e.g. b = 8 or 16),
+        output has the same layout, so no reorders are needed around blocked convolutions.
+        Arguments:
+            input (Tensor[N, ceil(C/b), H, W, b]): input tensor, channel c is input[:, c // b, ..., c % b]
+            weights (Tensor[C, 2]): shifts, channels of the last block above C are not shifted
+            Other arguments are the same as for shift2d_func
+        Returns:
+            output (Tensor[N, ceil(C/b), H_out, W_out, b])
+    """
+    _assert_has_ops()
+    assert padding_mode in [0,1,2,3,4], f'shift2d_blocked_func() expected padding_mode can be 0 - zeros, 1 - border, 2 - periodic, 3 - reflect, 4 - symmetric'
+    assert len(input.shape) == 5, f'shift2d_blocked_func(): expected 5D tensor as input, but it is shape is {input.shape}'
+    assert len(weights.shape) == 2 and weights.shape[-1] == 2, f'shift2d_blocked_func(): expected [n_channels,2] tensor as weight, but it is shape is {weights.shape}'
+    assert (input.shape[1] - 1)*input.shape[-1] < weights.shape[0] <= input.shape[1]*input.shape[-1], f'shift2d_blocked_func(): {weights.shape[0]} channels do not fit {input.shape[1]} blocks of {input.shape[-1]}'
+    assert input.device == weights.device, f'shift2d_blocked_func(): expected input and weights to be on same device, but input is  on {input.device} and weights is on {weights.device}'
+    stride = _param_list(stride, 2, 'stride')
+    dilation = _param_list(dilation, 2, 'dilation')
+    return torch.ops.torchshifts.shift2d_blocked(input, weights, padding_mode, active_flag, stride, dilation)
+
+
+def shift3d_blocked_func(input: Tensor, weights: Tensor,
+                         padding_mode: int, active_flag: bool,
+                         stride: Union[int, Sequence[int]] = 1,
+                         dilation: Union[int, Sequence[int]] = 1) -> Tensor:
+    """
+        shift3d_func for channel blocked layout(oneDNN nCdhw8c/nCdhw16c style, blocks of b channels, e.g. b = 8 or 16),
+        output has the same layout, so no reorders are needed around blocked convolutions.
+        Arguments:
+            input (Tensor[N, ceil(C/b), H, W, D, b]): input tensor, channel c is input[:, c // b, ..., c % b]
+            weights (Tensor[C, 3]): shifts, channels of the last block above C are not shifted
+            Other arguments are the same as for shift3d_func
+        Returns:
+            output (Tensor[N, ceil(C/b), H_out, W_out, D_out, b])
+    """
+    _assert_has_ops()
+    assert padding_mode in [0,1,2,3,4], f'shift3d_blocked_func() expected padding_mode can be 0 - zeros, 1 - border, 2 - periodic, 3 - reflect, 4 - symmetric'
+    assert len(input.shape) == 6, f'shift3d_blocked_func(): expected 6D tensor as input, but it is shape is {input.shape}'
+    assert len(weights.shape) == 2 and weights.shape[-1] == 3, f'shift3d_blocked_func(): expected [n_channels,3] tensor as weight, but it is shape is {weights.shape}'
+    assert (input.shape[1] - 1)*input.shape[-1] < weights.shape[0] <= input.shape[1]*input.shape[-1], f'shift3d_blocked_func(): {weights.shape[0]} channels do not fit {input.shape[1]} blocks of {input.shape[-1]}'
+    assert input.device == weights.device, f'shift3d_blocked_func(): expected input and weights to be on same device, but input is  on {input.device} and weights is on {weights.device}'
+    stride = _param_list(stride, 3, 'stride')
+    dilation = _param_list(dilation, 3, 'dilation')
+    return torch.ops.torchshifts.shift3d_blocked(input, weights, padding_mode, active_flag, stride, dilation)
+
+
+def pack_samples(samples: Union[Tensor, Sequence[Tensor]]) -> Tuple[Tensor, Tensor]:
+    """
+        Packs samples of different spatial sizes for shift{1,2,3}d_packed_func.
+        Arguments:
+            samples (nested Tensor or sequence of Tensor[C, *spatial_n]): samples with equal number of channels
+        Returns:
+            packed (Tensor[sum(C*prod(spatial_n))]): samples flattened one after another
+            sizes (LongTensor[N, dim]): spatial sizes of the samples, on CPU
+    """
+    samples = samples.unbind() if isinstance(samples, Tensor) else list(samples)
+    assert len(samples) > 0, 'pack_samples(): expected at least one sample'
+    sizes = torch.tensor([list(t.shape[1:]) for t in samples], dtype=torch.long)
+    return torch.cat([t.reshape(-1) for t in samples]), sizes
+
 
+def unpack_samples(packed: Tensor, sizes: Tensor, n_channels: int) -> List[Tensor]:
+    """
+        Inverse of pack_samples: views of packed as Tensor[C, *spatial_n] samples
+        (use torch.nested.as_nested_tensor to get a nested tensor).
+    """
+    shapes = [[n_channels] + s for s in sizes.tolist()]
+    numels = [int(torch.tensor(shape).prod()) for shape in shapes]
+    return [t.view(shape) for t, shape in zip(packed.split(numels), shapes)]
+
+
+def shift1d_packed_func(input: Tensor, sizes: Tensor, weights: Tensor,
+                        padding_mode: int, active_flag: bool) -> Tensor:
+    """
+        shift1d_func for a batch of samples with different spatial sizes in a single call,
+        no padding of samples to the largest one: padding_mode is applied at the borders of every sample.
+        Arguments:
+            input (Tensor[L]): packed samples, see pack_samples
+            sizes (LongTensor[N, 1]): spatial sizes of the samples, on CPU
+            weights (Tensor[C, 1]): shifts shared by all samples
+            padding_mode (int), active_flag (bool): same as for shift1d_func
+        Returns:
+            output (Tensor[L]): packed shifted samples, see unpack_samples
+    """
+    _assert_has_ops()
+    assert padding_mode in [0,1,2,3,4], f'shift1d_packed_func() expected padding_mode can be 0 - zeros, 1 - border, 2 - periodic, 3 - reflect, 4 - symmetric'
+    assert len(input.shape) == 1, f'shift1d_packed_func(): expected flat packed tensor as input, but it is shape is {input.shape}'
+    assert len(sizes.shape) == 2 and sizes.shape[-1] == 1, f'shift1d_packed_func(): expected [n_samples,1] tensor as sizes, but it is shape is {sizes.shape}'
+    assert len(weights.shape) == 2 and weights.shape[-1] == 1, f'shift1d_packed_func(): expected [n_channels,1] tensor as weight, but it is shape is {weights.shape}'
+    assert input.device == weights.device, f'shift1d_packed_func(): expected input and weights to be on same device, but input is  on {input.device} and weights is on {weights.device}'
+    return torch.ops.torchshifts.shift1d_packed(input, sizes.to(device='cpu', dtype=torch.long), weights, padding_mode, active_flag)
+
+
+def shift2d_packed_func(input: Tensor, sizes: Tensor, weights: Tensor,
+                        padding_mode: int, active_flag: bool) -> Tensor:
+    """
+        shift2d_func for a batch of samples with different spatial sizes in a single call,
+        no padding of samples to the largest one: padding_mode is applied at the borders of every sample.
+        Arguments:
+            input (Tensor[L]): packed samples, see pack_samples
+            sizes (LongTensor[N, 2]): spatial sizes of the samples, on CPU
+            weights (Tensor[C, 2]): shifts shared by all samples
+            padding_mode (int), active_flag (bool): same as for shift2d_func
+        Returns:
+            output (Tensor[L]): packed shifted samples, see unpack_samples
+    """
+    _assert_has_ops()
+    assert padding_mode in [0,1,2,3,4], f'shift2d_packed_func() expected padding_mode can be 0 - zeros, 1 - border, 2 - periodic, 3 - reflect, 4 - symmetric'
+    assert len(input.shape) == 1, f'shift2d_packed_func(): expected flat packed tensor as input, but it is shape is {input.shape}'
+    assert len(sizes.shape) == 2 and sizes.shape[-1] == 2, f'shift2d_packed_func(): expected [n_samples,2] tensor as sizes, but it is shape is {sizes.shape}'
+    assert len(weights.shape) == 2 and weights.shape[-1] == 2, f'shift2d_packed_func(): expected [n_channels,2] tensor as weight, but it is shape is {weights.shape}'
+    assert input.device == weights.device, f'shift2d_packed_func(): expected input and weights to be on same device, but input is  on {input.device} and weights is on {weights.device}'
+    return torch.ops.torchshifts.shift2d_packed(input, sizes.to(device='cpu', dtype=torch.long), weights, padding_mode, active_flag)
+
+
+def shift3d_packed_func(input: Tensor, sizes: Tensor, weights: Tensor,
+                        padding_mode: int, active_flag: bool) -> Tensor:
+    """
+        shift3d_func for a batch of samples with different spatial sizes in a single call,
+        no padding of samples to the largest one: padding_mode is applied at the borders of every sample.
+        Arguments:
+            input (Tensor[L]): packed samples, see pack_samples
+            sizes (LongTensor[N, 3]): spatial sizes of the samples, on CPU
+            weights (Tensor[C, 3]): shifts shared by all samples
+            padding_mode (int), active_flag (bool): same as for shift3d_func
+        Returns:
+            output (Tensor[L]): packed shifted samples, see unpack_samples
+    """
+    _assert_has_ops()
+    assert padding_mode in [0,1,2,3,4], f'shift3d_packed_func() expected padding_mode can be 0 - zeros, 1 - border, 2 - periodic, 3 - reflect, 4 - symmetric'
+    assert len(input.shape) == 1, f'shift3d_packed_func(): expected flat packed tensor as input, but it is shape is {input.shape}'
+    assert len(sizes.shape) == 2 and sizes.shape[-1] == 3, f'shift3d_packed_func(): expected [n_samples,3] tensor as sizes, but it is shape is {sizes.shape}'
+    assert len(weights.shape) == 2 and weights.shape[-1] == 3, f'shift3d_packed_func(): expected [n_channels,3] tensor as weight, but it is shape is {weights.shape}'
+    assert input.device == weights.device, f'shift3d_packed_func(): expected input and weights to be on same device, but input is  on {input.device} and weights is on {weights.device}'
+    return torch.ops.torchshifts.shift3d_packed(input, sizes.to(device='cpu', dtype=torch.long), weights, padding_mode, active_flag)
+
+
+def sparsity_l1_grad(weights: Tensor, sparsity: float) -> Tensor:
+    """
+        Returns weights unchanged(a view, no copy), but on backward sparsity*sign(weights) is added to their gradient.
+        Same gradient as adding the L1 loss sparsity*sum(|weights|), without computing the loss. shift{1,2,3}d_func take
+        the sparsity argument instead(added inside their backward), this one is for the grouped and low memory functions.
+    """
+    _assert_has_ops()
+    return torch.ops.torchshifts._sparsity_l1(weights, float(sparsity))
+
+
+def contiguous_groups(n_channels: int, n_groups: int) -> Tensor:
+    """
+        Channel to group mapping for grouped shifts with contiguous blocks of channels:
+        group g holds channels g*C/G...(g+1)*C/G-1(sizes differ by at most one if G does not divide C).
+    """
+    assert 0 < n_groups <= n_channels, f'contiguous_groups(): expected 0 < n_groups <= n_channels, but got {n_groups} groups for {n_channels} channels'
+    return torch.arange(n_channels, dtype=torch.long) * n_groups // n_channels
+
+
+def shift1d_grouped_func(input: Tensor, weights: Tensor, groups: Tensor,
+                         padding_mode: int, active_flag: bool,
+                         stride: Union[int, Sequence[int]] = 1,
+                         dilation: Union[int, Sequence[int]] = 1) -> Tensor:
+    """
+        shift1d_func with shifts shared by groups of channels(GroupedShift),
+        equal to shift1d_func(input, weights[groups], ...), gradient w.r.t. weights is reduced per group.
+        Arguments:
+            weights (Tensor[G, 1]): shifts of the groups
+            groups (LongTensor[C]): group of every channel, contiguous blocks(see contiguous_groups) or any other mapping
+            Other arguments are the same as for shift1d_func
+    """
+    _assert_has_ops()
+    assert padding_mode in [0,1,2,3,4], f'shift1d_grouped_func() expected padding_mode can be 0 - zeros, 1 - border, 2 - periodic, 3 - reflect, 4 - symmetric'
+    assert len(input.shape) == 3, f'shift1d_grouped_func(): expected 3D tensor as input, but it is shape is {input.shape}'
+    assert len(weights.shape) == 2 and weights.shape[-1] == 1, f'shift1d_grouped_func(): expected [n_groups,1] tensor as weight, but it is shape is {weights.shape}'
+    assert groups.shape == (input.shape[1],), f'shift1d_grouped_func(): expected [n_channels] tensor as groups, but it is shape is {groups.shape}'
+    assert input.device == weights.device, f'shift1d_grouped_func(): expected input and weights to be on same device, but input is  on {input.device} and weights is on {weights.device}'
+    stride = _param_list(stride, 1, 'stride')
+    dilation = _param_list(dilation, 1, 'dilation')
+    return torch.ops.torchshifts.shift1d_grouped(input, weights, groups.to(device=weights.device, dtype=torch.long),
+                                                  padding_mode, active_flag, stride, dilation)
+
+
+def shift2d_grouped_func(input: Tensor, weights: Tensor, groups: Tensor,
+                         padding_mode: int, active_flag: bool,
+                         stride: Union[int, Sequence[int]] = 1,
+                         dilation: Union[int, Sequence[int]] = 1) -> Tensor:
+    """
+        shift2d_func with shifts shared by groups of channels(GroupedShift),
+        equal to shift2d_func(input, weights[groups], ...), gradient w.r.t. weights is reduced per group.
+        Arguments:
+            weights (Tensor[G, 2]): shifts of the groups
+            groups (LongTensor[C]): group of every channel, contiguous blocks(see contiguous_groups) or any other mapping
+            Other arguments are the same as for shift2d_func
+    """
+    _assert_has_ops()
+    assert padding_mode in [0,1,2,3,4], f'shift2d_grouped_func() expected padding_mode can be 0 - zeros, 1 - border, 2 - periodic, 3 - reflect, 4 - symmetric'
+    assert len(input.shape) == 4, f'shift2d_grouped_func(): expected 4D tensor as input, but it is shape is {input.shape}'
+    assert len(weights.shape) == 2 and weights.shape[-1] == 2, f'shift2d_grouped_func(): expected [n_groups,2] tensor as weight, but it is shape is {weights.shape}'
+    assert groups.shape == (input.shape[1],), f'shift2d_grouped_func(): expected [n_channels] tensor as groups, but it is shape is {groups.shape}'
+    assert input.device == weights.device, f'shift2d_grouped_func(): expected input and weights to be on same device, but input is  on {input.device} and weights is on {weights.device}'
+    stride = _param_list(stride, 2, 'stride')
+    dilation = _param_list(dilation, 2, 'dilation')
+    return torch.ops.torchshifts.shift2d_grouped(input, weights, groups.to(device=weights.device, dtype=torch.long),
+                                                  padding_mode, active_flag, stride, dilation)
+
+
+def shift3d_grouped_func(input: Tensor, weights: Tensor, groups: Tensor,
+                         padding_mode: int, active_flag: bool,
+                         stride: Union[int, Sequence[int]] = 1,
+                         dilation: Union[int, Sequence[int]] = 1) -> Tensor:
+    """
+        shift3d_func with shifts shared by groups of channels(GroupedShift),
+        equal to shift3d_func(input, weights[groups], ...), gradient w.r.t. weights is reduced per group.
+        Arguments:
+            weights (Tensor[G, 3]): shifts of the groups
+            groups (LongTensor[C]): group of every channel, contiguous blocks(see contiguous_groups) or any other mapping
+            Other arguments are the same as for shift3d_func
+    """
+    _assert_has_ops()
+    assert padding_mode in [0,1,2,3,4], f'shift3d_grouped_func() expected padding_mode can be 0 - zeros, 1 - border, 2 - periodic, 3 - reflect, 4 - symmetric'
+    assert len(input.shape) == 5, f'shift3d_grouped_func(): expected 5D tensor as input, but it is shape is {input.shape}'
+    assert len(weights.shape) == 2 and weights.shape[-1] == 3, f'shift3d_grouped_func(): expected [n_groups,3] tensor as weight, but it is shape is {weights.shape}'
+    assert groups.shape == (input.shape[1],), f'shift3d_grouped_func(): expected [n_channels] tensor as groups, but it is shape is {groups.shape}'
+    assert input.device == weights.device, f'shift3d_grouped_func(): expected input and weights to be on same device, but input is  on {input.device} and weights is on {weights.device}'
+    stride = _param_list(stride, 3, 'stride')
+    dilation = _param_list(dilation, 3, 'dilation')
+    return torch.ops.torchshifts.shift3d_grouped(input, weights, groups.to(device=weights.device, dtype=torch.long),
+                                                  padding_mode, active_flag, stride, dilation)
+
+
+saved_inputs_dict = {'full': 0, 'bf16': 1, 'int8': 2}
+
+
+def shift1d_lowmem_func(input: Tensor, weights: Tensor,
+                        padding_mode: int, active_flag: bool,
+                        saved_input: str = 'bf16',
+                        stride: Union[int, Sequence[int]] = 1,
+                        dilation: Union[int, Sequence[int]] = 1) -> Tensor:
+    """
+        shift1d_func which saves input for backward in compressed form(low memory training),
+        forward output is exactly the same, only gradient w.r.t. weights is affected by compression.
+        Arguments:
+            saved_input (str): 'bf16' - bfloat16(half of float32 memory),
+                               'int8' - int8 with per channel scale(quarter of float32 memory),
+                               'full' - same as shift1d_func
+            Other arguments are the same as for shift1d_func
+    """
+    _assert_has_ops()
+    assert padding_mode in [0,1,2,3,4], f'shift1d_lowmem_func() expected padding_mode can be 0 - zeros, 1 - border, 2 - periodic, 3 - reflect, 4 - symmetric'
+    assert saved_input in saved_inputs_dict, f'shift1d_lowmem_func(): expected saved_input to be one of {list(saved_inputs_dict)}, but got {saved_input}'
+    assert len(input.shape) == 3, f'shift1d_lowmem_func(): expected 3D tensor as input, but it is shape is {input.shape}'
+    assert weights.shape[-1] == 1, f'shift1d_lowmem_func(): expected [n_channels,1] tensor as weight, but it is shape is {weights.shape}'
+    assert len(weights.shape) == 2 or (len(weights.shape) == 3 and weights.shape[0] == input.shape[0]), f'shift1d_lowmem_func(): expected [n_channels,1] or [batch,n_channels,1] tensor as weight, but it is shape is {weights.shape}'
+    assert input.shape[1] == weights.shape[-2],  f'shift1d_lowmem_func(): expected that input and weight have equal number of channels, but input have {input.shape[1]} and weight have {weights.shape[-2]} channels.'
+    assert input.device == weights.device, f'shift1d_lowmem_func(): expected input and weights to be on same device, but input is  on {input.device} and weights is on {weights.device}'
+    stride = _param_list(stride, 1, 'stride')
+    dilation = _param_list(dilation, 1, 'dilation')
+    return torch.ops.torchshifts.shift1d_lowmem(input, weights, padding_mode, active_flag, saved_inputs_dict[saved_input],
+                                                stride, dilation)
+
+
+def shift2d_lowmem_func(input: Tensor, weights: Tensor,
+                        padding_mode: int, active_flag: bool,
+                        saved_input: str = 'bf16',
+                        stride: Union[int, Sequence[int]] = 1,
+                        dilation: Union[int, Sequence[int]] = 1) -> Tensor:
+    """
+        shift2d_func which saves input for backward in compressed form(low memory training),
+        forward output is exactly the same, only gradient w.r.t. weights is affected by compression.
+        Arguments:
+            saved_input (str): 'bf16' - bfloat16(half of float32 memory),
+                               'int8' - int8 with per channel scale(quarter of float32 memory),
+                               'full' - same as shift2d_func
+            Other arguments are the same as for shift2d_func
+    """
+    _assert_has_ops()
+    assert padding_mode in [0,1,2,3,4], f'shift2d_lowmem_func() expected padding_mode can be 0 - zeros, 1 - border, 2 - periodic, 3 - reflect, 4 - symmetric'
+    assert saved_input in saved_inputs_dict, f'shift2d_lowmem_func(): expected saved_input to be one of {list(saved_inputs_dict)}, but got {saved_input}'
+    assert len(input.shape) == 4, f'shift2d_lowmem_func(): expected 4D tensor as input, but it is shape is {input.shape}'
+    assert weights.shape[-1] == 2, f'shift2d_lowmem_func(): expected [n_channels,2] tensor as weight, but it is shape is {weights.shape}'
+    assert len(weights.shape) == 2 or (len(weights.shape) == 3 and weights.shape[0] == input.shape[0]), f'shift2d_lowmem_func(): expected [n_channels,2] or [batch,n_channels,2] tensor as weight, but it is shape is {weights.shape}'
+    assert input.shape[1] == weights.shape[-2],  f'shift2d_lowmem_func(): expected that input and weight have equal number of channels, but input have {input.shape[1]} and weight have {weights.shape[-2]} channels.'
+    assert input.device == weights.device, f'shift2d_lowmem_func(): expected input and weights to be on same device, but input is  on {input.device} and weights is on {weights.device}'
+    stride = _param_list(stride, 2, 'stride')
+    dilation = _param_list(dilation, 2, 'dilation')
+    return torch.ops.torchshifts.shift2d_lowmem(input, weights, padding_mode, active_flag, saved_inputs_dict[saved_input],
+                                                stride, dilation)
+
+
+def shift3d_lowmem_func(input: Tensor, weights: Tensor,
+                        padding_mode: int, active_flag: bool,
+                        saved_input: str = 'bf16',
+                        stride: Union[int, Sequence[int]] = 1,
+                        dilation: Union[int, Sequence[int]] = 1) -> Tensor:
+    """
+        shift3d_func which saves input for backward in compressed form(low memory training),
+        forward output is exactly the same, only gradient w.r.t. weights is affected by compression.
+        Arguments:
+            saved_input (str): 'bf16' - bfloat16(half of float32 memory),
+                               'int8' - int8 with per channel scale(quarter of float32 memory),
+                               'full' - same as shift3d_func
+            Other arguments are the same as for shift3d_func
+    """
+    _assert_has_ops()
+    assert padding_mode in [0,1,2,3,4], f'shift3d_lowmem_func() expected padding_mode can be 0 - zeros, 1 - border, 2 - periodic, 3 - reflect, 4 - symmetric'
+    assert saved_input in saved_inputs_dict, f'shift3d_lowmem_func(): expected saved_input to be one of {list(saved_inputs_dict)}, but got {saved_input}'
+    assert len(input.shape) == 5, f'shift3d_lowmem_func(): expected 5D tensor as input, but it is shape is {input.shape}'
+    assert weights.shape[-1] == 3, f'shift3d_lowmem_func(): expected [n_channels,3] tensor as weight, but it is shape is {weights.shape}'
+    assert len(weights.shape) == 2 or (len(weights.shape) == 3 and weights.shape[0] == input.shape[0]), f'shift3d_lowmem_func(): expected [n_channels,3] or [batch,n_channels,3] tensor as weight, but it is shape is {weights.shape}'
+    assert input.shape[1] == weights.shape[-2],  f'shift3d_lowmem_func(): expected that input and weight have equal number of channels, but input have {input.shape[1]} and weight have {weights.shape[-2]} channels.'
+    assert input.device == weights.device, f'shift3d_lowmem_func(): expected input and weights to be on same device, but input is  on {input.device} and weights is on {weights.device}'
+    stride = _param_list(stride, 3, 'stride')
+    dilation = _param_list(dilation, 3, 'dilation')
+    return torch.ops.torchshifts.shift3d_lowmem(input, weights, padding_mode, active_flag, saved_inputs_dict[saved_input],
+                                                stride, dilation)
+
+
+def shift3d_sparse_func(features: Tensor, coords: Tensor, spatial_size: Sequence[int],
+                        weights: Tensor, active_flag: bool = False) -> Tensor:
+    """
+        shift3d_func for sparse voxel grids(e.g. voxelized point clouds): only occupied voxels are stored and processed,
+        cost scales with their number instead of the grid volume. Output is computed at the same voxels and equals
+        dense shift3d_func(Zeros padding) of the scattered features gathered back at them, gradients too.
+        CPU only.
+        Arguments:
+            features (Tensor[M, C]): features of occupied voxels
+            coords (LongTensor[M, 4]): (batch index, h, w, d) of every voxel, must be unique
+            spatial_size (list of 3 ints): grid size (H, W, D)
+            weights (Tensor[C, 3]): same as for shift3d_func
+            active_flag (bool): same as for shift3d_func
+        Returns:
+            output (Tensor[M, C])
+    """
+    _assert_has_ops()
+    assert len(features.shape) == 2, f'shift3d_sparse_func(): expected [n_voxels,n_channels] tensor as features, but it is shape is {features.shape}'
+    assert len(coords.shape) == 2 and coords.shape[0] == features.shape[0] and coords.shape[1] == 4, f'shift3d_sparse_func(): expected [n_voxels,4] tensor as coords, but it is shape is {coords.shape}'
+    assert len(weights.shape) == 2 and weights.shape[-1] == 3, f'shift3d_sparse_func(): expected [n_channels,3] tensor as weight, but it is shape is {weights.shape}'
+    assert features.shape[1] == weights.shape[0],  f'shift3d_sparse_func(): expected that features and weight have equal number of channels, but features have {features.shape[1]} and weight have {weights.shape[0]} channels.'
+    assert features.device == weights.device, f'shift3d_sparse_func(): expected features and weights to be on same device, but features is  on {features.device} and weights is on {weights.device}'
+    spatial_size = [int(s) for s in spatial_size]
+    assert len(spatial_size) == 3 and all(s > 0 for s in spatial_size), f'shift3d_sparse_func(): expected spatial_size of 3 positive ints, but got {spatial_size}'
+    return torch.ops.torchshifts.shift3d_sparse(features, coords.to(device=features.device, dtype=torch.long),
+                                                spatial_size, weights, active_flag)
+
+
+def shiftnd_func(input: Tensor, weights: Tensor,
+                 padding_mode: int, active_flag: bool) -> Tensor:
+    """
+        Performs shift operation on tensor with any number R of spatial axes(1 to 6), e.g. video [N, C, T, H, W]
+        or 4D light fields [N, C, U, V, H, W], in one pass instead of several shift3d_func calls over reshaped views.
+        CPU only.
+        Arguments:
+            input (Tensor[N, C, *spatial]): input tensor with R spatial axes
+            weights (Tensor[C, R] or Tensor[N, C, R]): shift values for each spatial axis of each channel, optionally per sample
+            padding_mode (int): same as for shift1d_func
+            active_flag (bool): if true - the active shift(via R-linear interpolation) will used on forward pass.
+        Returns:
+            output (Tensor[N, C, *spatial])
+    """
+    _assert_has_ops()
+    n_dims = len(input.shape) - 2
+    assert padding_mode in [0,1,2,3,4], f'shiftnd_func() expected padding_mode can be 0 - zeros, 1 - border, 2 - periodic, 3 - reflect, 4 - symmetric'
+    assert 1 <= n_dims <= 6, f'shiftnd_func(): expected tensor with 1 to 6 spatial axes as input, but it is shape is {input.shape}'
+    assert weights.shape[-1] == n_dims, f'shiftnd_func(): expected [n_channels,{n_dims}] tensor as weight, but it is shape is {weights.shape}'
+    assert len(weights.shape) == 2 or (len(weights.shape) == 3 and weights.shape[0] == input.shape[0]), f'shiftnd_func(): expected [n_channels,{n_dims}] or [batch,n_channels,{n_dims}] tensor as weight, but it is shape is {weights.shape}'
+    assert input.shape[1] == weights.shape[-2],  f'shiftnd_func(): expected that input and weight have equal number of channels, but input have {input.shape[1]} and weight have {weights.shape[-2]} channels.'
+    assert input.device == weights.device, f'shiftnd_func(): expected input and weights to be on same device, but input is  on {input.device} and weights is on {weights.device}'
+    return torch.ops.torchshifts.shiftnd(input, weights, padding_mode, active_flag)
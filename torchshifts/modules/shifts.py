@@ -1,6 +1,10 @@
 from torch import nn
 import torch
-from torchshifts.functional import shift1d_func, shift2d_func, shift3d_func
+from torchshifts.functional import shift1d_func, shift2d_func, shift3d_func, contiguous_groups
+from torchshifts.functional import shift1d_grouped_func, shift2d_grouped_func, shift3d_grouped_func
+from torchshifts.functional import shift1d_lowmem_func, shift2d_lowmem_func, shift3d_lowmem_func, saved_inputs_dict
+from torchshifts.functional import shift3d_sparse_func, sparsity_l1_grad, channel_shuffle_perm
+from torchshifts.recompute import remember_shift
 
 paddings_dict = {'zeros':0, 'border':1, 'periodic':2, 'reflect':3, 'symmetric':4}
 
@@ -14,42 +18,143 @@ class _Shiftnd(nn.Module):
             init_shift(float) - Border for uniform initialization of weights(shifts): [-init_stride;init_stride]. Default: 1.
             sparsity_term(float) - Strength of sparsity. Default: 5e-4.
             active_shift(bool) - Compute forward pass via bilinear interpolation. Default: False.
+            stride(int or tuple) - Step of the output grid, fuses downsampling into the shift. Default: 1.
+            dilation(int or tuple) - Multiplier of shift values along each axis. Default: 1.
+            groups(int) - Number of channel groups sharing one shift(GroupedShift), None - shift per channel. Default: None.
+            group_map(LongTensor[C]) - Group of every channel, contiguous blocks when None. Default: None.
+            saved_input(str) - Form of input saved for backward: 'full', 'bf16' or 'int8'(low memory training). Default: 'full'.
+            fused_sparsity(bool) - Add sparsity gradient directly in backward instead of returning loss(see sparsity_loss). Default: False.
+            memory_format(torch.memory_format) - Layout of the output(e.g. torch.channels_last for NCHW input), converted by the shift itself.
+                                                 None - contiguous output. Default: None.
+            channel_shuffle(int) - Number of groups of channel shuffle(ShuffleNet) fused into the shift output. Default: None.
+            channel_dim(int) - Axis of channels, e.g. -1 for tokens [N, L, C] or [N, H, W, C](no transposes around the shift). Default: 1.
     """
     def __init__(self, in_channels, padding='zeros',
                  init_shift = 1,
                  sparsity_term=5e-4,
-                 active_flag=False):
+                 active_flag=False,
+                 stride=1,
+                 dilation=1,
+                 groups=None,
+                 group_map=None,
+                 saved_input='full',
+                 fused_sparsity=False,
+                 memory_format=None,
+                 channel_shuffle=None,
+                 channel_dim=1):
         super(_Shiftnd, self).__init__()
         assert padding.lower() in paddings_dict.keys(), f'incorrect padding option: {padding}'
         self.padding = paddings_dict[padding]
         self.sparsity_term = sparsity_term
         self.in_channels = in_channels
+        self.groups = groups
+        if groups is not None:
+            group_map = contiguous_groups(in_channels, groups) if group_map is None else torch.as_tensor(group_map, dtype=torch.long)
+            assert group_map.shape == (in_channels,) and 0 <= int(group_map.min()) and int(group_map.max()) < groups, \
+                f'incorrect group_map for {in_channels} channels and {groups} groups'
+            self.register_buffer('group_map', group_map)
         self._init_weights(init_shift)
         self.__active_flag = active_flag
+        self.stride = stride
+        self.dilation = dilation
+        assert saved_input in saved_inputs_dict.keys(), f'incorrect saved_input option: {saved_input}'
+        self.saved_input = saved_input
+        self.fused_sparsity = fused_sparsity
+        assert memory_format is None or (groups is None and saved_input == 'full'), \
+            'memory_format is supported only by plain shift(no groups, full saved_input)'
+        self.memory_format = memory_format
+        assert channel_shuffle is None or (groups is None and saved_input == 'full'), \
+            'channel_shuffle is supported only by plain shift(no groups, full saved_input)'
+        self.channel_shuffle = channel_shuffle
+        assert channel_dim == 1 or (groups is None and saved_input == 'full'), \
+            'channel_dim is supported only by plain shift(no groups, full saved_input)'
+        self.channel_dim = channel_dim
+        self.register_buffer('channel_perm', None if channel_shuffle is None else channel_shuffle_perm(in_channels, channel_shuffle))
         self.__shift_func = self._init_shift_fn()
+        self.__grouped_shift_func = self._init_grouped_shift_fn()
+        self.__lowmem_shift_func = self._init_lowmem_shift_fn()
 
     def _init_shift_fn(self):
         raise NotImplemented
+
+    def _init_grouped_shift_fn(self):
+        raise NotImplemented
+
+    def _init_lowmem_shift_fn(self):
+        raise NotImplemented
         
     def _init_weights(self, init_shift):
-        self.weight = nn.Parameter(torch.Tensor(self.in_channels, self.dim))
+        self.weight = nn.Parameter(torch.Tensor(self.in_channels if self.groups is None else self.groups, self.dim))
         self.reset_parameters(init_shift)
 
     def reset_parameters(self, init_shift):
         self.weight.data.uniform_(-abs(init_shift), abs(init_shift))
     
+    def channel_weight(self):
+        """Per channel shifts [C, dim](weights of the groups spread to their channels in grouped mode)"""
+        return self.weight if self.groups is None else self.weight[self.group_map]
+
     def _compute_weight_loss(self):
         return self.sparsity_term * torch.sum(torch.abs(self.weight))
+
+    def _sparsity(self):
+        """(weights, sparsity passed to the shift op, loss)"""
+        # sparsity only affects training: eval forward is the plain shift and loss is None
+        if not (self.training and bool(self.sparsity_term)):
+            return self.weight, 0., None
+        if not self.fused_sparsity:
+            return self.weight, 0., self._compute_weight_loss()
+        if (self.saved_input == 'full') and (self.groups is None):
+            # added by the backward kernel of the shift itself
+            return self.weight, self.sparsity_term, None
+        return sparsity_l1_grad(self.weight, self.sparsity_term), 0., None
+
+    def sparsity_loss(self):
+        """Value of L1 sparsity loss on demand(e.g. for logging with fused_sparsity=True)"""
+        return self._compute_weight_loss()
                 
     def forward(self, input):
-        loss = self._compute_weight_loss() if bool(self.sparsity_term) else None
-        return self.__shift_func(input, self.weight, self.padding, self.__active_flag), loss
+        weight, sparsity, loss = self._sparsity()
+        if self.saved_input != 'full':
+            func = self.__lowmem_shift_func
+            weight = weight if self.groups is None else weight[self.group_map]
+            args = (self.padding, self.__active_flag, self.saved_input, self.stride, self.dilation)
+        elif self.groups is not None:
+            func = self.__grouped_shift_func
+            args = (self.group_map, self.padding, self.__active_flag, self.stride, self.dilation)
+        else:
+            func = self.__shift_func
+            args = (self.padding, self.__active_flag, self.stride, self.dilation, self.memory_format, self.channel_perm,
+                    self.channel_dim, sparsity)
+        output = func(input, weight, *args)
+        if self.saved_input == 'full':
+            # output can be recomputed in backward instead of being stored by next layer, see recompute_shifts
+            # (low memory modes save a compressed input, keeping the full one for the recipe would cost more)
+            output = remember_shift(output, func, input, weight, args)
+        return output, loss
     
     def extra_repr(self):
         pad = dict(zip(paddings_dict.values(),paddings_dict.keys()))[self.padding]
         active = f'Active shift on forward pass: {"Yes" if self.__active_flag else "No"}'
         sp = f'Sparse shift: {"Yes - sparsity strength: {}".format(self.sparsity_term) if bool(self.sparsity_term) else "No"}'
-        return f'in_channels={self.in_channels}, padding_method={pad}, {active}, {sp}'
+        s = f'in_channels={self.in_channels}, padding_method={pad}, {active}, {sp}'
+        if self.stride != 1:
+            s += f', stride={self.stride}'
+        if self.dilation != 1:
+            s += f', dilation={self.dilation}'
+        if self.groups is not None:
+            s += f', groups={self.groups}'
+        if self.saved_input != 'full':
+            s += f', saved_input={self.saved_input}'
+        if self.fused_sparsity:
+            s += ', fused_sparsity=True'
+        if self.memory_format is not None:
+            s += f', memory_format={self.memory_format}'
+        if self.channel_shuffle is not None:
+            s += f', channel_shuffle={self.channel_shuffle}'
+        if self.channel_dim != 1:
+            s += f', channel_dim={self.channel_dim}'
+        return s
 
 
     
@@ -71,14 +176,34 @@ class Shift1d(_Shiftnd):
             init_shift(float) - Border for uniform initialization of weights(shifts): [-init_stride;init_stride]. Default: 1.
             sparsity_term(float) - Strength of sparsity. Default: 5e-4.
             active_shift(bool) - Compute forward pass via bilinear interpolation. Default: False.
+            stride(int or tuple) - Step of the output grid, fuses downsampling into the shift. Default: 1.
+            dilation(int or tuple) - Multiplier of shift values along each axis. Default: 1.
+            groups(int) - Number of channel groups sharing one shift(GroupedShift), None - shift per channel. Default: None.
+            group_map(LongTensor[C]) - Group of every channel, contiguous blocks when None. Default: None.
+            saved_input(str) - Form of input saved for backward: 'full', 'bf16' or 'int8'(low memory training). Default: 'full'.
+            fused_sparsity(bool) - Add sparsity gradient directly in backward instead of returning loss(see sparsity_loss). Default: False.
+            memory_format(torch.memory_format) - Layout of the output(e.g. torch.channels_last for NCHW input), converted by the shift itself.
+                                                 None - contiguous output. Default: None.
+            channel_shuffle(int) - Number of groups of channel shuffle(ShuffleNet) fused into the shift output. Default: None.
+            channel_dim(int) - Axis of channels, e.g. -1 for tokens [N, L, C] or [N, H, W, C](no transposes around the shift). Default: 1.
     """
     def __init__(self, in_channels, padding='zeros',
-                 init_shift = 1, sparsity_term=5e-4, active_flag=False):
+                 init_shift = 1, sparsity_term=5e-4, active_flag=False,
+                 stride=1, dilation=1, groups=None, group_map=None, saved_input='full', fused_sparsity=False,
+                 memory_format=None, channel_shuffle=None, channel_dim=1):
         self.dim = 1
-        super(Shift1d, self).__init__(in_channels, padding, init_shift, sparsity_term, active_flag)
+        super(Shift1d, self).__init__(in_channels, padding, init_shift, sparsity_term, active_flag,
+                                      stride, dilation, groups, group_map, saved_input, fused_sparsity, memory_format,
+                                      channel_shuffle, channel_dim)
     
     def _init_shift_fn(self):
         return shift1d_func
+
+    def _init_grouped_shift_fn(self):
+        return shift1d_grouped_func
+
+    def _init_lowmem_shift_fn(self):
+        return shift1d_lowmem_func
     
 class Shift2d(_Shiftnd):
     """
@@ -98,14 +223,34 @@ class Shift2d(_Shiftnd):
             init_stride(float) - Border for uniform initialization of weights(shifts): [-init_stride;init_stride]. Default: 1.
             sparsity_term(float) - Strength of sparsity. Default: 5e-4.
             active_shift(bool) - Compute forward pass via bilinear interpolation. Default: False.
+            stride(int or tuple) - Step of the output grid, fuses downsampling into the shift. Default: 1.
+            dilation(int or tuple) - Multiplier of shift values along each axis. Default: 1.
+            groups(int) - Number of channel groups sharing one shift(GroupedShift), None - shift per channel. Default: None.
+            group_map(LongTensor[C]) - Group of every channel, contiguous blocks when None. Default: None.
+            saved_input(str) - Form of input saved for backward: 'full', 'bf16' or 'int8'(low memory training). Default: 'full'.
+            fused_sparsity(bool) - Add sparsity gradient directly in backward instead of returning loss(see sparsity_loss). Default: False.
+            memory_format(torch.memory_format) - Layout of the output(e.g. torch.channels_last for NCHW input), converted by the shift itself.
+                                                 None - contiguous output. Default: None.
+            channel_shuffle(int) - Number of groups of channel shuffle(ShuffleNet) fused into the shift output. Default: None.
+            channel_dim(int) - Axis of channels, e.g. -1 for tokens [N, L, C] or [N, H, W, C](no transposes around the shift). Default: 1.
     """
     def __init__(self, in_channels, padding='zeros',
-                 init_shift = 1, sparsity_term=5e-4, active_flag=False):
+                 init_shift = 1, sparsity_term=5e-4, active_flag=False,
+                 stride=1, dilation=1, groups=None, group_map=None, saved_input='full', fused_sparsity=False,
+                 memory_format=None, channel_shuffle=None, channel_dim=1):
         self.dim = 2
-        super(Shift2d, self).__init__(in_channels, padding, init_shift, sparsity_term, active_flag)
+        super(Shift2d, self).__init__(in_channels, padding, init_shift, sparsity_term, active_flag,
+                                      stride, dilation, groups, group_map, saved_input, fused_sparsity, memory_format,
+                                      channel_shuffle, channel_dim)
     
     def _init_shift_fn(self):
         return shift2d_func
+
+    def _init_grouped_shift_fn(self):
+        return shift2d_grouped_func
+
+    def _init_lowmem_shift_fn(self):
+        return shift2d_lowmem_func
     
 
 class Shift3d(_Shiftnd):
@@ -126,12 +271,45 @@ class Shift3d(_Shiftnd):
             init_stride(float) - Border for uniform initialization of weights(shifts): [-init_stride;init_stride]. Default: 1.
             sparsity_term(float) - Strength of sparsity. Default: 5e-4.
             active_shift(bool) - Compute forward pass via bilinear interpolation. Default: False.
+            stride(int or tuple) - Step of the output grid, fuses downsampling into the shift. Default: 1.
+            dilation(int or tuple) - Multiplier of shift values along each axis. Default: 1.
+            groups(int) - Number of channel groups sharing one shift(GroupedShift), None - shift per channel. Default: None.
+            group_map(LongTensor[C]) - Group of every channel, contiguous blocks when None. Default: None.
+            saved_input(str) - Form of input saved for backward: 'full', 'bf16' or 'int8'(low memory training). Default: 'full'.
+            fused_sparsity(bool) - Add sparsity gradient directly in backward instead of returning loss(see sparsity_loss). Default: False.
+            memory_format(torch.memory_format) - Layout of the output(e.g. torch.channels_last for NCHW input), converted by the shift itself.
+                                                 None - contiguous output. Default: None.
+            channel_shuffle(int) - Number of groups of channel shuffle(ShuffleNet) fused into the shift output. Default: None.
+            channel_dim(int) - Axis of channels, e.g. -1 for tokens [N, L, C] or [N, H, W, C](no transposes around the shift). Default: 1.
     """
     def __init__(self, in_channels, padding='zeros',
-                 init_shift = 1, sparsity_term=5e-4, active_flag=False):
+                 init_shift = 1, sparsity_term=5e-4, active_flag=False,
+                 stride=1, dilation=1, groups=None, group_map=None, saved_input='full', fused_sparsity=False,
+                 memory_format=None, channel_shuffle=None, channel_dim=1):
         self.dim = 3
-        super(Shift3d, self).__init__(in_channels, padding, init_shift, sparsity_term, active_flag)
+        super(Shift3d, self).__init__(in_channels, padding, init_shift, sparsity_term, active_flag,
+                                      stride, dilation, groups, group_map, saved_input, fused_sparsity, memory_format,
+                                      channel_shuffle, channel_dim)
     
     def _init_shift_fn(self):
         return shift3d_func
+
+    def _init_grouped_shift_fn(self):
+        return shift3d_grouped_func
+
+    def _init_lowmem_shift_fn(self):
+        return shift3d_lowmem_func
+
+    def forward_sparse(self, features, coords, spatial_size):
+        """
+            Same as forward for sparse voxel grid(CPU, zeros padding only), see shift3d_sparse_func.
+            features [M, C] and coords [M, 4](batch index, h, w, d) of occupied voxels, spatial_size (H, W, D).
+        """
+        assert self.padding == paddings_dict['zeros'], 'Shift3d.forward_sparse: only zeros padding is supported'
+        assert self.stride == 1 and self.dilation == 1, 'Shift3d.forward_sparse: stride and dilation are not supported'
+        weight, sparsity, loss = self._sparsity()
+        if sparsity:
+            weight = sparsity_l1_grad(weight, sparsity)
+        weight = weight if self.groups is None else weight[self.group_map]
+        return shift3d_sparse_func(features, coords, spatial_size, weight, self._Shiftnd__active_flag), loss
     
@@ -0,0 +1,243 @@
+'''
+    ONNX export of integer shifts: shift{1,2,3}d(and shift{1,2,3}d_grouped) are lowered to
+    Pad + Slice/Concat or Pad + GatherND, whichever needs fewer nodes. Shifts are read from the graph
+    at export time, so weights must be constants(see export_constants for Shift modules).
+'''
+import contextlib
+import torch
+from torch.onnx import symbolic_helper
+
+_INT_MAX = 2**63 - 1
+_INT_MIN = -2**63
+_ZEROS, _BORDER, _PERIODIC, _REFLECT, _SYMMETRIC = range(5)
+_PAD_MODES = {_ZEROS: 'constant', _BORDER: 'edge', _REFLECT: 'reflect'}
+_MIN_OPSET = 11
+# GatherND with batch_dims
+_GATHER_ND_OPSET = 12
+# Transpose + Reshape + GatherND + Reshape + Transpose
+_GATHER_ND_NODES = 5
+
+
+def _const(g, values):
+    return g.op('Constant', value_t=torch.tensor(values, dtype=torch.long))
+
+
+def _slice(g, x, axes, starts, ends, steps):
+    return g.op('Slice', x, _const(g, starts), _const(g, ends), _const(g, axes), _const(g, steps))
+
+
+def _pad_by_slices(g, x, axis, before, after, padding_mode):
+    # Periodic and Symmetric have no ONNX Pad mode(before opset 19): glue slices of x to its ends
+    parts = []
+    if before > 0:
+        if padding_mode == _PERIODIC:
+            parts.append(_slice(g, x, [axis], [-before], [_INT_MAX], [1]))
+        else:
+            parts.append(_slice(g, x, [axis], [before - 1], [_INT_MIN], [-1]))
+    parts.append(x)
+    if after > 0:
+        if padding_mode == _PERIODIC:
+            parts.append(_slice(g, x, [axis], [0], [after], [1]))
+        else:
+            parts.append(_slice(g, x, [axis], [-1], [-after - 1], [-1]))
+    return g.op('Concat', *parts, axis_i=axis) if len(parts) > 1 else x
+
+
+def _pad(g, x, n_dims, before, after, padding_mode):
+    if not any(before) and not any(after):
+        return x
+    if padding_mode in _PAD_MODES:
+        pads = [0, 0] + list(before) + [0, 0] + list(after)
+        return g.op('Pad', x, _const(g, pads), mode_s=_PAD_MODES[padding_mode])
+    for d in range(n_dims):
+        x = _pad_by_slices(g, x, d + 2, before[d], after[d], padding_mode)
+    return x
+
+
+def shift_plan(shifts, gather_nd=False):
+    """
+        Chooses the lowering which needs fewer nodes for the given per channel shifts.
+        Arguments:
+            shifts (list of tuples): integer shift of every channel
+            gather_nd (bool): GatherND lowering is available(static spatial sizes, opset >= 12)
+        Returns:
+            lowering (str): 'slices' or 'gather_nd'(one GatherND by precomputed indices, other outputs are None)
+            order (list or None): channel permutation applied before slicing(None - keep order)
+            inverse (list or None): permutation restoring the channel order after concatenation
+            runs (list of (c_begin, c_end, shift)): ranges of (reordered) channels sharing a shift, one Slice each
+    """
+    def make_runs(values):
+        runs = []
+        for c, s in enumerate(values):
+            if runs and runs[-1][2] == s:
+                runs[-1][1] = c + 1
+            else:
+                runs.append([c, c + 1, s])
+        return [tuple(r) for r in runs]
+
+    runs = make_runs(shifts)
+    n_distinct = len(set(shifts))
+    # in order: Slice per run + Concat; sorted: Gather + Slice per distinct shift + Concat + Gather
+    in_order_nodes = len(runs) + (len(runs) > 1)
+    sorted_nodes = n_distinct + (n_distinct > 1) + 2
+    if gather_nd and (_GATHER_ND_NODES < min(in_order_nodes, sorted_nodes)):
+        return 'gather_nd', None, None, None
+    if sorted_nodes >= in_order_nodes:
+        return 'slices', None, None, runs
+    order = sorted(range(len(shifts)), key=lambda c: shifts[c])
+    inverse = [0] * len(order)
+    for position, c in enumerate(order):
+        inverse[c] = position
+    return 'slices', order, inverse, make_runs([shifts[c] for c in order])
+
+
+def gather_nd_indices(shifts, before, padded_sizes, output_sizes, stride):
+    """
+        Flat positions in the padded plane read by every output position of every channel:
+        indices[c, q, 0] = ravel(out_pos(q)*stride + before - shifts[c]), shape [C, prod(output_sizes), 1]
+    """
+    grids = torch.meshgrid(*[torch.arange(o) * st for o, st in zip(output_sizes, stride)], indexing='ij')
+    shifts = torch.tensor(shifts, dtype=torch.long)
+    flat = torch.zeros(shifts.shape[0], 1, dtype=torch.long)
+    for d in range(len(output_sizes)):
+        flat = flat * padded_sizes[d] + (grids[d].reshape(1, -1) + before[d] - shifts[:, d:d + 1])
+    return flat.unsqueeze(-1)
+
+
+def _lower_gather_nd(g, x, shifts, n_dims, before, padded_sizes, output_sizes, stride):
+    # [N, C, *S] -> [C, prod(S), N]: channel is the batch axis of GatherND, so each channel has its own indices
+    n_channels = len(shifts)
+    x = g.op('Transpose', x, perm_i=list(range(1, n_dims + 2)) + [0])
+    x = g.op('Reshape', x, _const(g, [n_channels, _prod(padded_sizes), -1]))
+    indices = gather_nd_indices(shifts, before, padded_sizes, output_sizes, stride)
+    x = g.op('GatherND', x, g.op('Constant', value_t=indices), batch_dims_i=1)
+    x = g.op('Reshape', x, _const(g, [n_channels] + list(output_sizes) + [-1]))
+    return g.op('Transpose', x, perm_i=[n_dims + 1] + list(range(n_dims + 1)))
+
+
+def _prod(values):
+    result = 1
+    for v in values:
+        result *= v
+    return result
+
+
+def lower_shift(g, input, shifts, n_dims, padding_mode, stride):
+    """
+        Emits output[:, c, i, ...] = padded(input)[:, c, i*stride - shifts[c][0], ...] as ONNX nodes.
+        Shifts must be smaller than the spatial sizes for Reflect, Symmetric and Periodic paddings.
+    """
+    before = [max(0, max(s[d] for s in shifts)) for d in range(n_dims)]
+    after = [max(0, -min(s[d] for s in shifts)) for d in range(n_dims)]
+    x = _pad(g, input, n_dims, before, after, padding_mode)
+    # GatherND indices depend on the spatial sizes: only for inputs exported with static ones
+    sizes = symbolic_helper._get_tensor_sizes(input)
+    spatial = None if sizes is None else sizes[2:]
+    static = (spatial is not None) and (len(spatial) == n_dims) and all(isinstance(v, int) for v in spatial)
+    lowering, order, inverse, runs = shift_plan(shifts, gather_nd=static and (g.opset >= _GATHER_ND_OPSET))
+    if lowering == 'gather_nd':
+        padded_sizes = [spatial[d] + before[d] + after[d] for d in range(n_dims)]
+        output_sizes = [(spatial[d] + stride[d] - 1) // stride[d] for d in range(n_dims)]
+        return _lower_gather_nd(g, x, shifts, n_dims, before, padded_sizes, output_sizes, stride)
+    if order is not None:
+        x = g.op('Gather', x, _const(g, order), axis_i=1)
+    outputs = []
+    for c_begin, c_end, shift in runs:
+        axes, starts, ends, steps = [], [], [], []
+        if len(runs) > 1:
+            axes, starts, ends, steps = [1], [c_begin], [c_end], [1]
+        for d in range(n_dims):
+            start = before[d] - shift[d]
+            # exclusive end counted from the end of the padded axis, so spatial sizes may be dynamic
+            end_offset = after[d] + shift[d]
+            if start == 0 and end_offset == 0 and stride[d] == 1:
+                continue
+            axes.append(d + 2)
+            starts.append(start)
+            ends.append(-end_offset if end_offset > 0 else _INT_MAX)
+            steps.append(stride[d])
+        outputs.append(_slice(g, x, axes, starts, ends, steps) if axes else x)
+    output = g.op('Concat', *outputs, axis_i=1) if len(outputs) > 1 else outputs[0]
+    if inverse is not None:
+        output = g.op('Gather', output, _const(g, inverse), axis_i=1)
+    return output
+
+
+def _constant_shifts(weights, groups, n_dims, active_flag, dilation, op_name):
+    weights = symbolic_helper._maybe_get_const(weights, 't')
+    if not isinstance(weights, torch.Tensor):
+        raise RuntimeError(f'{op_name}: ONNX export needs constant weights, wrap the export in torchshifts.onnx.export_constants(model)')
+    if active_flag:
+        raise RuntimeError(f'{op_name}: ONNX export supports integer shifts only(active_flag=False)')
+    if weights.dim() != 2:
+        raise RuntimeError(f'{op_name}: ONNX export does not support per sample weights')
+    if groups is not None:
+        groups = symbolic_helper._maybe_get_const(groups, 't')
+        if not isinstance(groups, torch.Tensor):
+            raise RuntimeError(f'{op_name}: ONNX export needs constant groups')
+        weights = weights[groups.long()]
+    dilation = dilation * n_dims if len(dilation) == 1 else dilation
+    shifts = torch.round(weights.double() * torch.tensor(dilation, dtype=torch.double)).long()
+    return [tuple(s) for s in shifts.tolist()]
+
+
+def _make_symbolic(n_dims):
+    # memory_format only changes strides of the output, ONNX tensors have none
+    @symbolic_helper.parse_args('v', 'v', 'i', 'b', 'is', 'is', 'none', 'v', 'none')
+    def symbolic(g, input, weights, padding_mode, active_flag, stride, dilation, memory_format=None, channel_perm=None,
+                 sparsity=None):
+        shifts = _constant_shifts(weights, None, n_dims, active_flag, dilation, f'shift{n_dims}d')
+        stride = stride * n_dims if len(stride) == 1 else stride
+        output = lower_shift(g, input, shifts, n_dims, padding_mode, stride)
+        if (channel_perm is not None) and not symbolic_helper._is_none(channel_perm):
+            perm = symbolic_helper._maybe_get_const(channel_perm, 't')
+            if not isinstance(perm, torch.Tensor):
+                raise RuntimeError(f'shift{n_dims}d: ONNX export needs constant channel_perm')
+            # output[:, perm[c]] = shift(input)[:, c]
+            output = g.op('Gather', output, _const(g, torch.argsort(perm.long()).tolist()), axis_i=1)
+        return output
+    return symbolic
+
+
+def _make_grouped_symbolic(n_dims):
+    @symbolic_helper.parse_args('v', 'v', 'v', 'i', 'b', 'is', 'is')
+    def symbolic(g, input, weights, groups, padding_mode, active_flag, stride, dilation):
+        shifts = _constant_shifts(weights, groups, n_dims, active_flag, dilation, f'shift{n_dims}d_grouped')
+        stride = stride * n_dims if len(stride) == 1 else stride
+        return lower_shift(g, input, shifts, n_dims, padding_mode, stride)
+    return symbolic
+
+
+def register_onnx_symbolics(opset_version: int = 13):
+    """Registers ONNX symbolics of shift{1,2,3}d and shift{1,2,3}d_grouped for torch.onnx.export"""
+    assert opset_version >= _MIN_OPSET, f'register_onnx_symbolics(): opset {_MIN_OPSET} or newer is required, but got {opset_version}'
+    for n_dims in (1, 2, 3):
+        torch.onnx.register_custom_op_symbolic(f'torchshifts::shift{n_dims}d', _make_symbolic(n_dims), opset_version)
+        torch.onnx.register_custom_op_symbolic(f'torchshifts::shift{n_dims}d_grouped', _make_grouped_symbolic(n_dims), opset_version)
+
+
+@contextlib.contextmanager
+def export_constants(model: torch.nn.Module):
+    """
+        Within the context weights(and channel_perm buffers) of Shift modules are plain tensors instead of
+        parameters, so tracing records them as constants and the symbolics can read the shifts.
+    """
+    from torchshifts.modules.shifts import _Shiftnd
+    saved = []
+    for module in model.modules():
+        if not isinstance(module, _Shiftnd):
+            continue
+        if 'weight' in module._parameters:
+            weight = module._parameters.pop('weight')
+            module.weight = weight.detach().clone()
+            saved.append((module, 'weight', weight, module._parameters))
+        if module._buffers.get('channel_perm') is not None:
+            perm = module._buffers.pop('channel_perm')
+            module.channel_perm = perm.clone()
+            saved.append((module, 'channel_perm', perm, module._buffers))
+    try:
+        yield model
+    finally:
+        for module, name, value, store in reversed(saved):
+            delattr(module, name)
+            store[name] = value
@@ -1,16 +1,16 @@
 from torchshifts.functional import shift1d_func, shift2d_func, shift3d_func
 
-def shift1d_quantized(input, weight, padding_mode):
+def shift1d_quantized(input, weight, padding_mode, stride=1, dilation=1, channel_dim=1):
     if not input.is_quantized:
         raise ValueError("Input to 'shift1d_quantized' must be quantized!")
-    return shift1d_func(input, weight, padding_mode, False)
+    return shift1d_func(input, weight, padding_mode, False, stride, dilation, channel_dim=channel_dim)
 
-def shift2d_quantized(input, weight, padding_mode):
+def shift2d_quantized(input, weight, padding_mode, stride=1, dilation=1, channel_dim=1):
     if not input.is_quantized:
         raise ValueError("Input to 'shift2d_quantized' must be quantized!")
-    return shift2d_func(input, weight, padding_mode, False)
+    return shift2d_func(input, weight, padding_mode, False, stride, dilation, channel_dim=channel_dim)
 
-def shift3d_quantized(input, weight, padding_mode):
+def shift3d_quantized(input, weight, padding_mode, stride=1, dilation=1, channel_dim=1):
     if not input.is_quantized:
         raise ValueError("Input to 'shift3d_quantized' must be quantized!")
-    return shift3d_func(input, weight, padding_mode, False)
\ No newline at end of file
+    return shift3d_func(input, weight, padding_mode, False, stride, dilation, channel_dim=channel_dim)
\ No newline at end of file
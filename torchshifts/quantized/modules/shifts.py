@@ -12,58 +12,61 @@ def quantize_shift_weights(weight):
     return torch.quantize_per_tensor(weight, scale, 128, torch.quint8)
 
 class Shift1d(shifts.Shift1d):
-    def __init__(self, in_channels, padding='zeros'):
-        super(Shift1d, self).__init__(in_channels, padding, 1, 0, False)
+    def __init__(self, in_channels, padding='zeros', stride=1, dilation=1, channel_dim=1):
+        super(Shift1d, self).__init__(in_channels, padding, 1, 0, False, stride, dilation, channel_dim=channel_dim)
         self.qweight = quantize_shift_weights(self.weight.float())
 
     def forward(self, input):
-        return shift1d_quantized(input, self.qweight, self.padding)
+        return shift1d_quantized(input, self.qweight, self.padding, self.stride, self.dilation, self.channel_dim)
 
     def _get_name(self):
         return 'QuantizedShift1D'
 
     @staticmethod
     def from_float(mod):
-        qshift = Shift1d(mod.in_channels, rp_dict[mod.padding])
-        qshift.weight = mod.weight
-        qshift.qweight = quantize_shift_weights(mod.weight.float())
+        qshift = Shift1d(mod.in_channels, rp_dict[mod.padding], mod.stride, mod.dilation, mod.channel_dim)
+        weight = mod.channel_weight()
+        qshift.weight = weight if isinstance(weight, torch.nn.Parameter) else torch.nn.Parameter(weight.detach())
+        qshift.qweight = quantize_shift_weights(weight.float())
         return qshift
 
 
 class Shift2d(shifts.Shift2d):
-    def __init__(self, in_channels, padding='zeros'):
-        super(Shift2d, self).__init__(in_channels, padding, 1, 0, False)
+    def __init__(self, in_channels, padding='zeros', stride=1, dilation=1, channel_dim=1):
+        super(Shift2d, self).__init__(in_channels, padding, 1, 0, False, stride, dilation, channel_dim=channel_dim)
         self.qweight = quantize_shift_weights(self.weight.float())
 
     def forward(self, input):
-        return shift2d_quantized(input, self.qweight, self.padding)
+        return shift2d_quantized(input, self.qweight, self.padding, self.stride, self.dilation, self.channel_dim)
 
     def _get_name(self):
         return 'QuantizedShift2D'
 
     @staticmethod
     def from_float(mod):
-        qshift = Shift2d(mod.in_channels, rp_dict[mod.padding])
-        qshift.weight = mod.weight
-        qshift.qweight = quantize_shift_weights(mod.weight.float())
+        qshift = Shift2d(mod.in_channels, rp_dict[mod.padding], mod.stride, mod.dilation, mod.channel_dim)
+        weight = mod.channel_weight()
+        qshift.weight = weight if isinstance(weight, torch.nn.Parameter) else torch.nn.Parameter(weight.detach())
+        qshift.qweight = quantize_shift_weights(weight.float())
         return qshift
     
 class Shift3d(shifts.Shift3d):
-    def __init__(self, in_channels, padding='zeros'):
-        super(Shift3d, self).__init__(in_channels, padding, 1, 0, False)
+    def __init__(self, in_channels, padding='zeros', stride=1, dilation=1, channel_dim=1):
+        super(Shift3d, self).__init__(in_channels, padding, 1, 0, False, stride, dilation, channel_dim=channel_dim)
         self.qweight = quantize_shift_weights(self.weight.float())
 
     def forward(self, input):
-        return shift3d_quantized(input, self.qweight, self.padding)
+        return shift3d_quantized(input, self.qweight, self.padding, self.stride, self.dilation, self.channel_dim)
 
     def _get_name(self):
         return 'QuantizedShift3D'
 
     @staticmethod
     def from_float(mod):
-        qshift = Shift3d(mod.in_channels, rp_dict[mod.padding])
-        qshift.weight = mod.weight
-        qshift.qweight = quantize_shift_weights(mod.weight.float())
+        qshift = Shift3d(mod.in_channels, rp_dict[mod.padding], mod.stride, mod.dilation, mod.channel_dim)
+        weight = mod.channel_weight()
+        qshift.weight = weight if isinstance(weight, torch.nn.Parameter) else torch.nn.Parameter(weight.detach())
+        qshift.qweight = quantize_shift_weights(weight.float())
         return qshift
     
 
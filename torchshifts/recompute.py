@@ -0,0 +1,76 @@
+import weakref
+from contextlib import contextmanager
+import torch
+
+
+# recipes of shift outputs created inside recompute_shifts(), None outside of it
+_recipes = None
+
+
+class _ShiftRecipe:
+    __slots__ = ('func', 'input', 'input_version', 'weights', 'args')
+
+    def __init__(self, func, input, input_version, weights, args):
+        self.func = func
+        self.input = input
+        self.input_version = input_version
+        self.weights = weights
+        self.args = args
+
+    def __call__(self):
+        if self.input._version != self.input_version:
+            raise RuntimeError('recompute_shifts(): input of Shift layer was modified by an inplace operation, '
+                               'shifted tensor can not be recomputed in backward')
+        with torch.no_grad():
+            return self.func(self.input, self.weights, *self.args)
+
+
+def remember_shift(output, func, input, weights, args):
+    """
+        Records how `output` was computed: output = func(input, weights, *args).
+        Does nothing outside of recompute_shifts() context. Only weak references to output and input are kept,
+        so tensors are not held alive by the registration itself.
+    """
+    if (_recipes is not None) and torch.is_grad_enabled():
+        _recipes[id(output)] = (weakref.ref(output), output._version, weakref.ref(input), input._version,
+                                func, weights.detach(), args)
+    return output
+
+
+@contextmanager
+def recompute_shifts():
+    """
+        Shift outputs saved for backward by following layers(e.g. 1x1 convolution of ShiftNet block) are not stored,
+        only the pre-shift input(which Shift layer saves anyway) is kept, shifted tensor is recomputed by the shift
+        kernel in backward. Applies to Shift modules called inside the context, backward may be called outside of it:
+            with recompute_shifts():
+                out = model(x)
+            loss(out).backward()
+        Shift outputs modified inplace or saved as views are stored as usual, as well as outputs of Shift layers with
+        saved_input other than 'full'(they do not keep the full input).
+    """
+    global _recipes
+    previous = _recipes
+    recipes = {}
+
+    def pack(tensor):
+        entry = recipes.get(id(tensor))
+        if entry is None:
+            return tensor
+        output_ref, output_version, input_ref, input_version, func, weights, args = entry
+        input = input_ref()
+        if (output_ref() is tensor) and (output_version == tensor._version) and (input is not None):
+            # the recipe holds the input from here on, it is already saved by Shift layer for its own backward
+            return _ShiftRecipe(func, input, input_version, weights, args)
+        return tensor
+
+    def unpack(packed):
+        return packed() if isinstance(packed, _ShiftRecipe) else packed
+
+    _recipes = recipes
+    try:
+        with torch.autograd.graph.saved_tensors_hooks(pack, unpack):
+            yield
+    finally:
+        _recipes = previous
+        recipes.clear()